@@ -20,11 +20,15 @@
 
 
 #include <QApplication>
+#include <QDir>
+#include <QFileInfo>
 
 #include "mainwindow.h"
 #include "objects/valkyrie_object.h"
+#include "options/vk_option.h"
 #include "options/vk_parse_cmdline.h"
 #include "toolview/toolview.h"
+#include "utils/vglogbatch.h"
 #include "utils/vk_utils.h"
 #include "utils/vk_config.h"
 
@@ -33,6 +37,135 @@ VkCfgGlbl* vkCfgGlbl = NULL;  // Singleton VkCfgGlbl (non-project config)
 VkCfgProj* vkCfgProj = NULL;  // Singleton VkCfgProj (project config)
 
 
+/*!
+    Valkyrie's option named by arg ("--name" or "-x"), if any.
+    0 if none: or if arg has its value in it too.
+*/
+static VkOption* findCmdOption( Valkyrie* vk, const QString& arg )
+{
+   bool isLong = arg.startsWith( "--" );
+   foreach( VkObject* obj, vk->vkObjList() ) {
+      foreach( VkOption* opt, obj->getOptions() ) {
+         if ( opt->argType == VkOPT::NOT_POPT ) {
+            continue;
+         }
+         if ( isLong ? ( opt->longFlag == arg.mid( 2 ) )
+                     : ( !opt->shortFlag.isNull() && arg == QString( "-" ) + opt->shortFlag ) ) {
+            return opt;
+         }
+      }
+   }
+   return 0;
+}
+
+
+/*!
+    --batch=<file> runs without a gui: which has to be known before
+    the options are parsed, to make the right kind of application.
+     - a one-off: it's taken out of argv here, so it never reaches
+       the option parser, nor the project config.
+     - only valkyrie's own options count: they end at the client
+       program (the first argument that's not an option, nor an
+       option's value), or at "--".
+    Returns false if --batch was given badly.
+*/
+static bool takeBatchArg( int& argc, char* argv[], Valkyrie* vk,
+                          QString& output )
+{
+   for ( int i = 1; i < argc; ++i ) {
+      QString arg = argv[i];
+      if ( arg == "--" || !arg.startsWith( "-" ) ) {
+         break;
+      }
+
+      int taken = 0;
+      if ( arg == "--batch" ) {
+         taken = ( i + 1 < argc ) ? 2 : 1;
+         output = ( taken == 2 ) ? QString( argv[i + 1] ) : QString();
+      }
+      else if ( arg.startsWith( "--batch=" ) ) {
+         taken = 1;
+         output = arg.mid( 8 );
+      }
+      else {
+         // an option given its value separately: skip that too
+         VkOption* opt = findCmdOption( vk, arg );
+         if ( opt != 0 && opt->argType != VkOPT::ARG_NONE ) {
+            ++i;
+         }
+         continue;
+      }
+
+      for ( int j = i; j + taken < argc; ++j ) {
+         argv[j] = argv[j + taken];
+      }
+      argc -= taken;
+      argv[argc] = 0;
+
+      if ( output.isEmpty() ) {
+         vkPrintErr( "--batch: needs an output file (.json|.csv, - for stdout)" );
+         return false;
+      }
+      if ( output != "-" && !QFileInfo( output ).absoluteDir().exists() ) {
+         vkPrintErr( "--batch: no such directory: '%s'", qPrintable( output ) );
+         return false;
+      }
+      return true;
+   }
+   return true;
+}
+
+
+/*!
+    The logs a batch run summarises: --view-log's, straight from the
+    command line.  The option parser would write them to the project
+    config, and so would have them be the last log viewed, in a
+    project given by --project-file too: batch mode leaves the config
+    be, and valkyrie's other options to the gui.
+    Returns false if --view-log was given badly.
+*/
+static bool findBatchLogs( int argc, char* argv[], Valkyrie* vk,
+                           QString& logs )
+{
+   VkOption* viewLog = vk->getOption( VALKYRIE::VIEW_LOG );
+   for ( int i = 1; i < argc; ++i ) {
+      QString arg = argv[i];
+      if ( arg == "--" || !arg.startsWith( "-" ) ) {
+         break;
+      }
+
+      VkOption* opt = findCmdOption( vk, arg );
+      if ( opt == 0 ) {
+         int eq = arg.indexOf( '=' );
+         if ( eq != -1 ) {
+            opt = findCmdOption( vk, arg.left( eq ) );
+            if ( opt == viewLog ) {
+               logs = arg.mid( eq + 1 );
+            }
+         }
+         continue;
+      }
+      if ( opt->argType == VkOPT::ARG_NONE ) {
+         continue;
+      }
+      if ( ++i < argc && opt == viewLog ) {
+         logs = argv[i];
+      }
+   }
+
+   if ( logs.isEmpty() ) {
+      return true;
+   }
+   int rc = vk->checkOptArg( VALKYRIE::VIEW_LOG, logs );
+   if ( rc != PARSED_OK ) {
+      vkPrintErr( "--view-log: %s: '%s'", parseErrString( rc ),
+                  qPrintable( logs ) );
+      return false;
+   }
+   return true;
+}
+
+
 
 /*!
     Main program entry point
@@ -41,7 +174,9 @@ VkCfgProj* vkCfgProj = NULL;  // Singleton VkCfgProj (project config)
 int main( int argc, char* argv[] )
 {
    int exit_status = EXIT_SUCCESS;
-   QApplication* app  = 0;
+   QCoreApplication* app = 0;
+   bool batch = false;
+   QString batchOutput;
    MainWindow* vkWin  = 0;
    VGTOOL::ToolProcessId startProcess = VGTOOL::PROC_NONE;
 
@@ -51,7 +186,17 @@ int main( int argc, char* argv[] )
    
    // ------------------------------------------------------------
    // Start turning the engine over
-   app = new QApplication( argc, argv );
+   //  - no widgets in batch mode: may not even have a display
+   if ( ! takeBatchArg( argc, argv, &valkyrie, batchOutput ) ) {
+      return EXIT_FAILURE;
+   }
+   batch = !batchOutput.isEmpty();
+   if ( batch ) {
+      app = new QCoreApplication( argc, argv );
+   }
+   else {
+      app = new QApplication( argc, argv );
+   }
    
    // ------------------------------------------------------------
    // Setup application config settings
@@ -81,6 +226,19 @@ int main( int argc, char* argv[] )
 
    //TODO: check docs found
 
+   // ------------------------------------------------------------
+   // Batch: just summarise the logs, and exit
+   //  - only logs given on the command line: not the last ones viewed
+   if ( batch ) {
+      QString logs;
+      if ( ! findBatchLogs( argc, argv, &valkyrie, logs ) ) {
+         exit_status = EXIT_FAILURE;
+         goto cleanup_and_exit;
+      }
+      exit_status = VgLogBatch::exec( logs, batchOutput );
+      goto cleanup_and_exit;
+   }
+
    // ------------------------------------------------------------
    // Command-line parsing
    //  - if a project file is given, the settings will override the initialised vkCfgProj.
@@ -25,18 +25,23 @@ The Valgrind process control & log parsing goes like this:
 
 === Happy flow ===
 start() -> vgproc                               ->(writes)-> XML_LOG
-        -> logpoller ->(triggers)-> readVgLog() <-(reads )<- XML_LOG
+        -> logsource ->(wakes)-> vgparser thread <-(reads )<- XML_LOG
+                                 vgparser (gui)  ->(fills )-> VgLogView
 
 vgproc      ->(finished/died)-> processDone() ->(if parser done)-> DONE
-readVgLog() ->(finished parsing log)          ->(if vgproc done)-> DONE
+vgparser    ->(finished parsing log)-> readVgLogDone() ->(if vgproc done)-> DONE
+
+=== --trace-children ===
+vgproc children   ->(each write their own)-> XML_LOG.<pid>
+        -> childWatch ->(wakes)-> childParsers ->(fill)-> a VgLogView each
 
 === Exceptions ===
-processDone() ->(parser alive && vgproc error)-> stopProcess()
-readVgLog()   ->(parser error && vgproc alive)-> stopProcess()
+processDone()   ->(parser alive && vgproc error)-> stopProcess()
+readVgLogDone() ->(parser error && vgproc alive)-> stopProcess()
 User Input    ->(Stop command)-> stop()       -> stopProcess()
 
 stopProcess()
-  -> cleanup logpoller
+  -> cleanup logsource
   -> cleanup vgproc
        ->(QProc::terminate)->SIGTERM->          -> processDone() -> DONE
        ->(timeout)-> killProc() ->(QtProc::kill)-> processDone() -> DONE
@@ -44,6 +49,7 @@ stopProcess()
 
 #include "objects/tool_object.h"
 #include "toolview/toolview.h"
+#include "utils/vglogmerger.h"
 #include "utils/vk_config.h"
 #include "utils/vk_utils.h"
 
@@ -61,19 +67,21 @@ stopProcess()
 #include "utils/vk_messages.h"
 #include "utils/vk_utils.h"      // vk_assert, VK_DEBUG, etc.
 #include "utils/vglogreader.h"
+#include "utils/vglogparser.h"
+#include "utils/vk_compress.h"
+#include "toolview/logdiffview.h"
 #include "options/vk_option.h"   // PERROR* and friends
 //#include "vk_file_utils.h"       // FileCopy()
 
 #include <QApplication>
 #include <QDir>
+#include <QFileInfo>
 #include <QTimer>
 #endif
 #include <unistd.h>	// for usleep
 
 // Waiting for Vg to start:
 #define WAIT_VG_START_MAX   1000 // msecs before giving up
-#define WAIT_VG_START_SLEEP 100  // msecs to sleep each loop
-#define WAIT_VG_START_LOOPS (WAIT_VG_START_MAX / WAIT_VG_START_SLEEP)
 
 // Waiting for Vg to die:
 #define TIMEOUT_KILL_PROC       2000 // msec: 'please stop?' to 'die!'
@@ -95,13 +103,9 @@ stopProcess()
 ToolObject::ToolObject( const QString& toolname, VGTOOL::ToolID id )
    : VkObject( toolname ),
      toolView( 0 ), vgRunSaved( true ), processId( VGTOOL::PROC_NONE ),
-     toolId( id ), vgreader( 0 ), vgproc( 0 )
-{
-   // init logpoller
-   logpoller = new VkLogPoller( this );
-   connect( logpoller, SIGNAL( logUpdated() ),
-            this,        SLOT( readVgLog() ) );
-}
+     toolId( id ), vgparser( 0 ), vgproc( 0 ), logsource( 0 ),
+     rootPid( -1 ), childWatch( 0 ), childParsers( 0 )
+{ }
 
 ToolObject::~ToolObject()
 {
@@ -120,17 +124,36 @@ ToolObject::~ToolObject()
       vgproc = 0;
    }
 
-   if ( vgreader ) {
-      delete vgreader;
-      vgreader = 0;
+   if ( vgparser ) {
+      delete vgparser;
+      vgparser = 0;
+   }
+
+   if ( childParsers ) {
+      delete childParsers;
+      childParsers = 0;
    }
 
-   // logpoller auto deleted by Qt when 'this' dies
+   // logsource, childWatch auto deleted by Qt when 'this' dies
 
-   // cleanup temp-log
-   if ( QFile::exists( tmplogFname ) ) {
-      QFile::remove( tmplogFname );
+   // cleanup temp-logs
+   removeLogs();
+}
+
+
+/*!
+  Remove the temp-logs of the last run: the children's too.
+*/
+void ToolObject::removeLogs()
+{
+   QStringList logs = childLogs;
+   logs << tmplogFname;
+   for ( int i = 0; i < logs.count(); ++i ) {
+      if ( QFile::exists( logs.at( i ) ) ) {
+         QFile::remove( logs.at( i ) );
+      }
    }
+   childLogs.clear();
 }
 
 
@@ -145,6 +168,8 @@ ToolView* ToolObject::createView( QWidget* parent )
    // signals tool_view --> tool_obj
    connect( toolView, SIGNAL( saveLogFile() ),
             this,       SLOT( fileSaveDialog() ) );
+   connect( toolView, SIGNAL( diffLogFile() ),
+            this,       SLOT( diffLogDialog() ) );
 
    // signals tool_obj --> tool_view
    connect( this,    SIGNAL( running( bool ) ),
@@ -258,6 +283,7 @@ bool ToolObject::start( VGTOOL::ToolProcessId procId,
   Called by valkyrie->runTool() if cmdline --view-log=<file> specified.
   ToolView::openLogFile() if gui parse-log selected.
   If 'checked' == true, file perms/format has already been checked
+  A directory or wildcard of logs is merged: see mergeLogFiles().
 */
 bool ToolObject::parseLogFile()
 {
@@ -271,6 +297,10 @@ bool ToolObject::parseLogFile()
    //TODO: pass this via flags from the toolview, or something.
    QString log_file = vkCfgProj->value( "valkyrie/view-log" ).toString();
 
+   if ( VgLogMerger::isLogSet( log_file ) ) {
+      return mergeLogFiles( log_file );
+   }
+
    statusMsg( "Parsing '" + log_file + "'" );
 
    // check this is a valid file, and has at least read perms
@@ -293,11 +323,15 @@ bool ToolObject::parseLogFile()
 
    // Parse the log
    VgLogReader vgLogFileReader( toolView->createVgLogView() );
-   bool success = vgLogFileReader.parse( log_file );
+   bool success = vgLogFileReader.parseFile( log_file, toolView );
 
    if ( success ) {
       statusMsg( "Loaded Logfile '" + log_file + "'" );
    }
+   else if ( vgLogFileReader.handler()->fatalMsg().isEmpty() ) {
+      // user cancelled
+      statusMsg( "Cancelled loading Logfile '" + log_file + "'" );
+   }
    else {
       statusMsg( "Error Parsing Logfile '" + log_file + "'" );
 
@@ -311,6 +345,54 @@ bool ToolObject::parseLogFile()
 }
 
 
+/*!
+  Merge all the logs of a directory or wildcard into one view.
+   - logs that can't be merged are left out, and listed.
+*/
+bool ToolObject::mergeLogFiles( const QString& log_set )
+{
+   statusMsg( "Merging '" + log_set + "'" );
+
+   QStringList logs = VgLogMerger::logFiles( log_set );
+   if ( logs.isEmpty() ) {
+      vkError( toolView, "File Error", "No readable log files in: \n\"%s\"",
+               qPrintable( escapeEntities( log_set ) ) );
+      setProcessId( VGTOOL::PROC_NONE );
+      return false;
+   }
+
+   // Could be a lot of logs, so at least get ui up-to-date now
+   qApp->processEvents( QEventLoop::AllEvents, 1000/*max msecs*/ );
+
+   VgLogMerger merger( toolView->createVgLogView() );
+   bool success = merger.merge( logs, toolView );
+
+   if ( success ) {
+      statusMsg( QString( "Merged %1 of %2 Logfiles in '%3'" )
+                 .arg( merger.numMerged() ).arg( logs.count() ).arg( log_set ) );
+
+      QStringList skipped = merger.skippedLogs();
+      if ( !skipped.isEmpty() ) {
+         vkInfo( toolView, "Logs Left Out",
+                 "<p>These logs could not be merged:</p><p>%s</p>",
+                 qPrintable( str2html( escapeEntities( skipped.join( "\n" ) ) ) ) );
+      }
+   }
+   else if ( merger.fatalMsg().isEmpty() ) {
+      // user cancelled
+      statusMsg( "Cancelled merging '" + log_set + "'" );
+   }
+   else {
+      statusMsg( "Error Merging '" + log_set + "'" );
+      vkError( toolView, "XML Parse Error",
+               "<p>%s</p>", qPrintable( str2html( escapeEntities( merger.fatalMsg() ) ) ) );
+   }
+
+   setProcessId( VGTOOL::PROC_NONE );
+   return success;
+}
+
+
 /*!
   Run a VKProcess, as given by 'flags'.
    - Reads ouput from file, loading this to the listview.
@@ -335,9 +417,39 @@ bool ToolObject::runValgrind( QStringList flags )
 
 #endif
 
-   // new vgreader - view may have been recreated, so need up-to-date ptr
-   vk_assert( vgreader == 0 );
-   vgreader = new VgLogReader( toolView->createVgLogView() );
+   // the last run's children are done with
+   delete childWatch;
+   childWatch = 0;
+   delete childParsers;
+   childParsers = 0;
+
+   // --trace-children: a log per process, each named by its pid.
+   //  - the root process' log is only known once it's started.
+   QString pattern;
+   bool vg_ok = true;
+   if ( vkCfgProj->value( "valgrind/trace-children" ).toString() == "yes" ) {
+      int dot = tmplogFname.lastIndexOf( '.' );
+      vk_assert( dot > 0 );
+      pattern = tmplogFname.left( dot ) + ".%p" + tmplogFname.mid( dot );
+
+      int idx = args.indexOf( "--xml-file=" + tmplogFname );
+      vk_assert( idx >= 0 );
+      args[idx] = "--xml-file=" + pattern;
+   }
+   else {
+      // new vgparser - view may have been recreated, so need up-to-date ptr
+      vk_assert( vgparser == 0 );
+      vgparser = new VgLogParser( toolView->createVgLogView(), tmplogFname, this );
+      connect( vgparser, SIGNAL( logParsed() ),
+               this,       SLOT( readVgLogDone() ) );
+
+      // wake the parser whenever Vg has written more
+      vk_assert( logsource == 0 );
+      logsource = VkLogSource::create( tmplogFname, this );
+      connect( logsource, SIGNAL( logUpdated() ),
+               vgparser,    SLOT( logUpdated() ) );
+      vg_ok = logsource->open( args );
+   }
 
    // start a new process, listening on exit signal to call processDone().
    //  - once Vg is done, we can read the remainder of the log in one last go.
@@ -353,28 +465,29 @@ bool ToolObject::runValgrind( QStringList flags )
    vgproc->setWorkingDirectory( vkCfgProj->value( "valkyrie/working-dir" ).toString() );
 
    // start running process
-   vgproc->start( program, args );
-   //VK_DEBUG( "Started VgProcess" );
-
    // Make sure Vg started ok before moving further.
-   // Don't bother using QProcess::start():
-   //  1) Vg may have finished already(!)
-   //  2) QXmlSimpleReader won't start on an empty log: seems to need at least "<?x"
-   // So just wait for a while until we find the valgrind output log...
-   int nLoops=0;
-   for (;nLoops < WAIT_VG_START_LOOPS; nLoops++) {
-      if ( QFile::exists( tmplogFname ) ) { break; }
-      usleep( WAIT_VG_START_SLEEP * 1000 );
+   //  - no need to wait for the log to turn up: the parser is
+   //    woken by logsource once there's something to read.
+   //  - if Vg fails after starting (e.g. bad flags), processDone() deals with it.
+   if ( vg_ok ) {
+      vgproc->start( program, args );
+      vg_ok = vgproc->waitForStarted( WAIT_VG_START_MAX );
+      //VK_DEBUG( "Started VgProcess" );
+   }
+
+   if ( vg_ok && !pattern.isEmpty() ) {
+      vg_ok = traceChildren( pattern );
    }
-   bool vg_ok = (nLoops < WAIT_VG_START_LOOPS);
 
    if ( vg_ok ) {
       //VK_DEBUG( "Started Valgrind" );
       statusMsg( "Started Valgrind ..." );
+      logsource->processStarted();
 
-      // poll log regularly to trigger parsing of the latest data via readVgLog()
-      // doesn't matter if processDone() or readVgLog() gets called first.
-      logpoller->start( 250 );  // msec
+      // parse the log in the background, filling the view as we go.
+      // doesn't matter if processDone() or readVgLogDone() gets called first.
+      vgparser->startParsing();
+      statusMsg( "Parsing Valgrind XML log..." );
    }
    else {
       vgRunSaved = true;  // nothing to save
@@ -396,6 +509,57 @@ bool ToolObject::runValgrind( QStringList flags )
 }
 
 
+/*!
+  --trace-children: Vg is up, and writing to the log of its pid.
+   - that log is parsed as usual, into the main view; it's the one
+     saved.  A pipe won't do: every process would write to it.
+   - every other process' log gets a view and parser of its own,
+     as it turns up.  One watcher and one drain timer does them all.
+*/
+bool ToolObject::traceChildren( const QString& pattern )
+{
+   rootPid = vgproc->pid();
+
+   // vk_mkstemp()'s file: unused, but the pattern is made from it
+   QFile::remove( tmplogFname );
+   tmplogFname = VkProcLogWatch::logFile( pattern, rootPid );
+
+   vk_assert( vgparser == 0 );
+   vgparser = new VgLogParser( toolView->createVgLogView(), tmplogFname, this );
+   connect( vgparser, SIGNAL( logParsed() ),
+            this,       SLOT( readVgLogDone() ) );
+
+   vk_assert( logsource == 0 );
+   QStringList noflags;
+   logsource = new VkLogFileTail( tmplogFname, this );
+   connect( logsource, SIGNAL( logUpdated() ),
+            vgparser,    SLOT( logUpdated() ) );
+   if ( !logsource->open( noflags ) ) {
+      return false;
+   }
+
+   childParsers = new VgLogParserSet( this );
+   childWatch = new VkProcLogWatch( pattern, this );
+   connect( childWatch, SIGNAL( logCreated( const QString&, qint64 ) ),
+            this,         SLOT( childLogCreated( const QString&, qint64 ) ) );
+   connect( childWatch,   SIGNAL( logUpdated( const QString& ) ),
+            childParsers,   SLOT( logUpdated( const QString& ) ) );
+   return childWatch->open();
+}
+
+/*!
+  A child process has started logging: show it alongside the root's.
+*/
+void ToolObject::childLogCreated( const QString& logfile, qint64 pid )
+{
+   if ( pid == rootPid || childParsers == 0 ) {
+      return;
+   }
+   childLogs << logfile;
+   childParsers->addLog( logfile, toolView->createProcLogView() );
+}
+
+
 /*!
   Stop a process.
   Try to be nice, but if nice don't get the job done, hire a
@@ -415,13 +579,24 @@ void ToolObject::stopProcess()
    statusMsg( "Stopping Valgrind process ..." );
 
    // first things first: stop trying to read from the log.
-   if ( logpoller != 0 && logpoller->isActive() ) {
-      logpoller->stop();
+   if ( logsource != 0 ) {
+      delete logsource;
+      logsource = 0;
+   }
+
+   if ( vgparser != 0 ) {
+      delete vgparser;
+      vgparser = 0;
+   }
+
+   if ( childWatch != 0 ) {
+      delete childWatch;
+      childWatch = 0;
    }
 
-   if ( vgreader != 0 ) {
-      delete vgreader;
-      vgreader = 0;
+   if ( childParsers != 0 ) {
+      delete childParsers;
+      childParsers = 0;
    }
 
    switch ( getProcessId() ) {
@@ -528,9 +703,7 @@ bool ToolObject::queryDone()
    }
 
    if ( discardLog ) {
-      if ( QFile::exists( tmplogFname ) ) {
-         QFile::remove( tmplogFname );
-      }
+      removeLogs();
       tmplogFname = QString();
       vgRunSaved = true; // nothing more to save
 
@@ -663,13 +836,13 @@ void ToolObject::processDone( int exitCode, QProcess::ExitStatus exitStatus )
    }
 
    // if log reader not active anymore, we're done
-   if ( vgreader == 0 ) {
+   if ( vgparser == 0 ) {
       //VK_DEBUG( "All done." );
       statusMsg( "Finished running Valgrind successfully!" );
       setProcessId( VGTOOL::PROC_NONE );
    }
    else {
-      // For a number of reasons, vgreader may continue on a while after
+      // For a number of reasons, vgparser may continue on a while after
       // vgproc has gone (e.g. Vg dies, leaving incomplete xml)
       if ( !ok ) {
          // process error: stop reader now.
@@ -694,59 +867,21 @@ void ToolObject::processDone( int exitCode, QProcess::ExitStatus exitStatus )
 
 
 /*!
-  Read Valgrind XML
-   - Called by logpoller signals only.
+  Finished reading Valgrind XML
+   - Called by vgparser signal only, once the parser thread is done
+     and everything it parsed is in the view.
 
-  Don't worry about Valgrind process state: just read the log.
+  Don't worry about Valgrind process state: just deal with the log.
    - unless we have a parser error & valgrind is still runnning,
      in which case, stop the process too, via stopProcess().
 */
-void ToolObject::readVgLog()
+void ToolObject::readVgLogDone()
 {
    vk_assert( toolView != 0 );
-   vk_assert( vgreader != 0 );
-   vk_assert( logpoller != 0 );
-   vk_assert( !tmplogFname.isEmpty() );
-
-   // Note: not calling qApp->processEvents(), since parser only
-   // reads in a limited amount in one go anyway.
-
-   // try parsing vg xml log ----------------------------------------
-   bool ok = true;
-   QString errHeader;
-   statusMsg( "Parsing Valgrind XML log..." );
-
-   if ( !vgreader->handler()->started() ) {
-      // first time around...
-      //VK_DEBUG( "Start parsing Valgrind XML log" );
-
-      ok = vgreader->parse( tmplogFname, true/*incremental*/ );
-
-      if ( !ok ) {
-         VK_DEBUG( "Error: parse() failed" );
-         errHeader = "XML Parse-Startup Error";
-      }
-   }
-   else {
-      // we've started, so we'll continue...
-      //VK_DEBUG( "Continue parsing Valgrind XML log" );
-
-      ok = vgreader->parseContinue();
-
-      if ( !ok ) {
-         VK_DEBUG( "Error: parseContinue() failed" );
-         errHeader = "XML Parse-Continue Error";
-      }
-   }
-
-   if ( !vgreader->handler()->fatalMsg().isEmpty() ) {
-      ok = false;
-   }
-
-   if ( vgreader->handler()->finished() ) {
-      //VK_DEBUG( "Reached end of XML log" );
-   }
+   vk_assert( vgparser != 0 );
+   vk_assert( logsource != 0 );
 
+   bool ok = vgparser->ok();
 
    // deal with failures --------------------------------------------
    if ( !ok ) {
@@ -755,43 +890,38 @@ void ToolObject::readVgLog()
       statusMsg( "Error parsing Valgrind log" );
 
       // Failed: print error & stop everything.
-      QString errMsg = vgreader->handler()->fatalMsg();
+      QString errHeader = vgparser->failedStart() ? "XML Parse-Startup Error"
+                                                  : "XML Parse-Continue Error";
+      QString errMsg = vgparser->fatalMsg();
       vkError( toolView, errHeader,
                "<p>Failed to parse Valgrind XML output:<br>%s</p>",
                qPrintable( str2html( errMsg ) ) );
    }
 
    // cleanup -------------------------------------------------------
-   // if parsing failed, or this was a last call, then cleanup
-   if ( !ok || vgreader->handler()->finished() ) {
-      //VK_DEBUG( "Cleaning up logpoller & reader" );
-      vk_assert( vgreader != 0 );
-      vk_assert( logpoller != 0 );
-      vk_assert( logpoller->isActive() );
-
-      // cleanup.
-      logpoller->stop();
-      delete vgreader;
-      vgreader = 0;
-
-      // if vgproc not active anymore, we're done!
-      if ( vgproc == 0 ) {
-         //VK_DEBUG( "All done." );
-         statusMsg( "Finished running Valgrind successfully!" );
-         setProcessId( VGTOOL::PROC_NONE );
-      }
-      else {
-         // vgproc is still alive...
-         if ( !ok ) {
-            // parse error: stop vgproc now
-            VK_DEBUG( "VgReader finished with error: stop VgProcess" );
-            stopProcess();
-         }
+   //VK_DEBUG( "Cleaning up logsource & parser" );
+   delete logsource;
+   logsource = 0;
+   vgparser->deleteLater();   // we're in its signal
+   vgparser = 0;
 
-         // else: parser finished happily. Allow Vg to stop when it's also happy.
-         // TODO: Any reason why Vg might need stopping from this state?
-         //  - if any good reason, then dup checkParserFinished() functionality.
+   // if vgproc not active anymore, we're done!
+   if ( vgproc == 0 ) {
+      //VK_DEBUG( "All done." );
+      statusMsg( "Finished running Valgrind successfully!" );
+      setProcessId( VGTOOL::PROC_NONE );
+   }
+   else {
+      // vgproc is still alive...
+      if ( !ok ) {
+         // parse error: stop vgproc now
+         VK_DEBUG( "VgParser finished with error: stop VgProcess" );
+         stopProcess();
       }
+
+      // else: parser finished happily. Allow Vg to stop when it's also happy.
+      // TODO: Any reason why Vg might need stopping from this state?
+      //  - if any good reason, then dup checkParserFinished() functionality.
    }
 }
 
@@ -801,16 +931,15 @@ void ToolObject::readVgLog()
   inform the user and remind of option to stopping by hand.
 
   Notes:
-  * vgreader->parse() and parseContinue() call QXmlInputSource::fetchData(),
-    which reads in only a limited amount (512B for Qt3.3.6) from the logfile.
-    Valgrind, after finishing up, can write a whole bunch of data in one go
-    to the logfile, which takes some iterations of parserContinue() to read in.
+  * Valgrind, after finishing up, can write a whole bunch of data in one go
+    to the logfile, which takes the parser thread a while to get through,
+    and the view a while longer to take in.
   * If Valgrind doesn't write a complete XMLfile (!), this would leave the
     parser with incomplete XML, trying to parse it indefinitely.
 */
 void ToolObject::checkParserFinished()
 {
-   if ( vgproc == 0 && vgreader != 0 ) {
+   if ( vgproc == 0 && vgparser != 0 ) {
       VK_DEBUG( "Timeout waiting for parser to finish: Parser _still_ alive." );
       vkInfo( toolView, "Valgrind finished, but log-reader alive",
               "<p>The Valgrind process finished some time ago,<br>"
@@ -846,11 +975,13 @@ bool ToolObject::fileSaveDialog()
    }
 
    // --- Get appropriate source log
-   // TODO: this is horrible, but good enough for now.
-   //  - relies on empty tmplogFname to indicate not a vg run but a loaded log
-   QString srcFname = tmplogFname;
-   if ( tmplogFname.isEmpty() ) {
-      srcFname = vkCfgProj->value( "valkyrie/view-log" ).toString();
+   QString srcFname = logFile();
+
+   // a merged view is of many logs: none of them is it
+   if ( VgLogMerger::isLogSet( srcFname ) ) {
+      vkInfo( toolView, "Save Failed",
+              "<p>A view merged from many logs can't be saved as one log.</p>" );
+      return false;
    }
 
    // trying to copy src to src?
@@ -859,22 +990,93 @@ bool ToolObject::fileSaveDialog()
    }
 
    // --- Copy src log to given filename ---
+   // - compressed as fname's extension says (.gz, .xz, .zst)
    // first delete if already exists
    if ( QFile::exists( fname ) ) {
       QFile::remove( fname );
    }
-   bool ok = QFile::copy( srcFname, fname );
+   QString errMsg;
+   bool ok = VkCompress::copy( srcFname, fname, errMsg, toolView );
 
    if ( ok ) {
       vgRunSaved = true;
       statusMsg( "Saved: " + srcFname );
    }
+   else if ( errMsg.isEmpty() ) {
+      // cancelled by the user
+      statusMsg( "Cancelled Save: " + srcFname );
+   }
    else {
       // nogo: return and try again
       vkInfo( toolView, "Save Failed",
-              "<p>Failed to save file to '%s'", qPrintable( fname ) );
+              "<p>Failed to save file to '%s'<br/>%s</p>",
+              qPrintable( fname ), qPrintable( escapeEntities( errMsg ) ) );
       statusMsg( "Failed Save: " + srcFname );
    }
 
    return ok;
 }
+
+
+/*!
+  The log shown: this run's, or the one loaded.
+  TODO: this is horrible, but good enough for now.
+   - relies on empty tmplogFname to indicate not a vg run but a loaded log
+*/
+QString ToolObject::logFile()
+{
+   if ( tmplogFname.isEmpty() ) {
+      return vkCfgProj->value( "valkyrie/view-log" ).toString();
+   }
+   return tmplogFname;
+}
+
+
+/*!
+  Compare the log shown with a baseline log the user picks,
+  and show what's new, fixed, and changed count.
+*/
+void ToolObject::diffLogDialog()
+{
+   vk_assert( toolView != 0 );
+
+   if ( isRunning() ) {
+      vkInfo( toolView, "Compare Logs",
+              "<p>The log can be compared once the run is done.</p>" );
+      return;
+   }
+
+   QString log = logFile();
+   if ( log.isEmpty() || VgLogMerger::isLogSet( log ) ) {
+      vkInfo( toolView, "Compare Logs",
+              "<p>Only a single log can be compared with a baseline.</p>" );
+      return;
+   }
+
+   // no cfg key: the baseline isn't the log being viewed, and mustn't
+   // be kept as if it were.  Start by the log: baselines are often
+   // kept alongside.
+   QString baseline = vkDlgGetFile( toolView, QFileInfo( log ).absolutePath() );
+   if ( baseline.isEmpty() ) { // Cancelled
+      return;
+   }
+
+   statusMsg( "Comparing with: " + baseline );
+   VgLogDiff diff;
+   bool ok = diff.diff( baseline, log, toolView );
+
+   if ( !ok && diff.fatalMsg().isEmpty() ) {
+      statusMsg( "Cancelled comparing with: " + baseline );
+      return;
+   }
+   if ( !ok ) {
+      statusMsg( "Failed comparing with: " + baseline );
+      vkError( toolView, "Compare Logs",
+               "<p>%s</p>", qPrintable( str2html( escapeEntities( diff.fatalMsg() ) ) ) );
+      return;
+   }
+
+   LogDiffView* dlg = new LogDiffView( diff, baseline, log, toolView );
+   dlg->show();
+   statusMsg( "Compared with: " + baseline );
+}
@@ -30,8 +30,8 @@
 
 #include "objects/vk_objects.h"
 #include "toolview/toolview.h"
-#include "utils/vglogreader.h"
-#include "utils/vk_logpoller.h"
+#include "utils/vglogparser.h"
+#include "utils/vk_logsource.h"
 
 #include <QList>
 #include <QProcess>
@@ -86,18 +86,24 @@ private:
    virtual ToolView* createToolView( QWidget* parent ) = 0;
    virtual void statusMsg( QString msg ) = 0;
    bool runValgrind( QStringList vgflags );
+   bool traceChildren( const QString& pattern );
+   void removeLogs();
    bool parseLogFile();
+   bool mergeLogFiles( const QString& log_set );
    bool queryFileSave();
+   QString logFile();
 
 private slots:
    void stopProcess();
    void killProcess();
    void processDone( int exitCode, QProcess::ExitStatus exitStatus );
-   void readVgLog();
+   void readVgLogDone();
    void checkParserFinished();
+   void childLogCreated( const QString& logfile, qint64 pid );
 
 public slots:
    bool fileSaveDialog();
+   void diffLogDialog();
 
 public:
    VGTOOL::ToolID getToolId() {
@@ -116,9 +122,15 @@ private:
    
    VGTOOL::ToolID toolId;  // which tool are we.
 
-   VgLogReader* vgreader;
+   VgLogParser* vgparser;
    QProcess*    vgproc;
-   VkLogPoller* logpoller;
+   VkLogSource* logsource;
+
+   // --trace-children: the logs of the root process' children
+   qint64          rootPid;
+   VkProcLogWatch* childWatch;
+   VgLogParserSet* childParsers;
+   QStringList     childLogs;
 };
 
 
@@ -556,26 +556,10 @@ int Valgrind::checkOptArg( int optid, QString& argval )
    }
    break;
    
-   case VALGRIND::TRACE_CH: {
-#if 0
-      // TODO
-      if ( opt->isValidArg( &errval, argval ) ) {
-         if ( argval == "yes" ) {
-            if ( vkCfgProj->rdBool( "db-attach", "valgrind" ) ) {
-               errval = PERROR_DB_CONFLICT;
-            }
-         }
-      }
-      
-#else
-      /* Disabled for now - can't deal with the multiple xml files this generates */
-      /* Note: Also disabled in ValgrindOptionsPage() */
-      errval = PERROR_BADOPT;
-      //         vkPrintErr("Option disabled '--%s'", opt->m_longFlag.latin1());
-      //         vkPrintErr(" - Valkyrie can't yet handle the multiple xml files this generates.");
-#endif
-   }
-   break;
+   case VALGRIND::TRACE_CH:
+      /* each process gets an xml log of its own: see ToolObject::traceChildren() */
+      opt->isValidArg( &errval, argval );
+      break;
    
    case VALGRIND::SILENT_CH: {
       /* Disabled for now - output between fork and exec is confusing for the XML output */
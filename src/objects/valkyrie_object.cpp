@@ -22,6 +22,7 @@
 #include "objects/tool_object.h"
 #include "objects/valkyrie_object.h"
 #include "options/valkyrie_options_page.h"   // createVkOptionsPage()
+#include "utils/vglogmerger.h"
 #include "utils/vk_config.h"
 #include "utils/vk_utils.h"
 
@@ -337,7 +338,7 @@ void Valkyrie::setupOptions()
       "",
       "",
       "",
-      "parse and view a valgrind logfile",
+      "parse and view a valgrind logfile (a dir/wildcard: merge them)",
       urlNone,
       VkOPT::ARG_STRING,
       VkOPT::WDG_NONE
@@ -357,6 +358,51 @@ void Valkyrie::setupOptions()
       VkOPT::NOT_POPT,
       VkOPT::WDG_LEDIT
    );
+
+   options.addOpt(
+      VALKYRIE::XML_PIPE,
+      this->objectName(),
+      "xml-pipe",
+      '\0',
+      "",
+      "true|false",
+      "false",
+      "Read Valgrind output through a pipe",
+      "",
+      urlValkyrie::logDir,
+      VkOPT::NOT_POPT,
+      VkOPT::WDG_CHECK
+   );
+
+   options.addOpt(
+      VALKYRIE::LAZY_LOG,
+      this->objectName(),
+      "lazy-log-mb",
+      '\0',
+      "",
+      "0|1048576",
+      "512",
+      "Logs over this size (MB) aren't kept mapped while shown:",
+      "",
+      urlValkyrie::logDir,
+      VkOPT::NOT_POPT,
+      VkOPT::WDG_SPINBOX
+   );
+
+   options.addOpt(
+      VALKYRIE::GROUP_DEPTH,
+      this->objectName(),
+      "group-depth",
+      '\0',
+      "",
+      "1|100",
+      "4",
+      "Group errors by this many top stack frames:",
+      "",
+      urlValkyrie::logDir,
+      VkOPT::NOT_POPT,
+      VkOPT::WDG_SPINBOX
+   );
 }
 
 
@@ -447,7 +493,10 @@ int Valkyrie::checkOptArg( int optid, QString& argval )
    case VALKYRIE::FNT_GEN_SYS:
    case VALKYRIE::FNT_GEN_USR:
    case VALKYRIE::FNT_TOOL_USR:
-   case VALKYRIE::SRC_LINES: {
+   case VALKYRIE::SRC_LINES:
+   case VALKYRIE::XML_PIPE:
+   case VALKYRIE::LAZY_LOG:
+   case VALKYRIE::GROUP_DEPTH: {
          vk_assert( opt->argType == VkOPT::NOT_POPT );
          return errval;
       } break;
@@ -564,8 +613,17 @@ int Valkyrie::checkOptArg( int optid, QString& argval )
 
    case VALKYRIE::VIEW_LOG:
       if ( !argval.isEmpty() ) {
-         // see if we have a logfile with at least R permissions:
-         argval = fileCheck( &errval, argval, true );
+         if ( VgLogMerger::isLogSet( argval ) ) {
+            // logs to merge: need at least one with R permissions
+            if ( VgLogMerger::logFiles( argval ).isEmpty() ) {
+               errval = PERROR_BADFILE;
+            }
+            argval = QFileInfo( argval ).absoluteFilePath();
+         }
+         else {
+            // see if we have a logfile with at least R permissions:
+            argval = fileCheck( &errval, argval, true );
+         }
          m_startToolProcess = VGTOOL::PROC_PARSE_LOG;
       } break;
 
@@ -60,6 +60,9 @@ enum vkOptId {
    BIN_FLAGS,     // flags for user-binary
    VIEW_LOG,      // parse and view a valgrind logfile
    DFLT_LOGDIR,   // where to put our temporary logs
+   XML_PIPE,      // read valgrind's xml through a pipe (--xml-fd)
+   LAZY_LOG,      // log size (MB) from which logs aren't kept mapped
+   GROUP_DEPTH,   // top frames that group errors together
 
    NUM_OPTS
 };
@@ -307,10 +307,6 @@ void ValgrindOptionsPage::setupOptions()
    /* Disabled for now: Only supporting memcheck so far. */
    m_itemList[VALGRIND::TOOL       ]->setEnabled( false );
    
-   /* Disabled for now - can't deal with the multiple xml files this generates */
-   /* Note: Also disabled in Valgrind::checkOptArg() */
-   m_itemList[VALGRIND::TRACE_CH   ]->setEnabled( false );
-   
    /* Disabled - must be left on to generate clean XML */
    /* Note: Also disabled in Valgrind::checkOptArg() */
    m_itemList[VALGRIND::SILENT_CH  ]->setEnabled( false );
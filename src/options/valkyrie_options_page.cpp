@@ -112,6 +112,10 @@ void ValkyrieOptionsPage::setupOptions()
    insertOptionWidget( VALKYRIE::VG_EXEC, group1, false );  // ledit + button
    LeWidget* vgbinLedit = (( LeWidget* )m_itemList[VALKYRIE::VG_EXEC] );
    vgbinLedit->addButton( group1, this, SLOT( getVgExec() ) );
+
+   insertOptionWidget( VALKYRIE::XML_PIPE, group1, false );  // checkbox
+   insertOptionWidget( VALKYRIE::LAZY_LOG, group1, true );  // intspin
+   insertOptionWidget( VALKYRIE::GROUP_DEPTH, group1, true );  // intspin
    
    // general prefs - layout
    grid->addWidget( editLedit->button(), i, 0 );
@@ -124,6 +128,9 @@ void ValkyrieOptionsPage::setupOptions()
    grid->addWidget( dirLogSave->widget(), i++, 1, 1, 3 );
    grid->addWidget( vgbinLedit->button(), i, 0 );
    grid->addWidget( vgbinLedit->widget(), i++, 1, 1, 3 );
+   grid->addWidget( m_itemList[VALKYRIE::XML_PIPE]->widget(), i++, 0, 1, 4 );
+   grid->addLayout( m_itemList[VALKYRIE::LAZY_LOG]->hlayout(), i++, 0, 1, 4 );
+   grid->addLayout( m_itemList[VALKYRIE::GROUP_DEPTH]->hlayout(), i++, 0, 1, 4 );
    
    grid->addWidget( sep( group1 ), i++, 0, 1, 4 );
    
@@ -180,6 +187,26 @@ void ValkyrieOptionsPage::setupOptions()
                             "Don't save your own files here!" );
    dirLogSave->button()->setToolTip( tip_logdir );
    dirLogSave->widget()->setToolTip( tip_logdir );
+
+   QString tip_pipe = tr( "Tip: Valgrind writes its output straight to Valkyrie "
+                          "(--xml-fd), instead of to a file in the temporary "
+                          "directory.<br>"
+                          "The output is still copied there, for saving." );
+   m_itemList[VALKYRIE::XML_PIPE]->widget()->setToolTip( tip_pipe );
+
+   QString tip_lazy = tr( "Tip: the errors' xml is never kept in memory, just "
+                          "what's shown of them: it's read back from the log "
+                          "for copying or suppressions.  Smaller saved logs "
+                          "stay mapped for that, bigger ones are read from "
+                          "the file each time.<br>"
+                          "0: keep all logs mapped." );
+   m_itemList[VALKYRIE::LAZY_LOG]->widget()->setToolTip( tip_lazy );
+
+   QString tip_group = tr( "Tip: in the grouped view, errors of the same kind "
+                           "are one group if this many innermost frames of "
+                           "their first stack match.<br>"
+                           "Also set from the grouped view itself." );
+   m_itemList[VALKYRIE::GROUP_DEPTH]->widget()->setToolTip( tip_group );
 }
 
 
@@ -39,6 +39,10 @@ void showHelp( vkPoptContext con, char key, Valkyrie* vk )
 
    case 'h':
       vkPoptPrintHelp( con, stdout, vk->objectName().toLatin1().constData() );
+      // not a config option: main() takes it out before we parse
+      printf( "\nWithout the gui:\n"
+              "    --batch=<file>   summarise the --view-log logs to <file>"
+              " (.json|.csv, - for stdout)\n" );
       printf( "\n%s\n"
               "and licensed under the GNU General Public License, version 2.\n"
               "Bug reports, feedback, praise, abuse, etc, to <%s>\n",
@@ -67,16 +67,42 @@ SOURCES += \
     options/widgets/opt_le_widget.cpp \
     options/widgets/opt_sp_widget.cpp \
     options/widgets/opt_lb_widget.cpp \
+    toolview/errorgroupview.cpp \
+    toolview/flamegraphview.cpp \
     toolview/helgrindview.cpp \
     toolview/helgrind_logview.cpp \
+    toolview/leaksiteview.cpp \
+    toolview/logdiffview.cpp \
+    toolview/logviewfilter.cpp \
+    toolview/logviewfilter_hg.cpp \
     toolview/logviewfilter_mc.cpp \
     toolview/memcheckview.cpp \
     toolview/memcheck_logview.cpp \
+    toolview/processview.cpp \
     toolview/toolview.cpp \
     toolview/vglogview.cpp \
+    utils/vgcalltree.cpp \
+    utils/vgerrorxml.cpp \
+    utils/vgfingerprint.cpp \
+    utils/vgknownerrors.cpp \
+    utils/vglogbatch.cpp \
+    utils/vglogdiff.cpp \
     utils/vglogreader.cpp \
+    utils/vgloggroups.cpp \
+    utils/vglogleaks.cpp \
+    utils/vglogindex.cpp \
+    utils/vglogloader.cpp \
+    utils/vglogmerger.cpp \
+    utils/vglogsidecar.cpp \
+    utils/vglogparser.cpp \
+    utils/vglogquery.cpp \
+    utils/vglogstore.cpp \
+    utils/vgsrcinfo.cpp \
+    utils/vgsrcsnippets.cpp \
+    utils/vgxmltokenizer.cpp \
+    utils/vk_compress.cpp \
     utils/vk_config.cpp \
-    utils/vk_logpoller.cpp \
+    utils/vk_logsource.cpp \
     utils/vk_messages.cpp \
     utils/vk_utils.cpp \
     utils/vknewprojectdialog.cpp
@@ -110,18 +136,45 @@ HEADERS += \
     options/widgets/opt_le_widget.h \
     options/widgets/opt_sp_widget.h \
     options/widgets/opt_lb_widget.h \
+    toolview/errorgroupview.h \
+    toolview/flamegraphview.h \
     toolview/helgrindview.h \
     toolview/helgrind_logview.h \
+    toolview/leaksiteview.h \
+    toolview/logdiffview.h \
+    toolview/logviewfilter.h \
+    toolview/logviewfilter_hg.h \
     toolview/logviewfilter_mc.h \
     toolview/memcheckview.h \
     toolview/memcheck_logview.h \
+    toolview/processview.h \
     toolview/toolview.h \
     toolview/vglogview.h \
+    utils/vgcalltree.h \
+    utils/vgerrorxml.h \
+    utils/vgfingerprint.h \
+    utils/vgknownerrors.h \
+    utils/vglogbatch.h \
+    utils/vglogdiff.h \
     utils/vglogreader.h \
+    utils/vgloggroups.h \
+    utils/vglogleaks.h \
+    utils/vglogindex.h \
+    utils/vglogloader.h \
+    utils/vglogmerger.h \
+    utils/vglogsidecar.h \
+    utils/vglogparser.h \
+    utils/vglogquery.h \
+    utils/vglogstore.h \
+    utils/vgsrcinfo.h \
+    utils/vgsrcsnippets.h \
+    utils/vgxmltokenizer.h \
+    utils/vk_compress.h \
     utils/vk_config.h \
     utils/vk_defines.h \
-    utils/vk_logpoller.h \
+    utils/vk_logsource.h \
     utils/vk_messages.h \
+    utils/vk_spscqueue.h \
     utils/vk_utils.h \
     utils/vknewprojectdialog.h
 
@@ -0,0 +1,367 @@
+/****************************************************************************
+** ErrorGroupView implementation
+**  - the errors of a log, grouped by fingerprint
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "toolview/errorgroupview.h"
+#include "utils/vk_config.h"
+#include "utils/vk_utils.h"
+
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QStringList>
+#include <QVBoxLayout>
+
+
+/***************************************************************************/
+/*!
+  ErrorGroupModel
+   - internal ids: 0 for a group row, group + 1 for its error rows.
+*/
+ErrorGroupModel::ErrorGroupModel( VgLogView* logview, QObject* parent )
+   : QAbstractItemModel( parent ), m_logview( logview ),
+     m_groups( logview->store()->groups() ), m_active( false )
+{
+   connect( m_logview, SIGNAL( errorAdded( int ) ),
+            this,        SLOT( errorAdded( int ) ) );
+   connect( m_logview, SIGNAL( errorCountsChanged() ),
+            this,        SLOT( errorCountsChanged() ) );
+   connect( m_logview, SIGNAL( modelReset() ),
+            this,        SLOT( resetGroups() ) );
+}
+
+void ErrorGroupModel::resetGroups()
+{
+   beginResetModel();
+   shownErrors.resize( m_active ? m_groups.count() : 0 );
+   for ( int i = 0; i < shownErrors.count(); ++i ) {
+      shownErrors[i] = m_groups.group( i ).errors.count();
+   }
+   endResetModel();
+}
+
+void ErrorGroupModel::setActive( bool active )
+{
+   if ( active != m_active ) {
+      m_active = active;
+      resetGroups();
+   }
+}
+
+void ErrorGroupModel::regroup( int depth, VG_FPRINT::Key key )
+{
+   if ( depth == m_groups.depth() && key == m_groups.key() ) {
+      return;
+   }
+   m_logview->store()->regroup( depth, key );
+   resetGroups();
+}
+
+
+/*!
+  Errors come in one at a time, in order: so each is either the
+  first of a new group, or the next of an existing one.
+*/
+void ErrorGroupModel::errorAdded( int errIdx )
+{
+   if ( !m_active ) {
+      return;
+   }
+
+   int grp = m_groups.groupOf( errIdx );
+   if ( grp == shownErrors.count() ) {
+      beginInsertRows( QModelIndex(), grp, grp );
+      shownErrors.append( 1 );
+      endInsertRows();
+   }
+   else {
+      QModelIndex parent = index( grp, 0 );
+      int row = shownErrors.at( grp );
+      beginInsertRows( parent, row, row );
+      shownErrors[grp]++;
+      endInsertRows();
+      emit dataChanged( parent, index( grp, NUM_COLS - 1 ) );
+   }
+}
+
+void ErrorGroupModel::errorCountsChanged()
+{
+   if ( m_active && !shownErrors.isEmpty() ) {
+      emit dataChanged( index( 0, 0 ),
+                        index( shownErrors.count() - 1, NUM_COLS - 1 ) );
+   }
+}
+
+
+/*!
+  The error of a row: for a group, its first error.  -1 if none.
+*/
+int ErrorGroupModel::errorIndex( const QModelIndex& idx ) const
+{
+   if ( !idx.isValid() ) {
+      return -1;
+   }
+   int grp = ( int )idx.internalId() - 1;
+   if ( grp < 0 ) {
+      return m_groups.group( idx.row() ).firstError;
+   }
+   return m_groups.group( grp ).errors.at( idx.row() );
+}
+
+/*!
+  The top frames of the error's first stack, innermost first,
+  as they're told apart by the grouping.
+*/
+QString ErrorGroupModel::framesText( int errIdx ) const
+{
+   const VgLogStore& store = *m_logview->store();
+   const VgErrorRec& err = store.error( errIdx );
+   bool bySrc = ( m_groups.key() == VG_FPRINT::SRCLINE );
+
+   QStringList names;
+   quint32 c = ( err.numStacks > 0 ) ? store.stack( err.firstStack ).top : 0;
+   for ( int n = 0; c != 0 && n < m_groups.depth(); ++n, c = store.cell( c ).next ) {
+      const VgFrameRec& frm = store.frame( store.cell( c ).frame );
+      if ( bySrc && frm.file != 0 ) {
+         names << store.str( frm.file ) + ":" + QString::number( frm.line );
+      }
+      else if ( frm.fn != 0 ) {
+         names << store.str( frm.fn );
+      }
+      else if ( frm.obj != 0 ) {
+         names << "(within " + QFileInfo( store.str( frm.obj ) ).fileName() + ")";
+      }
+      else {
+         names << "???";
+      }
+   }
+   return names.join( " < " );
+}
+
+
+QModelIndex ErrorGroupModel::index( int row, int column,
+                                    const QModelIndex& parent ) const
+{
+   if ( column < 0 || column >= NUM_COLS || row < 0 ||
+        row >= rowCount( parent ) ) {
+      return QModelIndex();
+   }
+   quint32 id = parent.isValid() ? parent.row() + 1 : 0;
+   return createIndex( row, column, id );
+}
+
+QModelIndex ErrorGroupModel::parent( const QModelIndex& child ) const
+{
+   if ( !child.isValid() || child.internalId() == 0 ) {
+      return QModelIndex();
+   }
+   return createIndex( ( int )child.internalId() - 1, 0, ( quint32 )0 );
+}
+
+int ErrorGroupModel::rowCount( const QModelIndex& parent ) const
+{
+   if ( !parent.isValid() ) {
+      return shownErrors.count();
+   }
+   if ( parent.column() > 0 || parent.internalId() != 0 ) {
+      return 0;
+   }
+   return shownErrors.at( parent.row() );
+}
+
+int ErrorGroupModel::columnCount( const QModelIndex& ) const
+{
+   return NUM_COLS;
+}
+
+/*!
+  Numbers are given as numbers: sorting (by the view's proxy)
+  is then numeric.
+*/
+QVariant ErrorGroupModel::data( const QModelIndex& index, int role ) const
+{
+   if ( !index.isValid() ||
+        ( role != Qt::DisplayRole && role != Qt::TextAlignmentRole ) ) {
+      return QVariant();
+   }
+
+   bool numeric = ( index.column() >= COL_ERRORS );
+   if ( role == Qt::TextAlignmentRole ) {
+      return numeric ? ( int )( Qt::AlignRight | Qt::AlignVCenter )
+                     : ( int )( Qt::AlignLeft | Qt::AlignVCenter );
+   }
+
+   int errIdx = errorIndex( index );
+   const VgErrorRec& err = m_logview->store()->error( errIdx );
+
+   if ( index.internalId() == 0 ) {
+      const VgLogGroups::Group& grp = m_groups.group( index.row() );
+      switch ( index.column() ) {
+      case COL_GROUP:
+         return m_logview->acronym( grp.kind ) + ": " +
+                m_logview->store()->text( err.what );
+      case COL_FRAMES:
+         return framesText( errIdx );
+      case COL_ERRORS:
+         return shownErrors.at( index.row() );
+      case COL_COUNT:
+         return grp.count;
+      case COL_LEAKED:
+         return grp.leakedBytes;
+      default:
+         break;
+      }
+   }
+   else {
+      switch ( index.column() ) {
+      case COL_GROUP:
+         return m_logview->errorText( errIdx );
+      case COL_COUNT:
+         return err.count;
+      case COL_LEAKED:
+         return err.leakedBytes;
+      default:
+         break;
+      }
+   }
+   return QVariant();
+}
+
+QVariant ErrorGroupModel::headerData( int section, Qt::Orientation orientation,
+                                      int role ) const
+{
+   if ( orientation != Qt::Horizontal || role != Qt::DisplayRole ) {
+      return QVariant();
+   }
+   switch ( section ) {
+   case COL_GROUP:  return tr( "Group" );
+   case COL_FRAMES: return tr( "Top frames" );
+   case COL_ERRORS: return tr( "Errors" );
+   case COL_COUNT:  return tr( "Count" );
+   case COL_LEAKED: return tr( "Leaked bytes" );
+   default:         return QVariant();
+   }
+}
+
+
+
+/***************************************************************************/
+/*!
+  ErrorGroupView
+*/
+ErrorGroupView::ErrorGroupView( QWidget* parent )
+   : QWidget( parent ), model( 0 ), m_active( false )
+{
+   setObjectName( QString::fromUtf8( "ErrorGroupView" ) );
+
+   QVBoxLayout* vLayout = new QVBoxLayout( this );
+   vLayout->setMargin( 0 );
+
+   QHBoxLayout* hLayout = new QHBoxLayout();
+   hLayout->setMargin( 0 );
+
+   combo_key = new QComboBox( this );
+   combo_key->addItem( tr( "functions" ), VG_FPRINT::FUNCTION );
+   combo_key->addItem( tr( "source lines" ), VG_FPRINT::SRCLINE );
+   combo_key->setToolTip( tr( "What tells the errors' frames apart: "
+                              "their function and object, or their "
+                              "source file and line." ) );
+
+   spin_depth = new QSpinBox( this );
+   spin_depth->setRange( 1, 100 );
+   bool ok = false;
+   int depth = vkCfgProj->value( "valkyrie/group-depth" ).toInt( &ok );
+   spin_depth->setValue( ok ? depth : 4 );
+   spin_depth->setToolTip( tr( "The number of innermost frames of each "
+                               "error's first stack that must match, "
+                               "for errors of the same kind to be "
+                               "grouped together." ) );
+
+   hLayout->addWidget( new QLabel( tr( "Group errors by their top" ), this ) );
+   hLayout->addWidget( spin_depth );
+   hLayout->addWidget( combo_key );
+   hLayout->addStretch( 1 );
+
+   treeView = new QTreeView( this );
+   treeView->setObjectName( QString::fromUtf8( "treeview_ErrorGroups" ) );
+   treeView->setUniformRowHeights( true );
+   treeView->setSortingEnabled( true );
+   treeView->setAllColumnsShowFocus( true );
+
+   proxy = new QSortFilterProxyModel( this );
+   proxy->setDynamicSortFilter( true );
+   treeView->setModel( proxy );
+   treeView->sortByColumn( ErrorGroupModel::COL_COUNT, Qt::DescendingOrder );
+
+   vLayout->addLayout( hLayout );
+   vLayout->addWidget( treeView );
+
+   connect( spin_depth, SIGNAL( valueChanged( int ) ),
+            this,         SLOT( regroup() ) );
+   connect( combo_key,  SIGNAL( currentIndexChanged( int ) ),
+            this,         SLOT( regroup() ) );
+   connect( treeView,   SIGNAL( activated( const QModelIndex& ) ),
+            this,         SLOT( activated( const QModelIndex& ) ) );
+}
+
+/*!
+  A new log: the old model goes with the old logview.
+*/
+void ErrorGroupView::setLogView( VgLogView* logview )
+{
+   ErrorGroupModel* oldModel = model;
+
+   model = new ErrorGroupModel( logview, this );
+   proxy->setSourceModel( model );
+   regroup();
+   model->setActive( m_active );
+
+   delete oldModel;
+}
+
+void ErrorGroupView::setActive( bool active )
+{
+   m_active = active;
+   if ( model != 0 ) {
+      model->setActive( active );
+   }
+}
+
+void ErrorGroupView::regroup()
+{
+   int depth = spin_depth->value();
+   vkCfgProj->setValue( "valkyrie/group-depth", depth );
+
+   if ( model != 0 ) {
+      int key = combo_key->itemData( combo_key->currentIndex() ).toInt();
+      model->regroup( depth, ( VG_FPRINT::Key )key );
+      treeView->resizeColumnToContents( ErrorGroupModel::COL_GROUP );
+   }
+}
+
+void ErrorGroupView::activated( const QModelIndex& idx )
+{
+   if ( model != 0 ) {
+      int errIdx = model->errorIndex( proxy->mapToSource( idx ) );
+      if ( errIdx >= 0 ) {
+         emit errorActivated( errIdx );
+      }
+   }
+}
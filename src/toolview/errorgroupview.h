@@ -0,0 +1,121 @@
+/****************************************************************************
+** ErrorGroupView definition
+**  - the errors of a log, grouped by fingerprint
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __ERRORGROUPVIEW_H
+#define __ERRORGROUPVIEW_H
+
+#include "toolview/vglogview.h"
+#include "utils/vgloggroups.h"
+
+#include <QAbstractItemModel>
+#include <QComboBox>
+#include <QSortFilterProxyModel>
+#include <QSpinBox>
+#include <QTreeView>
+#include <QVector>
+#include <QWidget>
+
+
+// ============================================================
+/*!
+  ErrorGroupModel: the store's error groups (VgLogGroups) as rows,
+  with their errors under them.
+   - columns: the group (kind, what), its top frames, and the
+     number of errors, their count and leaked bytes.
+   - only kept up to date while active: errors arriving during
+     a live run are added as rows one by one.  Activating it
+     again just resets it: the groups themselves are always
+     up to date.
+   - filters don't apply: it's for seeing all of a log at once.
+*/
+class ErrorGroupModel : public QAbstractItemModel
+{
+   Q_OBJECT
+public:
+   enum Column { COL_GROUP, COL_FRAMES, COL_ERRORS, COL_COUNT,
+                 COL_LEAKED, NUM_COLS };
+
+   ErrorGroupModel( VgLogView* logview, QObject* parent );
+
+   void setActive( bool active );
+   void regroup( int depth, VG_FPRINT::Key key );
+   int errorIndex( const QModelIndex& idx ) const;
+
+   // QAbstractItemModel
+   QModelIndex index( int row, int column,
+                      const QModelIndex& parent = QModelIndex() ) const;
+   QModelIndex parent( const QModelIndex& child ) const;
+   int rowCount( const QModelIndex& parent = QModelIndex() ) const;
+   int columnCount( const QModelIndex& parent = QModelIndex() ) const;
+   QVariant data( const QModelIndex& index, int role = Qt::DisplayRole ) const;
+   QVariant headerData( int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole ) const;
+
+private slots:
+   void resetGroups();
+   void errorAdded( int errIdx );
+   void errorCountsChanged();
+
+private:
+   QString framesText( int errIdx ) const;
+
+private:
+   VgLogView* m_logview;          // we don't own this
+   const VgLogGroups& m_groups;
+   bool m_active;
+   QVector<int> shownErrors;      // group -> rows of errors under it
+};
+
+
+
+// ============================================================
+/*!
+  ErrorGroupView: the group rows, and how to group.
+   - regrouping is interactive: the depth and key take effect
+     as soon as they're changed.
+   - activating an error (or a group: its first error) asks
+     the tool view to show it in the log.
+*/
+class ErrorGroupView : public QWidget
+{
+   Q_OBJECT
+public:
+   ErrorGroupView( QWidget* parent );
+
+   void setLogView( VgLogView* logview );
+   void setActive( bool active );
+
+signals:
+   void errorActivated( int errIdx );
+
+private slots:
+   void regroup();
+   void activated( const QModelIndex& idx );
+
+private:
+   QComboBox* combo_key;
+   QSpinBox*  spin_depth;
+   QTreeView* treeView;
+   QSortFilterProxyModel* proxy;
+   ErrorGroupModel* model;
+   bool m_active;
+};
+
+#endif // #ifndef __ERRORGROUPVIEW_H
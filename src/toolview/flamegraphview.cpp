@@ -0,0 +1,425 @@
+/****************************************************************************
+** FlameGraphView implementation
+**  - a log's error and leak stacks, as an icicle graph of call paths
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "toolview/flamegraphview.h"
+#include "utils/vk_utils.h"
+
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QHelpEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QStringList>
+#include <QToolTip>
+#include <QVBoxLayout>
+
+
+// narrower than this (pixels), a node isn't drawn, nor its children
+static const qreal MIN_WIDTH = 1.0;
+
+// repainting during a live run: at most this often (ms)
+static const int UPDATE_INTERVAL = 250;
+
+
+/***************************************************************************/
+/*!
+  FlameGraph
+*/
+FlameGraph::FlameGraph( QWidget* parent )
+   : QWidget( parent ), m_tree( 0 ), m_store( 0 ), m_zoom( 0 )
+{
+   setObjectName( QString::fromUtf8( "FlameGraph" ) );
+   setBackgroundRole( QPalette::Base );
+   setAutoFillBackground( true );
+   rowHeight = fontMetrics().height() + 4;
+}
+
+/*!
+  A new tree: shown from its root.
+*/
+void FlameGraph::setTree( const VgCallTree* tree, const VgLogStore* store )
+{
+   m_tree  = tree;
+   m_store = store;
+   m_zoom  = 0;
+   emit zoomed( m_zoom );
+   treeChanged();
+}
+
+/*!
+  The tree has grown: it only ever grows, so the zoom holds.
+*/
+void FlameGraph::treeChanged()
+{
+   setMinimumHeight( numRows() * rowHeight );
+   updateGeometry();
+   update();
+}
+
+int FlameGraph::numRows() const
+{
+   if ( m_tree == 0 ) {
+      return 1;
+   }
+   return m_tree->maxDepth() - m_tree->node( m_zoom ).depth + 1;
+}
+
+QSize FlameGraph::sizeHint() const
+{
+   return QSize( 400, numRows() * rowHeight );
+}
+
+
+void FlameGraph::zoomTo( int node )
+{
+   if ( m_tree != 0 && node >= 0 && node != m_zoom ) {
+      m_zoom = node;
+      emit zoomed( m_zoom );
+      treeChanged();
+   }
+}
+
+void FlameGraph::zoomOut()
+{
+   if ( m_tree != 0 && m_zoom != 0 ) {
+      zoomTo( m_tree->node( m_zoom ).parent );
+   }
+}
+
+
+/*!
+  A node's function: else its object, else what we know.
+*/
+QString FlameGraph::label( int node ) const
+{
+   if ( node == 0 ) {
+      return ( m_tree->weight() == VG_CALLTREE::LEAKED ) ? tr( "all leaks" )
+                                                         : tr( "all errors" );
+   }
+   const VgCallTree::Node& n = m_tree->node( node );
+   if ( n.fn != 0 ) {
+      return m_store->str( n.fn );
+   }
+   if ( n.obj != 0 ) {
+      return "(within " + QFileInfo( m_store->str( n.obj ) ).fileName() + ")";
+   }
+   return "???";
+}
+
+/*!
+  Warm colours, the same for a function wherever it's called from:
+  a hot function stands out as one colour.
+*/
+QColor FlameGraph::colour( int node ) const
+{
+   if ( node == 0 ) {
+      return palette().color( QPalette::Button );
+   }
+   const VgCallTree::Node& n = m_tree->node( node );
+   uint h = qHash( ( n.fn != 0 ) ? n.fn : n.obj );
+   return QColor::fromHsv( h % 50, 120 + ( h >> 8 ) % 100, 240 );
+}
+
+
+void FlameGraph::paintEvent( QPaintEvent* ev )
+{
+   if ( m_tree == 0 || m_tree->node( m_zoom ).weight == 0 ) {
+      return;
+   }
+   QPainter p( this );
+   p.setClipRect( ev->rect() );
+   paintNode( p, m_zoom, 0, width(), 0, ev->rect() );
+}
+
+/*!
+  The node at row, spanning x to x + w, then its children below it,
+  side by side, in proportion to their weights.
+   - what's left of a node's width, past its children, is weight
+     of errors whose stacks end there.
+*/
+void FlameGraph::paintNode( QPainter& p, int node, qreal x, qreal w, int row,
+                            const QRect& clip )
+{
+   int y = row * rowHeight;
+   if ( y > clip.bottom() ) {
+      return;
+   }
+
+   // rows above the area being repainted: not drawn, but their
+   // children may be
+   if ( y + rowHeight > clip.top() ) {
+      QRectF rect( x, y, w, rowHeight - 1 );
+      p.fillRect( rect, colour( node ) );
+      if ( w > 3 * MIN_WIDTH ) {
+         p.setPen( palette().color( QPalette::Mid ) );
+         p.drawRect( rect );
+      }
+      if ( w > rowHeight ) {
+         QString txt = fontMetrics().elidedText( label( node ), Qt::ElideRight,
+                                                 ( int )w - 4 );
+         p.setPen( Qt::black );
+         p.drawText( rect.adjusted( 2, 0, -2, 0 ),
+                     Qt::AlignLeft | Qt::AlignVCenter, txt );
+      }
+   }
+
+   const VgCallTree::Node& n = m_tree->node( node );
+   qreal cx = x;
+   for ( int c = n.firstChild; c >= 0; c = m_tree->node( c ).nextSibling ) {
+      qreal cw = w * m_tree->node( c ).weight / n.weight;
+      if ( cw >= MIN_WIDTH ) {
+         paintNode( p, c, cx, cw, row + 1, clip );
+      }
+      cx += cw;
+   }
+}
+
+/*!
+  The node drawn at pos: -1 if none.
+*/
+int FlameGraph::nodeAt( const QPoint& pos ) const
+{
+   if ( m_tree == 0 || m_tree->node( m_zoom ).weight == 0 ) {
+      return -1;
+   }
+
+   int row = pos.y() / rowHeight;
+   int node = m_zoom;
+   qreal x = 0, w = width();
+   for ( int r = 0; r < row; ++r ) {
+      const VgCallTree::Node& n = m_tree->node( node );
+      int found = -1;
+      qreal cx = x;
+      for ( int c = n.firstChild; c >= 0; c = m_tree->node( c ).nextSibling ) {
+         qreal cw = w * m_tree->node( c ).weight / n.weight;
+         if ( cw >= MIN_WIDTH && pos.x() >= cx && pos.x() < cx + cw ) {
+            found = c;
+            x = cx;
+            w = cw;
+            break;
+         }
+         cx += cw;
+      }
+      if ( found < 0 ) {
+         return -1;
+      }
+      node = found;
+   }
+   return node;
+}
+
+
+/*!
+  Tooltips: the node under the mouse, and its share of the weight.
+*/
+bool FlameGraph::event( QEvent* ev )
+{
+   if ( ev->type() == QEvent::ToolTip ) {
+      QHelpEvent* help = static_cast<QHelpEvent*>( ev );
+      int node = nodeAt( help->pos() );
+      if ( node < 0 ) {
+         QToolTip::hideText();
+         ev->ignore();
+         return true;
+      }
+      quint64 weight = m_tree->node( node ).weight;
+      quint64 total  = m_tree->node( 0 ).weight;
+      QString what = ( m_tree->weight() == VG_CALLTREE::LEAKED )
+                     ? tr( "bytes leaked" ) : tr( "errors" );
+      QToolTip::showText( help->globalPos(),
+                          tr( "%1\n%2 %3 (%4% of all)" )
+                          .arg( label( node ) )
+                          .arg( weight )
+                          .arg( what )
+                          .arg( 100.0 * weight / total, 0, 'f', 1 ),
+                          this );
+      return true;
+   }
+   return QWidget::event( ev );
+}
+
+void FlameGraph::mousePressEvent( QMouseEvent* ev )
+{
+   if ( ev->button() == Qt::LeftButton ) {
+      zoomTo( nodeAt( ev->pos() ) );
+   }
+   else if ( ev->button() == Qt::RightButton ) {
+      zoomOut();
+   }
+   else {
+      QWidget::mousePressEvent( ev );
+   }
+}
+
+
+
+/***************************************************************************/
+/*!
+  FlameGraphView
+*/
+FlameGraphView::FlameGraphView( QWidget* parent )
+   : QWidget( parent ), m_logview( 0 ), m_active( false )
+{
+   setObjectName( QString::fromUtf8( "FlameGraphView" ) );
+
+   QVBoxLayout* vLayout = new QVBoxLayout( this );
+   vLayout->setMargin( 0 );
+
+   QHBoxLayout* hLayout = new QHBoxLayout();
+   hLayout->setMargin( 0 );
+
+   combo_root = new QComboBox( this );
+   combo_root->addItem( tr( "callers, from main" ), VG_CALLTREE::CALLERS );
+   combo_root->addItem( tr( "callees, from the innermost frames" ),
+                        VG_CALLTREE::CALLEES );
+   combo_root->setToolTip( tr( "Which end of the stacks the graph grows "
+                               "from: main, or the functions the errors "
+                               "happened in (for leaks: the allocation "
+                               "functions)." ) );
+
+   combo_weight = new QComboBox( this );
+   combo_weight->addItem( tr( "error counts" ), VG_CALLTREE::COUNT );
+   combo_weight->addItem( tr( "leaked bytes" ), VG_CALLTREE::LEAKED );
+
+   btn_unzoom = new QPushButton( tr( "Reset zoom" ), this );
+   btn_unzoom->setToolTip( tr( "Show the whole graph again.  Click on a "
+                               "function to zoom in to it, right-click "
+                               "to zoom out." ) );
+
+   hLayout->addWidget( new QLabel( tr( "Call paths of" ), this ) );
+   hLayout->addWidget( combo_root );
+   hLayout->addWidget( new QLabel( tr( "weighed by" ), this ) );
+   hLayout->addWidget( combo_weight );
+   hLayout->addWidget( btn_unzoom );
+   hLayout->addStretch( 1 );
+
+   lbl_path = new QLabel( this );
+   lbl_path->setTextInteractionFlags( Qt::TextSelectableByMouse );
+
+   graph = new FlameGraph( this );
+   scrollArea = new QScrollArea( this );
+   scrollArea->setWidgetResizable( true );
+   scrollArea->setWidget( graph );
+
+   vLayout->addLayout( hLayout );
+   vLayout->addWidget( lbl_path );
+   vLayout->addWidget( scrollArea );
+
+   updateTimer.setSingleShot( true );
+   updateTimer.setInterval( UPDATE_INTERVAL );
+   connect( &updateTimer, SIGNAL( timeout() ),
+            graph,          SLOT( treeChanged() ) );
+   connect( combo_root,   SIGNAL( currentIndexChanged( int ) ),
+            this,           SLOT( rebuild() ) );
+   connect( combo_weight, SIGNAL( currentIndexChanged( int ) ),
+            this,           SLOT( rebuild() ) );
+   connect( btn_unzoom,   SIGNAL( clicked() ),
+            this,           SLOT( resetZoom() ) );
+   connect( graph,        SIGNAL( zoomed( int ) ),
+            this,           SLOT( showZoomed( int ) ) );
+}
+
+/*!
+  A new log: the graph follows it.
+*/
+void FlameGraphView::setLogView( VgLogView* logview )
+{
+   if ( m_logview != 0 ) {
+      m_logview->disconnect( this );
+   }
+   m_logview = logview;
+
+   connect( m_logview, SIGNAL( errorAdded( int ) ),
+            this,        SLOT( errorAdded( int ) ) );
+   connect( m_logview, SIGNAL( errorCountsChanged() ),
+            this,        SLOT( errorCountsChanged() ) );
+   connect( m_logview, SIGNAL( modelReset() ),
+            this,        SLOT( rebuild() ) );
+   rebuild();
+}
+
+/*!
+  Inactive, the tree's let go: it's built again when wanted.
+*/
+void FlameGraphView::setActive( bool active )
+{
+   if ( active != m_active ) {
+      m_active = active;
+      rebuild();
+   }
+}
+
+/*!
+  Build the tree afresh, from the store's records: no re-parsing.
+*/
+void FlameGraphView::rebuild()
+{
+   int root   = combo_root->itemData( combo_root->currentIndex() ).toInt();
+   int weight = combo_weight->itemData( combo_weight->currentIndex() ).toInt();
+   tree.setup( ( VG_CALLTREE::Root )root, ( VG_CALLTREE::Weight )weight );
+
+   if ( m_active && m_logview != 0 && m_logview->store()->numErrors() > 0 ) {
+      const VgLogStore& store = *m_logview->store();
+      tree.addError( store.numErrors() - 1, store );
+   }
+   graph->setTree( &tree, m_logview ? m_logview->store() : 0 );
+}
+
+/*!
+  Errors come in one at a time: add each to the tree now (cheap),
+  but repaint them all together, later.
+*/
+void FlameGraphView::errorAdded( int errIdx )
+{
+   if ( !m_active ) {
+      return;
+   }
+   tree.addError( errIdx, *m_logview->store() );
+   if ( !updateTimer.isActive() ) {
+      updateTimer.start();
+   }
+}
+
+void FlameGraphView::errorCountsChanged()
+{
+   if ( m_active ) {
+      tree.updateCounts( *m_logview->store() );
+      graph->treeChanged();
+   }
+}
+
+/*!
+  The path to the node shown at the top.
+*/
+void FlameGraphView::showZoomed( int node )
+{
+   QStringList path;
+   for ( int n = node; n > 0; n = tree.node( n ).parent ) {
+      path.prepend( graph->label( n ) );
+   }
+   lbl_path->setText( path.isEmpty() ? QString() : path.join( " > " ) );
+   btn_unzoom->setEnabled( node != 0 );
+}
+
+void FlameGraphView::resetZoom()
+{
+   graph->zoomTo( 0 );
+}
@@ -0,0 +1,123 @@
+/****************************************************************************
+** FlameGraphView definition
+**  - a log's error and leak stacks, as an icicle graph of call paths
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __FLAMEGRAPHVIEW_H
+#define __FLAMEGRAPHVIEW_H
+
+#include "toolview/vglogview.h"
+#include "utils/vgcalltree.h"
+
+#include <QComboBox>
+#include <QLabel>
+#include <QPushButton>
+#include <QScrollArea>
+#include <QTimer>
+#include <QWidget>
+
+
+// ============================================================
+/*!
+  FlameGraph: draws a VgCallTree, root at the top: each node as
+  wide as its share of its parent's weight.
+   - only what's at least a pixel wide, and in the area being
+     repainted, is drawn: however big the tree, a paint costs
+     no more than the pixels it fills.
+   - click on a node to zoom in to it, right-click to zoom out.
+*/
+class FlameGraph : public QWidget
+{
+   Q_OBJECT
+public:
+   FlameGraph( QWidget* parent );
+
+   void setTree( const VgCallTree* tree, const VgLogStore* store );
+   QString label( int node ) const;
+
+   QSize sizeHint() const;
+
+public slots:
+   void treeChanged();
+   void zoomTo( int node );
+   void zoomOut();
+
+signals:
+   void zoomed( int node );
+
+protected:
+   bool event( QEvent* ev );
+   void paintEvent( QPaintEvent* ev );
+   void mousePressEvent( QMouseEvent* ev );
+
+private:
+   void paintNode( QPainter& p, int node, qreal x, qreal w, int row,
+                   const QRect& clip );
+   int nodeAt( const QPoint& pos ) const;
+   QColor colour( int node ) const;
+   int numRows() const;
+
+private:
+   const VgCallTree* m_tree;      // we don't own these
+   const VgLogStore* m_store;
+   int m_zoom;                    // the node drawn as the top row
+   int rowHeight;
+};
+
+
+
+// ============================================================
+/*!
+  FlameGraphView: the graph, and how to build it.
+   - grown as errors come in, while active: repainted a little
+     later, all in one go.  Built afresh when activated.
+   - the tree grows from main (callers), or from the innermost
+     frames (callees: e.g. the allocation functions), and is
+     weighed by error counts or leaked bytes.
+*/
+class FlameGraphView : public QWidget
+{
+   Q_OBJECT
+public:
+   FlameGraphView( QWidget* parent );
+
+   void setLogView( VgLogView* logview );
+   void setActive( bool active );
+
+private slots:
+   void rebuild();
+   void errorAdded( int errIdx );
+   void errorCountsChanged();
+   void showZoomed( int node );
+   void resetZoom();
+
+private:
+   QComboBox*   combo_root;
+   QComboBox*   combo_weight;
+   QPushButton* btn_unzoom;
+   QLabel*      lbl_path;
+   QScrollArea* scrollArea;
+   FlameGraph*  graph;
+
+   VgLogView* m_logview;          // we don't own this
+   VgCallTree tree;
+   QTimer updateTimer;
+   bool m_active;
+};
+
+#endif // #ifndef __FLAMEGRAPHVIEW_H
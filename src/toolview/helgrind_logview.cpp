@@ -1,6 +1,6 @@
 /****************************************************************************
 ** HelgrindLogView implementation
-**  - links QDomElements with QTreeWidgetItems
+**  - tool-specific parts of the log model
 ** --------------------------------------------------------------------------
 **
 ** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
@@ -21,14 +21,16 @@
 #include "toolview/helgrind_logview.h"
 #include "utils/vk_utils.h"
 
+#include <QRegExp>
+
 
 // ============================================================
 /*!
   setup static class maps
 */
-static ErrorItem::AcronymMap setupErrAcronymMap()
+static VgLogView::AcronymMap setupErrAcronymMap()
 {
-   ErrorItem::AcronymMap amap;
+   VgLogView::AcronymMap amap;
    amap["Race"]           = "RAC"; // Data race.
    amap["UnlockUnlocked"] = "ULU"; // Unlocking a not-locked lock
    amap["UnlockForeign"]  = "ULF"; // Unlocking a lock held by some other thread
@@ -38,33 +40,27 @@ static ErrorItem::AcronymMap setupErrAcronymMap()
    amap["Misc"]           = "MSC"; // Misc.
    return amap;
 }
-ErrorItem::AcronymMap ErrorItemHG::acnymMap = setupErrAcronymMap();
-
 
-// ============================================================
-/*!
-  ErrorItem for Helgrind
-*/
-ErrorItemHG::ErrorItemHG( VgOutputItem* parent, QTreeWidgetItem* after,
-                          QDomElement err )
-      : ErrorItem( parent, after, err, acnymMap )
+const VgLogView::AcronymMap& HelgrindLogView::acronyms()
 {
+   static const AcronymMap acnymMap = setupErrAcronymMap();
+   return acnymMap;
 }
 
 
 
 // ============================================================
 /*!
-  TopStatus: first item in listview
+  TopStatus: first row in the view
 */
-TopStatusItemHG::TopStatusItemHG( QTreeWidget* parent, QDomElement exe,
-                                  QDomElement status, QString _protocol )
-   : TopStatusItem( parent, exe, status, "", _protocol )
+TopStatusHG::TopStatusHG( const QString& exe, const VgLogRecord& status,
+                          QString _protocol )
+   : TopStatus( exe, status, "", _protocol )
 {
 }
 
 
-void TopStatusItemHG::updateToolStatus( QDomElement /*err*/ )
+void TopStatusHG::updateToolStatus( const VgLogRecord& /*err*/ )
 {
    // Update general error count
    // Note: this may be _way_ off, 'cos we don't see repeated errors
@@ -75,60 +71,12 @@ void TopStatusItemHG::updateToolStatus( QDomElement /*err*/ )
 
 
 
-// ============================================================
-/*!
-  AnnounceThreadItem
-
-  The relative position in the log does not reflect the actual
-  thread creation point - this is simply when Helgrind 'announces' it,
-  for use in a subsequent ERROR.
-
-  TODO: put that in a tooltip, or sthng.
-*/
-AnnounceThreadItem::AnnounceThreadItem( VgOutputItem* parent,
-                                        QTreeWidgetItem* after,
-                                        QDomElement err )
-: VgOutputItem( parent, after, err )
-{
-
-   QDomElement hthreadid = elem.firstChildElement();
-#ifdef DEBUG_ON
-   if ( hthreadid.tagName() != "hthreadid" ) {
-      vkPrintErr( "AnnounceThreadItem::AnnounceThreadItem(): unexpected tagName: %s",
-                  qPrintable( hthreadid.tagName() ) );
-   }
-#endif
-   QString hthreadid_str = hthreadid.text();
-   setText( "Thread Announce: #HG_" + hthreadid_str );
-
-   isExpandable = true;
-}
-
-
-void AnnounceThreadItem::setupChildren()
-{
-   if ( childCount() == 0 ) {
-      QDomElement e = elem.firstChildElement();
-      e = e.nextSiblingElement();
-#ifdef DEBUG_ON
-      if ( e.tagName() != "stack" ) {
-         vkPrintErr( "AnnounceThreadItem::setupChildren(): unexpected tagName: %s",
-                     qPrintable( e.tagName() ) );
-      }
-#endif
-      VgOutputItem* stack = new StackItem( this, this, e );
-      stack->openChildren();
-   }
-}
-
-
-
 // ============================================================
 /*!
   HelgrindLogView
 */
-HelgrindLogView::HelgrindLogView( QTreeWidget* view )
-   : VgLogView( view )
+HelgrindLogView::HelgrindLogView()
+   : VgLogView( acronyms() )
 {}
 
 HelgrindLogView::~HelgrindLogView()
@@ -156,18 +104,82 @@ void HelgrindLogView::updateThreadId( QDomElement elem )
    n.setNodeValue( n.nodeValue().replace( "hread #", "hread #HG_" ) );
 }
 
+/*!
+  all the thread id descriptions of an error
+*/
+void HelgrindLogView::updateThreadIds( QDomElement err )
+{
+   updateThreadId( err.firstChildElement( "xwhat" ).firstChildElement( "text" ) );
+   updateThreadId( err.firstChildElement( "xauxwhat" ).firstChildElement( "text" ) );
+   updateThreadId( err.firstChildElement( "what" ) );
+   updateThreadId( err.firstChildElement( "auxwhat" ) );
+}
+
+/*!
+  an error's element, read back after all: as for its record
+*/
+void HelgrindLogView::errorElementLoaded( QDomElement err ) const
+{
+   updateThreadIds( err );
+}
+
+/*!
+  as for the elements, for the record of an error.
+*/
+void HelgrindLogView::updateThreadId( VgLogRecord& rec )
+{
+   rec.what.replace( "hread #", "hread #HG_" );
+   rec.xwhat.replace( "hread #", "hread #HG_" );
+
+   for ( int i = 0; i < rec.details.count(); ++i ) {
+      VgLogDetail& det = rec.details[i];
+      if ( det.type == VG_ELEM::WHAT  || det.type == VG_ELEM::AUXWHAT ||
+           det.type == VG_ELEM::XWHAT || det.type == VG_ELEM::XAUXWHAT ) {
+         det.text.replace( "hread #", "hread #HG_" );
+      }
+   }
+}
+
+
+/*!
+  Lock addresses mentioned by an error, for filtering.
+   - helgrind only gives them in the text:
+     e.g. "Lock at 0x601060 was first observed",
+          "lock order \"0x601060 before 0x6010A0\" violated"
+*/
+void HelgrindLogView::findLockAddrs( VgLogRecord& rec )
+{
+   static const QRegExp rxAddr( "0x[0-9a-fA-F]+" );
+
+   for ( int i = 0; i < rec.details.count(); ++i ) {
+      const VgLogDetail& det = rec.details.at( i );
+      if ( det.type == VG_ELEM::STACK || det.type == VG_ELEM::TID ||
+           !det.text.contains( "lock", Qt::CaseInsensitive ) ) {
+         continue;
+      }
+      int pos = 0;
+      while ( ( pos = rxAddr.indexIn( det.text, pos ) ) != -1 ) {
+         quint64 addr = rxAddr.cap( 0 ).toULongLong( 0, 0 );
+         if ( !rec.lockAddrs.contains( addr ) ) {
+            rec.lockAddrs.append( addr );
+         }
+         pos += rxAddr.matchedLength();
+      }
+   }
+}
+
 
 /*!
-  Populate our model (QDomDocument) and the view (QListWidget)
-   - top-level xml elements are pushed to us from the parser
-   - node is reparented to the QDomDocument log
+  Populate our model: helgrind's part
+   - the records of top-level xml elements are pushed to us
+     from the parser
 */
-bool HelgrindLogView::appendNodeTool( QDomElement elem, QString& errMsg )
+bool HelgrindLogView::appendNodeTool( VgLogRecord& rec, QString& errMsg )
 {
-   switch ( VgOutputItem::elemType( elem.tagName() ) ) {
+   switch ( rec.type ) {
    case VG_ELEM::PROTOCOL_VERSION : {
-      if ( elem.text() != "4" ) {
-         errMsg = "Helgrind tool doesn't support XML protocol version: (" + elem.text() + ")";
+      if ( rec.text != "4" ) {
+         errMsg = "Helgrind tool doesn't support XML protocol version: (" + rec.text + ")";
          vkPrintErr( "%s", qPrintable( "HelgrindLogView::appendNodeTool(): " + errMsg ) );
          return false;
       }
@@ -175,24 +187,37 @@ bool HelgrindLogView::appendNodeTool( QDomElement elem, QString& errMsg )
    }
 
    case VG_ELEM::ERROR: {
-      QDomElement err = elem;
-
       // update thread id description, to distinguish from real thread id's.
-      updateThreadId( err.firstChildElement( "xwhat" ).firstChildElement( "text" ) );
-      updateThreadId( err.firstChildElement( "xauxwhat" ).firstChildElement( "text" ) );
-      updateThreadId( err.firstChildElement( "what" ) );
-      updateThreadId( err.firstChildElement( "auxwhat" ) );
+      // (the element, if it's ever read back: errorElementLoaded())
+      updateThreadId( rec );
+      findLockAddrs( rec );
 
-      lastItem = new ErrorItemHG( topStatus, lastItem, err );
+      int idx = store()->addError( rec );
+      appendError( idx );
 
       // update topStatus
-      topStatus->updateToolStatus( err );
+      if ( topStatus != 0 ) {
+         topStatus->updateToolStatus( rec );
+      }
       break;
    }
 
    case VG_ELEM::ANNOUNCETHREAD: {
-      QDomElement announcethread = elem;
-      lastItem = new AnnounceThreadItem( topStatus, lastItem, announcethread );
+      // The relative position in the log does not reflect the actual
+      // thread creation point - this is simply when Helgrind 'announces' it,
+      // for use in a subsequent ERROR.
+      // TODO: put that in a tooltip, or sthng.
+#ifdef DEBUG_ON
+      if ( rec.hthreadid.isEmpty() ) {
+         vkPrintErr( "HelgrindLogView::appendNodeTool(): missing hthreadid" );
+      }
+      if ( rec.stacks.isEmpty() ) {
+         vkPrintErr( "HelgrindLogView::appendNodeTool(): missing stack" );
+      }
+#endif
+      int stackIdx = rec.stacks.isEmpty() ? -1 : store()->addStacks( rec );
+      appendAnnounceThread( rec, "Thread Announce: #HG_" + rec.hthreadid,
+                            stackIdx );
       break;
    }
 
@@ -204,11 +229,10 @@ bool HelgrindLogView::appendNodeTool( QDomElement elem, QString& errMsg )
 }
 
 
-TopStatusItem* HelgrindLogView::createTopStatus( QTreeWidget* view,
-                                                 QDomElement exe,
-                                                 QDomElement status,
-                                                 QString _protocol )
+TopStatus* HelgrindLogView::createTopStatus( const QString& exe,
+                                             const VgLogRecord& status,
+                                             QString _protocol )
 {
-   return new TopStatusItemHG( view, exe, status, _protocol );
+   return new TopStatusHG( exe, status, _protocol );
 }
 
@@ -1,6 +1,6 @@
 /****************************************************************************
 ** MemcheckLogView definition
-**  - links QDomElements with QTreeWidgetItems
+**  - tool-specific parts of the log model
 ** --------------------------------------------------------------------------
 **
 ** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
@@ -27,58 +27,39 @@
 // ============================================================
 class HelgrindLogView : public VgLogView
 {
+   Q_OBJECT
 public:
-   HelgrindLogView( QTreeWidget* );
+   HelgrindLogView();
    ~HelgrindLogView();
 
+   // error::kind -> three-letter acronym
+   static const AcronymMap& acronyms();
+
 private:
-   void updateThreadId( QDomElement elem );
+   static void updateThreadIds( QDomElement err );
+   static void updateThreadId( QDomElement elem );
+   void updateThreadId( VgLogRecord& rec );
+   void findLockAddrs( VgLogRecord& rec );
 
    // Template method functions:
-   TopStatusItem* createTopStatus( QTreeWidget* view, QDomElement exe,
-                                   QDomElement status, QString _protocol );
+   TopStatus* createTopStatus( const QString& exe, const VgLogRecord& status,
+                               QString _protocol );
    QString toolName();
-   bool appendNodeTool( QDomElement elem, QString& errMsg );
-};
-
-
-
-
-
-// ============================================================
-class ErrorItemHG : public ErrorItem
-{
-public:
-   ErrorItemHG( VgOutputItem* parent, QTreeWidgetItem* after,
-                QDomElement err );
-private:
-   static ErrorItem::AcronymMap acnymMap;
+   bool appendNodeTool( VgLogRecord& rec, QString& errMsg );
+   void errorElementLoaded( QDomElement err ) const;
 };
 
 
 
 
 // ============================================================
-class TopStatusItemHG : public TopStatusItem
-{
-public:
-   TopStatusItemHG( QTreeWidget* parent, QDomElement exe,
-                    QDomElement status, QString _protocol );
-
-   void updateToolStatus( QDomElement err );
-};
-
-
-
-// ============================================================
-class AnnounceThreadItem : public VgOutputItem
+class TopStatusHG : public TopStatus
 {
 public:
-   AnnounceThreadItem( VgOutputItem* parent, QTreeWidgetItem* after,
-                       QDomElement err );
+   TopStatusHG( const QString& exe, const VgLogRecord& status,
+                QString _protocol );
 
-private:
-   void setupChildren(); // called by base class
+   void updateToolStatus( const VgLogRecord& err );
 };
 
 
@@ -26,6 +26,7 @@
 
 #include <QAction>
 #include <QApplication>
+#include <QItemSelectionModel>
 #include <QLabel>
 #include <QMenuBar>
 #include <QProcess>
@@ -69,21 +70,17 @@ HelgrindView::HelgrindView( QWidget* parent )
    setupActions();
    setupToolBar();
 
-   // enable | disable show*Item buttons
-   connect( treeView, SIGNAL( itemSelectionChanged() ),
-            this,       SLOT( updateItemActions() ) );
-
    // on collapsing a branch, reset currentItem to branch head.
-   connect( treeView, SIGNAL( itemCollapsed( QTreeWidgetItem* ) ),
-            this,       SLOT( itemCollapsed( QTreeWidgetItem* ) ) );
+   connect( treeView, SIGNAL( collapsed( const QModelIndex& ) ),
+            this,       SLOT( itemCollapsed( const QModelIndex& ) ) );
 
-   // load items on-demand
-   connect( treeView, SIGNAL( itemExpanded( QTreeWidgetItem* ) ),
-            this,       SLOT( itemExpanded( QTreeWidgetItem* ) ) );
+   // open the rows that open with their parent
+   connect( treeView, SIGNAL( expanded( const QModelIndex& ) ),
+            this,       SLOT( itemExpanded( const QModelIndex& ) ) );
 
    // launch editor with src file loaded
-   connect( treeView, SIGNAL( itemDoubleClicked( QTreeWidgetItem*, int ) ),
-            this,       SLOT( launchEditor( QTreeWidgetItem* ) ) );
+   connect( treeView, SIGNAL( doubleClicked( const QModelIndex& ) ),
+            this,       SLOT( launchEditor( const QModelIndex& ) ) );
 }
 
 
@@ -92,10 +89,9 @@ HelgrindView::HelgrindView( QWidget* parent )
 */
 HelgrindView::~HelgrindView()
 {
-   if ( logview != 0 ) {
-      delete logview;
-      logview = 0;
-   }
+   qDeleteAll( logviews );
+   logviews.clear();
+   logview = 0;
 }
 
 
@@ -109,12 +105,59 @@ HelgrindView::~HelgrindView()
 */
 VgLogView* HelgrindView::createVgLogView()
 {
+   QList<VgLogView*> oldLogviews = logviews;
+
+   VgLogView* lv = new HelgrindLogView();
+   logviews.clear();
+   logviews.append( lv );
+   processView->setRootLogView( lv );
+   showLogView( lv );
+
+   qDeleteAll( oldLogviews );
+   return lv;
+}
+
+/*!
+   --trace-children: another process' log, to be filled alongside
+   the root process' one (createVgLogView()).
+*/
+VgLogView* HelgrindView::createProcLogView()
+{
+   VgLogView* lv = new HelgrindLogView();
+   logviews.append( lv );
+   processView->addLogView( lv );
+   return lv;
+}
+
+/*!
+   Show one of the run's logs: the tree, filter and groups follow it.
+*/
+void HelgrindView::showLogView( VgLogView* lv )
+{
+   if ( lv == logview ) {
+      return;
+   }
+   QItemSelectionModel* oldSelection = treeView->selectionModel();
    if ( logview != 0 ) {
-      delete logview;
+      logview->disconnect( this );
    }
 
-   logview = new HelgrindLogView( treeView );
-   return logview;
+   logview = lv;
+   treeView->setModel( logview );
+   delete oldSelection;
+
+   // enable | disable show*Item buttons
+   connect( treeView->selectionModel(),
+            SIGNAL( currentChanged( const QModelIndex&, const QModelIndex& ) ),
+            this, SLOT( updateItemActions() ) );
+
+   // open the status row when it turns up
+   connect( logview, SIGNAL( rowsInserted( const QModelIndex&, int, int ) ),
+            this,      SLOT( rowsAdded( const QModelIndex& ) ) );
+
+   // the filter tells the model which errors to show
+   logviewFilter->setLogView( logview );
+   groupView->setLogView( logview );
 }
 
 
@@ -127,11 +170,35 @@ void HelgrindView::setupLayout()
    QVBoxLayout* vLayout = new QVBoxLayout( this );
    vLayout->setMargin(0);
    
-   treeView = new QTreeWidget( this );
+   treeView = new QTreeView( this );
    treeView->setObjectName( QString::fromUtf8( "treeview_Helgrind" ) );
    treeView->setHeaderHidden( true );
    treeView->setRootIsDecorated( false );
+
+   // all rows one line high: lets the view skip measuring rows
+   // it isn't showing, however many errors there are.
+   treeView->setUniformRowHeights( true );
+
+   // filter
+   logviewFilter = new LogViewFilterHG( this );
+
+   // the errors in groups: shown instead of the tree, on demand
+   groupView = new ErrorGroupView( this );
+   groupView->hide();
+   connect( groupView, SIGNAL( errorActivated( int ) ),
+            this,        SLOT( showError( int ) ) );
+
+   // --trace-children: the processes, to pick one's log
+   processView = new ProcessView( this );
+   processView->hide();
+   connect( processView, SIGNAL( logViewSelected( VgLogView* ) ),
+            this,          SLOT( showLogView( VgLogView* ) ) );
+
+   // layout
+   vLayout->addWidget( processView );
+   vLayout->addWidget( logviewFilter );
    vLayout->addWidget( treeView );
+   vLayout->addWidget( groupView );
 }
 
 
@@ -184,6 +251,36 @@ void HelgrindView::setupActions()
    act_SaveLog->setIconVisibleInMenu( true );
    connect( act_SaveLog, SIGNAL( triggered() ), this, SIGNAL( saveLogFile() ) );
 
+   // menu only: no icon for it
+   act_DiffLog = new QAction( this );
+   act_DiffLog->setObjectName( QString::fromUtf8( "act_DiffLog" ) );
+   connect( act_DiffLog, SIGNAL( triggered() ), this, SIGNAL( diffLogFile() ) );
+
+   act_enableFilter = new QAction( this );
+   act_enableFilter->setObjectName( QString::fromUtf8( "act_enableFilter" ) );
+   QIcon icon_filter;
+   icon_filter.addPixmap( QPixmap( QString::fromUtf8( ":/vk_icons/icons/filter_off.png" ) ),
+                         QIcon::Normal, QIcon::On );
+   icon_filter.addPixmap( QPixmap( QString::fromUtf8( ":/vk_icons/icons/filter.png" ) ),
+                         QIcon::Normal, QIcon::Off );
+   act_enableFilter->setIcon( icon_filter );
+   act_enableFilter->setIconVisibleInMenu( true );
+   act_enableFilter->setCheckable( true );
+   act_enableFilter->setChecked( true );
+   connect( act_enableFilter, SIGNAL(toggled(bool)),
+            logviewFilter, SLOT(enableFilter(bool)) );
+
+   act_GroupErrors = new QAction( this );
+   act_GroupErrors->setObjectName( QString::fromUtf8( "act_GroupErrors" ) );
+   QIcon icon_groups;
+   icon_groups.addPixmap( QPixmap( QString::fromUtf8( ":/vk_icons/icons/vglogview_groups.xpm" ) ) );
+   act_GroupErrors->setIcon( icon_groups );
+   act_GroupErrors->setIconVisibleInMenu( true );
+   act_GroupErrors->setCheckable( true );
+   act_GroupErrors->setChecked( false );
+   connect( act_GroupErrors, SIGNAL( toggled( bool ) ),
+            this,              SLOT( showGroups( bool ) ) );
+
    // ------------------------------------------------------------
    // initialise actions (enable / disable)
    setState( false );
@@ -201,6 +298,14 @@ void HelgrindView::setupActions()
    act_OpenLog->setToolTip( tr( "Open XML log" ) );
    act_SaveLog->setText(    tr( "Save Log" ) );
    act_SaveLog->setToolTip( tr( "Save Valgrind output to an XML log" ) );
+   act_DiffLog->setText(    tr( "Compare with baseline..." ) );
+   act_DiffLog->setToolTip( tr( "Show the errors new, fixed, and changed in count since a baseline log" ) );
+
+   act_enableFilter->setText( tr( "Filters on/off" ) );
+   act_enableFilter->setToolTip( tr( "Enable or disable the temporary log filters." ) );
+
+   act_GroupErrors->setText( tr( "Group errors" ) );
+   act_GroupErrors->setToolTip( tr( "Show the errors grouped by kind and top stack frames" ) );
 }
 
 
@@ -219,6 +324,8 @@ void HelgrindView::setupToolBar()
    toolToolBar->addAction( act_ShowSrcPaths );
    toolToolBar->addAction( act_OpenLog );
    toolToolBar->addAction( act_SaveLog );
+   toolToolBar->addAction( act_enableFilter );
+   toolToolBar->addAction( act_GroupErrors );
 
    // ------------------------------------------------------------
    // Menu (created in base class)
@@ -230,6 +337,9 @@ void HelgrindView::setupToolBar()
    toolMenu->addAction( act_ShowSrcPaths );
    toolMenu->addAction( act_OpenLog );
    toolMenu->addAction( act_SaveLog );
+   toolMenu->addAction( act_DiffLog );
+   toolMenu->addAction( act_enableFilter );
+   toolMenu->addAction( act_GroupErrors );
 }
 
 
@@ -247,25 +357,26 @@ void HelgrindView::setState( bool run )
       act_OpenClose_all->setEnabled( false );
       act_ShowSrcPaths->setEnabled( false );
       act_SaveLog->setEnabled( false );
+      act_DiffLog->setEnabled( false );
 
       this->setCursor( QCursor( Qt::WaitCursor ) );
-      treeView->clear();
    }
    else {
       unsetCursor();
 
       // ... turn on again only if they can be used
-      bool tree_empty = ( treeView->topLevelItemCount() == 0 );
+      bool tree_empty = ( logview == 0 || logview->rowCount() == 0 );
       act_OpenClose_item->setEnabled( false );       // can't enable before item clicked
       act_OpenClose_all->setEnabled( !tree_empty );  // enable only if sthng in tree
       act_ShowSrcPaths->setEnabled( !tree_empty );   // enable only if sthng in tree
       act_SaveLog->setEnabled( !tree_empty );
+      act_DiffLog->setEnabled( !tree_empty );
    }
 }
 
 
 /*!
-    Launches an editor for the given \a item.
+    Launches an editor for the given \a index.
     Checks if the itemType() is of type SRC_CODE,
     and if the referenced file isReadable|isWriteable.
     If these checks are passed, the (option-configurable) editor
@@ -274,26 +385,25 @@ void HelgrindView::setState( bool run )
 
     TODO: what if fails tests: user message?
 */
-void HelgrindView::launchEditor( QTreeWidgetItem* item )
+void HelgrindView::launchEditor( const QModelIndex& index )
 {
-   //vkDebug( "HelgrindView::launchEditor( %s )", qPrintable( item->text( 0 ) ) );
+   //vkDebug( "HelgrindView::launchEditor( %s )",
+   //         qPrintable( index.data().toString() ) );
 
-   VgOutputItem* vgItemCurr = (VgOutputItem*)item;
-   if ( !vgItemCurr ||
-        !vgItemCurr->parent() ) {
+   if ( logview == 0 || !index.parent().isValid() ) {
       return;
    }
 
-   // only interested in SrcItem items (== LINE type)
-   if ( vgItemCurr->elemType() != VG_ELEM::LINE ||
-        vgItemCurr->parent()->elemType() != VG_ELEM::FRAME ) {
+   // only interested in source lines (== LINE type, under a frame)
+   if ( logview->elemType( index ) != VG_ELEM::LINE ||
+        logview->elemType( index.parent() ) != VG_ELEM::FRAME ) {
       return;
    }
 
    // nothing to do if not even readable :-(
-   // in principle, if a src item is visible, it should be readable,
+   // in principle, if a src line is visible, it should be readable,
    // but you never know...
-   if ( !vgItemCurr->getIsReadable() ) {
+   if ( !logview->isReadable( index ) ) {
       vkError( this, "Editor Launch", "<p>Source file not readable.</p>" );
       return;
    }
@@ -308,21 +418,17 @@ void HelgrindView::launchEditor( QTreeWidgetItem* item )
    }
 
    // get path,line for this frame
-   FrameItem* frame = (FrameItem*)vgItemCurr->parent();
-
-   QDomNodeList frame_details = frame->getElement().childNodes();
-   vk_assert( frame_details.count() >= 1 );   // only ip guaranteed
-   QDomElement dir    = frame_details.item( 3 ).toElement();
-   QDomElement srcloc = frame_details.item( 4 ).toElement();
-   QDomElement line   = frame_details.item( 5 ).toElement();
+   QString dir    = logview->srcDir( index );
+   QString srcloc = logview->srcFile( index );
+   quint32 line   = logview->srcLine( index );
 
-   if ( dir.isNull() || srcloc.isNull() ) {
+   if ( dir.isEmpty() || srcloc.isEmpty() ) {
       VK_DEBUG( "HelgrindView::launchEditor(): Not enough path information." );
       vkError( this, "Editor Launch", "<p>Not enough path information.</p>" );
       return;
    }
 
-   QString path( dir.text() + '/' + srcloc.text() );
+   QString path( dir + '/' + srcloc );
    vk_assert( !path.isEmpty() );
 
    // setup args to editor
@@ -330,7 +436,7 @@ void HelgrindView::launchEditor( QTreeWidgetItem* item )
    QString  program = args.at( 0 );
    args = args.mid( 1 );
 
-   if ( line.isNull() ) {
+   if ( line == 0 ) {
       // remove any arg with "%n" in it
       QStringList lineargs = args.filter(".*%n.*");
       QStringList::iterator it = lineargs.begin();
@@ -338,7 +444,7 @@ void HelgrindView::launchEditor( QTreeWidgetItem* item )
          args.removeAll( *it );
       }
    } else {
-      args.replaceInStrings( "%n", line.text() );
+      args.replaceInStrings( "%n", QString::number( line ) );
    }
    args << path;
 
@@ -362,25 +468,24 @@ void HelgrindView::showSrcPath()
 {
    //vkDebug( "HelgrindView::showSrcPath()" );
 
-   if ( treeView->topLevelItemCount() == 0 ) {
+   if ( logview == 0 || logview->rowCount() == 0 ) {
       return;
    }
-   VgOutputItem* vgItemTop = (VgOutputItem*)treeView->topLevelItem( 0 );
+   QModelIndex idxTop = logview->statusIndex();
 
-   VgOutputItem* vgItem = (VgOutputItem*)treeView->currentItem();
-   if ( !vgItem ) {
-      vgItem = vgItemTop;
+   QModelIndex idx = treeView->currentIndex();
+   if ( !idx.isValid() ) {
+      idx = idxTop;
    }
 
    // if we're top dog, show full src path for all _open_ error items.
    // Note: not supporting UNshow for all. Don't think worth the effort.
-   if ( vgItem == vgItemTop ) {
-      for ( int i=0; i<vgItem->childCount(); ++i ) {
-         VgOutputItem* child = (VgOutputItem*)vgItem->child( i );
-         if ( child->isExpanded() &&
-              child->elemType() == VG_ELEM::ERROR ) {
-            ErrorItem* error = (ErrorItem*)vgItem->child( i );
-            error->showFullSrcPath( true );
+   if ( idx == idxTop ) {
+      for ( int i=0; i<logview->rowCount( idxTop ); ++i ) {
+         QModelIndex child = logview->index( i, 0, idxTop );
+         if ( treeView->isExpanded( child ) &&
+              logview->elemType( child ) == VG_ELEM::ERROR ) {
+            logview->showFullSrcPath( child, true );
          }
       }
       return;
@@ -389,18 +494,16 @@ void HelgrindView::showSrcPath()
    // else, we're not top level item...
    // in case we're hanging out on a branch somewhere,
    // crawl up the branch until we're a first-child item
-   vk_assert( vgItem->parent() != 0 );
-   vk_assert( vgItem != vgItemTop );
-   while ( vgItem->parent() != vgItemTop ) {
-      vgItem = vgItem->parent();
+   vk_assert( idx.parent().isValid() );
+   while ( idx.parent() != idxTop ) {
+      idx = idx.parent();
    }
 
    // if we're an _open_ ERROR-item, then show src path for this item only.
    // Toggling of show-full-src-paths supported for this case.
-   if ( vgItem->isExpanded() &&
-        vgItem->elemType() == VG_ELEM::ERROR ) {
-      ErrorItem* error = (ErrorItem*)vgItem;
-      error->showFullSrcPath( !error->isFullSrcPathShown() );
+   if ( treeView->isExpanded( idx ) &&
+        logview->elemType( idx ) == VG_ELEM::ERROR ) {
+      logview->showFullSrcPath( idx, !logview->isFullSrcPathShown( idx ) );
    }
 }
 
@@ -413,13 +516,14 @@ void HelgrindView::opencloseAllItems()
 {
    //vkDebug( "HelgrindView::opencloseAllItems()" );
 
-   if ( treeView->topLevelItemCount() == 0 ) {
+   if ( logview == 0 || logview->rowCount() == 0 ) {
       // empty tree.
       return;
    }
 
-   VgOutputItem* vgItemTop = (VgOutputItem*)treeView->topLevelItem( 0 );
-   if ( !vgItemTop || vgItemTop->childCount() == 0 ) {
+   QModelIndex idxTop = logview->statusIndex();
+   int numRows = logview->rowCount( idxTop );
+   if ( numRows == 0 ) {
       vkPrintErr( "Error: listview not populated. This shouldn't happen!" );
       return;
    }
@@ -428,22 +532,22 @@ void HelgrindView::opencloseAllItems()
    // check item->isOpen, start from first error, ignore suppcounts
    bool anItemIsOpen = false;
    int idxItemERR = -1;
-   for ( int i=0; i<vgItemTop->childCount(); ++i ) {
-      VgOutputItem* child = (VgOutputItem*)vgItemTop->child( i );
+   for ( int i=0; i<numRows; ++i ) {
+      QModelIndex child = logview->index( i, 0, idxTop );
 
       // find the first ERROR element
       if ( (idxItemERR == -1) &&
-           child->elemType() == VG_ELEM::ERROR ) {
+           logview->elemType( child ) == VG_ELEM::ERROR ) {
          idxItemERR = i;
       }
 
       // and check all elements from then on for isExpanded()
       if ( idxItemERR != -1 ) {
          // skip suppressions
-         if ( child->elemType() == VG_ELEM::SUPPCOUNTS ) {
+         if ( logview->elemType( child ) == VG_ELEM::SUPPCOUNTS ) {
             continue;
          }
-         if ( child->isExpanded() ) {
+         if ( treeView->isExpanded( child ) ) {
             anItemIsOpen = true;
             break;
          }
@@ -457,13 +561,13 @@ void HelgrindView::opencloseAllItems()
 
    // iterate over the same items, opening or collapsing all.
    // note: only opening/collapsing first-child level, not all levels.
-   for ( int i=idxItemERR; i<vgItemTop->childCount(); ++i ) {
-      VgOutputItem* child = (VgOutputItem*)vgItemTop->child( i );
+   for ( int i=idxItemERR; i<numRows; ++i ) {
+      QModelIndex child = logview->index( i, 0, idxTop );
       // skip suppressions
-      if ( child->elemType() == VG_ELEM::SUPPCOUNTS ) {
+      if ( logview->elemType( child ) == VG_ELEM::SUPPCOUNTS ) {
          continue;
       }
-      child->setExpanded( !anItemIsOpen );
+      treeView->setExpanded( child, !anItemIsOpen );
    }
 
 
@@ -473,7 +577,7 @@ void HelgrindView::opencloseAllItems()
       // - giving currentItem == last branch to be collapsed.
       // Too much work to figure out if we were previously
       // inside a now collapsed branch. Just reset to top.
-      treeView->setCurrentItem( vgItemTop );
+      treeView->setCurrentIndex( idxTop );
    }
 }
 
@@ -487,42 +591,57 @@ void HelgrindView::opencloseAllItems()
 void HelgrindView::opencloseOneItem()
 {
    //vkDebug( "HelgrindView::opencloseOneItem():" );
-   
-   QTreeWidgetItem* item = treeView->currentItem();
-   if ( item == 0 )
+   QModelIndex index = treeView->currentIndex();
+   if ( !index.isValid() )
       return;
 
-   item->setExpanded( !item->isExpanded() );
+   treeView->setExpanded( index, !treeView->isExpanded( index ) );
 }
 
 
 /*!
-  void HelgrindView::itemExpanded( QTreeWidgetItem* item )
-
-  Supports on-demand loading our VgOutputItems from our underlying model (VgElements)
-  Have to catch the treeView::itemExpanded() signal and pass it on to our
-  implementation of QTreeWidgetItem (VgOutputItem).
+  void HelgrindView::itemExpanded( const QModelIndex& index )
 
-  This should be in VgOutputItem class, but QTreeWidgetItem no longer
-  provides a virtual setExpanded() method :-(
+  The model sets up the rows on-demand (VgLogView::fetchMore()):
+  here we just open those children that open with their parent
+  (stacks, args, etc).
 */
-void HelgrindView::itemExpanded( QTreeWidgetItem* item )
+void HelgrindView::itemExpanded( const QModelIndex& index )
 {
    //vkDebug( "HelgrindView::itemExpanded():" );
-   ((VgOutputItem*)item)->openChildren();
+   if ( logview->canFetchMore( index ) ) {
+      logview->fetchMore( index );
+   }
+
+   for ( int i=0; i<logview->rowCount( index ); ++i ) {
+      QModelIndex child = logview->index( i, 0, index );
+      if ( logview->openWithParent( child ) ) {
+         treeView->expand( child );
+      }
+   }
 }
 
 
 /*!
   if we collapse a branch, set current item to branch head
 */
-void HelgrindView::itemCollapsed( QTreeWidgetItem* item )
+void HelgrindView::itemCollapsed( const QModelIndex& index )
 {
    //vkDebug( "HelgrindView::itemCollapsed():" );
 
-   if ( item != treeView->currentItem() ) {
-      // this should be a slot. grr!
-      treeView->setCurrentItem( item );
+   if ( index != treeView->currentIndex() ) {
+      treeView->setCurrentIndex( index );
+   }
+}
+
+
+/*!
+  the status row opens as soon as it's added
+*/
+void HelgrindView::rowsAdded( const QModelIndex& parent )
+{
+   if ( !parent.isValid() ) {
+      treeView->expand( logview->statusIndex() );
    }
 }
 
@@ -534,13 +653,40 @@ void HelgrindView::updateItemActions()
 {
    //vkDebug( "HelgrindView::updateItemActions():" );
 
-   QTreeWidgetItem* item = treeView->currentItem();
-   if ( !item ) {
+   QModelIndex index = treeView->currentIndex();
+   if ( !index.isValid() ) {
       act_OpenClose_item->setEnabled( false );
    }
    else {
       // item ok: contract / expand it
-      VgOutputItem* vgItem = (VgOutputItem*)item;
-      act_OpenClose_item->setEnabled( vgItem->getIsExpandable() );
+      act_OpenClose_item->setEnabled( logview->hasChildren( index ) );
+   }
+}
+
+
+/*!
+    Show the errors grouped (ErrorGroupView), or the log tree.
+*/
+void HelgrindView::showGroups( bool show )
+{
+   treeView->setVisible( !show );
+   logviewFilter->setVisible( !show );
+   groupView->setVisible( show );
+   groupView->setActive( show );
+}
+
+
+/*!
+    An error activated in the groups: show it in the log tree.
+     - unless the filter's hiding it.
+*/
+void HelgrindView::showError( int errIdx )
+{
+   act_GroupErrors->setChecked( false );
+
+   QModelIndex idx = logview->errorRow( errIdx );
+   if ( idx.isValid() ) {
+      treeView->setCurrentIndex( idx );
+      treeView->scrollTo( idx, QAbstractItemView::PositionAtTop );
    }
 }
@@ -23,9 +23,12 @@
 
 #include "toolview/toolview.h"
 #include "toolview/vglogview.h"
+#include "toolview/errorgroupview.h"
+#include "toolview/processview.h"
+#include "toolview/logviewfilter_hg.h"
 
 #include <QMenu>
-#include <QTreeWidget>
+#include <QTreeView>
 #include <QToolButton>
 
 
@@ -38,6 +41,7 @@ public:
    ~HelgrindView();
    
    VgLogView* createVgLogView();
+   VgLogView* createProcLogView();
 
 public slots:
    virtual void setState( bool run );
@@ -51,10 +55,14 @@ private slots:
    void opencloseAllItems();
    void opencloseOneItem();
    void showSrcPath();
-   void launchEditor( QTreeWidgetItem* item );
-   void itemExpanded( QTreeWidgetItem* item );
-   void itemCollapsed( QTreeWidgetItem* item );
+   void launchEditor( const QModelIndex& index );
+   void itemExpanded( const QModelIndex& index );
+   void itemCollapsed( const QModelIndex& index );
+   void rowsAdded( const QModelIndex& parent );
+   void showGroups( bool show );
+   void showError( int errIdx );
    void updateItemActions();
+   void showLogView( VgLogView* lv );
 
 private:
    QAction* act_OpenClose_all;
@@ -62,9 +70,17 @@ private:
    QAction* act_ShowSrcPaths;
    QAction* act_OpenLog;
    QAction* act_SaveLog;
+   QAction* act_DiffLog;
+   QAction* act_enableFilter;
+   QAction* act_GroupErrors;
 
-   QTreeWidget* treeView;
-   VgLogView*   logview;
+   QTreeView*   treeView;
+   VgLogView*   logview;         // the one shown
+   QList<VgLogView*> logviews;   // all the run's: one per process
+
+   LogViewFilterHG* logviewFilter;
+   ErrorGroupView* groupView;
+   ProcessView* processView;
 };
 
 #endif // __HELGRINDVIEW_H
@@ -0,0 +1,368 @@
+/****************************************************************************
+** LeakSiteView implementation
+**  - a log's leaks, totalled by allocation site
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "toolview/leaksiteview.h"
+#include "utils/vk_utils.h"
+
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QStringList>
+#include <QVBoxLayout>
+
+
+// frames shown for a site told apart by its whole stack
+static const int SHOWN_FRAMES = 4;
+
+// re-ranking during a live run: at most this often (ms)
+static const int RERANK_INTERVAL = 250;
+
+
+/***************************************************************************/
+/*!
+  LeakSiteModel
+*/
+LeakSiteModel::LeakSiteModel( VgLogView* logview, QObject* parent )
+   : QAbstractTableModel( parent ), m_logview( logview ),
+     m_leaks( logview->store()->leaks() ), m_active( false ), m_topN( 0 ),
+     m_key( VG_LEAK::BYTES ), m_descending( true ), rankedCheck( 0 )
+{
+   rerankTimer.setSingleShot( true );
+   rerankTimer.setInterval( RERANK_INTERVAL );
+   connect( &rerankTimer, SIGNAL( timeout() ),
+            this,           SLOT( rerank() ) );
+
+   connect( m_logview, SIGNAL( errorAdded( int ) ),
+            this,        SLOT( errorAdded( int ) ) );
+   connect( m_logview, SIGNAL( modelReset() ),
+            this,        SLOT( rerank() ) );
+}
+
+void LeakSiteModel::setActive( bool active )
+{
+   if ( active != m_active ) {
+      m_active = active;
+      rerank();
+   }
+}
+
+void LeakSiteModel::regroup( int depth )
+{
+   if ( depth != m_leaks.depth() ) {
+      m_logview->store()->regroupLeaks( depth );
+      rerank();
+   }
+}
+
+void LeakSiteModel::setTopN( int n )
+{
+   if ( n != m_topN ) {
+      m_topN = n;
+      rerank();
+   }
+}
+
+
+/*!
+  Rank the sites again: the top n, by the sort key.
+*/
+void LeakSiteModel::rerank()
+{
+   rerankTimer.stop();
+
+   beginResetModel();
+   if ( m_active ) {
+      ranked = m_leaks.top( m_topN, m_key, m_descending );
+   }
+   else {
+      ranked.clear();
+   }
+   rankedCheck = m_leaks.leakCheck();
+   endResetModel();
+}
+
+/*!
+  Leaks come in one at a time: rank them all together, later.
+   - unless a new leak check has started: the sites ranked
+     are gone.
+*/
+void LeakSiteModel::errorAdded( int )
+{
+   if ( !m_active ) {
+      return;
+   }
+   if ( m_leaks.leakCheck() != rankedCheck ) {
+      rerank();
+   }
+   else if ( !rerankTimer.isActive() ) {
+      rerankTimer.start();
+   }
+}
+
+
+/*!
+  A site's first leak.  -1 if none.
+*/
+int LeakSiteModel::errorIndex( const QModelIndex& idx ) const
+{
+   if ( !idx.isValid() || ranked.at( idx.row() ) >= m_leaks.count() ) {
+      return -1;
+   }
+   return m_leaks.site( ranked.at( idx.row() ) ).firstError;
+}
+
+/*!
+  The site's frames, innermost first, as they're told apart.
+*/
+QString LeakSiteModel::siteText( int site ) const
+{
+   const VgLogStore& store = *m_logview->store();
+   int depth = ( m_leaks.depth() > 0 ) ? m_leaks.depth() : SHOWN_FRAMES;
+
+   QStringList names;
+   quint32 c = m_leaks.siteTop( m_leaks.site( site ).firstError, store );
+   for ( int n = 0; c != 0 && n < depth; ++n, c = store.cell( c ).next ) {
+      const VgFrameRec& frm = store.frame( store.cell( c ).frame );
+      if ( frm.fn != 0 ) {
+         names << store.str( frm.fn );
+      }
+      else if ( frm.obj != 0 ) {
+         names << "(within " + QFileInfo( store.str( frm.obj ) ).fileName() + ")";
+      }
+      else {
+         names << "???";
+      }
+   }
+   if ( c != 0 ) {
+      names << "...";
+   }
+   return names.join( " < " );
+}
+
+
+int LeakSiteModel::rowCount( const QModelIndex& parent ) const
+{
+   return parent.isValid() ? 0 : ranked.count();
+}
+
+int LeakSiteModel::columnCount( const QModelIndex& parent ) const
+{
+   return parent.isValid() ? 0 : NUM_COLS;
+}
+
+QVariant LeakSiteModel::data( const QModelIndex& index, int role ) const
+{
+   if ( !index.isValid() ||
+        ( role != Qt::DisplayRole && role != Qt::TextAlignmentRole ) ) {
+      return QVariant();
+   }
+
+   bool numeric = ( index.column() >= COL_RECORDS );
+   if ( role == Qt::TextAlignmentRole ) {
+      return numeric ? ( int )( Qt::AlignRight | Qt::AlignVCenter )
+                     : ( int )( Qt::AlignLeft | Qt::AlignVCenter );
+   }
+
+   // a new leak check, not yet ranked
+   int site = ranked.at( index.row() );
+   if ( site >= m_leaks.count() ) {
+      return QVariant();
+   }
+   const VgLogLeaks::Site& s = m_leaks.site( site );
+
+   switch ( index.column() ) {
+   case COL_SITE:
+      return siteText( site );
+   case COL_LOSSES: {
+      QStringList losses;
+      for ( int i = 0; i < VG_LEAK::NUM_LOSSES; ++i ) {
+         if ( s.losses & ( 1 << i ) ) {
+            losses << m_logview->acronym( m_leaks.kind( ( VG_LEAK::Loss )i ) );
+         }
+      }
+      return losses.join( " " );
+   }
+   case COL_RECORDS:
+      return s.records;
+   case COL_BYTES:
+      return s.bytes;
+   case COL_BLOCKS:
+      return s.blocks;
+   case COL_DEFINITE:
+      return s.lostBytes[VG_LEAK::DEFINITE];
+   default:
+      break;
+   }
+   return QVariant();
+}
+
+QVariant LeakSiteModel::headerData( int section, Qt::Orientation orientation,
+                                    int role ) const
+{
+   if ( orientation != Qt::Horizontal || role != Qt::DisplayRole ) {
+      return QVariant();
+   }
+   switch ( section ) {
+   case COL_SITE:     return tr( "Allocation site" );
+   case COL_LOSSES:   return tr( "Kinds" );
+   case COL_RECORDS:  return tr( "Records" );
+   case COL_BYTES:    return tr( "Bytes" );
+   case COL_BLOCKS:   return tr( "Blocks" );
+   case COL_DEFINITE: return tr( "Definitely lost" );
+   default:           return QVariant();
+   }
+}
+
+/*!
+  Only the totals rank sites: other columns leave the order be.
+*/
+void LeakSiteModel::sort( int column, Qt::SortOrder order )
+{
+   switch ( column ) {
+   case COL_RECORDS:  m_key = VG_LEAK::RECORDS;        break;
+   case COL_BYTES:    m_key = VG_LEAK::BYTES;          break;
+   case COL_BLOCKS:   m_key = VG_LEAK::BLOCKS;         break;
+   case COL_DEFINITE: m_key = VG_LEAK::DEFINITE_BYTES; break;
+   default:           return;
+   }
+   m_descending = ( order == Qt::DescendingOrder );
+   rerank();
+}
+
+
+
+/***************************************************************************/
+/*!
+  LeakSiteView
+*/
+LeakSiteView::LeakSiteView( QWidget* parent )
+   : QWidget( parent ), model( 0 ), m_active( false )
+{
+   setObjectName( QString::fromUtf8( "LeakSiteView" ) );
+
+   QVBoxLayout* vLayout = new QVBoxLayout( this );
+   vLayout->setMargin( 0 );
+
+   QHBoxLayout* hLayout = new QHBoxLayout();
+   hLayout->setMargin( 0 );
+
+   spin_depth = new QSpinBox( this );
+   spin_depth->setRange( 0, 100 );
+   spin_depth->setSpecialValueText( tr( "all" ) );
+   spin_depth->setValue( 0 );
+   spin_depth->setToolTip( tr( "The number of frames of each leak's "
+                               "stack, past the allocator, that must "
+                               "match for leaks to be totalled together. "
+                               "'all': the whole stack." ) );
+
+   spin_top = new QSpinBox( this );
+   spin_top->setRange( 0, 1000000 );
+   spin_top->setSpecialValueText( tr( "all" ) );
+   spin_top->setValue( 100 );
+   spin_top->setToolTip( tr( "The number of sites shown: the heaviest, "
+                             "by the column sorted on." ) );
+
+   lbl_totals = new QLabel( this );
+
+   hLayout->addWidget( new QLabel( tr( "Total leaks by" ), this ) );
+   hLayout->addWidget( spin_depth );
+   hLayout->addWidget( new QLabel( tr( "allocation frames; show the top" ), this ) );
+   hLayout->addWidget( spin_top );
+   hLayout->addStretch( 1 );
+   hLayout->addWidget( lbl_totals );
+
+   treeView = new QTreeView( this );
+   treeView->setObjectName( QString::fromUtf8( "treeview_LeakSites" ) );
+   treeView->setRootIsDecorated( false );
+   treeView->setUniformRowHeights( true );
+   treeView->setAllColumnsShowFocus( true );
+   treeView->setSortingEnabled( true );
+   treeView->sortByColumn( LeakSiteModel::COL_BYTES, Qt::DescendingOrder );
+
+   vLayout->addLayout( hLayout );
+   vLayout->addWidget( treeView );
+
+   connect( spin_depth, SIGNAL( valueChanged( int ) ),
+            this,         SLOT( regroup() ) );
+   connect( spin_top,   SIGNAL( valueChanged( int ) ),
+            this,         SLOT( setTopN( int ) ) );
+   connect( treeView,   SIGNAL( activated( const QModelIndex& ) ),
+            this,         SLOT( activated( const QModelIndex& ) ) );
+}
+
+/*!
+  A new log: the old model goes with the old logview.
+*/
+void LeakSiteView::setLogView( VgLogView* logview )
+{
+   LeakSiteModel* oldModel = model;
+
+   model = new LeakSiteModel( logview, this );
+   connect( model, SIGNAL( modelReset() ),
+            this,    SLOT( updateTotals() ) );
+   model->setTopN( spin_top->value() );
+   treeView->setModel( model );   // sorts, by the header's column
+   regroup();
+   model->setActive( m_active );
+
+   delete oldModel;
+}
+
+void LeakSiteView::setActive( bool active )
+{
+   m_active = active;
+   if ( model != 0 ) {
+      model->setActive( active );
+   }
+}
+
+void LeakSiteView::regroup()
+{
+   if ( model != 0 ) {
+      model->regroup( spin_depth->value() );
+      treeView->resizeColumnToContents( LeakSiteModel::COL_SITE );
+   }
+}
+
+void LeakSiteView::setTopN( int n )
+{
+   if ( model != 0 ) {
+      model->setTopN( n );
+   }
+}
+
+void LeakSiteView::updateTotals()
+{
+   const VgLogLeaks& leaks = model->leaks();
+   lbl_totals->setText( tr( "%1 bytes in %2 blocks, from %3 sites" )
+                        .arg( leaks.totalBytes() )
+                        .arg( leaks.totalBlocks() )
+                        .arg( leaks.count() ) );
+}
+
+void LeakSiteView::activated( const QModelIndex& idx )
+{
+   if ( model != 0 ) {
+      int errIdx = model->errorIndex( idx );
+      if ( errIdx >= 0 ) {
+         emit errorActivated( errIdx );
+      }
+   }
+}
@@ -0,0 +1,128 @@
+/****************************************************************************
+** LeakSiteView definition
+**  - a log's leaks, totalled by allocation site
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __LEAKSITEVIEW_H
+#define __LEAKSITEVIEW_H
+
+#include "toolview/vglogview.h"
+#include "utils/vglogleaks.h"
+
+#include <QAbstractTableModel>
+#include <QLabel>
+#include <QSpinBox>
+#include <QTimer>
+#include <QTreeView>
+#include <QVector>
+#include <QWidget>
+
+
+// ============================================================
+/*!
+  LeakSiteModel: the store's leak sites (VgLogLeaks), heaviest first.
+   - columns: the site's frames, its kinds of loss, and its number
+     of loss records, leaked bytes, blocks, and bytes definitely
+     lost.
+   - only the top n sites are rows: sort() ranks them with a
+     partial sort, so a leak report of 100k records is still quick.
+     No proxy: that would sort them all.
+   - only kept up to date while active: leaks arriving during a
+     live run re-rank the sites, a little later, all in one go.
+*/
+class LeakSiteModel : public QAbstractTableModel
+{
+   Q_OBJECT
+public:
+   enum Column { COL_SITE, COL_LOSSES, COL_RECORDS, COL_BYTES,
+                 COL_BLOCKS, COL_DEFINITE, NUM_COLS };
+
+   LeakSiteModel( VgLogView* logview, QObject* parent );
+
+   void setActive( bool active );
+   void regroup( int depth );
+   void setTopN( int n );
+   int errorIndex( const QModelIndex& idx ) const;
+   const VgLogLeaks& leaks() const {
+      return m_leaks;
+   }
+
+   // QAbstractTableModel
+   int rowCount( const QModelIndex& parent = QModelIndex() ) const;
+   int columnCount( const QModelIndex& parent = QModelIndex() ) const;
+   QVariant data( const QModelIndex& index, int role = Qt::DisplayRole ) const;
+   QVariant headerData( int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole ) const;
+   void sort( int column, Qt::SortOrder order = Qt::AscendingOrder );
+
+private slots:
+   void rerank();
+   void errorAdded( int errIdx );
+
+private:
+   QString siteText( int site ) const;
+
+private:
+   VgLogView* m_logview;          // we don't own this
+   const VgLogLeaks& m_leaks;
+   bool m_active;
+   int m_topN;                    // 0: all
+   VG_LEAK::SortKey m_key;
+   bool m_descending;
+   QVector<int> ranked;           // row -> site
+   int rankedCheck;               // the leak check ranked
+   QTimer rerankTimer;
+};
+
+
+
+// ============================================================
+/*!
+  LeakSiteView: the top leak sites, and how to tell sites apart.
+   - like ErrorGroupView: the depth and number of sites take
+     effect as soon as they're changed, and activating a site
+     asks the tool view to show its first leak in the log.
+*/
+class LeakSiteView : public QWidget
+{
+   Q_OBJECT
+public:
+   LeakSiteView( QWidget* parent );
+
+   void setLogView( VgLogView* logview );
+   void setActive( bool active );
+
+signals:
+   void errorActivated( int errIdx );
+
+private slots:
+   void regroup();
+   void setTopN( int n );
+   void updateTotals();
+   void activated( const QModelIndex& idx );
+
+private:
+   QSpinBox*  spin_depth;
+   QSpinBox*  spin_top;
+   QLabel*    lbl_totals;
+   QTreeView* treeView;
+   LeakSiteModel* model;
+   bool m_active;
+};
+
+#endif // #ifndef __LEAKSITEVIEW_H
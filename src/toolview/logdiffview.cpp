@@ -0,0 +1,191 @@
+/****************************************************************************
+** LogDiffView implementation
+**  - the errors of a run, against those of a baseline run
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "toolview/logdiffview.h"
+#include "utils/vk_utils.h"
+
+#include <QDialogButtonBox>
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QRegExp>
+#include <QVBoxLayout>
+
+
+// the filter's choices: a regexp on the status column each
+static const char* const filterRxs[] = {
+   "New|Fixed|Changed", "New", "Fixed", "Changed", ""
+};
+
+
+/***************************************************************************/
+/*!
+  LogDiffModel
+*/
+LogDiffModel::LogDiffModel( const VgLogDiff& diff, QObject* parent )
+   : QAbstractTableModel( parent ), entries( diff.entries() )
+{ }
+
+QString LogDiffModel::statusName( VG_DIFF::Status status )
+{
+   switch ( status ) {
+   case VG_DIFF::NEW:     return tr( "New" );
+   case VG_DIFF::FIXED:   return tr( "Fixed" );
+   case VG_DIFF::CHANGED: return tr( "Changed" );
+   case VG_DIFF::SAME:    return tr( "Same" );
+   default:               return QString();
+   }
+}
+
+int LogDiffModel::rowCount( const QModelIndex& parent ) const
+{
+   return parent.isValid() ? 0 : entries.count();
+}
+
+int LogDiffModel::columnCount( const QModelIndex& parent ) const
+{
+   return parent.isValid() ? 0 : NUM_COLS;
+}
+
+QVariant LogDiffModel::data( const QModelIndex& index, int role ) const
+{
+   if ( !index.isValid() ||
+        ( role != Qt::DisplayRole && role != Qt::TextAlignmentRole ) ) {
+      return QVariant();
+   }
+
+   bool numeric = ( index.column() >= COL_COUNT_BASE );
+   if ( role == Qt::TextAlignmentRole ) {
+      return numeric ? ( int )( Qt::AlignRight | Qt::AlignVCenter )
+                     : ( int )( Qt::AlignLeft | Qt::AlignVCenter );
+   }
+
+   const VgLogDiffEntry& ent = entries.at( index.row() );
+   switch ( index.column() ) {
+   case COL_STATUS:       return statusName( ent.status );
+   case COL_KIND:         return ent.kind;
+   case COL_WHAT:         return ent.what;
+   case COL_FRAMES:       return ent.frames;
+   case COL_COUNT_BASE:   return ent.count[VG_DIFF::BASE];
+   case COL_COUNT:        return ent.count[VG_DIFF::LOG];
+   case COL_COUNT_DELTA:  return ent.countDelta();
+   case COL_LEAKED_BASE:  return ent.leakedBytes[VG_DIFF::BASE];
+   case COL_LEAKED:       return ent.leakedBytes[VG_DIFF::LOG];
+   case COL_LEAKED_DELTA: return ent.leakedDelta();
+   default:               return QVariant();
+   }
+}
+
+QVariant LogDiffModel::headerData( int section, Qt::Orientation orientation,
+                                   int role ) const
+{
+   if ( orientation != Qt::Horizontal || role != Qt::DisplayRole ) {
+      return QVariant();
+   }
+   switch ( section ) {
+   case COL_STATUS:       return tr( "Status" );
+   case COL_KIND:         return tr( "Kind" );
+   case COL_WHAT:         return tr( "What" );
+   case COL_FRAMES:       return tr( "Top frames" );
+   case COL_COUNT_BASE:   return tr( "Count (baseline)" );
+   case COL_COUNT:        return tr( "Count" );
+   case COL_COUNT_DELTA:  return tr( "+/-" );
+   case COL_LEAKED_BASE:  return tr( "Leaked (baseline)" );
+   case COL_LEAKED:       return tr( "Leaked bytes" );
+   case COL_LEAKED_DELTA: return tr( "+/-" );
+   default:               return QVariant();
+   }
+}
+
+
+
+/***************************************************************************/
+/*!
+  LogDiffView
+*/
+LogDiffView::LogDiffView( const VgLogDiff& diff, const QString& baseline,
+                          const QString& log, QWidget* parent )
+   : QDialog( parent )
+{
+   setObjectName( QString::fromUtf8( "LogDiffView" ) );
+   setWindowTitle( tr( "Valkyrie: %1 against %2" )
+                   .arg( QFileInfo( log ).fileName() )
+                   .arg( QFileInfo( baseline ).fileName() ) );
+   setAttribute( Qt::WA_DeleteOnClose );
+   resize( 900, 500 );
+
+   QVBoxLayout* vLayout = new QVBoxLayout( this );
+
+   qint64 leaked = diff.leakedDelta();
+   label_summary = new QLabel( this );
+   label_summary->setText(
+      tr( "%1 new, %2 fixed, %3 changed, %4 unchanged.  Leaked bytes: %5%6" )
+      .arg( diff.numWith( VG_DIFF::NEW ) )
+      .arg( diff.numWith( VG_DIFF::FIXED ) )
+      .arg( diff.numWith( VG_DIFF::CHANGED ) )
+      .arg( diff.numWith( VG_DIFF::SAME ) )
+      .arg( leaked > 0 ? "+" : "" )
+      .arg( leaked ) );
+
+   combo_filter = new QComboBox( this );
+   combo_filter->addItem( tr( "differences" ) );
+   combo_filter->addItem( tr( "new" ) );
+   combo_filter->addItem( tr( "fixed" ) );
+   combo_filter->addItem( tr( "changed count" ) );
+   combo_filter->addItem( tr( "all" ) );
+
+   QHBoxLayout* hLayout = new QHBoxLayout();
+   hLayout->addWidget( label_summary );
+   hLayout->addStretch( 1 );
+   hLayout->addWidget( new QLabel( tr( "Show:" ), this ) );
+   hLayout->addWidget( combo_filter );
+
+   model = new LogDiffModel( diff, this );
+   proxy = new QSortFilterProxyModel( this );
+   proxy->setSourceModel( model );
+   proxy->setFilterKeyColumn( LogDiffModel::COL_STATUS );
+
+   treeView = new QTreeView( this );
+   treeView->setObjectName( QString::fromUtf8( "treeview_LogDiff" ) );
+   treeView->setRootIsDecorated( false );
+   treeView->setUniformRowHeights( true );
+   treeView->setSortingEnabled( true );
+   treeView->setAllColumnsShowFocus( true );
+   treeView->setModel( proxy );
+   treeView->sortByColumn( LogDiffModel::COL_COUNT_DELTA, Qt::DescendingOrder );
+
+   QDialogButtonBox* buttons = new QDialogButtonBox( QDialogButtonBox::Close, Qt::Horizontal, this );
+   connect( buttons, SIGNAL( rejected() ), this, SLOT( reject() ) );
+
+   vLayout->addLayout( hLayout );
+   vLayout->addWidget( treeView );
+   vLayout->addWidget( buttons );
+
+   connect( combo_filter, SIGNAL( currentIndexChanged( int ) ),
+            this,           SLOT( filterChanged( int ) ) );
+   filterChanged( 0 );
+}
+
+void LogDiffView::filterChanged( int idx )
+{
+   vk_assert( idx >= 0 && idx < ( int )( sizeof( filterRxs ) / sizeof( filterRxs[0] ) ) );
+   proxy->setFilterRegExp( QRegExp( filterRxs[idx] ) );
+   treeView->resizeColumnToContents( LogDiffModel::COL_KIND );
+}
@@ -0,0 +1,88 @@
+/****************************************************************************
+** LogDiffView definition
+**  - the errors of a run, against those of a baseline run
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __LOGDIFFVIEW_H
+#define __LOGDIFFVIEW_H
+
+#include "utils/vglogdiff.h"
+
+#include <QAbstractTableModel>
+#include <QComboBox>
+#include <QDialog>
+#include <QLabel>
+#include <QSortFilterProxyModel>
+#include <QTreeView>
+
+
+// ============================================================
+/*!
+  LogDiffModel: a row per error of either log.
+   - numbers are given as numbers, so they sort as such.
+*/
+class LogDiffModel : public QAbstractTableModel
+{
+   Q_OBJECT
+public:
+   enum Column { COL_STATUS, COL_KIND, COL_WHAT, COL_FRAMES,
+                 COL_COUNT_BASE, COL_COUNT, COL_COUNT_DELTA,
+                 COL_LEAKED_BASE, COL_LEAKED, COL_LEAKED_DELTA, NUM_COLS };
+
+   LogDiffModel( const VgLogDiff& diff, QObject* parent );
+
+   static QString statusName( VG_DIFF::Status status );
+
+   // QAbstractItemModel
+   int rowCount( const QModelIndex& parent = QModelIndex() ) const;
+   int columnCount( const QModelIndex& parent = QModelIndex() ) const;
+   QVariant data( const QModelIndex& index, int role = Qt::DisplayRole ) const;
+   QVariant headerData( int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole ) const;
+
+private:
+   QVector<VgLogDiffEntry> entries;
+};
+
+
+
+// ============================================================
+/*!
+  LogDiffView: what's new, fixed and changed since the baseline.
+   - shown for differences only, to begin with: the unchanged
+     errors are there too, to be shown on demand.
+*/
+class LogDiffView : public QDialog
+{
+   Q_OBJECT
+public:
+   LogDiffView( const VgLogDiff& diff, const QString& baseline,
+                const QString& log, QWidget* parent );
+
+private slots:
+   void filterChanged( int idx );
+
+private:
+   QLabel*    label_summary;
+   QComboBox* combo_filter;
+   QTreeView* treeView;
+   QSortFilterProxyModel* proxy;
+   LogDiffModel* model;
+};
+
+#endif // #ifndef __LOGDIFFVIEW_H
@@ -0,0 +1,301 @@
+/****************************************************************************
+** LogViewFilter implementation
+**  - common base of the per-tool log filters
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2011-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "toolview/logviewfilter.h"
+#include "utils/vk_utils.h"
+
+#include <QAction>
+#include <QHBoxLayout>
+#include <QMap>
+#include <QRegExpValidator>
+#include <QTimer>
+
+
+
+LogViewFilter::LogViewFilter( QWidget *parent )
+   : QWidget(parent), m_logview( 0 )
+{
+   // ------------------------------------------------------------
+   // widgets
+   QIcon ico_filter( QString::fromUtf8( ":/vk_icons/icons/refresh.png" ) );
+   butt_refresh = new QPushButton( ico_filter, "" );
+   butt_refresh->setFixedWidth( 30 );
+   connect( butt_refresh, SIGNAL(clicked()), this, SLOT(refresh()) );
+
+   // XML tag types
+   combo_xmltag = new QComboBox();
+   connect( combo_xmltag, SIGNAL(currentIndexChanged(int)), this, SLOT(edited()) );
+
+   // Compare functions
+   cmpWidgStack = new QStackedWidget();
+   cmpWidgStack->setSizePolicy( QSizePolicy::Preferred, QSizePolicy::Maximum );
+   QComboBox* combo_cmp[3];    // for each of [CMP_KND, CMP_STR, CMP_INT]
+   for ( int i=0; i<3; ++i ) {
+      combo_cmp[i] = new QComboBox();
+      combo_cmp[i]->setSizeAdjustPolicy( QComboBox::AdjustToContents );
+      connect( combo_cmp[i], SIGNAL(currentIndexChanged(int)), this, SLOT(edited()) );
+      cmpWidgStack->addWidget( combo_cmp[i] );
+   }
+   vk_assert( cmpWidgStack->indexOf( combo_cmp[CMP_KND] ) == CMP_KND );
+   vk_assert( cmpWidgStack->indexOf( combo_cmp[CMP_STR] ) == CMP_STR );
+   vk_assert( cmpWidgStack->indexOf( combo_cmp[CMP_INT] ) == CMP_INT );
+   // query: operators are in the expression
+   cmpWidgStack->addWidget( new QWidget() );
+
+   // Filter values (combo/lineedits)
+   combo_kind = new QComboBox();
+   connect( combo_kind, SIGNAL(currentIndexChanged(int)), this, SLOT(edited()) );
+   QLineEdit* ledit_strfilter  = new QLineEdit();
+   connect( ledit_strfilter, SIGNAL(textChanged(QString)), this, SLOT(edited()) );
+   connect( ledit_strfilter, SIGNAL(editingFinished()), this, SLOT(refresh()) );
+   QLineEdit* ledit_intfilter  = new QLineEdit();
+   // only accept integers: decimal, or hex for addresses.
+   QRegExp rx_int( "0x[0-9a-fA-F]+|0|[1-9][0-9]*" );
+   ledit_intfilter->setValidator( new QRegExpValidator( rx_int, this ) );
+   connect( ledit_intfilter, SIGNAL(textChanged(QString)), this, SLOT(edited()) );
+   connect( ledit_intfilter, SIGNAL(editingFinished()), this, SLOT(refresh()) );
+   ledit_query = new QLineEdit();
+   connect( ledit_query, SIGNAL(textChanged(QString)), this, SLOT(queryEdited()) );
+
+   filterWidgStack = new QStackedWidget();
+   filterWidgStack->setSizePolicy( QSizePolicy::Preferred, QSizePolicy::Maximum );
+   filterWidgStack->addWidget( combo_kind );
+   filterWidgStack->addWidget( ledit_strfilter );
+   filterWidgStack->addWidget( ledit_intfilter );
+   filterWidgStack->addWidget( ledit_query );
+   vk_assert( filterWidgStack->indexOf( combo_kind      ) == CMP_KND );
+   vk_assert( filterWidgStack->indexOf( ledit_strfilter ) == CMP_STR );
+   vk_assert( filterWidgStack->indexOf( ledit_intfilter ) == CMP_INT );
+   vk_assert( filterWidgStack->indexOf( ledit_query     ) == CMP_QRY );
+
+   // ------------------------------------------------------------
+   // layout
+   QGridLayout* gridLayout = new QGridLayout( this );
+   gridLayout->setColumnStretch( 0, 0 );
+   gridLayout->setColumnStretch( 1, 0 );
+   gridLayout->setColumnStretch( 2, 0 );
+   gridLayout->setColumnStretch( 3, 1 );
+   gridLayout->setMargin(0);
+   gridLayout->addWidget( butt_refresh,    0, 0 );
+   gridLayout->addWidget( combo_xmltag,    0, 1 );
+   gridLayout->addWidget( cmpWidgStack,    0, 2 );
+   gridLayout->addWidget( filterWidgStack, 0, 3 );
+
+   connect( combo_xmltag, SIGNAL(currentIndexChanged(int)), this, SLOT( setupFilter(int) ) );
+
+   // ------------------------------------------------------------
+   // setup compare function comboboxes, along with their enums
+   combo_cmp[CMP_KND]->addItem( "==",            VgFieldMatch::EQL   );
+   combo_cmp[CMP_KND]->addItem( "!=",            VgFieldMatch::NEQL  );
+   combo_cmp[CMP_STR]->addItem( "==",            VgFieldMatch::EQL   );
+   combo_cmp[CMP_STR]->addItem( "!=",            VgFieldMatch::NEQL  );
+   combo_cmp[CMP_STR]->addItem( "contains",      VgFieldMatch::CONT  );
+   combo_cmp[CMP_STR]->addItem( "! contain",     VgFieldMatch::NCONT );
+   combo_cmp[CMP_STR]->addItem( "starts with",   VgFieldMatch::STRT  );
+   combo_cmp[CMP_STR]->addItem( "! starts with", VgFieldMatch::NSTRT );
+   combo_cmp[CMP_STR]->addItem( "ends with",     VgFieldMatch::END   );
+   combo_cmp[CMP_STR]->addItem( "! ends with",   VgFieldMatch::NEND  );
+   combo_cmp[CMP_INT]->addItem( "==",            VgFieldMatch::EQL   );
+   combo_cmp[CMP_INT]->addItem( "!=",            VgFieldMatch::NEQL  );
+   combo_cmp[CMP_INT]->addItem( "<",             VgFieldMatch::LSTHN );
+   combo_cmp[CMP_INT]->addItem( ">",             VgFieldMatch::GRTHN );
+   combo_cmp[CMP_STR]->setCurrentIndex( 2 );
+
+   // kinds: filled in by subclass (display & matching text)
+   combo_kind->addItem( "", "" );
+
+   //TODO: ContextHelp::addHelp( this, urlValkyrie::XYZ);
+}
+
+LogViewFilter::~LogViewFilter()
+{ }
+
+
+/*!
+  Offer field for filtering, with the given compare type.
+*/
+void LogViewFilter::addField( const QString& label, VG_FIELD::Field field,
+                              CmpType type )
+{
+   vk_assert( type != CMP_QRY );
+
+   // map first: adding the first item calls setupFilter()
+   map_xmltag_cmptype.insert( field, type );
+   combo_xmltag->addItem( label, field );
+}
+
+void LogViewFilter::addKind( const QString& label, const QString& kind )
+{
+   combo_kind->addItem( label, kind );
+}
+
+/*!
+  All fields added: offer queries last.
+*/
+void LogViewFilter::setupDone( const QString& queryHelp )
+{
+   m_queryHelp = queryHelp;
+   ledit_query->setToolTip( m_queryHelp );
+
+   map_xmltag_cmptype.insert( VG_FIELD::NUM_FIELDS, CMP_QRY );
+   combo_xmltag->addItem( "Query", VG_FIELD::NUM_FIELDS );
+
+   // initialise filters
+   setupFilter( 0 );
+}
+
+
+/*!
+  The model shown by the view: called for each new log.
+*/
+void LogViewFilter::setLogView( VgLogView* logview )
+{
+   m_logview = logview;
+
+   // the new model starts unfiltered: hand it the filter.
+   updateView();
+}
+
+void LogViewFilter::setupFilter( int idx )
+{
+//   vkDebug( "LogViewFilter::setupFilter( %d )", idx );
+
+   VG_FIELD::Field xmltag = (VG_FIELD::Field)combo_xmltag->itemData( idx ).toInt();
+   CmpType cmp_type = map_xmltag_cmptype[ xmltag ];
+
+   // compares: combobox
+   cmpWidgStack->setCurrentIndex( cmp_type );
+
+   // filter values: combobox/lineedit
+   filterWidgStack->setCurrentIndex( cmp_type );
+}
+
+
+void LogViewFilter::edited()
+{
+//   vkDebug( "LogViewFilter::edited()" );
+
+   butt_refresh->setEnabled( true );
+}
+
+void LogViewFilter::refresh()
+{
+//   vkDebug( "LogViewFilter::refresh()" );
+
+   butt_refresh->setEnabled( false );
+
+   updateView();
+}
+
+/*!
+  Queries are cheap to evaluate: re-filter on each keystroke.
+*/
+void LogViewFilter::queryEdited()
+{
+   refresh();
+}
+
+
+
+
+/*!
+  Set up m_query from the widgets.
+  An inactive filter, or an empty filter value, shows all.
+  A query that doesn't compile leaves the last filter in place.
+*/
+void LogViewFilter::applyFilter()
+{
+   if ( this->isHidden() ) {
+      m_query.clear();
+      return;
+   }
+
+   if ( filterWidgStack->currentIndex() == CMP_QRY ) {
+      QString errMsg;
+      if ( m_query.compile( ledit_query->text(), errMsg ) ) {
+         ledit_query->setStyleSheet( QString() );
+         ledit_query->setToolTip( m_queryHelp );
+      }
+      else {
+         ledit_query->setStyleSheet( "QLineEdit { color: red; }" );
+         ledit_query->setToolTip( errMsg );
+      }
+      return;
+   }
+
+   m_query.clear();
+
+   // first get and test the filter value: if empty -> no filter.
+   QString str_flt;
+   if ( filterWidgStack->currentIndex() == CMP_KND ) { // => combobox
+      QComboBox* combo = (QComboBox*)filterWidgStack->currentWidget();
+      str_flt = combo->itemData( combo->currentIndex() ).toString();
+   }
+   else {                                           // => lineedit
+      QLineEdit* le = (QLineEdit*)filterWidgStack->currentWidget();
+      str_flt = le->text();
+   }
+
+   if ( str_flt.isEmpty() ) {
+//      vkDebug( "Filter value empty -> empty filter" );
+      return;
+   }
+
+   // get the compare function
+   QComboBox* comboCmpFun = (QComboBox*)cmpWidgStack->currentWidget();
+   int idx = comboCmpFun->currentIndex();
+   VgFieldMatch::CmpFun cmpFun =
+      (VgFieldMatch::CmpFun)comboCmpFun->itemData( idx ).toInt();
+
+   // get the field to compare
+   idx = combo_xmltag->currentIndex();
+   VG_FIELD::Field xmltag = (VG_FIELD::Field)combo_xmltag->itemData( idx ).toInt();
+
+   m_query.setClause( new VgFieldMatch( xmltag, cmpFun, str_flt ) );
+}
+
+
+/*!
+  Apply the filter to all errors.
+   - the model drops the non-matching errors from its rows, and
+     checks errors arriving later against the same query.
+*/
+void LogViewFilter::updateView()
+{
+//   vkDebug( "LogViewFilter::updateView()" );
+
+   applyFilter();
+
+   if ( m_logview == 0 ) {
+      return;
+   }
+   m_logview->setErrorFilter( m_query.isEmpty() ? 0 : &m_query );
+}
+
+
+void LogViewFilter::enableFilter( bool enable )
+{
+   if ( enable )
+      this->show();
+   else
+      this->hide();
+
+   updateView();
+}
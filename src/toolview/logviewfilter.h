@@ -0,0 +1,89 @@
+/****************************************************************************
+** LogViewFilter definition
+**  - common base of the per-tool log filters
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2011-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef LOGVIEWFILTER_H
+#define LOGVIEWFILTER_H
+
+#include "toolview/vglogview.h"
+#include "utils/vglogquery.h"
+
+#include <QComboBox>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QStackedWidget>
+#include <QWidget>
+
+
+/*!
+  LogViewFilter: show only the errors matching a filter.
+   - filters are evaluated against the log store's field index
+     (VgLogIndex), as bitset operations: no per-item dom walks.
+   - the filter last applied is kept (and shared with the model),
+     so errors arriving during a live run are filtered one by one,
+     without a refresh.
+   - 'Query' takes a VgLogQuery expression, re-applied as it's typed.
+   - subclasses say which fields (and error kinds) their tool has.
+*/
+class LogViewFilter : public QWidget
+{
+    Q_OBJECT
+public:
+    LogViewFilter( QWidget *parent );
+    virtual ~LogViewFilter();
+
+    void setLogView( VgLogView* logview );
+
+public slots:
+    void enableFilter( bool enable );
+
+protected:
+    enum CmpType { CMP_KND, CMP_STR, CMP_INT, CMP_QRY };
+
+    // for subclass constructors
+    void addField( const QString& label, VG_FIELD::Field field, CmpType type );
+    void addKind( const QString& label, const QString& kind );
+    void setupDone( const QString& queryHelp );
+
+private slots:
+    void setupFilter( int idx );
+    void updateView();
+    void edited();
+    void refresh();
+    void queryEdited();
+
+private:
+    void applyFilter();
+
+private:
+    VgLogView* m_logview;       // we don't own this
+    VgLogQuery m_query;         // filter last applied: empty -> show all
+
+    QPushButton* butt_refresh;  // refresh the filter after editing
+    QComboBox* combo_xmltag;    // combobox of xmltags to filter on
+    QStackedWidget* cmpWidgStack;    // hold the different compare comboboxes
+    QStackedWidget* filterWidgStack; // hold the different filter value widgets
+    QComboBox* combo_kind;      // error kinds
+    QLineEdit* ledit_query;     // query expression
+    QString m_queryHelp;
+
+    QMap<VG_FIELD::Field, CmpType> map_xmltag_cmptype;
+};
+
+#endif // LOGVIEWFILTER_H
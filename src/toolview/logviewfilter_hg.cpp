@@ -0,0 +1,50 @@
+/****************************************************************************
+** LogViewFilterHG implementation
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2011-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "toolview/logviewfilter_hg.h"
+#include "toolview/helgrind_logview.h"
+
+
+
+LogViewFilterHG::LogViewFilterHG( QWidget *parent )
+   : LogViewFilter( parent )
+{
+   setObjectName( QString::fromUtf8( "LogViewFilterHG" ) );
+
+   // ------------------------------------------------------------
+   // xml tags to filter on, along with their compare types
+   addField( "Kind",          VG_FIELD::KIND,         CMP_KND );
+   addField( "Thread",        VG_FIELD::HTHREADID,    CMP_INT );
+   addField( "Lock Address",  VG_FIELD::LOCKADDR,     CMP_INT );
+   addField( "Function",      VG_FIELD::FN,           CMP_STR );
+   addField( "Object",        VG_FIELD::OBJ,          CMP_STR );
+   addField( "File",          VG_FIELD::SRCFILE,      CMP_STR );
+
+   // 'kind' types, as the error rows show them
+   const VgLogView::AcronymMap& kinds = HelgrindLogView::acronyms();
+   VgLogView::AcronymMap::const_iterator it;
+   for ( it = kinds.constBegin(); it != kinds.constEnd(); ++it ) {
+      addKind( it.value() + " - " + it.key(), it.key() );
+   }
+
+   setupDone( "e.g. thread=1 && thread=2 && file=\"server.c\"" );
+}
+
+LogViewFilterHG::~LogViewFilterHG()
+{ }
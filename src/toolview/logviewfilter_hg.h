@@ -0,0 +1,40 @@
+/****************************************************************************
+** LogViewFilterHG definition
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2011-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef LOGVIEWFILTER_HG_H
+#define LOGVIEWFILTER_HG_H
+
+#include "toolview/logviewfilter.h"
+
+
+/*!
+  LogViewFilterHG: show only the helgrind errors matching a filter.
+   - besides the frame fields: the (helgrind) threads an error
+     involves, and the lock addresses it mentions.
+   - a thread pair is a query: thread=1 && thread=2
+*/
+class LogViewFilterHG : public LogViewFilter
+{
+    Q_OBJECT
+public:
+    LogViewFilterHG( QWidget *parent );
+    ~LogViewFilterHG();
+};
+
+#endif // LOGVIEWFILTER_HG_H
@@ -20,49 +20,18 @@
 #ifndef LOGVIEWFILTER_MC_H
 #define LOGVIEWFILTER_MC_H
 
-#include "toolview/vglogview.h"
+#include "toolview/logviewfilter.h"
 
-#include <QComboBox>
-#include <QPushButton>
-#include <QStackedWidget>
-#include <QTreeWidget>
-#include <QWidget>
 
-
-class LogViewFilterMC : public QWidget
+/*!
+  LogViewFilterMC: show only the memcheck errors matching a filter.
+*/
+class LogViewFilterMC : public LogViewFilter
 {
     Q_OBJECT
 public:
-    LogViewFilterMC(QWidget *parent, QTreeWidget* view );
-
-public slots:
-    void showHideItem( VgOutputItem* item );
-    void enableFilter( bool enable );
-    
-private slots:
-    void setupFilter( int idx );
-    void updateView();
-    void edited();
-    void refresh();
-
-private:
-    QTreeWidget* m_view;        // hold on to this to rescan entire tree.
-    
-    QPushButton* butt_refresh;  // refresh the filter after editing
-    QComboBox* combo_xmltag;    // combobox of xmltags to filter on
-    QStackedWidget* cmpWidgStack;    // hold the different compare comboboxes
-    QStackedWidget* filterWidgStack; // hold the different filter value widgets
-
-    enum XmlTagType { XML_KND, XML_LBY, XML_LBL, XML_OBJ, XML_FUN, XML_DIR, XML_FIL, XML_LIN };
-    enum CmpType { CMP_KND, CMP_STR, CMP_INT };
-    enum CmpFunType { FUN_EQL, FUN_NEQL, FUN_LSTHN, FUN_GRTHN, FUN_CONT,
-                      FUN_NCONT, FUN_STRT, FUN_NSTRT, FUN_END, FUN_NEND };
-    QMap<XmlTagType, CmpType> map_xmltag_cmptype;
-    
-    bool xmlCompare( VgOutputItem* errItem, const QString& tag,
-                     const QString& str_flt, CmpFunType cmpFun, CmpType cmp_type );
-    bool compare_strings( const QStringList& list_xml, const QString& str_flt, CmpFunType cmpfuntype );
-    bool compare_integers( const QStringList& list_xml, const QString& str_flt, CmpFunType cmpfuntype );
+    LogViewFilterMC( QWidget *parent );
+    ~LogViewFilterMC();
 };
 
 #endif // LOGVIEWFILTER_MC_H
@@ -1,6 +1,6 @@
 /****************************************************************************
 ** MemcheckLogView implementation
-**  - links QDomElements with QTreeWidgetItems
+**  - tool-specific parts of the log model
 ** --------------------------------------------------------------------------
 **
 ** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
@@ -26,9 +26,9 @@
 /*!
   map Error::kind to a three-letter acronym
 */
-static ErrorItem::AcronymMap setupErrAcronymMap()
+static VgLogView::AcronymMap setupErrAcronymMap()
 {
-   ErrorItem::AcronymMap amap;
+   VgLogView::AcronymMap amap;
 //TODO: where did this go?
 //   amap["CoreMemError"]        = "CRM";
    amap["InvalidFree"]         = "IVF"; // free/delete/delete[] on an invalid pointer
@@ -48,17 +48,11 @@ static ErrorItem::AcronymMap setupErrAcronymMap()
    amap["Leak_StillReachable"] = "LSR";
    return amap;
 }
-ErrorItem::AcronymMap ErrorItemMC::acnymMap = setupErrAcronymMap();
 
-
-// ============================================================
-/*!
-  ErrorItem for Memcheck
-*/
-ErrorItemMC::ErrorItemMC( VgOutputItem* parent, QTreeWidgetItem* after,
-                          QDomElement err )
-      : ErrorItem( parent, after, err, acnymMap )
+const VgLogView::AcronymMap& MemcheckLogView::acronyms()
 {
+   static const AcronymMap acnymMap = setupErrAcronymMap();
+   return acnymMap;
 }
 
 
@@ -66,25 +60,28 @@ ErrorItemMC::ErrorItemMC( VgOutputItem* parent, QTreeWidgetItem* after,
 
 // ============================================================
 /*!
-  TopStatus: first item in listview
-  as two text lines:
+  TopStatus: first row in the view
+  as two text parts:
   status, client exe
   errcounts(num_errs), leak_errors(num_bytes++, num_blocks++)
 */
-TopStatusItemMC::TopStatusItemMC( QTreeWidget* parent, QDomElement exe,
-                                  QDomElement status, QString _protocol )
-   : TopStatusItem( parent, exe, status, ",   Leaked Bytes: 0", _protocol ),
-   num_bytes( 0 ), num_blocks( 0 )
+TopStatusMC::TopStatusMC( const QString& exe, const VgLogRecord& status,
+                          QString _protocol, const VgLogLeaks* _leaks )
+   : TopStatus( exe, status, ",   Leaked Bytes: 0", _protocol ),
+   leaks( _leaks )
 {
    // leaks, in addition to the basic errorcounts.
    errcounts_tmplt = ",   Leaked Bytes: %1 in %2 blocks";
 }
 
 
-void TopStatusItemMC::updateToolStatus( QDomElement err )
+/*!
+  Leaks are totalled by the store (VgLogLeaks): it knows when
+  a new leak check starts (e.g. from VALGRIND_DO_LEAK_CHECK).
+*/
+void TopStatusMC::updateToolStatus( const VgLogRecord& err )
 {
-   QString kind = err.firstChildElement( "kind" ).text();
-   if ( !kind.startsWith( "Leak_" ) ) {
+   if ( !err.kind.startsWith( "Leak_" ) ) {
       // Update general error count
       // Note: this may be _way_ off, 'cos we don't see repeated errors
       // until we get an ERRORCOUNTS element
@@ -92,56 +89,11 @@ void TopStatusItemMC::updateToolStatus( QDomElement err )
       updateText();
       return;
    }
-   else {
-      // Update Leak_* error counts
-      QDomElement xwhat = err.firstChildElement( "xwhat" );
-      if ( xwhat.isNull() ) {
-         vkPrintErr( "TopStatusItemMC::updateToolStatus(): missing xwhat element for leak error" );
-      }
-      else {
-#if 1  //TODO: still needed?
-
-         /* HACK ALERT!
-            VALGRIND_DO_LEAK_CHECK gives repeated leaks...
-            taking apart error::what to get record number
-            - if this is 'record 1' then reset counters
-         */
-         QDomElement text = xwhat.firstChildElement( "text" );
-         if ( ! text.isNull() ) {
-            QString text_str = text.text();
-            QString lossrec_str = text_str.mid( text_str.indexOf( "in loss record " ) );
-
-            if ( !lossrec_str.isEmpty() ) {
-               QString record = lossrec_str.split( " ", QString::SkipEmptyParts )[3];
-
-               if ( record == "1" ) {
-                  num_bytes = num_blocks = 0;
-               }
-            }
-            else {
-               VK_DEBUG( "Unexpected string value for 'text' element: %s",
-                         qPrintable( text_str ) );
-            }
-         }
-         else {
-            VK_DEBUG( "No 'text' child for 'xwhat' element" );
-         }
-#endif
-
-         QDomElement leakedbytes  = xwhat.firstChildElement( "leakedbytes" );
-         QDomElement leakedblocks = xwhat.firstChildElement( "leakedblocks" );
-
-         if ( !leakedbytes.isNull() && !leakedblocks.isNull() ) {
-            num_bytes  += leakedbytes.text().toUInt();
-            num_blocks += leakedblocks.text().toUInt();
-
-            toolstatus_str = errcounts_tmplt
-                             .arg( num_bytes )
-                             .arg( num_blocks );
-            updateText();
-         }
-      }
-   }
+
+   toolstatus_str = errcounts_tmplt
+                    .arg( leaks->totalBytes() )
+                    .arg( leaks->totalBlocks() );
+   updateText();
 }
 
 
@@ -151,8 +103,8 @@ void TopStatusItemMC::updateToolStatus( QDomElement err )
 /*!
   MemcheckLogView
 */
-MemcheckLogView::MemcheckLogView( QTreeWidget* view )
-   : VgLogView( view )
+MemcheckLogView::MemcheckLogView()
+   : VgLogView( acronyms() )
 {}
 
 MemcheckLogView::~MemcheckLogView()
@@ -164,16 +116,16 @@ QString MemcheckLogView::toolName()
 }
 
 /*!
-  Populate our model (QDomDocument) and the view (QListWidget)
-   - top-level xml elements are pushed to us from the parser
-   - node is reparented to the QDomDocument log
+  Populate our model: memcheck's part
+   - the records of top-level xml elements are pushed to us
+     from the parser
 */
-bool MemcheckLogView::appendNodeTool( QDomElement elem, QString& errMsg )
+bool MemcheckLogView::appendNodeTool( VgLogRecord& rec, QString& errMsg )
 {
-   switch ( VgOutputItem::elemType( elem.tagName() ) ) {
+   switch ( rec.type ) {
    case VG_ELEM::PROTOCOL_VERSION : {
-      if ( elem.text() != "4" ) {
-         errMsg = "Memcheck tool doesn't support XML protocol version: (" + elem.text() + ")";
+      if ( rec.text != "4" ) {
+         errMsg = "Memcheck tool doesn't support XML protocol version: (" + rec.text + ")";
          vkPrintErr( "%s", qPrintable( "MemcheckLogView::appendNodeTool(): " + errMsg ) );
          return false;
       }
@@ -181,15 +133,13 @@ bool MemcheckLogView::appendNodeTool( QDomElement elem, QString& errMsg )
    }
 
    case VG_ELEM::ERROR: {
-      QDomElement err = elem;
-      lastItem = new ErrorItemMC( topStatus, lastItem, err );
+      int idx = store()->addError( rec );
+      appendError( idx );
 
-// TODO: 
-//      flicker a problem?
-      emit this->errorItemAdded( lastItem );
-      
       // update topStatus
-      topStatus->updateToolStatus( err );
+      if ( topStatus != 0 ) {
+         topStatus->updateToolStatus( rec );
+      }
       break;
    }
 
@@ -201,11 +151,10 @@ bool MemcheckLogView::appendNodeTool( QDomElement elem, QString& errMsg )
 }
 
 
-TopStatusItem* MemcheckLogView::createTopStatus( QTreeWidget* view,
-                                                 QDomElement exe,
-                                                 QDomElement status,
-                                                 QString _protocol )
+TopStatus* MemcheckLogView::createTopStatus( const QString& exe,
+                                             const VgLogRecord& status,
+                                             QString _protocol )
 {
-   return new TopStatusItemMC( view, exe, status, _protocol );
+   return new TopStatusMC( exe, status, _protocol, &store()->leaks() );
 }
 
@@ -1,6 +1,6 @@
 /****************************************************************************
 ** MemcheckLogView definition
-**  - links QDomElements with QTreeWidgetItems
+**  - tool-specific parts of the log model
 ** --------------------------------------------------------------------------
 **
 ** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
@@ -29,48 +29,34 @@ class MemcheckLogView : public VgLogView
 {
    Q_OBJECT
 public:
-   MemcheckLogView( QTreeWidget* );
+   MemcheckLogView();
    ~MemcheckLogView();
-   
-signals:
-   void errorItemAdded( VgOutputItem* item );
-   
-private:
-   // Template method functions:
-   TopStatusItem* createTopStatus( QTreeWidget* view, QDomElement exe,
-                                   QDomElement status, QString _protocol );
-   QString toolName();
-   bool appendNodeTool( QDomElement elem, QString& errMsg );
-};
-
-
 
+   // error::kind -> three-letter acronym
+   static const AcronymMap& acronyms();
 
-
-// ============================================================
-class ErrorItemMC : public ErrorItem
-{
-public:
-   ErrorItemMC( VgOutputItem* parent, QTreeWidgetItem* after,
-                QDomElement err );
 private:
-   static ErrorItem::AcronymMap acnymMap;
+   // Template method functions:
+   TopStatus* createTopStatus( const QString& exe, const VgLogRecord& status,
+                               QString _protocol );
+   QString toolName();
+   bool appendNodeTool( VgLogRecord& rec, QString& errMsg );
 };
 
 
 
 
 // ============================================================
-class TopStatusItemMC : public TopStatusItem
+class TopStatusMC : public TopStatus
 {
 public:
-   TopStatusItemMC( QTreeWidget* parent, QDomElement exe,
-                    QDomElement status, QString _protocol );
+   TopStatusMC( const QString& exe, const VgLogRecord& status,
+                QString _protocol, const VgLogLeaks* _leaks );
 
-   void updateToolStatus( QDomElement err );
+   void updateToolStatus( const VgLogRecord& err );
 
 private:
-   int num_bytes, num_blocks;
+   const VgLogLeaks* leaks;    // the store's: we don't own this
    QString errcounts_tmplt;
 };
 
@@ -34,6 +34,8 @@
 #include <QApplication>
 #include <QClipboard>
 #include <QHeaderView>
+#include <QInputDialog>
+#include <QItemSelectionModel>
 #include <QLabel>
 #include <QMenuBar>
 #include <QProcess>
@@ -72,21 +74,17 @@ MemcheckView::MemcheckView( QWidget* parent )
    setupActions();
    setupToolBar();
    
-   // enable | disable show*Item buttons
-   connect( treeView, SIGNAL( itemSelectionChanged() ),
-            this,       SLOT( updateItemActions() ) );
-
    // on collapsing a branch, reset currentItem to branch head.
-   connect( treeView, SIGNAL( itemCollapsed( QTreeWidgetItem* ) ),
-            this,       SLOT( itemCollapsed( QTreeWidgetItem* ) ) );
+   connect( treeView, SIGNAL( collapsed( const QModelIndex& ) ),
+            this,       SLOT( itemCollapsed( const QModelIndex& ) ) );
 
-   // load items on-demand
-   connect( treeView, SIGNAL( itemExpanded( QTreeWidgetItem* ) ),
-            this,       SLOT( itemExpanded( QTreeWidgetItem* ) ) );
+   // open the rows that open with their parent
+   connect( treeView, SIGNAL( expanded( const QModelIndex& ) ),
+            this,       SLOT( itemExpanded( const QModelIndex& ) ) );
 
    // launch editor with src file loaded
-   connect( treeView, SIGNAL( itemDoubleClicked( QTreeWidgetItem*, int ) ),
-            this,       SLOT( launchEditor( QTreeWidgetItem* ) ) );
+   connect( treeView, SIGNAL( doubleClicked( const QModelIndex& ) ),
+            this,       SLOT( launchEditor( const QModelIndex& ) ) );
 
    treeView->setContextMenuPolicy( Qt::CustomContextMenu );
    connect( treeView, SIGNAL( customContextMenuRequested( const QPoint& ) ),
@@ -99,10 +97,9 @@ MemcheckView::MemcheckView( QWidget* parent )
 */
 MemcheckView::~MemcheckView()
 {
-   if ( logview != 0 ) {
-      delete logview;
-      logview = 0;
-   }
+   qDeleteAll( logviews );
+   logviews.clear();
+   logview = 0;
 }
 
 
@@ -116,17 +113,61 @@ MemcheckView::~MemcheckView()
 */
 VgLogView* MemcheckView::createVgLogView()
 {
+   QList<VgLogView*> oldLogviews = logviews;
+
+   VgLogView* lv = new MemcheckLogView();
+   logviews.clear();
+   logviews.append( lv );
+   processView->setRootLogView( lv );
+   showLogView( lv );
+
+   qDeleteAll( oldLogviews );
+   return lv;
+}
+
+/*!
+   --trace-children: another process' log, to be filled alongside
+   the root process' one (createVgLogView()).
+*/
+VgLogView* MemcheckView::createProcLogView()
+{
+   VgLogView* lv = new MemcheckLogView();
+   logviews.append( lv );
+   processView->addLogView( lv );
+   return lv;
+}
+
+/*!
+   Show one of the run's logs: the tree, filter and groups follow it.
+*/
+void MemcheckView::showLogView( VgLogView* lv )
+{
+   if ( lv == logview ) {
+      return;
+   }
+   QItemSelectionModel* oldSelection = treeView->selectionModel();
    if ( logview != 0 ) {
-      delete logview;
+      logview->disconnect( this );
    }
 
-   logview = new MemcheckLogView( treeView );
-   
-   // let filter show/hide an item
-   connect( logview, SIGNAL(errorItemAdded(VgOutputItem*)),
-            logviewFilter, SLOT(showHideItem(VgOutputItem*)) );
+   logview = lv;
+   treeView->setModel( logview );
+   delete oldSelection;
 
-   return logview;
+   // enable | disable show*Item buttons
+   connect( treeView->selectionModel(),
+            SIGNAL( currentChanged( const QModelIndex&, const QModelIndex& ) ),
+            this, SLOT( updateItemActions() ) );
+
+   // open the status row when it turns up
+   connect( logview, SIGNAL( rowsInserted( const QModelIndex&, int, int ) ),
+            this,      SLOT( rowsAdded( const QModelIndex& ) ) );
+
+   // the filter tells the model which errors to show
+   logviewFilter->setLogView( logview );
+   groupView->setLogView( logview );
+   leakView->setLogView( logview );
+   flameView->setLogView( logview );
 }
 
 
@@ -139,21 +180,51 @@ void MemcheckView::setupLayout()
    QVBoxLayout* vLayout = new QVBoxLayout( this );
    vLayout->setMargin(0);
    
-   treeView = new QTreeWidget( this );
+   treeView = new QTreeView( this );
    treeView->setObjectName( QString::fromUtf8( "treeview_Memcheck" ) );
    treeView->setHeaderHidden( true );
    treeView->setRootIsDecorated( false );
 
+   // all rows one line high: lets the view skip measuring rows
+   // it isn't showing, however many errors there are.
+   treeView->setUniformRowHeights( true );
+
    // give us a horizontal scrollbar rather than an ellipsis
    treeView->header()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
    treeView->header()->setStretchLastSection(false);
 
    // filter
-   logviewFilter = new LogViewFilterMC( this, treeView );
+   logviewFilter = new LogViewFilterMC( this );
+
+   // the errors in groups: shown instead of the tree, on demand
+   groupView = new ErrorGroupView( this );
+   groupView->hide();
+   connect( groupView, SIGNAL( errorActivated( int ) ),
+            this,        SLOT( showError( int ) ) );
+
+   // the leaks by allocation site: likewise
+   leakView = new LeakSiteView( this );
+   leakView->hide();
+   connect( leakView, SIGNAL( errorActivated( int ) ),
+            this,       SLOT( showError( int ) ) );
+
+   // the stacks' call paths, as a flame graph
+   flameView = new FlameGraphView( this );
+   flameView->hide();
+
+   // --trace-children: the processes, to pick one's log
+   processView = new ProcessView( this );
+   processView->hide();
+   connect( processView, SIGNAL( logViewSelected( VgLogView* ) ),
+            this,          SLOT( showLogView( VgLogView* ) ) );
 
    // layout
+   vLayout->addWidget( processView );
    vLayout->addWidget( logviewFilter );
    vLayout->addWidget( treeView );
+   vLayout->addWidget( groupView );
+   vLayout->addWidget( leakView );
+   vLayout->addWidget( flameView );
 }
 
 
@@ -205,6 +276,11 @@ void MemcheckView::setupActions()
    act_SaveLog->setIcon( icon_savelog );
    act_SaveLog->setIconVisibleInMenu( true );
    connect( act_SaveLog, SIGNAL( triggered() ), this, SIGNAL( saveLogFile() ) );
+
+   // menu only: no icon for it
+   act_DiffLog = new QAction( this );
+   act_DiffLog->setObjectName( QString::fromUtf8( "act_DiffLog" ) );
+   connect( act_DiffLog, SIGNAL( triggered() ), this, SIGNAL( diffLogFile() ) );
    
    act_enableFilter = new QAction( this );
    act_enableFilter->setObjectName( QString::fromUtf8( "act_enableFilter" ) );
@@ -219,6 +295,33 @@ void MemcheckView::setupActions()
    act_enableFilter->setChecked( true );
    connect( act_enableFilter, SIGNAL(toggled(bool)),
             logviewFilter, SLOT(enableFilter(bool)) );
+
+   act_GroupErrors = new QAction( this );
+   act_GroupErrors->setObjectName( QString::fromUtf8( "act_GroupErrors" ) );
+   QIcon icon_groups;
+   icon_groups.addPixmap( QPixmap( QString::fromUtf8( ":/vk_icons/icons/vglogview_groups.xpm" ) ) );
+   act_GroupErrors->setIcon( icon_groups );
+   act_GroupErrors->setIconVisibleInMenu( true );
+   act_GroupErrors->setCheckable( true );
+   act_GroupErrors->setChecked( false );
+   connect( act_GroupErrors, SIGNAL( toggled( bool ) ),
+            this,              SLOT( showGroups( bool ) ) );
+
+   // menu only: no icon for it
+   act_LeakSites = new QAction( this );
+   act_LeakSites->setObjectName( QString::fromUtf8( "act_LeakSites" ) );
+   act_LeakSites->setCheckable( true );
+   act_LeakSites->setChecked( false );
+   connect( act_LeakSites, SIGNAL( toggled( bool ) ),
+            this,            SLOT( showLeaks( bool ) ) );
+
+   // menu only: likewise
+   act_FlameGraph = new QAction( this );
+   act_FlameGraph->setObjectName( QString::fromUtf8( "act_FlameGraph" ) );
+   act_FlameGraph->setCheckable( true );
+   act_FlameGraph->setChecked( false );
+   connect( act_FlameGraph, SIGNAL( toggled( bool ) ),
+            this,             SLOT( showFlameGraph( bool ) ) );
    
    // ------------------------------------------------------------
    // initialise actions (enable / disable)
@@ -237,9 +340,18 @@ void MemcheckView::setupActions()
    act_OpenLog->setToolTip( tr( "Open Memcheck XML log" ) );
    act_SaveLog->setText(    tr( "Save Log" ) );
    act_SaveLog->setToolTip( tr( "Save Valgrind output to an XML log" ) );
+   act_DiffLog->setText(    tr( "Compare with baseline..." ) );
+   act_DiffLog->setToolTip( tr( "Show the errors new, fixed, and changed in count since a baseline log" ) );
    
    act_enableFilter->setText( tr( "Filters on/off" ) );
    act_enableFilter->setToolTip( tr( "Enable or disable the temporary log filters." ) );
+
+   act_GroupErrors->setText( tr( "Group errors" ) );
+   act_GroupErrors->setToolTip( tr( "Show the errors grouped by kind and top stack frames" ) );
+   act_LeakSites->setText( tr( "Leaks by site" ) );
+   act_LeakSites->setToolTip( tr( "Show the leaked bytes and blocks totalled by allocation site" ) );
+   act_FlameGraph->setText( tr( "Flame graph" ) );
+   act_FlameGraph->setToolTip( tr( "Show the call paths of all errors and leaks, weighed by count or leaked bytes" ) );
    
 }
 
@@ -260,6 +372,7 @@ void MemcheckView::setupToolBar()
    toolToolBar->addAction( act_OpenLog );
    toolToolBar->addAction( act_SaveLog );
    toolToolBar->addAction( act_enableFilter );
+   toolToolBar->addAction( act_GroupErrors );
    
    // ------------------------------------------------------------
    // Memcheck menu (created in base class)
@@ -271,7 +384,11 @@ void MemcheckView::setupToolBar()
    toolMenu->addAction( act_ShowSrcPaths );
    toolMenu->addAction( act_OpenLog );
    toolMenu->addAction( act_SaveLog );
+   toolMenu->addAction( act_DiffLog );
    toolMenu->addAction( act_enableFilter );
+   toolMenu->addAction( act_GroupErrors );
+   toolMenu->addAction( act_LeakSites );
+   toolMenu->addAction( act_FlameGraph );
 }
 
 
@@ -291,25 +408,26 @@ void MemcheckView::setState( bool run )
       act_OpenClose_all->setEnabled( false );
       act_ShowSrcPaths->setEnabled( false );
       act_SaveLog->setEnabled( false );
+      act_DiffLog->setEnabled( false );
       
       this->setCursor( QCursor( Qt::WaitCursor ) );
-      treeView->clear();
    }
    else {
       unsetCursor();
       
       // ... turn on again only if they can be used
-      bool tree_empty = ( treeView->topLevelItemCount() == 0 );
+      bool tree_empty = ( logview == 0 || logview->rowCount() == 0 );
       act_OpenClose_item->setEnabled( false );       // can't enable before item clicked
       act_OpenClose_all->setEnabled( !tree_empty );  // enable only if sthng in tree
       act_ShowSrcPaths->setEnabled( !tree_empty );   // enable only if sthng in tree
       act_SaveLog->setEnabled( !tree_empty );
+      act_DiffLog->setEnabled( !tree_empty );
    }
 }
 
 
 /*!
-    Launches an editor for the given \a item.
+    Launches an editor for the given \a index.
     Checks if the itemType() is of type SRC_CODE,
     and if the referenced file isReadable|isWriteable.
     If these checks are passed, the (option-configurable) editor
@@ -318,26 +436,25 @@ void MemcheckView::setState( bool run )
 
     TODO: what if fails tests: user message?
 */
-void MemcheckView::launchEditor( QTreeWidgetItem* item )
+void MemcheckView::launchEditor( const QModelIndex& index )
 {
-   vkDebug( "MemcheckView::launchEditor( %s )", qPrintable( item->text( 0 ) ) );
+   vkDebug( "MemcheckView::launchEditor( %s )",
+            qPrintable( index.data().toString() ) );
 
-   VgOutputItem* vgItemCurr = (VgOutputItem*)item;
-   if ( !vgItemCurr ||
-        !vgItemCurr->parent() ) {
+   if ( logview == 0 || !index.parent().isValid() ) {
       return;
    }
 
-   // only interested in SrcItem items (== LINE type)
-   if ( vgItemCurr->elemType() != VG_ELEM::LINE ||
-        vgItemCurr->parent()->elemType() != VG_ELEM::FRAME ) {
+   // only interested in source lines (== LINE type, under a frame)
+   if ( logview->elemType( index ) != VG_ELEM::LINE ||
+        logview->elemType( index.parent() ) != VG_ELEM::FRAME ) {
       return;
    }
 
    // nothing to do if not even readable :-(
-   // in principle, if a src item is visible, it should be readable,
+   // in principle, if a src line is visible, it should be readable,
    // but you never know...
-   if ( !vgItemCurr->getIsReadable() ) {
+   if ( !logview->isReadable( index ) ) {
       vkError( this, "Editor Launch", "<p>Source file not readable.</p>" );
       return;
    }
@@ -352,21 +469,17 @@ void MemcheckView::launchEditor( QTreeWidgetItem* item )
    }
 
    // get path,line for this frame
-   FrameItem* frame = (FrameItem*)vgItemCurr->parent();
+   QString dir    = logview->srcDir( index );
+   QString srcloc = logview->srcFile( index );
+   quint32 line   = logview->srcLine( index );
 
-   QDomNodeList frame_details = frame->getElement().childNodes();
-   vk_assert( frame_details.count() >= 1 );   // only ip guaranteed
-   QDomElement dir    = frame_details.item( 3 ).toElement();
-   QDomElement srcloc = frame_details.item( 4 ).toElement();
-   QDomElement line   = frame_details.item( 5 ).toElement();
-
-   if ( dir.isNull() || srcloc.isNull() ) {
+   if ( dir.isEmpty() || srcloc.isEmpty() ) {
       VK_DEBUG( "MemcheckView::launchEditor(): Not enough path information." );
       vkError( this, "Editor Launch", "<p>Not enough path information.</p>" );
       return;
    }
 
-   QString path( dir.text() + '/' + srcloc.text() );
+   QString path( dir + '/' + srcloc );
    vk_assert( !path.isEmpty() );
 
    // setup args to editor
@@ -374,7 +487,7 @@ void MemcheckView::launchEditor( QTreeWidgetItem* item )
    QString  program = args.at( 0 );
    args = args.mid( 1 );
 
-   if ( line.isNull() ) {
+   if ( line == 0 ) {
       // remove any arg with "%n" in it
       QStringList lineargs = args.filter(".*%n.*");
       QStringList::iterator it = lineargs.begin();
@@ -382,7 +495,7 @@ void MemcheckView::launchEditor( QTreeWidgetItem* item )
          args.removeAll( *it );
       }
    } else {
-      args.replaceInStrings( "%n", line.text() );
+      args.replaceInStrings( "%n", QString::number( line ) );
    }
    args << path;
 
@@ -402,11 +515,12 @@ void MemcheckView::launchEditor( QTreeWidgetItem* item )
 void MemcheckView::popupMenu( const QPoint& pos )
 {
    //vkDebug( "MemcheckView::popupMenu()" );
-   VgOutputItem* item = (VgOutputItem*)treeView->itemAt( pos );
-   if ( !item ) return;
+   QModelIndex index = treeView->indexAt( pos );
+   if ( logview == 0 || !index.isValid() ) return;
+   QDomElement elem = logview->element( index );
 
    // Setup title   
-   QAction actTitle( "[Item: " + item->getElement().tagName() + "]", this );
+   QAction actTitle( "[Item: " + logview->tagName( index ) + "]", this );
    actTitle.setEnabled(false);
    QFont f = qApp->font();
    f.setBold(true);
@@ -418,8 +532,32 @@ void MemcheckView::popupMenu( const QPoint& pos )
    QAction actCopyTxt( "Copy text", this );
    QAction actCopyXML( "Copy XML", this );
    QAction actSuppr( "Add suppression", this );
-   if ( ( item->elemType() != VG_ELEM::ERROR ) )
+   if ( ( logview->elemType( index ) != VG_ELEM::ERROR ) )
       actSuppr.setEnabled( false );
+
+   // triage: kept over all runs
+   int errIdx = logview->errorIndex( index );
+   QAction actKnown( "Mark as known", this );
+   QAction actIgnore( "Ignore", this );
+   QAction actTicket( "Set ticket...", this );
+   QAction actForget( "Forget triage", this );
+   actKnown.setCheckable( true );
+   actIgnore.setCheckable( true );
+   if ( errIdx < 0 ) {
+      actKnown.setEnabled( false );
+      actIgnore.setEnabled( false );
+      actTicket.setEnabled( false );
+      actForget.setEnabled( false );
+   }
+   else {
+      VG_TRIAGE::State state = logview->triage( errIdx );
+      actKnown.setChecked( state == VG_TRIAGE::KNOWN );
+      actIgnore.setChecked( state == VG_TRIAGE::IGNORED );
+      actForget.setEnabled( state != VG_TRIAGE::NONE );
+   }
+   // rows filled from records have no xml of their own
+   if ( elem.isNull() )
+      actCopyXML.setEnabled( false );
    
    // the menu
    QMenu menu( treeView );
@@ -427,24 +565,62 @@ void MemcheckView::popupMenu( const QPoint& pos )
    menu.addAction( &actCopyTxt ); // plain text of node tree -> clipboard
    menu.addAction( &actCopyXML ); // xml of node tree -> clipboard
    menu.addAction( &actSuppr );
+   menu.addSeparator();
+   menu.addAction( &actKnown );
+   menu.addAction( &actIgnore );
+   menu.addAction( &actTicket );
+   menu.addAction( &actForget );
    
    // popup
    QAction* act = menu.exec( treeView->mapToGlobal( pos ) );
    if ( act == &actCopyTxt ) { 
-      QString txt = item->getElement().text();
+      QString txt = elem.isNull() ? index.data().toString()
+                                  : elem.text();
       QClipboard *clipboard = QApplication::clipboard();
       clipboard->setText( txt );
    }
    else if ( act == &actCopyXML ) {
       QString xml;
       QTextStream ts(&xml);
-      ts << item->getElement() << endl;
+      ts << elem << endl;
       QClipboard *clipboard = QApplication::clipboard();
       clipboard->setText( xml );
    }
+   else if ( act == &actKnown || act == &actIgnore ||
+             act == &actTicket || act == &actForget ) {
+      VG_TRIAGE::State state = logview->triage( errIdx );
+      QString ticket = logview->ticket( errIdx );
+      if ( act == &actKnown ) {
+         state = VG_TRIAGE::KNOWN;
+      }
+      else if ( act == &actIgnore ) {
+         state = VG_TRIAGE::IGNORED;
+      }
+      else if ( act == &actForget ) {
+         state = VG_TRIAGE::NONE;
+         ticket = QString();
+      }
+      else {
+         bool ok;
+         ticket = QInputDialog::getText( this, "Set ticket", "Ticket id:",
+                                         QLineEdit::Normal, ticket, &ok ).trimmed();
+         if ( !ok ) {
+            return;
+         }
+         // a ticket is being dealt with
+         if ( state == VG_TRIAGE::NONE ) {
+            state = VG_TRIAGE::KNOWN;
+         }
+      }
+      if ( !logview->setTriage( errIdx, state, ticket ) ) {
+         vkError( this, "Triage Error",
+                  "<p>Failed to save to the known-errors database:<br>%s</p>",
+                  qPrintable( VgKnownErrors::dbPath() ) );
+      }
+   }
    else if ( act == &actSuppr ) {
-      // get suppression from ErrorItem
-      QString str_supp = ((ErrorItem*)item)->getSuppressionStr();
+      // get suppression from the error
+      QString str_supp = logview->suppressionStr( index );
 
       if ( str_supp.isEmpty() ) {
          vkPrintErr("No suppression found for this Error");
@@ -476,25 +652,24 @@ void MemcheckView::showSrcPath()
 {
    //vkDebug( "MemcheckView::showSrcPath()" );
 
-   if ( treeView->topLevelItemCount() == 0 ) {
+   if ( logview == 0 || logview->rowCount() == 0 ) {
       return;
    }
-   VgOutputItem* vgItemTop = (VgOutputItem*)treeView->topLevelItem( 0 );
+   QModelIndex idxTop = logview->statusIndex();
 
-   VgOutputItem* vgItem = (VgOutputItem*)treeView->currentItem();
-   if ( !vgItem ) {
-      vgItem = vgItemTop;
+   QModelIndex idx = treeView->currentIndex();
+   if ( !idx.isValid() ) {
+      idx = idxTop;
    }
 
    // if we're top dog, show full src path for all _open_ error items.
    // Note: not supporting UNshow for all. Don't think worth the effort.
-   if ( vgItem == vgItemTop ) {
-      for ( int i=0; i<vgItem->childCount(); ++i ) {
-         VgOutputItem* child = (VgOutputItem*)vgItem->child( i );
-         if ( child->isExpanded() &&
-              child->elemType() == VG_ELEM::ERROR ) {
-            ErrorItem* error = (ErrorItem*)vgItem->child( i );
-            error->showFullSrcPath( true );
+   if ( idx == idxTop ) {
+      for ( int i=0; i<logview->rowCount( idxTop ); ++i ) {
+         QModelIndex child = logview->index( i, 0, idxTop );
+         if ( treeView->isExpanded( child ) &&
+              logview->elemType( child ) == VG_ELEM::ERROR ) {
+            logview->showFullSrcPath( child, true );
          }
       }
       return;
@@ -503,18 +678,16 @@ void MemcheckView::showSrcPath()
    // else, we're not top level item...
    // in case we're hanging out on a branch somewhere,
    // crawl up the branch until we're a first-child item
-   vk_assert( vgItem->parent() != 0 );
-   vk_assert( vgItem != vgItemTop );
-   while ( vgItem->parent() != vgItemTop ) {
-      vgItem = vgItem->parent();
+   vk_assert( idx.parent().isValid() );
+   while ( idx.parent() != idxTop ) {
+      idx = idx.parent();
    }
 
    // if we're an _open_ ERROR-item, then show src path for this item only.
    // Toggling of show-full-src-paths supported for this case.
-   if ( vgItem->isExpanded() &&
-        vgItem->elemType() == VG_ELEM::ERROR ) {
-      ErrorItem* error = (ErrorItem*)vgItem;
-      error->showFullSrcPath( !error->isFullSrcPathShown() );
+   if ( treeView->isExpanded( idx ) &&
+        logview->elemType( idx ) == VG_ELEM::ERROR ) {
+      logview->showFullSrcPath( idx, !logview->isFullSrcPathShown( idx ) );
    }
 }
 
@@ -527,13 +700,14 @@ void MemcheckView::opencloseAllItems()
 {
    //vkDebug( "MemcheckView::opencloseAllItems()" );
 
-   if ( treeView->topLevelItemCount() == 0 ) {
+   if ( logview == 0 || logview->rowCount() == 0 ) {
       // empty tree.
       return;
    }
 
-   VgOutputItem* vgItemTop = (VgOutputItem*)treeView->topLevelItem( 0 );
-   if ( !vgItemTop || vgItemTop->childCount() == 0 ) {
+   QModelIndex idxTop = logview->statusIndex();
+   int numRows = logview->rowCount( idxTop );
+   if ( numRows == 0 ) {
       vkPrintErr( "Error: listview not populated. This shouldn't happen!" );
       return;
    }
@@ -542,22 +716,22 @@ void MemcheckView::opencloseAllItems()
    // check item->isOpen, start from first error, ignore suppcounts
    bool anItemIsOpen = false;
    int idxItemERR = -1;
-   for ( int i=0; i<vgItemTop->childCount(); ++i ) {
-      VgOutputItem* child = (VgOutputItem*)vgItemTop->child( i );
+   for ( int i=0; i<numRows; ++i ) {
+      QModelIndex child = logview->index( i, 0, idxTop );
 
       // find the first ERROR element
       if ( (idxItemERR == -1) &&
-           child->elemType() == VG_ELEM::ERROR ) {
+           logview->elemType( child ) == VG_ELEM::ERROR ) {
          idxItemERR = i;
       }
 
       // and check all elements from then on for isExpanded()
       if ( idxItemERR != -1 ) {
          // skip suppressions
-         if ( child->elemType() == VG_ELEM::SUPPCOUNTS ) {
+         if ( logview->elemType( child ) == VG_ELEM::SUPPCOUNTS ) {
             continue;
          }
-         if ( child->isExpanded() ) {
+         if ( treeView->isExpanded( child ) ) {
             anItemIsOpen = true;
             break;
          }
@@ -571,13 +745,13 @@ void MemcheckView::opencloseAllItems()
 
    // iterate over the same items, opening or collapsing all.
    // note: only opening/collapsing first-child level, not all levels.
-   for ( int i=idxItemERR; i<vgItemTop->childCount(); ++i ) {
-      VgOutputItem* child = (VgOutputItem*)vgItemTop->child( i );
+   for ( int i=idxItemERR; i<numRows; ++i ) {
+      QModelIndex child = logview->index( i, 0, idxTop );
       // skip suppressions
-      if ( child->elemType() == VG_ELEM::SUPPCOUNTS ) {
+      if ( logview->elemType( child ) == VG_ELEM::SUPPCOUNTS ) {
          continue;
       }
-      child->setExpanded( !anItemIsOpen );
+      treeView->setExpanded( child, !anItemIsOpen );
    }
 
 
@@ -587,7 +761,7 @@ void MemcheckView::opencloseAllItems()
       // - giving currentItem == last branch to be collapsed.
       // Too much work to figure out if we were previously
       // inside a now collapsed branch. Just reset to top.
-      treeView->setCurrentItem( vgItemTop );
+      treeView->setCurrentIndex( idxTop );
    }
 }
 
@@ -601,41 +775,57 @@ void MemcheckView::opencloseAllItems()
 void MemcheckView::opencloseOneItem()
 {
    //vkDebug( "MemcheckView::opencloseOneItem():" );
-   QTreeWidgetItem* item = treeView->currentItem();
-   if ( item == 0 )
+   QModelIndex index = treeView->currentIndex();
+   if ( !index.isValid() )
       return;
 
-   item->setExpanded( !item->isExpanded() );
+   treeView->setExpanded( index, !treeView->isExpanded( index ) );
 }
 
 
 /*!
-  void MemcheckView::itemExpanded( QTreeWidgetItem* item )
-
-  Supports on-demand loading our VgOutputItems from our underlying model (VgElements)
-  Have to catch the treeView::itemExpanded() signal and pass it on to our
-  implementation of QTreeWidgetItem (VgOutputItem).
+  void MemcheckView::itemExpanded( const QModelIndex& index )
 
-  This should be in VgOutputItem class, but QTreeWidgetItem no longer
-  provides a virtual setExpanded() method :-(
+  The model sets up the rows on-demand (VgLogView::fetchMore()):
+  here we just open those children that open with their parent
+  (stacks, args, etc).
 */
-void MemcheckView::itemExpanded( QTreeWidgetItem* item )
+void MemcheckView::itemExpanded( const QModelIndex& index )
 {
    //vkDebug( "MemcheckView::itemExpanded():" );
-   ((VgOutputItem*)item)->openChildren();
+   if ( logview->canFetchMore( index ) ) {
+      logview->fetchMore( index );
+   }
+
+   for ( int i=0; i<logview->rowCount( index ); ++i ) {
+      QModelIndex child = logview->index( i, 0, index );
+      if ( logview->openWithParent( child ) ) {
+         treeView->expand( child );
+      }
+   }
 }
 
 
 /*!
   if we collapse a branch, set current item to branch head
 */
-void MemcheckView::itemCollapsed( QTreeWidgetItem* item )
+void MemcheckView::itemCollapsed( const QModelIndex& index )
 {
    //vkDebug( "MemcheckView::itemCollapsed():" );
 
-   if ( item != treeView->currentItem() ) {
-      // this should be a slot. grr!
-      treeView->setCurrentItem( item );
+   if ( index != treeView->currentIndex() ) {
+      treeView->setCurrentIndex( index );
+   }
+}
+
+
+/*!
+  the status row opens as soon as it's added
+*/
+void MemcheckView::rowsAdded( const QModelIndex& parent )
+{
+   if ( !parent.isValid() ) {
+      treeView->expand( logview->statusIndex() );
    }
 }
 
@@ -647,13 +837,83 @@ void MemcheckView::updateItemActions()
 {
    //vkDebug( "MemcheckView::updateItemActions():" );
 
-   QTreeWidgetItem* item = treeView->currentItem();
-   if ( !item ) {
+   QModelIndex index = treeView->currentIndex();
+   if ( !index.isValid() ) {
       act_OpenClose_item->setEnabled( false );
    }
    else {
       // item ok: contract / expand it
-      VgOutputItem* vgItem = (VgOutputItem*)item;
-      act_OpenClose_item->setEnabled( vgItem->getIsExpandable() );
+      act_OpenClose_item->setEnabled( logview->hasChildren( index ) );
+   }
+}
+
+
+/*!
+    Show the errors grouped (ErrorGroupView), or the log tree.
+*/
+void MemcheckView::showGroups( bool show )
+{
+   if ( show ) {
+      act_LeakSites->setChecked( false );
+      act_FlameGraph->setChecked( false );
+   }
+   groupView->setVisible( show );
+   groupView->setActive( show );
+   updateTreeVisible();
+}
+
+/*!
+    Show the leaks by allocation site (LeakSiteView), or the log tree.
+*/
+void MemcheckView::showLeaks( bool show )
+{
+   if ( show ) {
+      act_GroupErrors->setChecked( false );
+      act_FlameGraph->setChecked( false );
+   }
+   leakView->setVisible( show );
+   leakView->setActive( show );
+   updateTreeVisible();
+}
+
+/*!
+    Show the flame graph of call paths (FlameGraphView), or the log tree.
+*/
+void MemcheckView::showFlameGraph( bool show )
+{
+   if ( show ) {
+      act_GroupErrors->setChecked( false );
+      act_LeakSites->setChecked( false );
+   }
+   flameView->setVisible( show );
+   flameView->setActive( show );
+   updateTreeVisible();
+}
+
+/*!
+    The log tree: unless the groups, leaks or flame graph are shown instead.
+*/
+void MemcheckView::updateTreeVisible()
+{
+   bool show = !act_GroupErrors->isChecked() && !act_LeakSites->isChecked() &&
+               !act_FlameGraph->isChecked();
+   treeView->setVisible( show );
+   logviewFilter->setVisible( show );
+}
+
+
+/*!
+    An error activated in the groups or leaks: show it in the log tree.
+     - unless the filter's hiding it.
+*/
+void MemcheckView::showError( int errIdx )
+{
+   act_GroupErrors->setChecked( false );
+   act_LeakSites->setChecked( false );
+
+   QModelIndex idx = logview->errorRow( errIdx );
+   if ( idx.isValid() ) {
+      treeView->setCurrentIndex( idx );
+      treeView->scrollTo( idx, QAbstractItemView::PositionAtTop );
    }
 }
@@ -23,10 +23,14 @@
 
 #include "toolview/toolview.h"
 #include "toolview/vglogview.h"
+#include "toolview/errorgroupview.h"
+#include "toolview/flamegraphview.h"
+#include "toolview/leaksiteview.h"
+#include "toolview/processview.h"
 #include "toolview/logviewfilter_mc.h"
 
 #include <QMenu>
-#include <QTreeWidget>
+#include <QTreeView>
 #include <QToolButton>
 
 
@@ -39,6 +43,7 @@ public:
    ~MemcheckView();
    
    VgLogView* createVgLogView();
+   VgLogView* createProcLogView();
    
 public slots:
    virtual void setState( bool run );
@@ -47,16 +52,23 @@ private:
    void setupLayout();
    void setupActions();
    void setupToolBar();
+   void updateTreeVisible();
    
 private slots:
    void opencloseAllItems();
    void opencloseOneItem();
    void showSrcPath();
-   void launchEditor( QTreeWidgetItem* item );
-   void itemExpanded( QTreeWidgetItem* item );
-   void itemCollapsed( QTreeWidgetItem* item );
+   void launchEditor( const QModelIndex& index );
+   void itemExpanded( const QModelIndex& index );
+   void itemCollapsed( const QModelIndex& index );
+   void rowsAdded( const QModelIndex& parent );
+   void showGroups( bool show );
+   void showLeaks( bool show );
+   void showFlameGraph( bool show );
+   void showError( int errIdx );
    void popupMenu( const QPoint& pos );
    void updateItemActions();
+   void showLogView( VgLogView* lv );
 
 private:
    QAction* act_OpenClose_all;
@@ -64,12 +76,21 @@ private:
    QAction* act_ShowSrcPaths;
    QAction* act_OpenLog;
    QAction* act_SaveLog;
+   QAction* act_DiffLog;
    QAction* act_enableFilter;
+   QAction* act_GroupErrors;
+   QAction* act_LeakSites;
+   QAction* act_FlameGraph;
    
-   QTreeWidget* treeView;
-   VgLogView*   logview;
+   QTreeView*   treeView;
+   VgLogView*   logview;         // the one shown
+   QList<VgLogView*> logviews;   // all the run's: one per process
    
    LogViewFilterMC* logviewFilter;
+   ErrorGroupView* groupView;
+   LeakSiteView* leakView;
+   FlameGraphView* flameView;
+   ProcessView* processView;
 };
 
 #endif // __MEMCHECKVIEW_H
@@ -0,0 +1,146 @@
+/****************************************************************************
+** ProcessView implementation
+**  - the processes of a --trace-children run, by parent
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "toolview/processview.h"
+#include "utils/vk_utils.h"
+
+#include <QList>
+#include <QStringList>
+
+
+/***************************************************************************/
+/*!
+  ProcessView
+*/
+ProcessView::ProcessView( QWidget* parent )
+   : QTreeWidget( parent )
+{
+   setObjectName( QString::fromUtf8( "ProcessView" ) );
+
+   setColumnCount( 2 );
+   setHeaderLabels( QStringList() << tr( "Process" ) << tr( "Status" ) );
+   setUniformRowHeights( true );
+   setAllColumnsShowFocus( true );
+
+   connect( this, SIGNAL( currentItemChanged( QTreeWidgetItem*, QTreeWidgetItem* ) ),
+            this,   SLOT( itemSelected( QTreeWidgetItem* ) ) );
+}
+
+/*!
+  A new run, or log: logview is its (root) process.
+   - the old logviews may be deleted as soon as we're done.
+*/
+void ProcessView::setRootLogView( VgLogView* logview )
+{
+   QList<VgLogView*> old = items.keys();
+   for ( int i = 0; i < old.count(); ++i ) {
+      old.at( i )->disconnect( this );
+   }
+   items.clear();
+   logviews.clear();
+   clear();
+   hide();
+
+   QTreeWidgetItem* item = newItem( logview );
+   addTopLevelItem( item );
+   setCurrentItem( item );
+}
+
+/*!
+  Another process: a child of the root's, or of one of its children.
+*/
+void ProcessView::addLogView( VgLogView* logview )
+{
+   addTopLevelItem( newItem( logview ) );
+   show();
+}
+
+
+QTreeWidgetItem* ProcessView::newItem( VgLogView* logview )
+{
+   QTreeWidgetItem* item = new QTreeWidgetItem();
+   items.insert( logview, item );
+   logviews.insert( item, logview );
+   updateItem( item, logview );
+
+   // the status row turns up, and changes, as the log is parsed
+   connect( logview, SIGNAL( rowsInserted( const QModelIndex&, int, int ) ),
+            this,      SLOT( logViewChanged() ) );
+   connect( logview, SIGNAL( dataChanged( const QModelIndex&, const QModelIndex& ) ),
+            this,      SLOT( logViewChanged() ) );
+   return item;
+}
+
+void ProcessView::logViewChanged()
+{
+   VgLogView* logview = qobject_cast<VgLogView*>( sender() );
+   QTreeWidgetItem* item = items.value( logview, 0 );
+   if ( item != 0 ) {
+      updateItem( item, logview );
+   }
+}
+
+/*!
+  Show the process' status, and once its pid is known, put it under
+  its parent, and its children under it: whichever log came first.
+*/
+void ProcessView::updateItem( QTreeWidgetItem* item, VgLogView* logview )
+{
+   QModelIndex status = logview->statusIndex();
+   item->setText( 1, status.isValid() ? logview->data( status ).toString()
+                                      : tr( "starting ..." ) );
+
+   if ( logview->pid() < 0 || !item->text( 0 ).isEmpty() ) {
+      return;
+   }
+   item->setText( 0, QString( "==%1==" ).arg( logview->pid() ) );
+
+   // moving the current item would make another one current, briefly
+   QTreeWidgetItem* current = currentItem();
+   blockSignals( true );
+
+   QHash<VgLogView*, QTreeWidgetItem*>::const_iterator it;
+   for ( it = items.constBegin(); it != items.constEnd(); ++it ) {
+      QTreeWidgetItem* other = it.value();
+      if ( other == item ) {
+         continue;
+      }
+      if ( item->parent() == 0 && it.key()->pid() == logview->ppid() &&
+           it.key()->pid() >= 0 ) {
+         other->addChild( takeTopLevelItem( indexOfTopLevelItem( item ) ) );
+         other->setExpanded( true );
+      }
+      else if ( other->parent() == 0 && it.key()->ppid() == logview->pid() ) {
+         item->addChild( takeTopLevelItem( indexOfTopLevelItem( other ) ) );
+         item->setExpanded( true );
+      }
+   }
+
+   setCurrentItem( current );
+   blockSignals( false );
+}
+
+void ProcessView::itemSelected( QTreeWidgetItem* item )
+{
+   VgLogView* logview = logviews.value( item, 0 );
+   if ( logview != 0 ) {
+      emit logViewSelected( logview );
+   }
+}
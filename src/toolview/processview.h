@@ -0,0 +1,63 @@
+/****************************************************************************
+** ProcessView definition
+**  - the processes of a --trace-children run, by parent
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __PROCESSVIEW_H
+#define __PROCESSVIEW_H
+
+#include "toolview/vglogview.h"
+
+#include <QHash>
+#include <QTreeWidget>
+
+
+// ============================================================
+/*!
+  ProcessView: a row per process logged, each under its parent.
+   - a process is only known by its pid once its log's status is
+     in: until then, it's a top-level row.
+   - picking a row asks the tool view to show that process' log.
+   - only shown once there's more than the one process.
+*/
+class ProcessView : public QTreeWidget
+{
+   Q_OBJECT
+public:
+   ProcessView( QWidget* parent );
+
+   void setRootLogView( VgLogView* logview );
+   void addLogView( VgLogView* logview );
+
+signals:
+   void logViewSelected( VgLogView* logview );
+
+private slots:
+   void logViewChanged();
+   void itemSelected( QTreeWidgetItem* item );
+
+private:
+   QTreeWidgetItem* newItem( VgLogView* logview );
+   void updateItem( QTreeWidgetItem* item, VgLogView* logview );
+
+private:
+   QHash<VgLogView*, QTreeWidgetItem*> items;   // we don't own the logviews
+   QHash<QTreeWidgetItem*, VgLogView*> logviews;
+};
+
+#endif // #ifndef __PROCESSVIEW_H
@@ -72,11 +72,13 @@ public:
    ~ToolView();
    
    virtual VgLogView* createVgLogView() = 0;
+   virtual VgLogView* createProcLogView() = 0;
 
    void setToolFont( QFont font );
 
 signals:
    void saveLogFile();
+   void diffLogFile();
 
 protected:
    virtual void setupLayout() = 0;
@@ -1,6 +1,6 @@
 /****************************************************************************
 ** VgLogView implementation
-**  - links QDomElements with QTreeWidgetItems
+**  - item model of a valgrind log, for the tool views
 ** --------------------------------------------------------------------------
 **
 ** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
@@ -21,8 +21,16 @@
 #include "toolview/vglogview.h"
 #include "utils/vk_utils.h"
 #include "utils/vk_config.h"
+#include "utils/vgerrorxml.h"
+#include "utils/vglogquery.h"
+#include "utils/vgsrcinfo.h"
+#include "utils/vgsrcsnippets.h"
 
+#include <QBrush>
+#include <QColor>
 #include <QFileInfo>
+#include <QFont>
+#include <QPixmap>
 #include <QStringList>
 #include <QTextStream>
 
@@ -89,12 +97,12 @@ static ElemTypeMap setupElemTypeMap()
    return etmap;
 }
 
-ElemTypeMap VgOutputItem::elemtypeMap = setupElemTypeMap();
+ElemTypeMap VgLogView::elemtypeMap = setupElemTypeMap();
 
 /*!
   static access function to static map data
 */
-VG_ELEM::ElemType VgOutputItem::elemType( QString tagName )
+VG_ELEM::ElemType VgLogView::elemType( QString tagName )
 {
    ElemTypeMap::Iterator it = elemtypeMap.find( tagName );
 
@@ -105,145 +113,94 @@ VG_ELEM::ElemType VgOutputItem::elemType( QString tagName )
    return it.value();
 }
 
-/*!
-   non-static shortcut for elemType of this element
-*/
-VG_ELEM::ElemType VgOutputItem::elemType()
-{
-   return elemType( elem.tagName() );
-}
-
 
 
 // ============================================================
 /*!
-  base class for SrcItem and OutputItem
+  VgLogNode: a row of the model.
+   - children are only set up when the view first asks for them.
+   - error rows have none, until they're wanted: see errorNode().
+   - what ref refers to depends on the type:
+       ERROR: error    STACK: stack    FRAME: frame
+       PAIR: suppcount, or under an error: origin (merged logs)
+       TID, WHAT, AUXWHAT, XWHAT, XAUXWHAT: detail
+       STATUS: nothing: the text is topStatus'
+       anything else: a DomRow
 */
-VgOutputItem::VgOutputItem( QTreeWidget* parent, QDomElement el )
-   : QTreeWidgetItem( parent ), elem( el )
-{
-   initialise();
-}
-
-VgOutputItem::VgOutputItem( QTreeWidgetItem* parent, QDomElement el )
-   : QTreeWidgetItem( parent ), elem( el )
-{
-   initialise();
-}
-
-VgOutputItem::VgOutputItem( QTreeWidgetItem* parent, QTreeWidgetItem* after,
-                            QDomElement el )
-   : QTreeWidgetItem( parent, after ), elem( el )
-{
-   initialise();
+namespace VG_NODE {
+   enum Flags {
+      FETCHED   = 0x1,     // children set up
+      READABLE  = 0x2,     // frame: source is readable
+      WRITEABLE = 0x4,     // frame: source is writeable
+      FULLPATH  = 0x8,     // error: show full source paths
+      PENDING   = 0x10     // frame: source not stat'd yet (VgSrcInfo)
+   };
 }
 
-void VgOutputItem::initialise()
-{
-   isReadable = isWriteable = false;
-   isExpandable = false;
-}
-
-void VgOutputItem::setText( QString str )
-{
-   QTreeWidgetItem::setText( 0, str );
-}
+struct VgLogNode {
+   VgLogNode( VgLogNode* p, VG_ELEM::ElemType t, int r, int rw )
+      : parent( p ), ref( r ), row( rw ), type( t ), flags( 0 ) { }
+   ~VgLogNode() {
+      qDeleteAll( kids );
+   }
 
-VgOutputItem* VgOutputItem::firstChild()
-{
-   return ( VgOutputItem* )QTreeWidgetItem::child( 0 );
-}
+   VgLogNode* parent;
+   QVector<VgLogNode*> kids;
+   qint32 ref;
+   qint32 row;            // in parent->kids
+   quint8 type;           // VG_ELEM::ElemType
+   quint8 flags;          // VG_NODE::Flags
+};
 
-VgOutputItem* VgOutputItem::parent()
+static bool isDetailType( int type )
 {
-   return ( VgOutputItem* )QTreeWidgetItem::parent();
+   return ( type == VG_ELEM::WHAT  || type == VG_ELEM::AUXWHAT ||
+            type == VG_ELEM::XWHAT || type == VG_ELEM::XAUXWHAT );
 }
 
-
-/*!
-  Setup children of this item.
-  Derived items use this to load children from the model on demand.
-  Rem to call this base class version at the end of derived methods,
-  in order to finish initialisation of children.
-
-  Ideally, we'd have overloaded QWidgetTreeItem::setExpanded(),
-  but it's no longer virtual in Qt4 :-(
-*/
-void VgOutputItem::openChildren()
+static bool isSrcLine( const VgLogNode* node )
 {
-   if ( parent() == 0 ) {
-      // Top-level item: no init needed.
-      return;
-   }
-
-   // load children (overloaded by each item)
-   setupChildren();
-
-   // now we've loaded any child items from the model,
-   // we can open the item without jitter.
-   this->setExpanded( true );
+   return ( node->type == VG_ELEM::LINE &&
+            node->parent->type == VG_ELEM::FRAME );
 }
 
 
-/*!
-   since we add children on demand, we can't use childCount()
-*/
-bool VgOutputItem::getIsExpandable()
-{ return isExpandable; }
-
-bool VgOutputItem::getIsReadable()
-{ return isReadable; }
-
-bool VgOutputItem::getIsWriteable()
-{ return isWriteable; }
-
-QDomElement VgOutputItem::getElement()
-{ return elem; }
-
-
-
-
 
 // ============================================================
 /*!
-  TopStatus: first item in listview
-  as two text lines:
-  status, client exe
-  errcounts(num_errs), leak_errors(num_bytes++, num_blocks++)
+  TopStatus: text of the first row
 */
-TopStatusItem::TopStatusItem( QTreeWidget* parent, QDomElement exe,
-                              QDomElement status, QString toolstatus,
-                              QString _protocol )
-   : VgOutputItem( parent, exe ),
-     toolstatus_str( toolstatus ), num_errs( 0 ),
-     time_str(), protocol( _protocol )
+TopStatus::TopStatus( const QString& exe, const VgLogRecord& status,
+                      QString toolstatus, QString _protocol )
+   : toolstatus_str( toolstatus ), num_errs( 0 ),
+     exe_str( exe ), time_str(), protocol( _protocol )
 {
-   state_str  = status.firstChildElement( "state" ).text();
-   start_time = status.firstChildElement( "time" ).text();
+   state_str  = status.state;
+   start_time = status.time;
 
-   status_tmplt = "Valgrind: %1 '%2'  %3\nErrors: %4%5";
+   // one line: all rows are the same height.
+   status_tmplt = "Valgrind: %1 '%2'  %3   Errors: %4%5";
    updateText();
-
-   isExpandable = true;
 }
 
-void TopStatusItem::updateText()
+TopStatus::~TopStatus()
+{ }
+
+void TopStatus::updateText()
 {
    status_str = status_tmplt
                 .arg( state_str )  // STARTED|FINISHED
-                .arg( QFileInfo( elem.text() ).fileName() )       // exe
+                .arg( QFileInfo( exe_str ).fileName() )           // exe
                 .arg( time_str )                                  // time
                 .arg( num_errs )
                 .arg( toolstatus_str );
-
-   setText( status_str );
 }
 
 
 // finished
-void TopStatusItem::updateStatus( QDomElement status )
+void TopStatus::updateStatus( const VgLogRecord& status )
 {
-   state_str = status.firstChildElement( "state" ).text();
+   state_str = status.state;
 
    int sday, shours, smins, ssecs, smsecs;
    int eday, ehours, emins, esecs, emsecs;
@@ -264,7 +221,7 @@ void TopStatusItem::updateStatus( QDomElement status )
                  &sday, &shours, &smins, &ssecs, &smsecs );
 
    if ( ret == 5 ) {
-      QString end_time = status.firstChildElement( "time" ).text();
+      QString end_time = status.time;
       ret = sscanf( end_time.toAscii().constData(), "%d:%d:%d:%d.%4d",
                     &eday, &ehours, &emins, &esecs, &emsecs );
 
@@ -304,16 +261,12 @@ void TopStatusItem::updateStatus( QDomElement status )
    }
 }
 
-void TopStatusItem::updateFromErrorCounts( QDomElement errcnts )
+void TopStatus::updateFromErrorCounts( const QVector<VgLogPair>& pairs )
 {
    // sum all counts in all pairs of errorcounts
    num_errs = 0;
-   QDomNodeList pairs = errcnts.childNodes();
-   QDomElement e = pairs.item( 0 ).toElement();
-   
-   for ( ; !e.isNull(); e = e.nextSiblingElement() ) {
-      QString count = e.firstChildElement().text();
-      num_errs += count.toInt();
+   for ( int i = 0; i < pairs.count(); ++i ) {
+      num_errs += pairs.at( i ).count;
    }
 
    updateText();
@@ -322,491 +275,778 @@ void TopStatusItem::updateFromErrorCounts( QDomElement errcnts )
 
 
 
+
 // ============================================================
 /*!
-  InfoItem
-   - info: as text line: tool, pid, ppid
-   - logfilequal
-   - var: as text line
-   - value: as text line
-   - usercomment:
-   - comment: as text line
-   - args
-   - details: as text lines
+  VgLogView
 */
-InfoItem::InfoItem( VgOutputItem* parent, QDomElement root /*element:ROOT*/ )
-   : VgOutputItem( parent, root )
-{
-   QString tool = elem.firstChildElement( "tool" ).text();
-   tool[0] = tool[0].toUpper();
-   QString pid = elem.firstChildElement( "pid" ).text();
-   QString ppid = elem.firstChildElement( "ppid" ).text();
-   
-   QString content =
-      QString( "%1 output for process id ==%2== (parent pid ==%3==)" )
-      .arg( tool )
-      .arg( pid )
-      .arg( ppid );
-      
-   setText( content );
-   
-   isExpandable = true;
-}
+// error elements read back, kept for reuse
+static const int MAX_LOADED_ERRORS = 64;
 
-void InfoItem::setupChildren()
+VgLogView::VgLogView( const AcronymMap& acnymMap )
+   : topStatus( 0 ), acronyms( acnymMap ), statusNode( 0 ),
+     procPid( -1 ), procPpid( -1 ), errBase( 0 ), numErrRows( 0 ),
+     uniquesSorted( true ), filter( 0 ), filtering( false )
 {
-   if ( childCount() == 0 ) {
-      VgOutputItem* last_item = 0;
+   rootNode = new VgLogNode( 0, VG_ELEM::NUM_ELEMS, -1, 0 );
+   rootNode->flags = VG_NODE::FETCHED;
+   errXml = new VgErrorXml();
+   loadedErrors.setMaxCost( MAX_LOADED_ERRORS );
 
-      // handle any number of log-file-qualifiers
-      QDomElement logqual = elem.firstChildElement( "logfilequalifier" );
-      while ( !logqual.isNull() && logqual.tagName() == "logfilequalifier" ) {
-         last_item = new LogQualItem( this, logqual );
-         last_item->openChildren();
-         logqual = logqual.nextSiblingElement();
-      }
-      
-      // may / may not have a user comment
-      QDomElement comment = elem.firstChildElement( "usercomment" );
-      if ( ! comment.isNull() ) {
-         last_item = new VgOutputItem( this, last_item, comment );
-         last_item->setText( comment.text() );
-      }
-      
-      // args
-      QDomElement args = elem.firstChildElement( "args" );
-      last_item = new ArgsItem( this, last_item, args );
-      last_item->openChildren();
-   }
+   connect( VgSrcInfo::instance(), SIGNAL( updated() ),
+            this,                    SLOT( srcInfoUpdated() ) );
 }
 
+VgLogView::~VgLogView()
+{
+   qDeleteAll( errorNodes );
+   delete rootNode;
+   delete topStatus;
+   delete errXml;
+}
 
 
-// ============================================================
 /*!
-  LogQualItem
+  initialise our log, from its ROOT record (VgLogHandler::rootRecord())
 */
-LogQualItem::LogQualItem( VgOutputItem* parent, QDomElement logqual )
-   : VgOutputItem( parent, logqual )
+bool VgLogView::init( const VgLogRecord& root )
 {
-   setText( "logfilequalifier" );
+   if ( root.text.isEmpty() ) {
+      vkPrintErr( "VgLogView::init(): doc_tag isEmpty" );
+      return false;
+   }
 
-   isExpandable = true;
+   clearNodes();
+   rootTag = root.text;
+   logstore.clear();
+   loadedErrors.clear();
+   return true;
 }
 
-void LogQualItem::setupChildren()
+void VgLogView::clearNodes()
 {
-   if ( childCount() == 0 ) {
-      VgOutputItem* last_item = 0;
-      QDomElement var   = elem.firstChildElement();
-      QDomElement value = var.nextSiblingElement();
-#ifdef DEBUG_ON
-      if ( var.tagName() != "var" ) {
-         vkPrintErr( "LogQualItem::setupChildren(): unexpected tagName: %s",
-                     qPrintable( var.tagName() ) );
-      }
-      if ( value.tagName() != "value" ) {
-         vkPrintErr( "LogQualItem::setupChildren(): unexpected tagName: %s",
-                     qPrintable( value.tagName() ) );
-      }
-#endif
-
-      last_item = new VgOutputItem( this, last_item, var );
-      last_item->setText( var.text() + ": '" + value.text() + "'" );
-   }
+   beginResetModel();
+   qDeleteAll( rootNode->kids );
+   rootNode->kids.clear();
+   statusNode = 0;
+   delete topStatus;
+   topStatus = 0;
+   procPid = procPpid = -1;
+   rootTag = headerXml = preambleXml = QString();
+   headerTexts.clear();
+
+   qDeleteAll( errorNodes );
+   errorNodes.clear();
+   errBase = numErrRows = 0;
+   topErrsBefore.clear();
+   uniquesSorted = true;
+   errorIdxs.clear();
+   errorKeys.clear();
+   domRows.clear();
+   visible.clear();
+   visibleRow.clear();
+   srcPathIds.clear();
+   srcFrames.clear();
+   endResetModel();
 }
 
 
 
-// ============================================================
 /*!
-  ArgsItem
+  Populate our model (VgLogStore + rows)
+   - the records of top-level xml elements are pushed to us from
+     the parser
+   - the header's (everything before the status) are kept as xml,
+     for the info rows: the rest's xml goes with their rows, if they
+     have one.  Errors and errorcounts come without any: the record
+     has all we need.
+
+  Tool-logviews can do stuff with the record,
+  a-la "Template Method", by implementing appendNodeTool().
 */
-ArgsItem::ArgsItem( VgOutputItem* parent, QTreeWidgetItem* after,
-                    QDomElement args )
-   : VgOutputItem( parent, after, args )
+bool VgLogView::appendNode( VgLogRecord& rec, QString& errMsg )
 {
-   setText( "args" );
-   isExpandable = true;
-}
+   errMsg = "";
 
-void ArgsItem::setupChildren()
-{
-   if ( childCount() == 0 ) {
-      QDomElement vgInfo = elem.firstChildElement( "vargv" );
-      QDomElement exInfo = elem.firstChildElement( "argv" );
-      
-      VgOutputItem* last_item = 0;
-      QDomElement e = vgInfo.firstChildElement();
-      for ( ; !e.isNull(); e = e.nextSiblingElement() ) {
-#ifdef DEBUG_ON
-         if ( e.tagName() != "exe" && e.tagName() != "arg" ) {
-            vkPrintErr( "ArgsItem::setupChildren(): unexpected tagName: %s",
-                        qPrintable( e.tagName() ) );
-         }
-#endif
-         last_item = new VgOutputItem( this, last_item, e );
-         last_item->setText( e.text() );
+   if ( rootTag.isEmpty() ) {
+      errMsg = "Program error: VgLog not initialised";
+      vkPrintErr( "%s", qPrintable( "VgLogView::appendNode(): " + errMsg ) );
+      return false;
+   }
+
+   VG_ELEM::ElemType elemtype = rec.type;
+
+   // check elem is a top-level xml chunk
+   if ( elemtype == VG_ELEM::NUM_ELEMS ) {
+      QString tag = rec.xml.mid( 1, rec.xml.indexOf( '>' ) - 1 );
+      errMsg = "Unrecognised tagname: (" + tag + ")";
+      vkPrintErr( "%s", qPrintable( "VgLogView::appendNode(): " + errMsg ) );
+      return false;
+   }
+
+   // the header: shown as the info rows, once the status is in
+   if ( statusNode == 0 && elemtype != VG_ELEM::STATUS && !rec.xml.isEmpty() ) {
+      headerXml += rec.xml;
+      if ( elemtype == VG_ELEM::PREAMBLE ) {
+         preambleXml = rec.xml;
       }
-      
-      e = exInfo.firstChildElement();
-      for ( ; !e.isNull(); e = e.nextSiblingElement() ) {
-#ifdef DEBUG_ON
-         if ( e.tagName() != "exe" && e.tagName() != "arg" ) {
-            vkPrintErr( "ArgsItem::setupChildren(): unexpected tagName: %s",
-                        qPrintable( e.tagName() ) );
-         }
-#endif
-         last_item = new VgOutputItem( this, last_item, e );
-         last_item->setText( e.text() );
+      else if ( elemtype == VG_ELEM::ARGS ) {
+         headerTexts.insert( VG_ELEM::EXE, rec.exe );
+      }
+      else {
+         headerTexts.insert( elemtype, rec.text );
       }
    }
-}
 
 
+   // --------------------
+   // ok so far...
+   // now add the top-level rows
+   //  - rows below these are only set up on-demand
 
-// ============================================================
-/*!
-  PreambleItem
-   - preamble
-   - lines: as text lines
-*/
-PreambleItem::PreambleItem( VgOutputItem* parent,
-                            QTreeWidgetItem* after,
-                            QDomElement preamble )
-   : VgOutputItem( parent, after, preamble )
-{
-   setText( "Preamble" );
-   isExpandable = true;
-}
+   switch ( elemtype ) {
+   case VG_ELEM::PROTOCOL_VERSION: {
+      if ( rec.text != "4" ) {
+         errMsg = "Unsupported XML protocol version: (" + rec.text + ")";
+         vkPrintErr( "%s", qPrintable( "VgLogView::appendNode(): " + errMsg ) );
+         return false;
+      }
+      break;
+   }
 
-void PreambleItem::setupChildren()
-{
-   if ( childCount() == 0 ) {
-      VgOutputItem* last_item = 0;
-      QDomElement e = elem.firstChildElement();
-      for ( ; !e.isNull(); e = e.nextSiblingElement() ) {
-#ifdef DEBUG_ON
-         if ( e.tagName() != "line" ) {
-            vkPrintErr( "PreambleItem::setupChildren(): unexpected tagName: %s",
-                        qPrintable( e.tagName() ) );
-         }
-#endif
-         last_item = new VgOutputItem( this, last_item, e );
-         last_item->setText( e.text() );
+   case VG_ELEM::PROTOCOL_TOOL: {
+      QString tool = this->toolName();
+      if ( rec.text != tool ) {
+         errMsg = "Wrong tool (" + tool + ") for XML stream (" + rec.text + ")";
+         vkPrintErr( "%s", qPrintable( "VgLogView::appendNode(): " + errMsg ) );
+         return false;
       }
+      break;
    }
-}
 
+   case VG_ELEM::STATUS: {
+      if ( rec.state == "RUNNING" && statusNode == 0 ) {
+         topStatus = createTopStatus( headerTexts.value( VG_ELEM::EXE ), rec,
+                                      headerTexts.value( VG_ELEM::PROTOCOL_VERSION ) );
+
+         beginInsertRows( QModelIndex(), 0, 0 );
+         statusNode = new VgLogNode( rootNode, VG_ELEM::STATUS, -1, 0 );
+         statusNode->flags = VG_NODE::FETCHED;
+         rootNode->kids.append( statusNode );
+         endInsertRows();
+
+         // info: tool, pid, ppid
+         QString tool = headerTexts.value( VG_ELEM::TOOL );
+         tool[0] = tool[0].toUpper();
+         QString pid  = headerTexts.value( VG_ELEM::PID );
+         QString ppid = headerTexts.value( VG_ELEM::PPID );
+         procPid  = pid.toLongLong();
+         procPpid = ppid.toLongLong();
+         QString info =
+            QString( "%1 output for process id ==%2== (parent pid ==%3==)" )
+            .arg( tool )
+            .arg( pid )
+            .arg( ppid );
+         QString root = "<" + rootTag + ">" + headerXml + "</" + rootTag + ">";
+         appendTopRow( VG_ELEM::ROOT, addDomRow( root, info ) );
+         appendTopRow( VG_ELEM::PREAMBLE, addDomRow( preambleXml, "Preamble" ) );
+      }
+      else if ( topStatus != 0 ) {
+         // update topStatus
+         topStatus->updateStatus( rec );
+      }
+      break;
+   }
 
+   case VG_ELEM::ERRORCOUNTS: {
+      if ( rec.pairs.isEmpty() || topStatus == 0 ) { // ignore empty errorcounts
+         break;
+      }
 
-// ============================================================
-/*!
-  ErrorItem
-*/
-ErrorItem::ErrorItem( VgOutputItem* parent, QTreeWidgetItem* after,
-                      QDomElement err, ErrorItem::AcronymMap acnymMap )//, QString acnym )
-   : VgOutputItem( parent, after, err )
-{
-   fullSrcPathShown = false;
-   isExpandable = true;
+      // update topStatus
+      topStatus->updateFromErrorCounts( rec.pairs );
 
-   // unclear what we can expect re what/xwhat.
-   //  - give 'what' preference over 'xwhat'.
-   QString description;
-   QDomElement what = elem.firstChildElement( "what" );
-   QDomElement xwhat = elem.firstChildElement( "xwhat" );
-   if ( !what.isNull() ) {
-      description = what.text();
-   }
-   else {
-      QDomElement text = xwhat.firstChildElement( "text" );
-      description = text.text();
+      // update all non-leak errors
+      updateErrorItems( rec.pairs );
+      break;
    }
 
-   QString kind = elem.firstChildElement( "kind" ).text();
-   QString acnym = getErrorAcronym( acnymMap, kind );
+   case VG_ELEM::SUPPCOUNTS: {
+      logstore.setSuppCounts( rec );
+      if ( statusNode != 0 ) {
+         appendTopRow( VG_ELEM::SUPPCOUNTS, addDomRow( rec.xml, "Suppressed errors" ) );
+      }
+      break;
+   }
 
-   err_tmplt  = acnym + " [%1]: " + description;
-   updateCount( "1" );
-   
-   // Store suppression for later use
-   QDomElement supp = elem.firstChildElement( "suppression" );
-   if ( !supp.isNull() ) {
-      // Qt has killed the <rawtext> newlines, so convert xml to text
-      QTextStream strm(&str_supp);
+   default:
+      // may not have dealt with element yet, don't panic!
+      break;
+   }
 
-      QDomElement snameEl = supp.firstChildElement( "sname" );
-      if ( !snameEl.isNull() )
-         strm << snameEl.text();
-      QDomElement skindEl = supp.firstChildElement( "skind" );
-      if ( !skindEl.isNull() )
-         strm << endl << skindEl.text();
-      QDomElement skauxEl = supp.firstChildElement( "skaux" );
-      if ( !skauxEl.isNull() )
-         strm << endl << skauxEl.text();
 
-      QDomElement sframeEl = supp.firstChildElement( "sframe" );
-      for ( ; !sframeEl.isNull();
-              sframeEl = sframeEl.nextSiblingElement("sframe") ) {
-         QDomElement objEl = sframeEl.firstChildElement( "obj" );
-         if ( !objEl.isNull() )
-            strm << endl << "obj:" << objEl.text();
-         QDomElement funEl = sframeEl.firstChildElement( "fun" );
-         if ( !funEl.isNull() )
-            strm << endl << "fun:" << funEl.text();
-      }
+   // --------------------
+   // Allow tools to do stuff with rec, a-la "Template Method".
+   if ( ! appendNodeTool( rec, errMsg ) ) {
+      return false;
    }
-}
 
-void ErrorItem::updateCount( QString count )
-{
-//TODO: perhaps only print [count] if >1 ?
-   setText( err_tmplt.arg( count ) );
+   statusChanged();
+   return true;
 }
 
-void ErrorItem::setupChildren()
-{
-   if ( childCount() == 0 ) {
-      VgOutputItem* last_item = this;  // for listview ordering.
-
-      // iterate over all child dom elements
-      QDomElement e = elem.firstChildElement();
-      for ( ; !e.isNull(); e = e.nextSiblingElement() ) {
-         VG_ELEM::ElemType elemtype = VgOutputItem::elemType( e.tagName() );
-
-         switch ( elemtype ) {
-         case VG_ELEM::UNIQUE:
-         case VG_ELEM::KIND:
-            // ignore.
-            break;
-
-         case VG_ELEM::TID: {
-            last_item = new VgOutputItem( this, last_item, e );
-            last_item->setText( "Thread Id: " + e.text() );
-            break;
-         }
 
-         case VG_ELEM::WHAT:
-         case VG_ELEM::AUXWHAT: {
-            //Note: (xml-output.txt, 1Mar2008): Some errors may have two <auxwhat>
-            // blocks, rather than just one, resulting from DATASYMS branch merge.
-            VgOutputItem* item = new VgOutputItem( this, last_item, e );
-            item->setText( e.text() );
+/*!
+   our compact log model
+*/
+VgLogStore* VgLogView::store()
+{
+   return &logstore;
+}
 
-            QFont fnt = item->font( 0 );
-            fnt.setWeight( QFont::DemiBold );
-            fnt.setItalic( true );
-            item->setFont( 0, fnt );
 
-            last_item = item;
-            break;
-         }
+/*!
+   where errors' elements are read back from: the parser spools
+   those it can't say where they are in the log
+*/
+VgErrorXml* VgLogView::errorXml()
+{
+   return errXml;
+}
 
-         case VG_ELEM::XWHAT:
-         case VG_ELEM::XAUXWHAT: {
-            QDomElement zwhat = e;
-
-            // All XWHAT/XAUXWHAT's have a text element: print it
-            QDomElement text = zwhat.firstChildElement();
-      #ifdef DEBUG_ON
-            if ( text.tagName() != "text" ) {
-               vkPrintErr( "ErrorItemHG::setupChildrenPerTool(): unexpected"
-                           " tagName within %s: %s", qPrintable( zwhat.tagName() ),
-                           qPrintable( text.tagName() ) );
-            }
-      #endif
-            last_item = new VgOutputItem( this, last_item, text );
-            last_item->setText( text.text() );
-
-            QFont fnt = last_item->font( 0 );
-            fnt.setWeight( QFont::DemiBold );
-            fnt.setItalic( true );
-            last_item->setFont( 0, fnt );
-
-            // Ignore further XWHAT/XAUXWHAT children elements here:
-            // they are used elsewhere, e.g. for updating TopStatus.
-            break;
-         }
 
-         case VG_ELEM::STACK: {
-            VgOutputItem* stack = new StackItem( this, last_item, e );
-            stack->openChildren();
-            last_item = stack;
-            break;
-         }
+/*!
+  Add the row for a new error: called by the tool-logviews'
+  appendNodeTool(), once the error is in the store.
+*/
+void VgLogView::appendError( int errIdx )
+{
+   vk_assert( errIdx == errBase + numErrRows );
 
-         case VG_ELEM::SUPPRESSION: {
-            // don't display this here.
-            break;
-         }
+   if ( statusNode != 0 ) {
+      appendTopRow( VG_ELEM::ERROR, errIdx );
+   }
+   else {
+      // never a row
+      vkPrintErr( "VgLogView::appendError(): error before status" );
+      errBase = errIdx + 1;
+   }
 
-         default:
-            vkPrintErr( "ErrorItem::setupChildren(): unexpected tagName: %s",
-                        qPrintable( e.tagName() ) );
-            break;
-         }
+   // valgrind numbers its errors in order: then there's no need
+   // to index them by <unique>, the store's in the same order.
+   quint64 unique = logstore.error( errIdx ).unique;
+   if ( uniquesSorted && errIdx > 0 && unique <= logstore.error( errIdx - 1 ).unique ) {
+      uniquesSorted = false;
+      for ( int i = 0; i < errIdx; ++i ) {
+         errorIdxs.insert( logstore.error( i ).unique, i );
       }
    }
+   if ( !uniquesSorted ) {
+      errorIdxs.insert( unique, errIdx );
+   }
+
+   const VgErrorRec& rec = logstore.error( errIdx );
+   for ( quint32 i = 0; i < rec.numStacks; ++i ) {
+      requestSrcInfo( rec.firstStack + i );
+   }
+
+   emit errorAdded( errIdx );
 }
 
 /*!
-  returns an acronym for a given error::kind
+  As above, for helgrind's thread announcements.
+   - stackIdx: the stack of the thread's creation, -1 if none
 */
-QString ErrorItem::getErrorAcronym( ErrorItem::AcronymMap map,
-                                    QString kind )
+void VgLogView::appendAnnounceThread( const VgLogRecord& rec, const QString& text,
+                                      int stackIdx )
 {
-   AcronymMap::Iterator it = map.find( kind );
-   if ( it == map.end() ) {
-      return "???";
+   if ( statusNode != 0 ) {
+      appendTopRow( VG_ELEM::ANNOUNCETHREAD, addDomRow( rec.xml, text, stackIdx ) );
+   }
+   if ( stackIdx >= 0 ) {
+      requestSrcInfo( stackIdx );
    }
-   return it.value();
 }
 
 
 /*!
-  Shows src paths for all frames under this error
+  Have the sources of a stack's frames stat'd in the background,
+  as the stack arrives: by the time its frames are shown, their
+  permissions are (most likely) just a lookup away.
+   - each distinct dir/file pair is only asked for once.
 */
-void ErrorItem::showFullSrcPath( bool show )
-{
-   // (maybe) multiple stacks
-   for ( int i=0; i<childCount(); ++i ) {
-      StackItem* stack = (StackItem*)child( i );
-      if ( stack->elemType() == VG_ELEM::STACK ) {
-         // multiple frames
-         for ( int i=0; i<stack->childCount(); ++i ) {
-            VgOutputItem* item = (VgOutputItem*)stack->child( i );
-            if ( item->elemType() == VG_ELEM::FRAME ) {
-               QString text = ((FrameItem*)item)->describe_IP( show );
-               item->setText( text );
-            }
-         }
+void VgLogView::requestSrcInfo( int stackIdx )
+{
+   const VgStackRec& stck = logstore.stack( stackIdx );
+   for ( quint32 c = stck.top; c != 0; c = logstore.cell( c ).next ) {
+      const VgFrameRec& frm = logstore.frame( logstore.cell( c ).frame );
+      if ( frm.file == 0 ) {
+         continue;
+      }
+      quint64 key = ( ( quint64 )frm.dir << 32 ) | frm.file;
+      if ( !srcPathIds.contains( key ) ) {
+         srcPathIds.insert( key, VgSrcInfo::instance()->request( srcPath( frm ) ) );
       }
    }
-
-   fullSrcPathShown = show;
 }
 
 /*!
-  getter: isFullSrcPathShown()
+  Set frame's permission flags from what VgSrcInfo knows.
+  Returns true if they changed.
 */
-bool ErrorItem::isFullSrcPathShown()
+bool VgLogView::updateSrcFlags( VgLogNode* frame )
 {
-   return fullSrcPathShown;
+   const VgFrameRec& frm = logstore.frame( frame->ref );
+   quint64 key = ( ( quint64 )frm.dir << 32 ) | frm.file;
+   quint32 pathId = srcPathIds.value( key, 0 );
+   if ( pathId == 0 ) {
+      pathId = VgSrcInfo::instance()->request( srcPath( frm ) );
+      srcPathIds.insert( key, pathId );
+   }
+   quint8 info = VgSrcInfo::instance()->flags( pathId );
+
+   quint8 flags = frame->flags & ~( VG_NODE::READABLE | VG_NODE::WRITEABLE |
+                                    VG_NODE::PENDING );
+   if ( !( info & VG_SRC::KNOWN ) ) {
+      flags |= VG_NODE::PENDING;
+   }
+   if ( info & VG_SRC::READABLE ) {
+      flags |= VG_NODE::READABLE;
+   }
+   if ( info & VG_SRC::WRITEABLE ) {
+      flags |= VG_NODE::WRITEABLE;
+   }
+
+   bool changed = ( flags != frame->flags );
+   frame->flags = flags;
+   return changed;
 }
 
 /*!
-  getter: getSuppressionStr()
+  VgSrcInfo has stat'd some more: update the frames we've shown.
 */
-QString ErrorItem::getSuppressionStr()
+void VgLogView::srcInfoUpdated()
 {
-   return str_supp;
+   for ( int i = 0; i < srcFrames.count(); ++i ) {
+      VgLogNode* frame = srcFrames.at( i );
+      if ( updateSrcFlags( frame ) && isShown( frame ) ) {
+         QModelIndex idx = indexOf( frame );
+         emit dataChanged( idx, idx );
+      }
+   }
 }
 
 
-
-// ============================================================
 /*!
-  StackItem
+  The error with this <unique>: -1 if none.
+   - while valgrind's numbering is in order, it's a binary search
+     of the store: no index of them needed.
 */
-StackItem::StackItem( VgOutputItem* parent, QTreeWidgetItem* after,
-                      QDomElement stck )
-   : VgOutputItem( parent, after, stck )
+int VgLogView::errorOfUnique( quint64 unique ) const
 {
-   setText( "stack" );
-
-   isExpandable = true;
-}
+   if ( !uniquesSorted ) {
+      return errorIdxs.value( unique, -1 );
+   }
 
-void StackItem::setupChildren()
-{
-   if ( childCount() == 0 ) {
-      VgOutputItem* last_item = this;
-      QDomElement e = elem.firstChildElement();
-      for ( ; !e.isNull(); e = e.nextSiblingElement() ) {
-#ifdef DEBUG_ON
-         if ( e.tagName() != "frame" ) {
-            vkPrintErr( "StackItem::setupChildren(): unexpected tagName: %s",
-                        qPrintable( e.tagName() ) );
-         }
-#endif
-         last_item = new FrameItem( this, last_item, e );
-         // don't open children: just set them up.
-         last_item->setupChildren();
+   int lo = 0, hi = logstore.numErrors();
+   while ( lo < hi ) {
+      int mid = ( lo + hi ) / 2;
+      if ( logstore.error( mid ).unique < unique ) {
+         lo = mid + 1;
+      }
+      else {
+         hi = mid;
       }
    }
+   if ( lo < logstore.numErrors() && logstore.error( lo ).unique == unique ) {
+      return lo;
+   }
+   return -1;
 }
 
 
-// ============================================================
 /*!
-  FrameItem
+  Update errors from the latest <errorcounts>.
+   - one lookup per pair: errorcounts can turn up repeatedly
+     (e.g. after each VALGRIND_DO_LEAK_CHECK), for lots of errors.
+   - errors not listed keep their count: valgrind's counts only go up,
+     and leak errors aren't listed at all.
+   - the view is told of all the changed rows in one go.
 */
-FrameItem::FrameItem( VgOutputItem* parent, QTreeWidgetItem* after,
-                      QDomElement frm )
-   : VgOutputItem( parent, after, frm )
+void VgLogView::updateErrorItems( const QVector<VgLogPair>& pairs )
 {
-   // check what perms the user has w.r.t. this file
-   QDomElement srcdir  = frm.firstChildElement( "dir" );
-   QDomElement srcfile = frm.firstChildElement( "file" );
-   
-   if ( !srcfile.isNull() ) {
-      QString path;
-      
-      if ( !srcdir.isNull() ) {
-         path = srcdir.text() + "/";
+   int first = -1, last = -1;
+
+   for ( int i = 0; i < pairs.count(); ++i ) {
+      const VgLogPair& pair = pairs.at( i );
+      int errIdx = errorOfUnique( pair.unique );
+      if ( errIdx < 0 ) {
+         continue;
       }
-      
-      path += srcfile.text();
-      
-      QFileInfo fi( path );
-      
-      if ( fi.exists() && fi.isFile() /* && !fi.isSymLink() */) {
-         isReadable  = fi.isReadable();
-         isWriteable = fi.isWritable();
+      logstore.setErrorCount( errIdx, pair.count );
+
+      int row = errorRow( errIdx ).row();
+      if ( row != -1 ) {
+         first = ( first == -1 ) ? row : qMin( first, row );
+         last  = qMax( last, row );
       }
    }
-   
-   setText( describe_IP( false ) );
 
-   isExpandable = isReadable;
+   if ( first != -1 ) {
+      QModelIndex parent = indexOf( statusNode );
+      emit dataChanged( index( first, 0, parent ), index( last, 0, parent ) );
+   }
+   emit errorCountsChanged();
+}
 
-   if ( isExpandable ) {
-      QColor col( "blue" );
-      QBrush brush( col );
-      setForeground( 0, brush );
-   } else {
-      QColor col( "darkred" );
-      QBrush brush( col );
-      setForeground( 0, brush );
+void VgLogView::statusChanged()
+{
+   if ( statusNode != 0 ) {
+      QModelIndex idx = indexOf( statusNode );
+      emit dataChanged( idx, idx );
    }
 }
 
 
-void FrameItem::setupChildren()
-{
-   if ( childCount() == 0 && isExpandable ) {
-      QDomElement srcdir  = elem.firstChildElement( "dir" );
-      QDomElement srcfile = elem.firstChildElement( "file" );
-      QDomElement line    = elem.firstChildElement( "line" );
-      
-      if ( srcfile.isNull() ) {
-         return;
+
+// ============================================================
+/*
+  Rows
+*/
+/*!
+  A top-level row: its element is only built from xml if wanted.
+*/
+int VgLogView::addDomRow( const QString& xml, const QString& text, int num )
+{
+   DomRow dr;
+   dr.xml  = xml;
+   dr.text = text;
+   dr.num  = num;
+   domRows.append( dr );
+   return domRows.count() - 1;
+}
+
+/*!
+  A row under one of those: elem is from its element.
+*/
+int VgLogView::addDomRow( QDomElement elem, const QString& text, int num )
+{
+   DomRow dr;
+   dr.elem = elem;
+   dr.text = text;
+   dr.num  = num;
+   domRows.append( dr );
+   return domRows.count() - 1;
+}
+
+/*!
+  The element of a DomRow: built from its xml the first time
+  it's asked for.  Null if it has none.
+*/
+QDomElement VgLogView::rowElement( int ref ) const
+{
+   const DomRow& dr = domRows.at( ref );
+   if ( dr.elem.isNull() && !dr.xml.isEmpty() && dr.doc.isNull() ) {
+      QString errMsg;
+      if ( !dr.doc.setContent( dr.xml, &errMsg ) ) {
+         vkPrintErr( "VgLogView::rowElement(): %s", qPrintable( errMsg ) );
+         return QDomElement();
       }
-      
-      QString path;
-      if ( !srcdir.isNull() ) {
-         path = srcdir.text() + "/";
+      dr.elem = dr.doc.documentElement();
+   }
+   return dr.elem;
+}
+
+/*!
+  Add a row under the status row.
+   - errors get no node: just counted (see topAt()).
+   - when filtering, only errors matching the filter become visible.
+*/
+void VgLogView::appendTopRow( VG_ELEM::ElemType type, int ref )
+{
+   vk_assert( statusNode != 0 );
+
+   bool isError = ( type == VG_ELEM::ERROR );
+   bool show = !filtering || !isError || filter->matches( ref, logstore );
+   int pos = numErrRows + statusNode->kids.count();
+   int row = filtering ? visible.count() : pos;
+
+   if ( show ) {
+      beginInsertRows( indexOf( statusNode ), row, row );
+   }
+
+   if ( isError ) {
+      numErrRows++;
+   }
+   else {
+      int i = statusNode->kids.count();
+      statusNode->kids.append( new VgLogNode( statusNode, type, ref, i ) );
+      topErrsBefore.append( numErrRows );
+   }
+
+   if ( filtering ) {
+      visibleRow.append( show ? row : -1 );
+      if ( show ) {
+         visible.append( pos );
+      }
+   }
+
+   if ( show ) {
+      endInsertRows();
+   }
+}
+
+void VgLogView::addChild( QVector<VgLogNode*>& kids, VgLogNode* parent,
+                          VG_ELEM::ElemType type, int ref )
+{
+   kids.append( new VgLogNode( parent, type, ref, kids.count() ) );
+}
+
+
+/*!
+  Set up the children of node, from the store or the dom.
+*/
+void VgLogView::setupChildren( VgLogNode* node, QVector<VgLogNode*>& kids )
+{
+   switch ( node->type ) {
+   case VG_ELEM::ROOT: {
+      // info:
+      //  - logfilequalifiers, usercomment, args
+      QDomElement root = rowElement( node->ref );
+
+      // handle any number of log-file-qualifiers
+      QDomElement logqual = root.firstChildElement( "logfilequalifier" );
+      for ( ; !logqual.isNull();
+              logqual = logqual.nextSiblingElement( "logfilequalifier" ) ) {
+         addChild( kids, node, VG_ELEM::LOGQUAL,
+                   addDomRow( logqual, "logfilequalifier" ) );
+      }
+
+      // may / may not have a user comment
+      QDomElement comment = root.firstChildElement( "usercomment" );
+      if ( ! comment.isNull() ) {
+         addChild( kids, node, VG_ELEM::COMMENT,
+                   addDomRow( comment, comment.text() ) );
+      }
+
+      // args
+      QDomElement args = root.firstChildElement( "args" );
+      addChild( kids, node, VG_ELEM::ARGS, addDomRow( args, "args" ) );
+      break;
+   }
+
+   case VG_ELEM::LOGQUAL: {
+      QDomElement logqual = rowElement( node->ref );
+      QDomElement var   = logqual.firstChildElement();
+      QDomElement value = var.nextSiblingElement();
+#ifdef DEBUG_ON
+      if ( var.tagName() != "var" ) {
+         vkPrintErr( "VgLogView::setupChildren(): unexpected tagName: %s",
+                     qPrintable( var.tagName() ) );
+      }
+      if ( value.tagName() != "value" ) {
+         vkPrintErr( "VgLogView::setupChildren(): unexpected tagName: %s",
+                     qPrintable( value.tagName() ) );
+      }
+#endif
+      addChild( kids, node, VG_ELEM::VAR,
+                addDomRow( var, var.text() + ": '" + value.text() + "'" ) );
+      break;
+   }
+
+   case VG_ELEM::ARGS: {
+      QDomElement args = rowElement( node->ref );
+      const char* infos[] = { "vargv", "argv" };
+
+      for ( int i = 0; i < 2; ++i ) {
+         QDomElement e = args.firstChildElement( infos[i] ).firstChildElement();
+         for ( ; !e.isNull(); e = e.nextSiblingElement() ) {
+#ifdef DEBUG_ON
+            if ( e.tagName() != "exe" && e.tagName() != "arg" ) {
+               vkPrintErr( "VgLogView::setupChildren(): unexpected tagName: %s",
+                           qPrintable( e.tagName() ) );
+            }
+#endif
+            addChild( kids, node, elemType( e.tagName() ),
+                      addDomRow( e, e.text() ) );
+         }
+      }
+      break;
+   }
+
+   case VG_ELEM::PREAMBLE: {
+      QDomElement e = rowElement( node->ref ).firstChildElement();
+      for ( ; !e.isNull(); e = e.nextSiblingElement() ) {
+#ifdef DEBUG_ON
+         if ( e.tagName() != "line" ) {
+            vkPrintErr( "VgLogView::setupChildren(): unexpected tagName: %s",
+                        qPrintable( e.tagName() ) );
+         }
+#endif
+         addChild( kids, node, elemType( e.tagName() ), addDomRow( e, e.text() ) );
+      }
+      break;
+   }
+
+   case VG_ELEM::ERROR: {
+      const VgErrorRec& err = logstore.error( node->ref );
+
+      // iterate over all details of the error, in log order
+      //Note: (xml-output.txt, 1Mar2008): Some errors may have two <auxwhat>
+      // blocks, rather than just one, resulting from DATASYMS branch merge.
+      // For XWHAT/XAUXWHAT's, the detail is the text element.
+      for ( quint32 i = 0; i < err.numDetails; ++i ) {
+         const VgDetailRec& det = logstore.detail( err.firstDetail + i );
+         VG_ELEM::ElemType type = ( VG_ELEM::ElemType )det.type;
+
+         if ( type == VG_ELEM::TID || isDetailType( type ) ) {
+            addChild( kids, node, type, err.firstDetail + i );
+         }
+         else if ( type == VG_ELEM::STACK ) {
+            addChild( kids, node, type, err.firstStack + det.value );
+         }
+         else {
+            vkPrintErr( "VgLogView::setupChildren(): unexpected detail type: %d",
+                        det.type );
+         }
+      }
+
+      // merged logs: the logs it was found in
+      for ( quint32 o = err.firstOrigin; o != 0; o = logstore.origin( o ).next ) {
+         addChild( kids, node, VG_ELEM::PAIR, o );
+      }
+      break;
+   }
+
+   case VG_ELEM::ANNOUNCETHREAD:
+      addChild( kids, node, VG_ELEM::STACK, domRows.at( node->ref ).num );
+      break;
+
+   case VG_ELEM::STACK: {
+      const VgStackRec& stck = logstore.stack( node->ref );
+      for ( quint32 c = stck.top; c != 0; c = logstore.cell( c ).next ) {
+         addChild( kids, node, VG_ELEM::FRAME, logstore.cell( c ).frame );
+
+         // what perms the user has w.r.t. this file: VgSrcInfo knows.
+         VgLogNode* frame = kids.last();
+         if ( logstore.frame( frame->ref ).file != 0 ) {
+            updateSrcFlags( frame );
+            srcFrames.append( frame );
+         }
+      }
+      break;
+   }
+
+   case VG_ELEM::FRAME: {
+      // a chunk of the source file at the frame's line: a row per line
+      const VgFrameRec& frm = logstore.frame( node->ref );
+      QString path = srcPath( frm );
+
+      // num lines to show above / below the target line
+      int target_line = frm.line;
+      bool ok = false;
+      int n_lines = vkCfgProj->value( "valkyrie/src-lines" ).toInt( &ok );
+      if ( !ok ) {
+         vkPrintErr( "VgLogView::setupChildren(): failed to retrieve/convert 'src-lines' from config." );
+      }
+
+      // figure out where to start showing src lines
+      int top_line = 1;
+      if ( target_line > n_lines + 1 ) {
+         top_line = target_line - n_lines;
+      }
+      int bot_line = target_line + n_lines;
+
+      QStringList lines;
+      if ( !VgSrcSnippets::instance()->lines( path, top_line, bot_line, lines ) ) {
+         vkPrintErr( "VgLogView::setupChildren(): can't open source: %s",
+                     qPrintable( path ) );
+         break;
+      }
+      for ( int i = 0; i < lines.count(); ++i ) {
+         addChild( kids, node, VG_ELEM::LINE,
+                   addDomRow( QDomElement(), "  " + lines.at( i ), top_line + i ) );
       }
-      path += srcfile.text();
-      if ( !QFile::exists( path ) ) {
-         vkPrintErr( "FrameItem::setupChildren(): can't find source: %s, %s",
-                     qPrintable( srcdir.text() ), qPrintable( srcfile.text() ) );
-         return;
+      break;
+   }
+
+   case VG_ELEM::SUPPCOUNTS: {
+      const QVector<VgPairRec>& pairs = logstore.suppCounts();
+      for ( int i = 0; i < pairs.count(); ++i ) {
+         addChild( kids, node, VG_ELEM::PAIR, i );
+      }
+      break;
+   }
+
+   default:
+      break;
+   }
+}
+
+
+/*!
+  Rows that have (or may have) children
+*/
+bool VgLogView::canHaveChildren( const VgLogNode* node ) const
+{
+   switch ( node->type ) {
+   case VG_ELEM::ROOT:
+   case VG_ELEM::LOGQUAL:
+   case VG_ELEM::ARGS:
+   case VG_ELEM::PREAMBLE:
+   case VG_ELEM::ERROR:
+   case VG_ELEM::STACK:
+   case VG_ELEM::SUPPCOUNTS:
+      return true;
+   case VG_ELEM::ANNOUNCETHREAD:
+      return domRows.at( node->ref ).num >= 0;
+   case VG_ELEM::FRAME:
+      // not stat'd yet: find out on opening it
+      return ( node->flags & ( VG_NODE::READABLE | VG_NODE::PENDING ) ) != 0;
+   default:
+      return false;
+   }
+}
+
+
+/*!
+  The text of a row: worked out as the view asks for it.
+*/
+QString VgLogView::text( const VgLogNode* node ) const
+{
+   switch ( node->type ) {
+   case VG_ELEM::STATUS:
+      return ( topStatus != 0 ) ? topStatus->text() : QString();
+
+   case VG_ELEM::TID:
+      return "Thread Id: " + logstore.text( logstore.detail( node->ref ).value );
+
+   case VG_ELEM::WHAT:
+   case VG_ELEM::AUXWHAT:
+   case VG_ELEM::XWHAT:
+   case VG_ELEM::XAUXWHAT:
+      return logstore.text( logstore.detail( node->ref ).value );
+
+   case VG_ELEM::STACK:
+      return "stack";
+
+   case VG_ELEM::FRAME: {
+      const VgLogNode* err = errorOf( node );
+      bool withPath = ( err != 0 && ( err->flags & VG_NODE::FULLPATH ) );
+      return describe_IP( node->ref, withPath );
+   }
+
+   case VG_ELEM::PAIR: {
+      if ( node->parent->type == VG_ELEM::ERROR ) {
+         const VgOriginRec& org = logstore.origin( node->ref );
+         return QString( "%1:  " ).arg( org.count, 4 ) + logstore.str( org.log );
       }
-      
-      // create the item for the src lines
-      new SrcItem( this, line, path );
+      const VgPairRec& pr = logstore.suppCounts().at( node->ref );
+      return QString( "%1:  " ).arg( pr.count, 4 ) + logstore.text( pr.name );
+   }
+
+   default:
+      return domRows.at( node->ref ).text;
    }
 }
 
@@ -814,33 +1054,27 @@ void FrameItem::setupChildren()
 /*!
   ref: coregrind/m_debuginfo/symtab.c :: VG_(describe_IP)
 */
-QString FrameItem::describe_IP( bool withPath/*=false*/ )
+QString VgLogView::describe_IP( int frameIdx, bool withPath ) const
 {
-   QDomNodeList frame_details = elem.childNodes();
-   vk_assert( frame_details.count() >= 1 );  /* only ip guaranteed */
-   QDomElement ip     = elem.firstChildElement( "ip" );
-   QDomElement obj    = elem.firstChildElement( "obj" );
-   QDomElement fn     = elem.firstChildElement( "fn" );
-   QDomElement dir    = elem.firstChildElement( "dir" );
-   QDomElement srcloc = elem.firstChildElement( "file" );
-   QDomElement line   = elem.firstChildElement( "line" );
+   const VgFrameRec& frm = logstore.frame( frameIdx );
 
-   bool  know_fnname  = !fn.isNull();
-   bool  know_objname = !obj.isNull();
-   bool  know_srcloc  = !srcloc.isNull() && !line.isNull();
-   bool  know_dirinfo = !dir.isNull();
+   bool  know_fnname  = frm.fn != 0;
+   bool  know_objname = frm.obj != 0;
+   bool  know_srcloc  = frm.file != 0 && frm.line != 0;
+   bool  know_dirinfo = frm.dir != 0;
 
-   QString str = ip.text() + ": ";
+   // as valgrind prints it: 0x%llX
+   QString str = "0x" + QString::number( frm.ip, 16 ).toUpper() + ": ";
 
    if ( know_fnname ) {
-      str += fn.text();
+      str += logstore.str( frm.fn );
 
       if ( !know_srcloc && know_objname ) {
-         str += " (in " + obj.text() + ")";
+         str += " (in " + logstore.str( frm.obj ) + ")";
       }
    }
    else if ( know_objname && !know_srcloc ) {
-      str += "(within " + obj.text() + ")";
+      str += "(within " + logstore.str( frm.obj ) + ")";
    }
    else {
       str += "???";
@@ -850,390 +1084,787 @@ QString FrameItem::describe_IP( bool withPath/*=false*/ )
       QString path;
 
       if ( withPath && know_dirinfo ) {
-         path = dir.text() + "/";
+         path = logstore.str( frm.dir ) + "/";
       }
 
-      path += srcloc.text();
-      str += " (" + path + ":" + line.text() + ")";
+      path += logstore.str( frm.file );
+      str += " (" + path + ":" + QString::number( frm.line ) + ")";
    }
 
    return str;
 }
 
 
-
-// ============================================================
 /*!
-  class SrcItem (error::stack::frame::dir/file/line)
-   - given a valid source file path, display a chunk of the
-     offending file at the given lineno.
-   - double-click item => source file opened in an editor, at lineno.
+  dir/file of a frame's source
 */
-SrcItem::SrcItem( VgOutputItem* parent, QDomElement line, QString path )
-   : VgOutputItem( parent, line )
+QString VgLogView::srcPath( const VgFrameRec& frm ) const
 {
-   // --- setup text ---
-   int target_line = line.text().toInt();
-   
-   if ( target_line < 0 ) {
-      target_line = 0;
-   }
-   
-   // num lines to show above / below the target line
-   bool ok = false;
-   int n_lines = vkCfgProj->value( "valkyrie/src-lines" ).toInt( &ok );
-   if ( !ok ) {
-      vkPrintErr( "SrcItem::cons: failed to retrieve/convert 'src-lines' from config." );
+   QString path;
+   if ( frm.dir != 0 ) {
+      path = logstore.str( frm.dir ) + "/";
    }
+   return path + logstore.str( frm.file );
+}
 
-   // figure out where to start showing src lines
-   int top_line = 1;
-   if ( target_line > n_lines + 1 ) {
-      top_line = target_line - n_lines;
-   }
-   int bot_line = target_line + n_lines;
-   int current_line = 1;
-   
-   QFile file( path );
-   if ( !file.open( QIODevice::ReadOnly ) ) {
-      return;
-   }   
-   
-   // TODO: faster to set file pos using QFile::at(offset)
-   QString src_lines;
-   QTextStream stream( &file );
-   
-   while ( !stream.atEnd() && ( current_line <= bot_line ) ) {
-      if ( current_line < top_line ) {
-         stream.readLine();   // skip lines to top_line
-      }
-      else {
-         src_lines += "  " + stream.readLine() + "\n";
-      }
-      
-      current_line++;
+
+/*!
+  Nearest error (frame) at or above node: 0 if none
+*/
+const VgLogNode* VgLogView::errorOf( const VgLogNode* node ) const
+{
+   while ( node != 0 && node->type != VG_ELEM::ERROR ) {
+      node = node->parent;
    }
-   
-   file.close();
-   src_lines.truncate( src_lines.length() - 1 ); // remove last newline
-   
-   // --- setup item ---
-   isReadable  = parent->getIsReadable();
-   isWriteable = parent->getIsWriteable();
-   
-   // if we got this far, the source is at least readable.
-   vk_assert( isReadable == true );
+   return node;
+}
 
-   if ( isWriteable ) {  // read & write
-      setIcon( 0, QPixmap( QString::fromUtf8( ":/vk_icons/icons/vglogview_readwrite.xpm" ) ) );
+const VgLogNode* VgLogView::frameOf( const VgLogNode* node ) const
+{
+   if ( node == 0 ) {
+      return 0;
    }
-   else {                // readonly
-      setIcon( 0, QPixmap( QString::fromUtf8( ":/vk_icons/icons/vglogview_readonly.xpm" ) ) );
+   if ( node->type == VG_ELEM::FRAME ) {
+      return node;
    }
-   
-   setText( src_lines );
-
-   // pale gray background colour.
-   QColor col( "lightgrey" );
-   QBrush brush( col );
-   setBackground( 0, brush );
+   if ( isSrcLine( node ) ) {
+      return node->parent;
+   }
+   return 0;
 }
 
 
 
-
 // ============================================================
+/*
+  Node <-> index
+   - a node's row is its position in its parent's kids, except for
+     the rows under the status row.  Those are errors, in order,
+     and the few other rows (statusNode->kids) between them: a row
+     is a position in that (see topAt()), mapped through
+     visible/visibleRow while filtering.
+   - errors have no node: their index is just the error's, in the
+     store (errorId()).  A node is only made for one once it's
+     needed (opened, or its paths shown): errorNode().
+   - so data(), rowCount() etc. make no nodes: peekNode().
+*/
+
+/* error rows' internal ids: odd, so never a node's pointer */
+static quint32 errorId( int errIdx )
+{
+   return ( quint32 )errIdx * 2 + 1;
+}
+
+VgLogNode* VgLogView::nodeOf( const QModelIndex& idx ) const
+{
+   int errIdx = errorIndex( idx );
+   if ( errIdx >= 0 ) {
+      return errorNode( errIdx );
+   }
+   return idx.isValid() ? ( VgLogNode* )idx.internalPointer() : rootNode;
+}
+
 /*!
-  SuppCountsItem
-   - suppcounts
-   - pairs: as text line
+  As nodeOf(), but 0 for an error row without a node yet.
 */
-SuppCountsItem::SuppCountsItem( VgOutputItem* parent,
-                                QTreeWidgetItem* after,
-                                QDomElement sc )
-   : VgOutputItem( parent, after, sc )
+VgLogNode* VgLogView::peekNode( const QModelIndex& idx ) const
 {
-   setText( "Suppressed errors" );
+   int errIdx = errorIndex( idx );
+   if ( errIdx >= 0 ) {
+      return errorNodes.value( errIdx, 0 );
+   }
+   return idx.isValid() ? ( VgLogNode* )idx.internalPointer() : rootNode;
+}
 
-   isExpandable = true;
+/*!
+  An error's node: made the first time it's wanted.
+*/
+VgLogNode* VgLogView::errorNode( int errIdx ) const
+{
+   VgLogNode* node = errorNodes.value( errIdx, 0 );
+   if ( node == 0 ) {
+      node = new VgLogNode( statusNode, VG_ELEM::ERROR, errIdx, -1 );
+      errorNodes.insert( errIdx, node );
+   }
+   return node;
 }
 
-void SuppCountsItem::setupChildren()
+/*!
+  Position of a row under the status row, among all of them:
+  not counting the filter.
+*/
+int VgLogView::topPos( const VgLogNode* node ) const
 {
-   if ( childCount() == 0 ) {
-      VgOutputItem* child_item = 0;
-      QDomNodeList pairs = elem.childNodes();
+   if ( node->type == VG_ELEM::ERROR ) {
+      return errorPos( node->ref );
+   }
+   return node->row + topErrsBefore.at( node->row );
+}
 
-      QDomElement e = pairs.item( 0 ).toElement();
-      for ( ; !e.isNull(); e = e.nextSiblingElement() ) {
-#ifdef DEBUG_ON
-         if ( e.tagName() != "pair" ) {
-            vkPrintErr( "SuppCountsItem::setupChildren(): unexpected tagName: %s",
-                        qPrintable( e.tagName() ) );
-         }
-#endif
-         QDomElement pair = e;
-         QDomElement count = pair.firstChildElement();
-         QDomElement name = count.nextSiblingElement();
-#ifdef DEBUG_ON
-         if ( count.tagName() != "count" ) {
-            vkPrintErr( "SuppCountsItem::setupChildren(): unexpected tagName: %s",
-                        qPrintable( count.tagName() ) );
-         }
-         if ( name.tagName() != "name" ) {
-            vkPrintErr( "SuppCountsItem::setupChildren(): unexpected tagName: %s",
-                        qPrintable( name.tagName() ) );
-         }
-         QDomElement elem = name.nextSiblingElement();
-         if ( ! elem.isNull() ) {
-            vkPrintErr( "SuppCountsItem::setupChildren(): unexpected tagName: %s",
-                        qPrintable( elem.tagName() ) );
-         }
-#endif
-         QString count_str = count.text();
-         QString name_str  = name.text();
-         QString supp_str = QString( "%1:  " + name_str ).arg( count_str, 4 );
-         
-         child_item = new VgOutputItem( this, child_item, pair );
-         child_item->setText( supp_str );
+int VgLogView::errorPos( int errIdx ) const
+{
+   int i = errIdx - errBase;
+   // the other rows before it
+   QVector<int>::const_iterator it =
+      qUpperBound( topErrsBefore.begin(), topErrsBefore.end(), i );
+   return i + ( it - topErrsBefore.begin() );
+}
+
+/*!
+  The row at pos under the status row (see topPos()): its node, or
+  0 for an error, with errIdx set.
+*/
+VgLogNode* VgLogView::topAt( int pos, int& errIdx ) const
+{
+   // other rows at or before pos: each at k + topErrsBefore[k]
+   int lo = 0, hi = statusNode->kids.count();
+   while ( lo < hi ) {
+      int mid = ( lo + hi ) / 2;
+      if ( mid + topErrsBefore.at( mid ) <= pos ) {
+         lo = mid + 1;
       }
+      else {
+         hi = mid;
+      }
+   }
+
+   if ( lo > 0 && lo - 1 + topErrsBefore.at( lo - 1 ) == pos ) {
+      errIdx = -1;
+      return statusNode->kids.at( lo - 1 );
    }
+   errIdx = errBase + pos - lo;
+   return 0;
 }
 
+int VgLogView::rowOf( const VgLogNode* node ) const
+{
+   if ( node->parent == statusNode ) {
+      int pos = topPos( node );
+      return filtering ? visibleRow.at( pos ) : pos;
+   }
+   return node->row;
+}
 
+int VgLogView::childCount( const VgLogNode* node ) const
+{
+   if ( node == statusNode ) {
+      return filtering ? visible.count() : numErrRows + node->kids.count();
+   }
+   return node->kids.count();
+}
 
+QModelIndex VgLogView::childAt( const VgLogNode* node, int row ) const
+{
+   if ( node != statusNode ) {
+      return createIndex( row, 0, node->kids.at( row ) );
+   }
 
+   int errIdx;
+   VgLogNode* top = topAt( filtering ? visible.at( row ) : row, errIdx );
+   if ( top == 0 ) {
+      return createIndex( row, 0, errorId( errIdx ) );
+   }
+   return createIndex( row, 0, top );
+}
 
-// ============================================================
 /*!
-  VgLogView
+  Is node on a row: not under an error hidden by the filter
 */
-VgLogView::VgLogView( QTreeWidget* v )
-   : lastItem( 0 ), view( v )
-{}
+bool VgLogView::isShown( const VgLogNode* node ) const
+{
+   if ( !filtering ) {
+      return true;
+   }
+   while ( node != 0 && node->parent != statusNode ) {
+      node = node->parent;
+   }
+   return ( node == 0 || visibleRow.at( topPos( node ) ) != -1 );
+}
 
-VgLogView::~VgLogView()
-{ }
+QModelIndex VgLogView::indexOf( VgLogNode* node ) const
+{
+   if ( node == 0 || node == rootNode || !isShown( node ) ) {
+      return QModelIndex();
+   }
+   if ( node->type == VG_ELEM::ERROR && node->parent == statusNode ) {
+      return errorRow( node->ref );
+   }
+   return createIndex( rowOf( node ), 0, node );
+}
 
 
-/*!
-  initialise our log
+
+// ============================================================
+/*
+  QAbstractItemModel
 */
-bool VgLogView::init( QDomProcessingInstruction xml_insn, QString doc_tag )
+QModelIndex VgLogView::index( int row, int column,
+                              const QModelIndex& parent ) const
 {
-   if ( xml_insn.isNull() ) {
-      vkPrintErr( "VgLogView::init(): xml_insn isNull" );
-      return false;
+   const VgLogNode* node = peekNode( parent );
+   if ( column != 0 || node == 0 || row < 0 || row >= childCount( node ) ) {
+      return QModelIndex();
    }
+   return childAt( node, row );
+}
 
-   if ( doc_tag.isEmpty() ) {
-      vkPrintErr( "VgLogView::init(): doc_tag isEmpty" );
-      return false;
+QModelIndex VgLogView::parent( const QModelIndex& child ) const
+{
+   if ( !child.isValid() ) {
+      return QModelIndex();
    }
-
-   QString init_str;
-   QTextStream strm( &init_str, QIODevice::WriteOnly );
-   int indent = 2;
-   xml_insn.save( strm, indent );
-   strm << "<" << doc_tag << "/>";
-
-   vglog.setContent( init_str );
-   return true;
+   if ( errorIndex( child ) >= 0 ) {
+      return indexOf( statusNode );
+   }
+   return indexOf( nodeOf( child )->parent );
 }
 
+int VgLogView::rowCount( const QModelIndex& parent ) const
+{
+   if ( parent.column() > 0 ) {
+      return 0;
+   }
+   const VgLogNode* node = peekNode( parent );
+   return ( node != 0 ) ? childCount( node ) : 0;
+}
 
+int VgLogView::columnCount( const QModelIndex& ) const
+{
+   return 1;
+}
 
 /*!
-  Populate our model (QDomDocument) and the view (QListWidget)
-   - top-level xml elements are pushed to us from the parser
-   - node is reparented to the QDomDocument log
-
-  Tool-logviews can do stuff with the QDomElement, a-la "Template Method",
-  by implementing appendNodeTool().
-   - rem to set lastItem to created items, so items get added in order
+   since we add children on demand, we can't go by rowCount()
 */
-bool VgLogView::appendNode( QDomNode node, QString& errMsg )
+bool VgLogView::hasChildren( const QModelIndex& parent ) const
 {
-   errMsg = "";
-
-   // Test node validity, and attempt to populate QDomDocument model first
-   if ( vglog.isNull() ) {
-      errMsg = "Program error: VgLog not initialised";
-      vkPrintErr( "%s", qPrintable( "VgLogView::appendNode(): " + errMsg ) );
-      return false;
+   const VgLogNode* node = peekNode( parent );
+   if ( node == 0 ) {
+      // an error, not opened yet
+      return true;
    }
-
-   if ( logRoot().isNull() ) {
-      errMsg = "XML document root is null";
-      vkPrintErr( "%s", qPrintable( "VgLogView::appendNode(): " + errMsg ) );
-      return false;
+   if ( node->flags & VG_NODE::FETCHED ) {
+      return childCount( node ) > 0;
    }
+   return canHaveChildren( node );
+}
 
-   QDomElement elem = node.toElement();
-   if ( elem.isNull() ) {
-      errMsg = "XML Node not an element (" + node.firstChild().nodeValue() + ")";
-      vkPrintErr( "%s", qPrintable( "VgLogView::appendNode(): " + errMsg ) );
-      return false;
+bool VgLogView::canFetchMore( const QModelIndex& parent ) const
+{
+   const VgLogNode* node = peekNode( parent );
+   if ( node == 0 ) {
+      return true;
    }
+   return !( node->flags & VG_NODE::FETCHED ) && canHaveChildren( node );
+}
 
-   // reparent node
-   QDomNode n = logRoot().appendChild( node );
-   if ( n.isNull() ) {
-      errMsg = "Program error: Failed to reparent node: (" + elem.tagName() + ")";
-      vkPrintErr( "%s", qPrintable( "VgLogView::appendNode(): " + errMsg ) );
-      return false;
+/*!
+  On-demand loading of children: when the view opens a branch.
+*/
+void VgLogView::fetchMore( const QModelIndex& parent )
+{
+   VgLogNode* node = nodeOf( parent );
+   if ( node->flags & VG_NODE::FETCHED ) {
+      return;
    }
+   node->flags |= VG_NODE::FETCHED;
 
-   // check elem is a top-level xml chunk
-   VG_ELEM::ElemType elemtype = VgOutputItem::elemType( elem.tagName() );
-   if ( elemtype == VG_ELEM::NUM_ELEMS ) {
-      errMsg = "Unrecognised tagname: (" + elem.tagName() + ")";
-      vkPrintErr( "%s", qPrintable( "VgLogView::appendNode(): " + errMsg ) );
-      return false;
+   QVector<VgLogNode*> kids;
+   setupChildren( node, kids );
+   if ( kids.isEmpty() ) {
+      return;
    }
 
+   beginInsertRows( parent, 0, kids.count() - 1 );
+   node->kids = kids;
+   endInsertRows();
+}
 
-   // --------------------
-   // ok so far...
-   // now populate view with top-level items, from our model (QDomElements)
-   //  - children of these view items are only populated on-demand
+/*!
+  An error row's data: from the store, no node needed.
+*/
+QVariant VgLogView::errorData( int errIdx, int role ) const
+{
+   switch ( role ) {
+   case Qt::DisplayRole: {
+      QString tkt = ticket( errIdx );
+      return tkt.isEmpty() ? errorText( errIdx )
+                           : errorText( errIdx ) + "  {" + tkt + "}";
+   }
 
-   switch ( elemtype ) {
-   case VG_ELEM::PROTOCOL_VERSION: {
-      if ( elem.text() != "4" ) {
-         errMsg = "Unsupported XML protocol version: (" + elem.text() + ")";
-         vkPrintErr( "%s", qPrintable( "VgLogView::appendNode(): " + errMsg ) );
-         return false;
+   case Qt::ForegroundRole:
+      if ( triage( errIdx ) == VG_TRIAGE::IGNORED ) {
+         return QBrush( QColor( "gray" ) );
       }
       break;
-   }
 
-   case VG_ELEM::PROTOCOL_TOOL: {
-      QString tool = this->toolName();
-      if ( elem.text() != tool ) {
-         errMsg = "Wrong tool (" + tool + ") for XML stream (" + elem.text() + ")";
-         vkPrintErr( "%s", qPrintable( "VgLogView::appendNode(): " + errMsg ) );
-         return false;
+   case Qt::FontRole:
+      // new errors stand out: if anything's been triaged at all
+      if ( !VgKnownErrors::global().isEmpty() &&
+           triage( errIdx ) == VG_TRIAGE::NONE ) {
+         QFont fnt;
+         fnt.setBold( true );
+         return fnt;
       }
       break;
+
+   default:
+      break;
    }
 
-   case VG_ELEM::STATUS: {
-      QDomElement status = elem;
-      if ( status.firstChildElement().text() == "RUNNING" ) {
-         QDomElement exe = logRoot().firstChildElement( "args" )
-                           .firstChildElement( "argv" ).firstChildElement( "exe" );
+   return QVariant();
+}
 
-         QDomElement protocol = logRoot().firstChildElement( "protocolversion" );
+QVariant VgLogView::data( const QModelIndex& index, int role ) const
+{
+   if ( !index.isValid() ) {
+      return QVariant();
+   }
+   int errIdx = errorIndex( index );
+   if ( errIdx >= 0 ) {
+      return errorData( errIdx, role );
+   }
+   const VgLogNode* node = nodeOf( index );
 
-         topStatus = createTopStatus( view, exe, status, protocol.text() );
-         topStatus->setExpanded( true );
+   switch ( role ) {
+   case Qt::DisplayRole:
+      return text( node );
 
-         lastItem = new InfoItem( topStatus, logRoot() );
-         lastItem->setChildIndicatorPolicy( QTreeWidgetItem::ShowIndicator );
+   case Qt::ForegroundRole:
+      if ( node->type == VG_ELEM::FRAME && !( node->flags & VG_NODE::PENDING ) ) {
+         bool readable = ( node->flags & VG_NODE::READABLE );
+         return QBrush( QColor( readable ? "blue" : "darkred" ) );
+      }
+      break;
 
-         QDomElement preamble = logRoot().firstChildElement( "preamble" );
-         lastItem = new PreambleItem( topStatus, lastItem, preamble );
+   case Qt::FontRole:
+      if ( isDetailType( node->type ) ) {
+         QFont fnt;
+         fnt.setWeight( QFont::DemiBold );
+         fnt.setItalic( true );
+         return fnt;
       }
-      else {
-         // update topStatus
-         topStatus->updateStatus( status );
+      break;
+
+   case Qt::BackgroundRole:
+      if ( isSrcLine( node ) ) {
+         // pale gray background colour.
+         return QBrush( QColor( "lightgrey" ) );
       }
       break;
-   }
 
-   case VG_ELEM::ERRORCOUNTS: {
-      if ( elem.childNodes().count() == 0 ) { // ignore empty errorcounts
-         break;
+   case Qt::DecorationRole:
+      // the frame's own line
+      if ( isSrcLine( node ) &&
+           ( quint32 )domRows.at( node->ref ).num == logstore.frame( node->parent->ref ).line ) {
+         static const QPixmap pixReadWrite( QString::fromUtf8( ":/vk_icons/icons/vglogview_readwrite.xpm" ) );
+         static const QPixmap pixReadOnly( QString::fromUtf8( ":/vk_icons/icons/vglogview_readonly.xpm" ) );
+         bool writeable = ( node->parent->flags & VG_NODE::WRITEABLE );
+         return writeable ? pixReadWrite : pixReadOnly;
       }
+      break;
 
-      // update topStatus
-      topStatus->updateFromErrorCounts( elem );
-      
-      // update all non-leak errors
-      updateErrorItems( elem );
+   default:
       break;
    }
 
-   case VG_ELEM::SUPPCOUNTS: {
-      lastItem = new SuppCountsItem( topStatus, lastItem, elem );
-      break;
+   return QVariant();
+}
+
+
+
+// ============================================================
+/*
+  Row access for the tool views
+*/
+QModelIndex VgLogView::statusIndex() const
+{
+   return indexOf( statusNode );
+}
+
+VG_ELEM::ElemType VgLogView::elemType( const QModelIndex& idx ) const
+{
+   if ( errorIndex( idx ) >= 0 ) {
+      return VG_ELEM::ERROR;
    }
+   return ( VG_ELEM::ElemType )nodeOf( idx )->type;
+}
 
-   default:
-      // may not have dealt with element yet, don't panic!
-      break;
+/*!
+   tagname of this row: by its type, without building its element,
+   unless it's a tag we don't know.
+*/
+QString VgLogView::tagName( const QModelIndex& idx ) const
+{
+   VG_ELEM::ElemType type = elemType( idx );
+   if ( type != VG_ELEM::NUM_ELEMS ) {
+      return elemtypeMap.key( type );
    }
+   return element( idx ).tagName();
+}
 
+/*!
+   the element of this row, if it has one
+*/
+QDomElement VgLogView::element( const QModelIndex& idx ) const
+{
+   int errIdx = errorIndex( idx );
+   if ( errIdx >= 0 ) {
+      return errorElement( errIdx );
+   }
+   const VgLogNode* node = nodeOf( idx );
+   if ( node == rootNode || node->type == VG_ELEM::STATUS ||
+        node->type == VG_ELEM::TID || isDetailType( node->type ) ||
+        node->type == VG_ELEM::STACK || node->type == VG_ELEM::FRAME ||
+        node->type == VG_ELEM::PAIR ) {
+      return QDomElement();
+   }
+   return rowElement( node->ref );
+}
 
-   // --------------------
-   // Allow tools to do stuff with elem, a-la "Template Method".
-   if ( ! appendNodeTool( elem, errMsg ) ) {
-      return false;
+/*!
+  An error's element: read back from where the parser said it is
+  (VgErrorRec::source), as it's wanted.  Null if it can't be.
+*/
+QDomElement VgLogView::errorElement( int errIdx ) const
+{
+   QDomDocument* doc = loadedErrors.object( errIdx );
+   if ( doc != 0 ) {
+      return doc->documentElement();
    }
 
+   const VgErrorRec& rec = logstore.error( errIdx );
+   QByteArray bytes = errXml->read( rec.source, rec.offset, rec.length );
+   if ( bytes.isEmpty() ) {
+      vkPrintErr( "VgLogView::errorElement(): failed to read '%s'",
+                  qPrintable( logstore.str( rec.source ) ) );
+      return QDomElement();
+   }
 
-   // --------------------
-   // Set properties for all new items
-   if ( lastItem ) {
-      lastItem->setChildIndicatorPolicy( QTreeWidgetItem::ShowIndicator );
+   doc = new QDomDocument();
+   QString errMsg;
+   if ( !doc->setContent( bytes, &errMsg ) ) {
+      vkPrintErr( "VgLogView::errorElement(): %s", qPrintable( errMsg ) );
+      delete doc;
+      return QDomElement();
    }
 
-   return true;
+   QDomElement err = doc->documentElement();
+   errorElementLoaded( err );
+   loadedErrors.insert( errIdx, doc );
+   return err;
 }
 
+/*!
+  For tool-logviews to do to an error's element what they did
+  as it was parsed.
+*/
+void VgLogView::errorElementLoaded( QDomElement ) const
+{ }
+
 
 /*!
-   document element: <valgrindoutput/>
+   rows opened along with their parent
 */
-QDomElement VgLogView::logRoot()
+bool VgLogView::openWithParent( const QModelIndex& idx ) const
 {
-   return vglog.documentElement();
+   VG_ELEM::ElemType type = elemType( idx );
+   return ( type == VG_ELEM::STACK || type == VG_ELEM::LOGQUAL ||
+            type == VG_ELEM::ARGS );
 }
 
 
 /*!
-  iterate over all errors in the listview, looking for a match on
-  error->unique with ecounts->pairList->unique.  if we find a match,
-  update the error's num_times value
+  the process logged: -1 until its status is in
 */
-void VgLogView::updateErrorItems( QDomElement ec )
+qint64 VgLogView::pid() const
 {
-   for ( int i=0; i<topStatus->childCount(); ++i ) {
-      VgOutputItem* vgItem = (VgOutputItem*)topStatus->child( i );
+   return procPid;
+}
 
-      if ( vgItem->elemType() != VG_ELEM::ERROR ) {
-         continue;
-      }
+qint64 VgLogView::ppid() const
+{
+   return procPpid;
+}
 
-      ErrorItem* vgItemError = ( ErrorItem* )vgItem;
 
-      QString count = "1"; // can't have less than 1 for a reported error
-      QString err_unique = vgItemError->getElement().firstChildElement().text();
+/*!
+  index of the error's record in the store: -1 if not an error row
+*/
+int VgLogView::errorIndex( const QModelIndex& idx ) const
+{
+   if ( !idx.isValid() || !( idx.internalId() & 1 ) ) {
+      return -1;
+   }
+   return ( int )( idx.internalId() >> 1 );
+}
 
-      // search errorcount pairs for err_unique
-      QDomNodeList pairs = ec.childNodes();
-      for ( int i = 0; i < pairs.count(); i++ ) {
-         QDomNode pair = pairs.item( i );
-         QDomNodeList pair_details = pair.childNodes();
-         QString unique = pair_details.item( 1 ).toElement().text();
+/*!
+  the row of an error: invalid if hidden by the filter
+*/
+QModelIndex VgLogView::errorRow( int errIdx ) const
+{
+   if ( statusNode == 0 || errIdx < errBase || errIdx >= errBase + numErrRows ) {
+      return QModelIndex();
+   }
+   int pos = errorPos( errIdx );
+   int row = filtering ? visibleRow.at( pos ) : pos;
+   if ( row < 0 ) {
+      return QModelIndex();
+   }
+   return createIndex( row, 0, errorId( errIdx ) );
+}
 
-         if ( err_unique == unique ) {
-            count = pair_details.item( 0 ).toElement().text();
-            break;
-         }
+QString VgLogView::errorText( int errIdx ) const
+{
+   // what/xwhat preference already sorted out by the store.
+   const VgErrorRec& err = logstore.error( errIdx );
+//TODO: perhaps only print [count] if >1 ?
+   return acronym( err.kind ) + " [" + QString::number( err.count ) + "]: "
+          + logstore.text( err.what );
+}
+
+/*!
+  the error's triage: NONE if it's new
+*/
+VG_TRIAGE::State VgLogView::triage( int errIdx ) const
+{
+   if ( VgKnownErrors::global().isEmpty() ) {
+      return VG_TRIAGE::NONE;
+   }
+   return VgKnownErrors::global().lookup( errorKey( errIdx ) ).state;
+}
+
+QString VgLogView::ticket( int errIdx ) const
+{
+   if ( VgKnownErrors::global().isEmpty() ) {
+      return QString();
+   }
+   return VgKnownErrors::global().lookup( errorKey( errIdx ) ).ticket;
+}
+
+/*!
+  An error's key in VgKnownErrors: only worked out once there's
+  something to look it up in, and kept.
+*/
+quint64 VgLogView::errorKey( int errIdx ) const
+{
+   if ( errorKeys.count() < logstore.numErrors() ) {
+      errorKeys.resize( logstore.numErrors() );   // 0: not yet
+   }
+   quint64& key = errorKeys[errIdx];
+   if ( key == 0 ) {
+      key = VgKnownErrors::global().keyOf( logstore, errIdx );
+   }
+   return key;
+}
+
+/*!
+  Triage the error, for this and every later run: the same error
+  found again (here too) is then known.
+  Returns false if it couldn't be saved.
+*/
+bool VgLogView::setTriage( int errIdx, VG_TRIAGE::State state,
+                           const QString& ticket )
+{
+   bool ok = VgKnownErrors::global().set( errorKey( errIdx ), state, ticket );
+
+   // any row with the same key has changed too: no need to hunt
+   // them down, just have the view redraw
+   int rows = ( statusNode != 0 ) ? childCount( statusNode ) : 0;
+   if ( rows > 0 ) {
+      QModelIndex parent = indexOf( statusNode );
+      emit dataChanged( index( 0, 0, parent ), index( rows - 1, 0, parent ) );
+   }
+   return ok;
+}
+
+/*!
+  the tool's short name for an error kind
+*/
+QString VgLogView::acronym( quint32 kind ) const
+{
+   return acronyms.value( logstore.str( kind ), "???" );
+}
+
+/*!
+  suppression of an error row
+   - only wanted on user request: built from the dom as needed.
+*/
+QString VgLogView::suppressionStr( const QModelIndex& idx ) const
+{
+   QString str_supp;
+
+   int errIdx = errorIndex( idx );
+   if ( errIdx < 0 ) {
+      return str_supp;
+   }
+
+   QDomElement supp = errorElement( errIdx ).firstChildElement( "suppression" );
+   if ( !supp.isNull() ) {
+      // Qt has killed the <rawtext> newlines, so convert xml to text
+      QTextStream strm(&str_supp);
+
+      QDomElement snameEl = supp.firstChildElement( "sname" );
+      if ( !snameEl.isNull() )
+         strm << snameEl.text();
+      QDomElement skindEl = supp.firstChildElement( "skind" );
+      if ( !skindEl.isNull() )
+         strm << endl << skindEl.text();
+      QDomElement skauxEl = supp.firstChildElement( "skaux" );
+      if ( !skauxEl.isNull() )
+         strm << endl << skauxEl.text();
+
+      QDomElement sframeEl = supp.firstChildElement( "sframe" );
+      for ( ; !sframeEl.isNull();
+              sframeEl = sframeEl.nextSiblingElement("sframe") ) {
+         QDomElement objEl = sframeEl.firstChildElement( "obj" );
+         if ( !objEl.isNull() )
+            strm << endl << "obj:" << objEl.text();
+         QDomElement funEl = sframeEl.firstChildElement( "fun" );
+         if ( !funEl.isNull() )
+            strm << endl << "fun:" << funEl.text();
       }
+   }
+
+   return str_supp;
+}
+
+/*!
+  Shows src paths for all frames under an error row
+*/
+void VgLogView::showFullSrcPath( const QModelIndex& idx, bool show )
+{
+   VgLogNode* node = nodeOf( idx );
+   if ( node->type != VG_ELEM::ERROR ) {
+      return;
+   }
 
-      vgItemError->updateCount( count );
+   if ( show ) {
+      node->flags |= VG_NODE::FULLPATH;
+   }
+   else {
+      node->flags &= ~VG_NODE::FULLPATH;
+   }
+
+   // (maybe) multiple stacks, of multiple frames
+   for ( int i = 0; i < node->kids.count(); ++i ) {
+      VgLogNode* stack = node->kids.at( i );
+      if ( stack->type == VG_ELEM::STACK && !stack->kids.isEmpty() ) {
+         emit dataChanged( indexOf( stack->kids.first() ),
+                           indexOf( stack->kids.last() ) );
+      }
    }
 }
 
+bool VgLogView::isFullSrcPathShown( const QModelIndex& idx ) const
+{
+   const VgLogNode* node = peekNode( idx );
+   return node != 0 && ( node->flags & VG_NODE::FULLPATH ) != 0;
+}
 
 
+/*!
+  Frame rows, and the source line rows under them:
+  permissions and location of the source.
+*/
+bool VgLogView::isReadable( const QModelIndex& idx ) const
+{
+   const VgLogNode* frame = frameOf( peekNode( idx ) );
+   return frame != 0 && ( frame->flags & VG_NODE::READABLE );
+}
 
+bool VgLogView::isWriteable( const QModelIndex& idx ) const
+{
+   const VgLogNode* frame = frameOf( peekNode( idx ) );
+   return frame != 0 && ( frame->flags & VG_NODE::WRITEABLE );
+}
 
+QString VgLogView::srcDir( const QModelIndex& idx ) const
+{
+   const VgLogNode* frame = frameOf( peekNode( idx ) );
+   return frame ? logstore.str( logstore.frame( frame->ref ).dir ) : QString();
+}
 
+QString VgLogView::srcFile( const QModelIndex& idx ) const
+{
+   const VgLogNode* frame = frameOf( peekNode( idx ) );
+   return frame ? logstore.str( logstore.frame( frame->ref ).file ) : QString();
+}
 
+quint32 VgLogView::srcLine( const QModelIndex& idx ) const
+{
+   const VgLogNode* frame = frameOf( peekNode( idx ) );
+   return frame ? logstore.frame( frame->ref ).line : 0;
+}
+
+
+
+// ============================================================
+/*!
+  Show only the errors matching query (0: all).
+   - hidden errors are dropped from the rows under the status row:
+     a bitset from the index, and a pass to renumber the rows.
+   - the view keeps its expanded/current rows that are still shown.
+*/
+void VgLogView::setErrorFilter( const VgLogQuery* query )
+{
+   emit layoutAboutToBeChanged();
+
+   // errors and nodes of the view's persistent indexes, to find
+   // them again
+   QModelIndexList oldIdxs = persistentIndexList();
+   QVector<int> oldErrs;
+   QVector<VgLogNode*> oldNodes;
+   for ( int i = 0; i < oldIdxs.count(); ++i ) {
+      int errIdx = errorIndex( oldIdxs.at( i ) );
+      oldErrs.append( errIdx );
+      oldNodes.append( ( errIdx < 0 ) ? nodeOf( oldIdxs.at( i ) ) : 0 );
+   }
+
+   filter = query;
+   filtering = ( query != 0 && !query->isEmpty() );
+   visible.clear();
+   visibleRow.clear();
+
+   if ( filtering && statusNode != 0 ) {
+      QBitArray shown = query->select( logstore );
+      int n = numErrRows + statusNode->kids.count();
+      visibleRow.resize( n );
+
+      // errors in order, the other rows between them
+      int k = 0, errIdx = errBase;
+      for ( int pos = 0; pos < n; ++pos ) {
+         bool show;
+         if ( k < statusNode->kids.count() &&
+              topErrsBefore.at( k ) == errIdx - errBase ) {
+            show = true;
+            k++;
+         }
+         else {
+            show = ( errIdx < shown.size() && shown.testBit( errIdx ) );
+            errIdx++;
+         }
+
+         if ( show ) {
+            visibleRow[pos] = visible.count();
+            visible.append( pos );
+         }
+         else {
+            visibleRow[pos] = -1;
+         }
+      }
+   }
+
+   QModelIndexList newIdxs;
+   for ( int i = 0; i < oldIdxs.count(); ++i ) {
+      newIdxs.append( ( oldErrs.at( i ) >= 0 ) ? errorRow( oldErrs.at( i ) )
+                                               : indexOf( oldNodes.at( i ) ) );
+   }
+   changePersistentIndexList( oldIdxs, newIdxs );
+
+   emit layoutChanged();
+}
 
 
 //TODO: needed?
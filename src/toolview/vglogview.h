@@ -1,6 +1,6 @@
 /****************************************************************************
 ** VgLogView definition
-**  - links QDomElements with QTreeWidgetItems
+**  - item model of a valgrind log, for the tool views
 ** --------------------------------------------------------------------------
 **
 ** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
@@ -21,13 +21,12 @@
 #ifndef __VK_VGLOGVIEW_H
 #define __VK_VGLOGVIEW_H
 
-#include <QColormap>
-#include <QDateTime>
+#include <QAbstractItemModel>
+#include <QBitArray>
+#include <QCache>
+#include <QMap>
 #include <QObject>
-#include <QPainter>
-#include <QPixmap>
-#include <QTreeWidget>
-#include <QTreeWidgetItem>
+#include <QVector>
 
 // QDom stuff
 #include <QDomDocument>
@@ -36,157 +35,276 @@
 #include <QHash>
 #include <QString>
 
+#include "utils/vgknownerrors.h"
+#include "utils/vglogstore.h"
+
 
 // ============================================================
 // Forward decls
-class VgOutputItem;
-class TopStatusItem;
+class TopStatus;
+class VgErrorXml;
+class VgLogQuery;
+struct VgLogNode;
+
+
+// ============================================================
+// static map (tagname->enum) + access functions
+typedef QHash<QString, VG_ELEM::ElemType> ElemTypeMap;
+
 
 
 // ============================================================
 /*!
   VgLogView: abstract base class for tool-logviews
 
-   - Representation of a Valgrind XML log.
-
-   - Holds both model and view.
+   - Representation of a Valgrind XML log, as an item model:
+     shown by the tool's QTreeView.
      As the the parser (vglogreader) parses a complete top-level
-     element, it's passed to VgLogView to incrementally update
-     both the model and view.
-
-   - Takes a view* argument in constructor, and populates it at the same
-     time as the underlying model.
-
-   - Each view item gets a ref to its appropriate VgLog element, for
-     setting the item text data, and providing access to any further
-     element data.
-     Note: this is NOT one-to-one!  Some elements are ignored, and some
-        items represent multiple elements!
-
-    - On-demand sub-item creation.
-      Children of top-level items are created only when the user opens
-      the branch. the QDomElement refs held by item are then queried
-      to fill the item data.
+     element, its record is passed to VgLogView to incrementally
+     update the model, which tells the view of the new rows.
+
+   - Rows are nodes (VgLogNode): a few words each, referring into
+     the VgLogStore (or, for the few rows without a record, into
+     a small table of texts, and the xml of their elements).
+     Note: there's no dom of the log.  A row's element is only
+        built from its xml when it's wanted: on opening the row,
+        or copying it.
+     Note: rows and elements are NOT one-to-one!  Some elements are
+        ignored, and some rows represent multiple elements!
+
+   - Text, colours etc. are worked out by data(), as the view asks
+     for them: only for the rows it is actually showing.
+
+   - On-demand row creation.
+     Children of top-level rows are created only when the view opens
+     the branch (canFetchMore()/fetchMore()).
+
+   - Errors (and their stacks) are held as compact records in
+     a VgLogStore, as handed over by the parser: that's all the
+     rows need.  Neither errors nor <errorcounts> come with xml.
+
+   - Error rows are just the errors' indexes in the store: no
+     node is made for one unless it's opened.  Nor are they indexed
+     by <unique>, while valgrind numbers them in order: each
+     <errorcounts> is applied by binary search of the store.
+
+   - An error's element is only wanted for copying xml and
+     suppressions: it's then read back from where the parser says
+     it is, in the log or a spool of them (VgErrorXml), and a few
+     of the latest kept around.
+
+   - Merged logs (VgLogMerger): each error keeps the logs it was
+     found in, and its count in each, shown as rows under it.
+
+   - Source file permissions come from VgSrcInfo, which stats the
+     sources of each stack in the background as it arrives.
+
+   - Filtering (setErrorFilter()) maps the rows under the status
+     row to just the matching errors: hidden errors are simply not
+     rows, so the view never sees them.
 */
-class VgLogView : public QObject
+class VgLogView : public QAbstractItemModel
 {
    Q_OBJECT
 public:
-   VgLogView( QTreeWidget* );
+   typedef QMap<QString, QString> AcronymMap;
+
+   VgLogView( const AcronymMap& acnymMap );
    ~VgLogView();
 
-   bool init( QDomProcessingInstruction xml_insn, QString doc_tag );
-   bool appendNode( QDomNode node, QString& errMsg );
+   bool init( const VgLogRecord& root );
+   bool appendNode( VgLogRecord& rec, QString& errMsg );
+
+   VgLogStore* store();
+
+   // QAbstractItemModel
+   QModelIndex index( int row, int column,
+                      const QModelIndex& parent = QModelIndex() ) const;
+   QModelIndex parent( const QModelIndex& child ) const;
+   int rowCount( const QModelIndex& parent = QModelIndex() ) const;
+   int columnCount( const QModelIndex& parent = QModelIndex() ) const;
+   bool hasChildren( const QModelIndex& parent = QModelIndex() ) const;
+   bool canFetchMore( const QModelIndex& parent ) const;
+   void fetchMore( const QModelIndex& parent );
+   QVariant data( const QModelIndex& index, int role = Qt::DisplayRole ) const;
+
+   // rows
+   QModelIndex statusIndex() const;
+   VG_ELEM::ElemType elemType( const QModelIndex& idx ) const;
+   QString tagName( const QModelIndex& idx ) const;
+   QDomElement element( const QModelIndex& idx ) const;
+   bool openWithParent( const QModelIndex& idx ) const;
+   qint64 pid() const;
+   qint64 ppid() const;
+
+   // errors
+   int errorIndex( const QModelIndex& idx ) const;     // -1 if not an error
+   QModelIndex errorRow( int errIdx ) const;      // invalid if not shown
+   QString errorText( int errIdx ) const;
+   QString acronym( quint32 kind ) const;
+   QString suppressionStr( const QModelIndex& idx ) const;
+   void showFullSrcPath( const QModelIndex& idx, bool show );
+   bool isFullSrcPathShown( const QModelIndex& idx ) const;
+
+   // triage, as kept over all runs (VgKnownErrors)
+   VG_TRIAGE::State triage( int errIdx ) const;
+   QString ticket( int errIdx ) const;
+   bool setTriage( int errIdx, VG_TRIAGE::State state, const QString& ticket );
+
+   // frames, and their source lines
+   bool isReadable( const QModelIndex& idx ) const;
+   bool isWriteable( const QModelIndex& idx ) const;
+   QString srcDir( const QModelIndex& idx ) const;
+   QString srcFile( const QModelIndex& idx ) const;
+   quint32 srcLine( const QModelIndex& idx ) const;   // 0 if unknown
+
+   // 0: show all errors.  we don't own query: set again on change.
+   void setErrorFilter( const VgLogQuery* query );
+
+   // where errors' elements are read back from, as needed
+   VgErrorXml* errorXml();
+
+   // useful static data + functions for mapping tagname -> enum
+   static ElemTypeMap elemtypeMap;
+   static VG_ELEM::ElemType elemType( QString tagName );
+
+signals:
+   // errors: for views of the store (ErrorGroupModel)
+   void errorAdded( int errIdx );
+   void errorCountsChanged();
 
 //TODO: needed?
 //   QString toString( int indent = 2 ); // xml output
 
 protected:
-   // keep track of our progress
-   VgOutputItem*  lastItem;
-   TopStatusItem* topStatus;
+   // for the tool-logviews' appendNodeTool()
+   void appendError( int errIdx );
+   void appendAnnounceThread( const VgLogRecord& rec, const QString& text,
+                              int stackIdx );
+
+private slots:
+   void srcInfoUpdated();
+
+protected:
+   TopStatus* topStatus;
 
 private:
    virtual QString toolName() = 0;
-   virtual bool appendNodeTool( QDomElement elem, QString& errMsg ) = 0;
-   virtual TopStatusItem* createTopStatus( QTreeWidget* view, QDomElement exe,
-                                           QDomElement status, QString _protocol ) = 0;
-   void updateErrorItems( QDomElement ec );
-   QDomElement logRoot();
+   virtual bool appendNodeTool( VgLogRecord& rec, QString& errMsg ) = 0;
+   virtual TopStatus* createTopStatus( const QString& exe,
+                                       const VgLogRecord& status,
+                                       QString _protocol ) = 0;
+   virtual void errorElementLoaded( QDomElement err ) const;
+   QDomElement errorElement( int errIdx ) const;
+   QVariant errorData( int errIdx, int role ) const;
+   quint64 errorKey( int errIdx ) const;
+   int errorOfUnique( quint64 unique ) const;
+   void updateErrorItems( const QVector<VgLogPair>& pairs );
+
+   // nodes
+   void clearNodes();
+   VgLogNode* nodeOf( const QModelIndex& idx ) const;
+   VgLogNode* peekNode( const QModelIndex& idx ) const;
+   VgLogNode* errorNode( int errIdx ) const;
+   QModelIndex indexOf( VgLogNode* node ) const;
+   int topPos( const VgLogNode* node ) const;
+   int errorPos( int errIdx ) const;
+   VgLogNode* topAt( int pos, int& errIdx ) const;
+   int rowOf( const VgLogNode* node ) const;
+   int childCount( const VgLogNode* node ) const;
+   QModelIndex childAt( const VgLogNode* node, int row ) const;
+   bool isShown( const VgLogNode* node ) const;
+   bool canHaveChildren( const VgLogNode* node ) const;
+   const VgLogNode* errorOf( const VgLogNode* node ) const;
+   const VgLogNode* frameOf( const VgLogNode* node ) const;
+
+   int addDomRow( const QString& xml, const QString& text, int num = -1 );
+   int addDomRow( QDomElement elem, const QString& text, int num = -1 );
+   QDomElement rowElement( int ref ) const;
+   void appendTopRow( VG_ELEM::ElemType type, int ref );
+   void setupChildren( VgLogNode* node, QVector<VgLogNode*>& kids );
+   void addChild( QVector<VgLogNode*>& kids, VgLogNode* parent,
+                  VG_ELEM::ElemType type, int ref );
+   QString text( const VgLogNode* node ) const;
+   QString describe_IP( int frameIdx, bool withPath ) const;
+   QString srcPath( const VgFrameRec& frm ) const;
+   void requestSrcInfo( int stackIdx );
+   bool updateSrcFlags( VgLogNode* frame );
+   void statusChanged();
 
 private:
-   QDomDocument vglog;
-   QTreeWidget* view;    // we don't own this: don't cleanup
-};
-
-
-
-// ============================================================
-namespace VG_ELEM {
-   // All valgrind tag types, for mapping of tags to enum values
-   enum ElemType {
-      ROOT, PROTOCOL_VERSION, PROTOCOL_TOOL, PREAMBLE, PID, PPID, TOOL,
-      LOGQUAL, VAR, VALUE, COMMENT,
-      ARGS, VARGV, ARGV, EXE, ARG,
-      STATUS, STATE, TIME,
-      ERROR, UNIQUE, TID, KIND, WHAT, XWHAT, TEXT, STACK,
-      FRAME, IP, OBJ, FN, SRCDIR, SRCFILE, LINE, AUXWHAT, XAUXWHAT,
-      ERRORCOUNTS, ANNOUNCETHREAD, HTHREADID, PAIR, COUNT,
-      SUPPCOUNTS, NAME, LEAKEDBYTES, LEAKEDBLOCKS,
-      SUPPRESSION, SNAME, SKIND, SKAUX, SFRAME, RAWTEXT,
-      NUM_ELEMS
+   VgLogStore logstore;
+   const AcronymMap& acronyms;
+
+   VgLogNode* rootNode;                 // invisible root
+   VgLogNode* statusNode;               // top status: parent of the rest
+   qint64 procPid, procPpid;            // from the log's <pid>, <ppid>
+
+   // the log's header: the elements before its status
+   QString rootTag;                     // <valgrindoutput>
+   QString headerXml;
+   QString preambleXml;
+   QHash<int, QString> headerTexts;     // type -> text: <pid>, <exe>, ...
+   // error rows: errors [errBase, errBase + numErrRows), in order,
+   // with statusNode's kids between them
+   int errBase;                         // errors before the status: no rows
+   int numErrRows;
+   QVector<int> topErrsBefore;          // statusNode child -> error rows before it
+   mutable QHash<int, VgLogNode*> errorNodes;  // error index -> node, once made
+   bool uniquesSorted;                  // else errorIdxs is needed
+   QHash<quint64, int> errorIdxs;       // unique -> error index
+
+   // error elements not kept, but read back as wanted
+   VgErrorXml* errXml;
+   mutable QCache<int, QDomDocument> loadedErrors;
+   mutable QVector<quint64> errorKeys;  // error index -> VgKnownErrors key, 0: not yet
+
+   // rows without a record of their own
+   struct DomRow {
+      QString xml;                 // top-level rows: see rowElement()
+      mutable QDomDocument doc;    // ... built from xml, once wanted
+      mutable QDomElement elem;    // rows under them: from its doc
+      QString text;
+      int num;               // stack index / source line number
    };
-}
+   QVector<DomRow> domRows;
 
-// static map (tagname->enum) + access functions
-typedef QHash<QString, VG_ELEM::ElemType> ElemTypeMap;
+   // filter: rows under statusNode
+   const VgLogQuery* filter;
+   bool filtering;
+   QVector<int> visible;                // row -> position (topPos())
+   QVector<int> visibleRow;             // position -> row, or -1
+
+   // source files: VgSrcInfo path ids, and the frames showing them
+   QHash<quint64, quint32> srcPathIds;  // dir << 32 | file -> path id
+   QVector<VgLogNode*> srcFrames;
+};
 
 
 
 // ============================================================
 /*!
-   VgOutputItem: base class
-
-   Items represent one (or more) branches/leaves of a Valgrind XML log.
-
-   Top-level items are initialised with state and QDomElement references.
-    - children are only initialised on demand, via openChildren(),
-      for reasons of speed for large logs.
-
-   Note: Items do not have a one-to-one relationship with XML elements:
-   some XML log elements are ignored, some items represent multiple elements.
+  TopStatus: the text of the first row
+   as two text parts:
+   status, client exe
+   errcounts(num_errs), leak_errors(num_bytes++, num_blocks++)
 */
-class VgOutputItem : public QTreeWidgetItem
+class TopStatus
 {
 public:
-   VgOutputItem( QTreeWidget* parent, QDomElement );
-   VgOutputItem( QTreeWidgetItem* parent, QDomElement );
-   VgOutputItem( QTreeWidgetItem* parent, QTreeWidgetItem* after, QDomElement );
+   TopStatus( const QString& exe, const VgLogRecord& status,
+              QString toolstatus, QString _protocol );
+   virtual ~TopStatus();
 
-   void setText( QString str );
+   void updateStatus( const VgLogRecord& status );
+   void updateFromErrorCounts( const QVector<VgLogPair>& pairs );
 
-   VgOutputItem* firstChild();
-   VgOutputItem* parent();
+   // all tool TopStatus's must implement this:
+   virtual void updateToolStatus( const VgLogRecord& err ) = 0;
 
-   void openChildren();
-   // all (non-root) items with children must reimplement this:
-   virtual void setupChildren() {}
-
-   // useful static data + functions for mapping tagname -> enum
-   static ElemTypeMap elemtypeMap;
-   static VG_ELEM::ElemType elemType( QString tagName );
-   VG_ELEM::ElemType elemType();
-
-   // getters
-   bool getIsExpandable();
-   bool getIsReadable();
-   bool getIsWriteable();
-   QDomElement getElement();
-
-protected:
-   bool isReadable, isWriteable;
-   QDomElement elem;               // associated element
-   bool isExpandable;
-
-private:
-   void initialise();
-};
-
-
-
-
-// ============================================================
-class TopStatusItem : public VgOutputItem
-{
-public:
-   TopStatusItem( QTreeWidget* parent, QDomElement exe,
-                              QDomElement status, QString toolstatus,
-                              QString _protocol );
-   void updateStatus( QDomElement status );
-   void updateFromErrorCounts( QDomElement ec );
-
-   // all tool TopStatusItems must implement this:
-   virtual void updateToolStatus( QDomElement ) = 0;
+   QString text() const {
+      return status_str;
+   }
 
 protected:
    void updateText();
@@ -196,6 +314,7 @@ protected:
    int num_errs;
 
 private:
+   QString exe_str;
    QString state_str, start_time, time_str;
    QString protocol;
    QString status_tmplt, status_str;
@@ -203,123 +322,6 @@ private:
 
 
 
-// ============================================================
-class InfoItem : public VgOutputItem
-{
-public:
-   InfoItem( VgOutputItem* parent, QDomElement root );
-
-   void setupChildren();
-};
-
-
-// ============================================================
-class LogQualItem : public VgOutputItem
-{
-public:
-   LogQualItem( VgOutputItem* parent, QDomElement logqual );
-
-   void setupChildren();
-};
-
-
-// ============================================================
-class ArgsItem : public VgOutputItem
-{
-public:
-   ArgsItem( VgOutputItem* parent, QTreeWidgetItem* after,
-             QDomElement vgargs );
-
-   void setupChildren();
-};
-
-
-// ============================================================
-class PreambleItem : public VgOutputItem
-{
-public:
-   PreambleItem( VgOutputItem* parent, QTreeWidgetItem* after,
-                 QDomElement preamble );
-
-   void setupChildren();
-};
-
-
-
-
-// ============================================================
-// ErrorItem: abstract base class
-class ErrorItem : public VgOutputItem
-{
-public:
-   typedef QMap<QString, QString> AcronymMap;
-
-   ErrorItem( VgOutputItem* parent, QTreeWidgetItem* after,
-              QDomElement err, ErrorItem::AcronymMap map );//, QString acnym );
-   void updateCount( QString count );
-
-   void showFullSrcPath( bool show );
-   bool isFullSrcPathShown();
-   QString getSuppressionStr();
-
-   void setupChildren();
-
-protected:
-   QString getErrorAcronym( ErrorItem::AcronymMap map, QString kind );
-
-private:
-   QString err_tmplt;
-   bool fullSrcPathShown;
-   QString str_supp;
-};
-
-
-
-// ============================================================
-class StackItem : public VgOutputItem
-{
-public:
-   StackItem( VgOutputItem* parent, QTreeWidgetItem* after,
-              QDomElement stck );
-
-   void setupChildren();
-};
-
-
-// ============================================================
-class FrameItem : public VgOutputItem
-{
-public:
-   FrameItem( VgOutputItem* parent, QTreeWidgetItem* after,
-              QDomElement frm );
-
-   QString describe_IP( bool withPath = false );
-
-   void setupChildren();
-};
-
-
-// ============================================================
-class SrcItem : public VgOutputItem
-{
-public:
-   SrcItem( VgOutputItem* parent, QDomElement line, QString path );
-   // leaf item: no children to setup.
-};
-
-
-// ============================================================
-class SuppCountsItem : public VgOutputItem
-{
-public:
-   SuppCountsItem( VgOutputItem* parent, QTreeWidgetItem* after,
-                   QDomElement sc );
-
-   void setupChildren();
-};
-
-
-
 
 // ============================================================
 /* Notes re xml weaknesses
@@ -0,0 +1,222 @@
+/****************************************************************************
+** VgCallTree implementation
+**  - all errors' stacks merged into one tree of call paths
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vgcalltree.h"
+#include "utils/vglogstore.h"
+#include "utils/vk_utils.h"
+
+#include <QVarLengthArray>
+
+
+/**********************************************************************/
+/*!
+  VgCallTree
+*/
+VgCallTree::VgCallTree()
+   : m_root( VG_CALLTREE::CALLERS ), m_weight( VG_CALLTREE::COUNT ),
+     leakCheckStart( 0 ), m_maxDepth( 0 )
+{
+   mainFn = VgStrPool::global().intern( "main" );
+   clear();
+}
+
+/*!
+  Start again, growing from root, weighed by weight.
+*/
+void VgCallTree::setup( VG_CALLTREE::Root root, VG_CALLTREE::Weight weight )
+{
+   vk_assert( root >= 0 && root < VG_CALLTREE::NUM_ROOTS );
+   vk_assert( weight >= 0 && weight < VG_CALLTREE::NUM_WEIGHTS );
+
+   m_root   = root;
+   m_weight = weight;
+   clear();
+}
+
+/*!
+  Forget all errors: just the root is left.
+*/
+void VgCallTree::clear()
+{
+   nodes.clear();
+   childIds.clear();
+   stackLeaves.clear();
+   errLeaves.clear();
+   errWeights.clear();
+   leakChecks.clear();
+   leakCheckStart = 0;
+   m_maxDepth = 0;
+
+   Node root = { 0, 0, -1, -1, -1, 0, 0 };
+   nodes.append( root );
+}
+
+
+/*!
+  The child of parent for the frame: added if not yet there.
+*/
+int VgCallTree::child( int parent, quint32 fn, quint32 obj )
+{
+   quint64 key = ( ( quint64 )parent << 32 ) | ( fn != 0 ? fn : obj );
+   QHash<quint64, int>::const_iterator it = childIds.constFind( key );
+   if ( it != childIds.constEnd() ) {
+      return it.value();
+   }
+
+   int idx = nodes.count();
+   Node n;
+   n.fn          = fn;
+   n.obj         = obj;
+   n.parent      = parent;
+   n.firstChild  = -1;
+   n.nextSibling = nodes.at( parent ).firstChild;
+   n.depth       = nodes.at( parent ).depth + 1;
+   n.weight      = 0;
+   nodes.append( n );
+   nodes[parent].firstChild = idx;
+
+   childIds.insert( key, idx );
+   m_maxDepth = qMax( m_maxDepth, n.depth );
+   return idx;
+}
+
+/*!
+  The node the error's path ends at: the whole of its first stack,
+  from the root end.  The root if no frames.
+*/
+int VgCallTree::leafOf( int errIdx, const VgLogStore& store )
+{
+   const VgErrorRec& err = store.error( errIdx );
+   quint32 top = ( err.numStacks > 0 ) ? store.stack( err.firstStack ).top : 0;
+
+   QHash<quint32, int>::const_iterator it = stackLeaves.constFind( top );
+   if ( it != stackLeaves.constEnd() ) {
+      return it.value();
+   }
+
+   // frame ids, innermost first
+   QVarLengthArray<quint32, 64> frms;
+   for ( quint32 c = top; c != 0; c = store.cell( c ).next ) {
+      frms.append( store.cell( c ).frame );
+   }
+
+   int leaf = 0;
+   if ( m_root == VG_CALLTREE::CALLERS ) {
+      // what's outside main is just the runtime starting up
+      int start = frms.count() - 1;
+      for ( int i = start; i >= 0; --i ) {
+         if ( store.frame( frms[i] ).fn == mainFn ) {
+            start = i;
+            break;
+         }
+      }
+      for ( int i = start; i >= 0; --i ) {
+         const VgFrameRec& frm = store.frame( frms[i] );
+         leaf = child( leaf, frm.fn, frm.obj );
+      }
+   }
+   else {
+      for ( int i = 0; i < frms.count(); ++i ) {
+         const VgFrameRec& frm = store.frame( frms[i] );
+         leaf = child( leaf, frm.fn, frm.obj );
+      }
+   }
+
+   stackLeaves.insert( top, leaf );
+   return leaf;
+}
+
+
+quint64 VgCallTree::weightOf( int errIdx, const VgLogStore& store ) const
+{
+   const VgErrorRec& err = store.error( errIdx );
+   return ( m_weight == VG_CALLTREE::COUNT ) ? err.count : err.leakedBytes;
+}
+
+/*!
+  Add weight to leaf, and everything on its path up to the root.
+   - unsigned: adding a difference that's 'negative' wraps round
+     to just the right total.
+*/
+void VgCallTree::addWeight( int leaf, quint64 weight )
+{
+   for ( int n = leaf; n >= 0; n = nodes.at( n ).parent ) {
+      nodes[n].weight += weight;
+   }
+}
+
+
+/*!
+  A new leak check: take off the weight of the leaks added since
+  the last one started, up to endIdx.
+*/
+void VgCallTree::dropLeaks( int endIdx )
+{
+   for ( int i = leakCheckStart; i < endIdx; ++i ) {
+      if ( errWeights.at( i ) != 0 ) {
+         addWeight( errLeaves.at( i ), 0 - errWeights.at( i ) );
+         errWeights[i] = 0;
+      }
+   }
+   leakCheckStart = endIdx;
+}
+
+
+/*!
+  Add the store's errors up to errIdx: those not yet added.
+*/
+void VgCallTree::addError( int errIdx, const VgLogStore& store )
+{
+   const VgLogLeaks& leaks = store.leaks();
+   leakChecks.setCumulative( leaks.isCumulative() );
+
+   for ( int i = errLeaves.count(); i <= errIdx; ++i ) {
+      if ( m_weight == VG_CALLTREE::LEAKED ) {
+         const VgErrorRec& err = store.error( i );
+         if ( leaks.isLeak( err.kind ) &&
+              leakChecks.add( store.text( err.what ) ) ) {
+            dropLeaks( i );
+         }
+      }
+      int leaf = leafOf( i, store );
+      quint64 weight = weightOf( i, store );
+      errLeaves.append( leaf );
+      errWeights.append( weight );
+      addWeight( leaf, weight );
+   }
+}
+
+/*!
+  From <errorcounts>: the errors whose counts have changed add the
+  difference.  Leaks don't change.
+*/
+void VgCallTree::updateCounts( const VgLogStore& store )
+{
+   if ( m_weight != VG_CALLTREE::COUNT ) {
+      return;
+   }
+   for ( int i = 0; i < errLeaves.count(); ++i ) {
+      quint64 weight = weightOf( i, store );
+      if ( weight != errWeights.at( i ) ) {
+         addWeight( errLeaves.at( i ), weight - errWeights.at( i ) );
+         errWeights[i] = weight;
+      }
+   }
+}
@@ -0,0 +1,131 @@
+/****************************************************************************
+** VgCallTree definition
+**  - all errors' stacks merged into one tree of call paths
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VGCALLTREE_H
+#define __VGCALLTREE_H
+
+#include "utils/vglogleaks.h"
+
+#include <QHash>
+#include <QVector>
+
+
+class VgLogStore;
+
+
+// ============================================================
+namespace VG_CALLTREE {
+   // which end of the stacks the tree grows from
+   enum Root {
+      CALLERS,       // main (else the outermost frame): where it's called from
+      CALLEES,       // the innermost frame: e.g. the allocation function
+      NUM_ROOTS
+   };
+
+   // what a path is weighed by
+   enum Weight {
+      COUNT,         // errors' counts
+      LEAKED,        // leaked bytes: only leaks weigh anything
+      NUM_WEIGHTS
+   };
+}
+
+
+
+// ============================================================
+/*!
+  VgCallTree: the first stack of every error, merged into a trie of
+  call paths, each node weighed by the errors whose path goes through
+  it.  A frame is its function (its object, if no symbols): the
+  same function reached by the same path is one node, whatever
+  the call's ip.
+
+   - node 0 is the root: all errors.
+   - built as errors are added: addError() catches up with the
+     store, so it can start at any time.
+   - a path is worked out once per distinct stack: equal stacks
+     are the very same list of cells in the store, so most errors
+     just add their weight up the path from a cached leaf.
+   - counts changed (by <errorcounts>) are updated by difference:
+     updateCounts().
+   - weighed by leaked bytes, only the last leak check counts, as
+     for VgLogLeaks: a new one takes the last one's weight off
+     again.  Unless the store's leaks are cumulative.
+*/
+class VgCallTree
+{
+public:
+   struct Node {
+      quint32 fn, obj;            // interned: fn 0 if no symbol
+      int parent;                 // -1 for the root
+      int firstChild, nextSibling;   // -1 if none
+      int depth;
+      quint64 weight;
+   };
+
+   VgCallTree();
+
+   void setup( VG_CALLTREE::Root root, VG_CALLTREE::Weight weight );
+   void addError( int errIdx, const VgLogStore& store );
+   void updateCounts( const VgLogStore& store );
+   void clear();
+
+   VG_CALLTREE::Root root() const {
+      return m_root;
+   }
+   VG_CALLTREE::Weight weight() const {
+      return m_weight;
+   }
+   int count() const {
+      return nodes.count();
+   }
+   const Node& node( int idx ) const {
+      return nodes.at( idx );
+   }
+   int maxDepth() const {
+      return m_maxDepth;
+   }
+   int numErrors() const {
+      return errLeaves.count();
+   }
+
+private:
+   int leafOf( int errIdx, const VgLogStore& store );
+   int child( int parent, quint32 fn, quint32 obj );
+   quint64 weightOf( int errIdx, const VgLogStore& store ) const;
+   void addWeight( int leaf, quint64 weight );
+   void dropLeaks( int endIdx );
+
+private:
+   VG_CALLTREE::Root m_root;
+   VG_CALLTREE::Weight m_weight;
+   quint32 mainFn;                      // interned "main"
+
+   QVector<Node> nodes;
+   QHash<quint64, int> childIds;        // parent << 32 | fn (else obj) -> node
+   QHash<quint32, int> stackLeaves;     // first stack's top cell -> leaf
+   QVector<int> errLeaves;              // error index -> leaf
+   QVector<quint64> errWeights;         // error index -> weight added
+   VgLeakChecks leakChecks;
+   int leakCheckStart;                  // error index the last one starts at
+   int m_maxDepth;
+};
+
+#endif // #ifndef __VGCALLTREE_H
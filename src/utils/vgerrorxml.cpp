@@ -0,0 +1,157 @@
+/****************************************************************************
+** VgErrorXml implementation
+**  - where a log view's errors' xml is read back from
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vgerrorxml.h"
+#include "utils/vk_config.h"
+#include "utils/vk_utils.h"
+
+#include <QMutexLocker>
+
+
+/**********************************************************************/
+/*!
+  VgErrorXml
+*/
+VgErrorXml::VgErrorXml()
+   : spoolId( 0 ), spoolFailed( false ), mapData( 0 ), mapId( 0 )
+{ }
+
+VgErrorXml::~VgErrorXml()
+{
+   if ( spoolFile.isOpen() ) {
+      spoolFile.close();
+      spoolFile.remove();
+   }
+   if ( mapFile.isOpen() ) {
+      mapFile.close();   // unmaps too
+   }
+}
+
+
+/*!
+  The spool: a temporary file, only created once there's something
+  to spool.  Lives as long as we do.
+*/
+bool VgErrorXml::createSpool()
+{
+   QString path = vk_mkstemp( VkCfg::tmpDir() + "error_spool", "xml" );
+   spoolFile.setFileName( path );
+   if ( path.isEmpty() ||
+        !spoolFile.open( QIODevice::ReadWrite | QIODevice::Truncate ) ) {
+      VK_DEBUG( "VgErrorXml::createSpool(): failed to create '%s'",
+                qPrintable( path ) );
+      spoolFailed = true;
+      return false;
+   }
+   spoolId = VgStrPool::global().intern( path );
+   return true;
+}
+
+/*!
+  Spool an error's xml, and point rec at it.
+  Returns false if it can't be: rec is then left without an offset,
+  and the error's xml can't be read back.
+*/
+bool VgErrorXml::spool( const QString& xml, VgLogRecord& rec )
+{
+   QMutexLocker locker( &mutex );
+   if ( spoolFailed || ( spoolId == 0 && !createSpool() ) ) {
+      return false;
+   }
+
+   QByteArray bytes = xml.toUtf8();
+   qint64 offset = spoolFile.pos();
+   if ( spoolFile.write( bytes ) != bytes.size() ) {
+      VK_DEBUG( "VgErrorXml::spool(): failed to write '%s'",
+                qPrintable( spoolFile.fileName() ) );
+      return false;
+   }
+
+   rec.offset = offset;
+   rec.length = bytes.size();
+   rec.source = spoolId;
+   return true;
+}
+
+
+/*!
+  Keep logPath mapped, for reading its errors from.
+  Returns false if it can't be mapped: they're then read from the file.
+*/
+bool VgErrorXml::map( const QString& logPath )
+{
+   QMutexLocker locker( &mutex );
+   if ( mapFile.isOpen() ) {
+      mapFile.close();
+   }
+   mapData = 0;
+   mapId = 0;
+
+   mapFile.setFileName( logPath );
+   if ( !mapFile.open( QIODevice::ReadOnly ) || mapFile.size() <= 0 ) {
+      mapFile.close();
+      return false;
+   }
+   mapData = ( const char* )mapFile.map( 0, mapFile.size() );
+   if ( !mapData ) {
+      mapFile.close();
+      return false;
+   }
+   mapId = VgStrPool::global().intern( logPath );
+   return true;
+}
+
+
+/*!
+  The bytes [offset, offset + length) of the file source (an
+  interned path): empty if they can't be read.
+*/
+QByteArray VgErrorXml::read( quint32 source, qint64 offset, qint64 length )
+{
+   if ( source == 0 || offset < 0 || length <= 0 ) {
+      return QByteArray();
+   }
+
+   QMutexLocker locker( &mutex );
+   if ( source == mapId ) {
+      if ( offset + length > mapFile.size() ) {
+         return QByteArray();
+      }
+      return QByteArray( mapData + offset, length );
+   }
+
+   if ( source == spoolId ) {
+      // still being written: back to the end once read
+      QByteArray bytes;
+      qint64 end = spoolFile.pos();
+      if ( spoolFile.flush() && spoolFile.seek( offset ) ) {
+         bytes = spoolFile.read( length );
+      }
+      spoolFile.seek( end );
+      return bytes;
+   }
+   locker.unlock();
+
+   QFile file( VgStrPool::global().str( source ) );
+   if ( !file.open( QIODevice::ReadOnly ) || !file.seek( offset ) ) {
+      return QByteArray();
+   }
+   return file.read( length );
+}
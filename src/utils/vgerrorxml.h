@@ -0,0 +1,74 @@
+/****************************************************************************
+** VgErrorXml definition
+**  - where a log view's errors' xml is read back from
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VGERRORXML_H
+#define __VGERRORXML_H
+
+#include "utils/vglogstore.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+
+
+// ============================================================
+/*!
+  VgErrorXml: where a log view's errors' xml is read back from.
+
+   - errors are kept just as records (VgLogStore): their xml is
+     only wanted for copying, and for suppressions.  It's read back
+     from its place in the log (VgErrorRec::source, ::offset) then.
+   - logs parsed without byte offsets (a log valgrind is still
+     writing, a compressed log) have their errors' xml spooled to
+     a temporary file instead, as they're parsed: spool().
+   - saved logs up to valkyrie/lazy-log-mb are kept mapped while
+     shown (map()): their errors are read from memory, rather than
+     by seeking in the file each time.
+   - spool() is safe to call from the parsing threads.
+*/
+class VgErrorXml
+{
+public:
+   VgErrorXml();
+   ~VgErrorXml();
+
+   bool spool( const QString& xml, VgLogRecord& rec );
+   bool map( const QString& logPath );
+   QByteArray read( quint32 source, qint64 offset, qint64 length );
+
+private:
+   Q_DISABLE_COPY( VgErrorXml )
+
+   bool createSpool();
+
+private:
+   QMutex mutex;
+
+   QFile spoolFile;
+   quint32 spoolId;         // interned path: 0 until created
+   bool spoolFailed;
+
+   QFile mapFile;
+   const char* mapData;
+   quint32 mapId;           // interned path: 0 if none mapped
+};
+
+#endif // #ifndef __VGERRORXML_H
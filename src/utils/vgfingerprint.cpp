@@ -0,0 +1,178 @@
+/****************************************************************************
+** VgFingerprint implementation
+**  - what tells errors apart: their kind and stack
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vgfingerprint.h"
+#include "utils/vglogstore.h"
+
+#include <QVector>
+
+
+// a frame's part of a fingerprint starts with one of these,
+// so frames keyed differently can't run into each other.
+// Kept in VgKnownErrors' database: don't renumber.
+enum FrameTag { TAG_SRC = 1, TAG_FN, TAG_IP };
+
+// FNV-1a, 64 bit
+static const quint64 FNV_OFFSET = Q_UINT64_C( 14695981039346656037 );
+static const quint64 FNV_PRIME  = Q_UINT64_C( 1099511628211 );
+
+
+
+/**********************************************************************/
+/*
+  Where a fingerprint goes: words to hash, or a stable hash.
+*/
+class WordSink
+{
+public:
+   void tag( FrameTag t ) {
+      words.append( t );
+   }
+   void id( quint32 strId ) {
+      words.append( strId );
+   }
+   void num( quint32 n ) {
+      words.append( n );
+   }
+   void wide( quint64 n ) {
+      words << ( quint32 )n << ( quint32 )( n >> 32 );
+   }
+   QByteArray bytes() const {
+      return QByteArray( ( const char* )words.constData(),
+                         words.count() * sizeof( quint32 ) );
+   }
+
+private:
+   QVector<quint32> words;
+};
+
+class HashSink
+{
+public:
+   HashSink() : h( FNV_OFFSET ) {}
+
+   void tag( FrameTag t ) {
+      word( t );
+   }
+   // the length first: "ab","c" and "a","bc" differ
+   void id( quint32 strId ) {
+      const QString& str = VgStrPool::global().str( strId );
+      word( str.length() );
+      bytes( ( const char* )str.unicode(), str.length() * sizeof( QChar ) );
+   }
+   void num( quint32 n ) {
+      word( n );
+   }
+   void wide( quint64 n ) {
+      word( n );
+   }
+   quint64 hash() const {
+      return h;
+   }
+
+private:
+   void word( quint64 w ) {
+      bytes( ( const char* )&w, sizeof( w ) );
+   }
+   void bytes( const char* data, int len ) {
+      for ( int i = 0; i < len; ++i ) {
+         h = ( h ^ ( uchar )data[i] ) * FNV_PRIME;
+      }
+   }
+
+private:
+   quint64 h;
+};
+
+
+template <typename Sink>
+static void addFrame( Sink& sink, const VgFrameRec& frm, VG_FPRINT::Key key )
+{
+   if ( key == VG_FPRINT::SRCLINE && frm.file != 0 ) {
+      sink.tag( TAG_SRC );
+      sink.id( frm.dir );
+      sink.id( frm.file );
+      sink.num( frm.line );
+   }
+   else if ( frm.fn != 0 ) {
+      sink.tag( TAG_FN );
+      sink.id( frm.fn );
+      sink.id( frm.obj );
+   }
+   else {
+      sink.tag( TAG_IP );
+      sink.id( frm.obj );
+      sink.wide( frm.ip );
+   }
+}
+
+template <typename Sink>
+static void addError( Sink& sink, const VgLogStore& store, int errIdx,
+                      int depth, VG_FPRINT::Key key )
+{
+   const VgErrorRec& err = store.error( errIdx );
+   sink.id( err.kind );
+
+   quint32 c = ( err.numStacks > 0 ) ? store.stack( err.firstStack ).top : 0;
+   for ( int n = 0; c != 0 && ( depth == 0 || n < depth );
+         ++n, c = store.cell( c ).next ) {
+      addFrame( sink, store.frame( store.cell( c ).frame ), key );
+   }
+}
+
+
+
+/**********************************************************************/
+/*!
+  VgFingerprint
+*/
+QByteArray VgFingerprint::of( const VgLogStore& store, int errIdx,
+                              int depth/*=0*/, VG_FPRINT::Key key/*=SRCLINE*/ )
+{
+   WordSink sink;
+   addError( sink, store, errIdx, depth, key );
+   return sink.bytes();
+}
+
+/*!
+  Before it's in a store: e.g. in a worker thread (VgLogMerger).
+*/
+QByteArray VgFingerprint::of( const VgLogRecord& rec,
+                              int depth/*=0*/, VG_FPRINT::Key key/*=SRCLINE*/ )
+{
+   WordSink sink;
+   sink.id( VgStrPool::global().intern( rec.kind ) );
+
+   if ( !rec.stacks.isEmpty() ) {
+      const QVector<VgLogFrame>& frms = rec.stacks.first();
+      for ( int f = 0; f < frms.count() && ( depth == 0 || f < depth ); ++f ) {
+         addFrame( sink, VgLogStore::frameRec( frms.at( f ) ), key );
+      }
+   }
+   return sink.bytes();
+}
+
+quint64 VgFingerprint::stableHash( const VgLogStore& store, int errIdx,
+                                   int depth/*=0*/, VG_FPRINT::Key key/*=SRCLINE*/ )
+{
+   HashSink sink;
+   addError( sink, store, errIdx, depth, key );
+   return sink.hash();
+}
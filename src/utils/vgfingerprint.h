@@ -0,0 +1,72 @@
+/****************************************************************************
+** VgFingerprint definition
+**  - what tells errors apart: their kind and stack
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VGFINGERPRINT_H
+#define __VGFINGERPRINT_H
+
+#include <QByteArray>
+
+
+class VgLogStore;
+class VgLogRecord;
+
+
+// ============================================================
+namespace VG_FPRINT {
+   // what a frame contributes to an error's fingerprint.
+   // Kept in VgKnownErrors' database: don't renumber.
+   enum Key {
+      FUNCTION,      // fn and obj (the ip, without symbols)
+      SRCLINE,       // dir, file and line (as FUNCTION, without)
+      NUM_KEYS
+   };
+}
+
+
+
+// ============================================================
+/*!
+  VgFingerprint: an error's kind, then each of the innermost depth
+  frames of its first stack (0: all of them), by key.
+
+   - of(): the interned string ids (VgStrPool::global()), as bytes
+     to hash: quick, but only good for this session.  An error gives
+     the same bytes as a record (VgLogRecord) or from a store.
+   - stableHash(): of the strings themselves: the same in any
+     session, for keeping (VgKnownErrors).
+   - by default, what tells errors apart across logs: the whole
+     stack, by source line.  What isn't in it: for leaks, it has
+     the sizes in it.
+*/
+class VgFingerprint
+{
+public:
+   static QByteArray of( const VgLogStore& store, int errIdx,
+                         int depth = 0,
+                         VG_FPRINT::Key key = VG_FPRINT::SRCLINE );
+   static QByteArray of( const VgLogRecord& rec,
+                         int depth = 0,
+                         VG_FPRINT::Key key = VG_FPRINT::SRCLINE );
+   static quint64 stableHash( const VgLogStore& store, int errIdx,
+                              int depth = 0,
+                              VG_FPRINT::Key key = VG_FPRINT::SRCLINE );
+};
+
+#endif // #ifndef __VGFINGERPRINT_H
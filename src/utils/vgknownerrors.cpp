@@ -0,0 +1,286 @@
+/****************************************************************************
+** VgKnownErrors implementation
+**  - errors already triaged, over all runs: kept under the config dir
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vgknownerrors.h"
+#include "utils/vk_config.h"
+#include "utils/vk_utils.h"
+
+
+static const quint32 KNOWN_MAGIC   = 0x564b4b45;   // "VKKE"
+static const quint32 KNOWN_VERSION = 2;
+
+// a new database's keys: the top frames, by function.  Version 1
+// databases were keyed by the whole stack, by source line.
+static const VG_FPRINT::Key KNOWN_KEY   = VG_FPRINT::FUNCTION;
+static const quint32        KNOWN_DEPTH = 4;
+
+// compacted on loading, if it's more than this many times too big
+static const int COMPACT_FACTOR = 2;
+
+
+/**********************************************************************/
+/*!
+  VgKnownErrors
+*/
+VgKnownErrors::VgKnownErrors()
+   : keyType( KNOWN_KEY ), keyDepth( KNOWN_DEPTH ),
+     numRecords( 0 ), readOnly( false )
+{
+   load();
+}
+
+VgKnownErrors& VgKnownErrors::global()
+{
+   static VgKnownErrors db;
+   return db;
+}
+
+QString VgKnownErrors::dbPath()
+{
+   return VkCfg::cfgDir() + "known-errors.db";
+}
+
+
+/*!
+  An error's key: as this database keys them.
+*/
+quint64 VgKnownErrors::keyOf( const VgLogStore& store, int errIdx ) const
+{
+   return VgFingerprint::stableHash( store, errIdx, keyDepth, keyType );
+}
+
+
+/*!
+  Triage an error: NONE forgets it.
+  Returns false if the change couldn't be saved.
+*/
+bool VgKnownErrors::set( quint64 key, VG_TRIAGE::State state,
+                         const QString& ticket )
+{
+   vk_assert( state >= 0 && state < VG_TRIAGE::NUM_STATES );
+
+   if ( state == VG_TRIAGE::NONE ) {
+      entries.remove( key );
+   }
+   else {
+      Entry& ent = entries[key];
+      ent.state  = state;
+      ent.ticket = ticket;
+   }
+
+   if ( readOnly ) {
+      return false;
+   }
+   if ( !journal.isOpen() && !openJournal() ) {
+      return false;
+   }
+   strm << key << ( quint8 )state << ticket;
+   journal.flush();
+   numRecords++;
+   return strm.status() == QDataStream::Ok;
+}
+
+
+/*!
+  Replay the journal: the last record of a key is its state.
+*/
+void VgKnownErrors::load()
+{
+   QFile file( dbPath() );
+   if ( !file.exists() || file.size() == 0 ) {
+      return;   // nothing triaged yet
+   }
+   if ( !file.open( QIODevice::ReadOnly ) ) {
+      vkPrintErr( "VgKnownErrors: failed to open '%s': %s: "
+                  "changes won't be saved", qPrintable( dbPath() ),
+                  qPrintable( file.errorString() ) );
+      readOnly = true;
+      return;
+   }
+   QDataStream in( &file );
+   in.setVersion( QDataStream::Qt_4_6 );
+
+   quint32 magic, version;
+   in >> magic >> version;
+   if ( file.error() != QFile::NoError ) {
+      vkPrintErr( "VgKnownErrors: failed to read '%s': %s: "
+                  "changes won't be saved", qPrintable( dbPath() ),
+                  qPrintable( file.errorString() ) );
+      readOnly = true;
+      return;
+   }
+   if ( in.status() != QDataStream::Ok || magic != KNOWN_MAGIC ) {
+      // keep it, in case it's worth something to someone
+      file.close();
+      QString badPath = dbPath() + ".bad";
+      QFile::remove( badPath );
+      if ( !QFile::rename( dbPath(), badPath ) ) {
+         vkPrintErr( "VgKnownErrors: '%s' isn't a known-errors database, "
+                     "and couldn't be moved aside: changes won't be saved",
+                     qPrintable( dbPath() ) );
+         readOnly = true;
+         return;
+      }
+      vkPrintErr( "VgKnownErrors: '%s' isn't a known-errors database: "
+                  "moved to '%s', starting a new one",
+                  qPrintable( dbPath() ), qPrintable( badPath ) );
+      return;
+   }
+   if ( version == 1 ) {
+      // keyed as they were then: kept that way, so its keys still
+      // match.  Rewritten as a version 2 database, saying so.
+      keyType  = VG_FPRINT::SRCLINE;
+      keyDepth = 0;
+   }
+   else if ( version == KNOWN_VERSION ) {
+      quint8 type;
+      in >> type >> keyDepth;
+      if ( in.status() != QDataStream::Ok || type >= VG_FPRINT::NUM_KEYS ) {
+         vkPrintErr( "VgKnownErrors: '%s' has a bad header: "
+                     "changes won't be saved", qPrintable( dbPath() ) );
+         keyType  = KNOWN_KEY;
+         keyDepth = KNOWN_DEPTH;
+         readOnly = true;
+         return;
+      }
+      keyType = ( VG_FPRINT::Key )type;
+   }
+   else {
+      // e.g. written by a newer valkyrie: not ours to rewrite
+      vkPrintErr( "VgKnownErrors: '%s' is version %u, not %u: "
+                  "changes won't be saved", qPrintable( dbPath() ),
+                  version, KNOWN_VERSION );
+      readOnly = true;
+      return;
+   }
+
+   quint64 key;
+   quint8 state;
+   QString ticket;
+   while ( !in.atEnd() ) {
+      in >> key >> state >> ticket;
+      if ( in.status() != QDataStream::Ok ) {
+         break;
+      }
+      numRecords++;
+      if ( state == VG_TRIAGE::NONE || state >= VG_TRIAGE::NUM_STATES ) {
+         entries.remove( key );
+      }
+      else {
+         Entry& ent = entries[key];
+         ent.state  = ( VG_TRIAGE::State )state;
+         ent.ticket = ticket;
+      }
+   }
+
+   if ( file.error() != QFile::NoError ) {
+      // what's left may be fine: don't compact it away
+      vkPrintErr( "VgKnownErrors: failed to read '%s': %s: "
+                  "changes won't be saved", qPrintable( dbPath() ),
+                  qPrintable( file.errorString() ) );
+      readOnly = true;
+      return;
+   }
+   bool truncated = ( in.status() != QDataStream::Ok );
+   file.close();
+
+   if ( truncated ) {
+      // e.g. cut short by a crash: drop the partial record, rather
+      // than append to it
+      vkPrintErr( "VgKnownErrors: '%s' is truncated",
+                  qPrintable( dbPath() ) );
+   }
+   if ( numRecords > COMPACT_FACTOR * entries.count() || truncated ||
+        version != KNOWN_VERSION ) {
+      if ( !compact() && truncated ) {
+         // appending would run into the partial record
+         vkPrintErr( "VgKnownErrors: failed to rewrite '%s': "
+                     "changes won't be saved", qPrintable( dbPath() ) );
+         readOnly = true;
+      }
+   }
+}
+
+
+/*!
+  Write just the current entries: to a new file, put in place of
+  the old one only once it's all there.  The old one is moved aside
+  ('.bak') meanwhile, and back again if the new one can't be put in
+  place: there's always a whole database on disk.
+*/
+bool VgKnownErrors::compact()
+{
+   journal.close();
+
+   QString tmpPath = dbPath() + ".tmp";
+   QFile file( tmpPath );
+   if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
+      return false;
+   }
+   QDataStream out( &file );
+   out.setVersion( QDataStream::Qt_4_6 );
+   out << KNOWN_MAGIC << KNOWN_VERSION << ( quint8 )keyType << keyDepth;
+
+   QHash<quint64, Entry>::const_iterator it;
+   for ( it = entries.constBegin(); it != entries.constEnd(); ++it ) {
+      out << it.key() << ( quint8 )it.value().state << it.value().ticket;
+   }
+   file.close();
+
+   if ( out.status() != QDataStream::Ok || file.error() != QFile::NoError ) {
+      QFile::remove( tmpPath );
+      return false;
+   }
+   QString bakPath = dbPath() + ".bak";
+   QFile::remove( bakPath );
+   if ( QFile::exists( dbPath() ) && !QFile::rename( dbPath(), bakPath ) ) {
+      QFile::remove( tmpPath );
+      return false;
+   }
+   if ( !QFile::rename( tmpPath, dbPath() ) ) {
+      QFile::rename( bakPath, dbPath() );
+      QFile::remove( tmpPath );
+      return false;
+   }
+   QFile::remove( bakPath );
+   numRecords = entries.count();
+   return true;
+}
+
+
+/*!
+  Open for appending changes, starting it if need be.
+*/
+bool VgKnownErrors::openJournal()
+{
+   journal.setFileName( dbPath() );
+   bool isNew = !journal.exists() || journal.size() == 0;
+   if ( !journal.open( QIODevice::WriteOnly | QIODevice::Append ) ) {
+      vkPrintErr( "VgKnownErrors: failed to open '%s': %s",
+                  qPrintable( dbPath() ), qPrintable( journal.errorString() ) );
+      return false;
+   }
+   strm.setDevice( &journal );
+   strm.setVersion( QDataStream::Qt_4_6 );
+   if ( isNew ) {
+      strm << KNOWN_MAGIC << KNOWN_VERSION << ( quint8 )keyType << keyDepth;
+   }
+   return true;
+}
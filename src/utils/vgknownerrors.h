@@ -0,0 +1,110 @@
+/****************************************************************************
+** VgKnownErrors definition
+**  - errors already triaged, over all runs: kept under the config dir
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VGKNOWNERRORS_H
+#define __VGKNOWNERRORS_H
+
+#include "utils/vgfingerprint.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+#include <QString>
+
+
+// ============================================================
+namespace VG_TRIAGE
+{
+enum State {
+   NONE,       // not triaged: a new error
+   KNOWN,      // seen before, and being dealt with
+   IGNORED,    // not worth dealing with
+   NUM_STATES
+};
+}
+
+
+// ============================================================
+/*!
+  VgKnownErrors: the triage state of every error fingerprint
+  ever triaged, with its ticket id, if any.
+   - errors are keyed by a 64-bit hash of their kind and the top
+     frames of their first stack, by function name: the same in
+     every run, unlike interned ids (VgFingerprint::stableHash()),
+     and unchanged by a rebuild that just moves lines about.
+     keyOf() works it out.  How many frames, and by what, is kept
+     in the database's header: a database keeps its keys meaning
+     the same, whatever the defaults become.
+   - looked up in memory: O(1), for every error as it comes in.
+   - on disk, a journal: a change is just appended, however big
+     the database.  Loaded once, and compacted then if it's
+     mostly changes overwritten since.
+   - a file that isn't a database is moved aside ('.bad'); one
+     that can't be read, or is of another version, or is cut short
+     and can't be rewritten, is left be: changes are then kept in
+     memory only.
+   - gui thread only.
+*/
+class VgKnownErrors
+{
+public:
+   struct Entry {
+      Entry() : state( VG_TRIAGE::NONE ) {}
+      VG_TRIAGE::State state;
+      QString ticket;
+   };
+
+   static VgKnownErrors& global();
+
+   quint64 keyOf( const VgLogStore& store, int errIdx ) const;
+
+   Entry lookup( quint64 key ) const {
+      return entries.value( key );
+   }
+   bool isEmpty() const {
+      return entries.isEmpty();
+   }
+   int count() const {
+      return entries.count();
+   }
+
+   bool set( quint64 key, VG_TRIAGE::State state, const QString& ticket );
+
+   static QString dbPath();
+
+private:
+   VgKnownErrors();
+   Q_DISABLE_COPY( VgKnownErrors )
+
+   void load();
+   bool compact();
+   bool openJournal();
+
+private:
+   QHash<quint64, Entry> entries;
+   VG_FPRINT::Key keyType;     // what errors are keyed by
+   quint32 keyDepth;           // ... and how many frames of it
+   QFile journal;
+   QDataStream strm;
+   int numRecords;        // in the journal
+   bool readOnly;         // the file on disk isn't ours to write
+};
+
+#endif // #ifndef __VGKNOWNERRORS_H
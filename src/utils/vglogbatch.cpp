@@ -0,0 +1,397 @@
+/****************************************************************************
+** VgLogBatch implementation
+**  - summaries of many valgrind logs, without the gui
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vglogbatch.h"
+#include "utils/vglogmerger.h"
+#include "utils/vglogreader.h"
+#include "utils/vk_config.h"
+#include "utils/vk_utils.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QRegExp>
+#include <QThread>
+#include <QThreadPool>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+// top stacks kept for each log
+static const int NUM_TOP_STACKS = 10;
+
+
+// most found first
+static bool moreFound( const VgLogSummary::Stack& a, const VgLogSummary::Stack& b )
+{
+   return a.count > b.count;
+}
+
+static QString jsonStr( const QString& str )
+{
+   QString res = "\"";
+   for ( int i = 0; i < str.length(); ++i ) {
+      QChar c = str.at( i );
+      switch ( c.unicode() ) {
+      case '"':  res += "\\\""; break;
+      case '\\': res += "\\\\"; break;
+      case '\n': res += "\\n";  break;
+      case '\r': res += "\\r";  break;
+      case '\t': res += "\\t";  break;
+      default:
+         if ( c.unicode() < 0x20 ) {
+            res += QString( "\\u%1" ).arg( c.unicode(), 4, 16, QChar( '0' ) );
+         }
+         else {
+            res += c;
+         }
+      }
+   }
+   return res + "\"";
+}
+
+static QString csvStr( const QString& str )
+{
+   if ( !str.contains( QRegExp( "[\",\\n\\r]" ) ) ) {
+      return str;
+   }
+   QString res = str;
+   return "\"" + res.replace( "\"", "\"\"" ) + "\"";
+}
+
+
+
+// ============================================================
+/*!
+  VgLogSummary
+*/
+quint64 VgLogSummary::errorCount() const
+{
+   quint64 n = 0;
+   for ( int i = 0; i < kinds.count(); ++i ) {
+      n += kinds.at( i ).count;
+   }
+   return n;
+}
+
+quint64 VgLogSummary::leakedBytes() const
+{
+   quint64 n = 0;
+   for ( int i = 0; i < kinds.count(); ++i ) {
+      n += kinds.at( i ).leakedBytes;
+   }
+   return n;
+}
+
+
+
+// ============================================================
+/*!
+  VgLogBatchTask
+*/
+VgLogBatchTask::VgLogBatchTask( const QString& path, int _depth, int _numStacks )
+   : depth( _depth ), numStacks( _numStacks )
+{
+   // VgLogBatch owns us
+   setAutoDelete( false );
+   summary.path = path;
+   summary.ok = false;
+}
+
+/*!
+  The top depth frames of an error's first stack, innermost first.
+*/
+QString VgLogBatchTask::framesText( const VgLogRecord& rec, int depth )
+{
+   VgStrPool& pool = VgStrPool::global();
+   QStringList names;
+   if ( !rec.stacks.isEmpty() ) {
+      const QVector<VgLogFrame>& frms = rec.stacks.first();
+      for ( int f = 0; f < frms.count() && f < depth; ++f ) {
+         const VgLogFrame& lf = frms.at( f );
+         QString name = ( lf.fn != 0 ) ? pool.str( lf.fn ) : lf.ip;
+         if ( lf.file != 0 ) {
+            name += " (" + pool.str( lf.file ) + ":" + lf.line + ")";
+         }
+         else if ( lf.obj != 0 ) {
+            name += " (in " + QFileInfo( pool.str( lf.obj ) ).fileName() + ")";
+         }
+         names << name;
+      }
+   }
+   return names.join( " < " );
+}
+
+
+/*!
+  Parse the whole log, here, as records: then boil it down.
+*/
+void VgLogBatchTask::run()
+{
+   VgLogReader reader( 0 );
+   VgLogHandler* hnd = reader.handler();
+
+   summary.ok = reader.parseRecords( summary.path );
+   if ( !summary.ok ) {
+      summary.fatalMsg = hnd->fatalMsg();
+      return;
+   }
+
+   const QVector<VgLogRecord>& elems = hnd->collectedElements();
+   summary.tool = hnd->protocolTool();
+
+   const QVector<quint32> counts = hnd->errorCounts();
+
+   QHash<QString, int> kindIdxs;
+   QList<VgLogSummary::Stack> stacks;
+   for ( int e = 0; e < elems.count(); ++e ) {
+      const VgLogRecord& rec = elems.at( e );
+      if ( rec.type != VG_ELEM::ERROR ) {
+         continue;
+      }
+
+      quint64 count = counts.at( e );
+
+      int k = kindIdxs.value( rec.kind, -1 );
+      if ( k < 0 ) {
+         VgLogSummary::Kind kind;
+         kind.kind = rec.kind;
+         kind.errors = 0;
+         kind.count = kind.leakedBytes = kind.leakedBlocks = 0;
+         k = summary.kinds.count();
+         summary.kinds.append( kind );
+         kindIdxs.insert( rec.kind, k );
+      }
+      VgLogSummary::Kind& kind = summary.kinds[k];
+      kind.errors++;
+      kind.count        += count;
+      kind.leakedBytes  += rec.leakedBytes.toULongLong();
+      kind.leakedBlocks += rec.leakedBlocks.toULongLong();
+
+      VgLogSummary::Stack stk;
+      stk.kind = rec.kind;
+      stk.what = rec.what.isEmpty() ? rec.xwhat : rec.what;
+      stk.count = count;
+      stk.leakedBytes = rec.leakedBytes.toULongLong();
+
+      stk.frames = framesText( rec, depth );
+      stacks.append( stk );
+   }
+
+   qStableSort( stacks.begin(), stacks.end(), moreFound );
+   summary.topStacks = stacks.mid( 0, numStacks );
+}
+
+
+
+// ============================================================
+/*!
+  VgLogBatch
+*/
+VgLogBatch::VgLogBatch()
+{ }
+
+VgLogBatch::~VgLogBatch()
+{
+   qDeleteAll( tasks );
+}
+
+
+/*!
+  The whole of --batch: summarise the logs of logSpec, and write
+  them to output.  Returns the exit status: failure if any log has
+  errors, or couldn't be parsed, as well as if we couldn't do it.
+*/
+int VgLogBatch::exec( const QString& logSpec, const QString& output )
+{
+   if ( logSpec.isEmpty() ) {
+      vkPrintErr( "--batch: no logs given: use --view-log=<file|dir|wildcard>" );
+      return EXIT_FAILURE;
+   }
+
+   QStringList logs = VgLogMerger::isLogSet( logSpec )
+                      ? VgLogMerger::logFiles( logSpec ) : QStringList( logSpec );
+   if ( logs.isEmpty() ) {
+      vkPrintErr( "--batch: no readable logs in '%s'", qPrintable( logSpec ) );
+      return EXIT_FAILURE;
+   }
+
+   VgLogBatch batch;
+   batch.summarise( logs );
+
+   QString errMsg;
+   if ( !batch.write( output, errMsg ) ) {
+      vkPrintErr( "--batch: %s", qPrintable( errMsg ) );
+      return EXIT_FAILURE;
+   }
+   return ( batch.numFailed() == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/*!
+  Parse and summarise the logs, all cores at it.
+*/
+void VgLogBatch::summarise( const QStringList& logs )
+{
+   bool ok = false;
+   int depth = vkCfgProj->value( "valkyrie/group-depth" ).toInt( &ok );
+   if ( !ok ) {
+      depth = 4;
+   }
+
+   QThreadPool pool;
+   pool.setMaxThreadCount( QThread::idealThreadCount() );
+   for ( int i = 0; i < logs.count(); ++i ) {
+      VgLogBatchTask* task = new VgLogBatchTask( logs.at( i ), depth, NUM_TOP_STACKS );
+      tasks.append( task );
+      pool.start( task );
+   }
+   pool.waitForDone();
+}
+
+
+/*!
+  As JSON, unless output ends in .csv.  "-" is stdout.
+*/
+bool VgLogBatch::write( const QString& output, QString& errMsg )
+{
+   QFile file;
+   bool ok;
+   if ( output == "-" ) {
+      ok = file.open( stdout, QIODevice::WriteOnly );
+   }
+   else {
+      file.setFileName( output );
+      ok = file.open( QIODevice::WriteOnly | QIODevice::Truncate );
+   }
+   if ( !ok ) {
+      errMsg = "can't write to '" + output + "': " + file.errorString();
+      return false;
+   }
+
+   QTextStream out( &file );
+   out.setCodec( "UTF-8" );
+   if ( output.endsWith( ".csv", Qt::CaseInsensitive ) ) {
+      writeCsv( out );
+   }
+   else {
+      writeJson( out );
+   }
+   out.flush();
+
+   if ( file.error() != QFile::NoError ) {
+      errMsg = "failed writing '" + output + "': " + file.errorString();
+      return false;
+   }
+   return true;
+}
+
+int VgLogBatch::numFailed() const
+{
+   int n = 0;
+   for ( int i = 0; i < tasks.count(); ++i ) {
+      const VgLogSummary& sum = tasks.at( i )->summary;
+      if ( !sum.ok || sum.errorCount() > 0 ) {
+         n++;
+      }
+   }
+   return n;
+}
+
+
+/*!
+  { "logs": [ { "log", "tool", "status", "errors", "leaked_bytes",
+                "kinds": [...], "top_stacks": [...] }, ... ],
+    "failed": n }
+*/
+void VgLogBatch::writeJson( QTextStream& out )
+{
+   out << "{\n  \"logs\": [";
+   for ( int i = 0; i < tasks.count(); ++i ) {
+      const VgLogSummary& sum = tasks.at( i )->summary;
+      out << ( i > 0 ? "," : "" ) << "\n    {\n"
+          << "      \"log\": " << jsonStr( sum.path ) << ",\n";
+      if ( !sum.ok ) {
+         out << "      \"status\": \"error\",\n"
+             << "      \"message\": " << jsonStr( sum.fatalMsg ) << "\n    }";
+         continue;
+      }
+      out << "      \"tool\": " << jsonStr( sum.tool ) << ",\n"
+          << "      \"status\": \"" << ( sum.errorCount() == 0 ? "pass" : "fail" ) << "\",\n"
+          << "      \"errors\": " << sum.errorCount() << ",\n"
+          << "      \"leaked_bytes\": " << sum.leakedBytes() << ",\n"
+          << "      \"kinds\": [";
+      for ( int k = 0; k < sum.kinds.count(); ++k ) {
+         const VgLogSummary::Kind& kind = sum.kinds.at( k );
+         out << ( k > 0 ? "," : "" ) << "\n        { "
+             << "\"kind\": " << jsonStr( kind.kind )
+             << ", \"errors\": " << kind.errors
+             << ", \"count\": " << kind.count
+             << ", \"leaked_bytes\": " << kind.leakedBytes
+             << ", \"leaked_blocks\": " << kind.leakedBlocks << " }";
+      }
+      out << ( sum.kinds.isEmpty() ? "" : "\n      " ) << "],\n"
+          << "      \"top_stacks\": [";
+      for ( int s = 0; s < sum.topStacks.count(); ++s ) {
+         const VgLogSummary::Stack& stk = sum.topStacks.at( s );
+         out << ( s > 0 ? "," : "" ) << "\n        { "
+             << "\"kind\": " << jsonStr( stk.kind )
+             << ", \"count\": " << stk.count
+             << ", \"leaked_bytes\": " << stk.leakedBytes
+             << ", \"what\": " << jsonStr( stk.what )
+             << ", \"frames\": " << jsonStr( stk.frames ) << " }";
+      }
+      out << ( sum.topStacks.isEmpty() ? "" : "\n      " ) << "]\n    }";
+   }
+   out << "\n  ],\n  \"failed\": " << numFailed() << "\n}\n";
+}
+
+/*!
+  A row per log, then one per kind and top stack of it: told apart
+  by the 'record' column.
+*/
+void VgLogBatch::writeCsv( QTextStream& out )
+{
+   out << "log,tool,record,status,kind,errors,count,"
+          "leaked_bytes,leaked_blocks,what,frames\n";
+   for ( int i = 0; i < tasks.count(); ++i ) {
+      const VgLogSummary& sum = tasks.at( i )->summary;
+      QString log = csvStr( sum.path ) + "," + csvStr( sum.tool );
+      if ( !sum.ok ) {
+         out << log << ",log,error,,,,,," << csvStr( sum.fatalMsg ) << ",\n";
+         continue;
+      }
+      out << log << ",log," << ( sum.errorCount() == 0 ? "pass" : "fail" )
+          << ",,," << sum.errorCount() << "," << sum.leakedBytes() << ",,,\n";
+      for ( int k = 0; k < sum.kinds.count(); ++k ) {
+         const VgLogSummary::Kind& kind = sum.kinds.at( k );
+         out << log << ",kind,," << csvStr( kind.kind ) << "," << kind.errors
+             << "," << kind.count << "," << kind.leakedBytes
+             << "," << kind.leakedBlocks << ",,\n";
+      }
+      for ( int s = 0; s < sum.topStacks.count(); ++s ) {
+         const VgLogSummary::Stack& stk = sum.topStacks.at( s );
+         out << log << ",stack,," << csvStr( stk.kind ) << ",," << stk.count
+             << "," << stk.leakedBytes << ",," << csvStr( stk.what )
+             << "," << csvStr( stk.frames ) << "\n";
+      }
+   }
+}
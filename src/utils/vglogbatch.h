@@ -0,0 +1,123 @@
+/****************************************************************************
+** VgLogBatch definition
+**  - summaries of many valgrind logs, without the gui
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VGLOGBATCH_H
+#define __VGLOGBATCH_H
+
+#include "utils/vglogstore.h"
+
+#include <QList>
+#include <QRunnable>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+
+
+// ============================================================
+/*!
+  VgLogSummary: what's worth knowing of a log, for a build to pass
+  or fail on.
+*/
+struct VgLogSummary {
+   struct Kind {
+      QString kind;
+      quint32 errors;         // distinct errors
+      quint64 count;          // times found
+      quint64 leakedBytes;
+      quint64 leakedBlocks;
+   };
+   struct Stack {
+      QString kind;
+      QString what;
+      QString frames;         // innermost first
+      quint64 count;
+      quint64 leakedBytes;
+   };
+
+   QString path;
+   QString tool;
+   bool ok;
+   QString fatalMsg;          // only set if !ok
+   QList<Kind> kinds;         // in the order first found
+   QList<Stack> topStacks;    // by count, most first
+
+   quint64 errorCount() const;
+   quint64 leakedBytes() const;
+};
+
+
+// ============================================================
+/*!
+  VgLogBatchTask: summarises one log, in a worker thread.
+   - the log's elements are gone once it's summarised: just
+     the summary is kept, however many logs there are.
+*/
+class VgLogBatchTask : public QRunnable
+{
+public:
+   VgLogBatchTask( const QString& path, int depth, int numStacks );
+
+   void run();
+
+   static QString framesText( const VgLogRecord& rec, int depth );
+
+   VgLogSummary summary;
+
+private:
+   int depth;        // frames of a stack to show
+   int numStacks;    // top stacks to keep
+};
+
+
+
+// ============================================================
+/*!
+  VgLogBatch: --batch: summarises a set of logs (a file, directory
+  or wildcard, as for --view-log), as JSON or CSV.
+   - for CI: no gui is set up, just a QCoreApplication.
+   - the logs are parsed in parallel, a worker thread per core;
+     the summaries are written in the order the logs were given.
+   - errors are kept as records only, as by every parse, and
+     nothing is spooled for them: see VgLogReader::parseRecords().
+*/
+class VgLogBatch
+{
+public:
+   VgLogBatch();
+   ~VgLogBatch();
+
+   static int exec( const QString& logSpec, const QString& output );
+
+   void summarise( const QStringList& logs );
+   bool write( const QString& output, QString& errMsg );
+
+   // logs with errors in them, or that couldn't be parsed
+   int numFailed() const;
+
+private:
+   void writeJson( QTextStream& out );
+   void writeCsv( QTextStream& out );
+
+private:
+   QVector<VgLogBatchTask*> tasks;
+};
+
+#endif // #ifndef __VGLOGBATCH_H
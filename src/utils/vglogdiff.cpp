@@ -0,0 +1,238 @@
+/****************************************************************************
+** VgLogDiff implementation
+**  - the errors of a log, against those of a baseline log
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vglogdiff.h"
+#include "utils/vgfingerprint.h"
+#include "utils/vglogbatch.h"
+#include "utils/vglogreader.h"
+#include "utils/vk_utils.h"
+
+#include <QApplication>
+#include <QMutexLocker>
+#include <QProgressDialog>
+#include <QThreadPool>
+
+
+// frames of a stack shown: they're matched on all of them
+static const int SHOWN_FRAMES = 4;
+
+
+
+// ============================================================
+/*!
+  VgLogDiffTask
+*/
+VgLogDiffTask::VgLogDiffTask( VgLogDiff* dff, const QString& _path,
+                              VG_DIFF::Side _side )
+   : path( _path ), side( _side ), ok( false ), differ( dff )
+{
+   // VgLogDiff owns us
+   setAutoDelete( false );
+}
+
+void VgLogDiffTask::run()
+{
+   if ( !differ->isCancelled() ) {
+      parse();
+   }
+   differ->taskDone();
+}
+
+void VgLogDiffTask::parse()
+{
+   VgLogReader reader( 0 );
+   ok = reader.parseRecords( path );
+   if ( !ok ) {
+      fatalMsg = reader.handler()->fatalMsg();
+      return;
+   }
+
+   const QVector<VgLogRecord>& elems = reader.handler()->collectedElements();
+   tool = reader.handler()->protocolTool();
+
+   const QVector<quint32> counts = reader.handler()->errorCounts();
+
+   VG_DIFF::Side other = ( side == VG_DIFF::BASE ) ? VG_DIFF::LOG : VG_DIFF::BASE;
+   for ( int e = 0; e < elems.count(); ++e ) {
+      const VgLogRecord& rec = elems.at( e );
+      if ( rec.type != VG_ELEM::ERROR ) {
+         continue;
+      }
+
+      QByteArray key = VgFingerprint::of( rec );
+      int idx = entryIdxs.value( key, -1 );
+      if ( idx < 0 ) {
+         VgLogDiffEntry ent;
+         ent.status = VG_DIFF::SAME;
+         ent.kind   = rec.kind;
+         ent.what   = rec.what.isEmpty() ? rec.xwhat : rec.what;
+         ent.frames = VgLogBatchTask::framesText( rec, SHOWN_FRAMES );
+         ent.count[side] = ent.count[other] = 0;
+         ent.leakedBytes[side] = ent.leakedBytes[other] = 0;
+         idx = entries.count();
+         entries.append( ent );
+         entryIdxs.insert( key, idx );
+      }
+
+      VgLogDiffEntry& ent = entries[idx];
+      ent.count[side] += counts.at( e );
+      ent.leakedBytes[side] += rec.leakedBytes.toULongLong();
+   }
+}
+
+
+
+// ============================================================
+/*!
+  VgLogDiff
+*/
+VgLogDiff::VgLogDiff()
+   : doneTasks( 0 ), cancelled( false )
+{
+   for ( int i = 0; i < VG_DIFF::NUM_STATUS; ++i ) {
+      numStatus[i] = 0;
+   }
+}
+
+qint64 VgLogDiff::leakedDelta() const
+{
+   qint64 delta = 0;
+   for ( int i = 0; i < m_entries.count(); ++i ) {
+      delta += m_entries.at( i ).leakedDelta();
+   }
+   return delta;
+}
+
+
+/*!
+  Diff log against baseline.
+  Returns false on error, with fatalMsg() set, or if cancelled by
+  the user, with no fatalMsg().
+*/
+bool VgLogDiff::diff( const QString& baseline, const QString& log,
+                      QWidget* parent )
+{
+   VgLogDiffTask base( this, baseline, VG_DIFF::BASE );
+   VgLogDiffTask curr( this, log, VG_DIFF::LOG );
+
+   QProgressDialog progress( "Comparing log files...", "Cancel",
+                             0, 2, parent );
+   progress.setWindowModality( Qt::WindowModal );
+   progress.setMinimumDuration( 500 );
+
+   // our own pool: don't tie up the global one
+   QThreadPool pool;
+   pool.setMaxThreadCount( 2 );
+   pool.start( &base );
+   pool.start( &curr );
+
+   // wait for both logs, keeping the gui alive
+   for ( int done = 0; done < 2; ) {
+      while ( !waitForTasks( done + 1 ) ) {
+         qApp->processEvents();
+         if ( progress.wasCanceled() ) {
+            // the tasks are ours: see them finish
+            cancel();
+            pool.waitForDone();
+            return false;
+         }
+      }
+      progress.setValue( ++done );
+   }
+   pool.waitForDone();
+
+   if ( !base.ok || !curr.ok ) {
+      VgLogDiffTask& bad = !base.ok ? base : curr;
+      m_fatalMsg = bad.path + ": " + bad.fatalMsg;
+      return false;
+   }
+   if ( base.tool != curr.tool ) {
+      m_fatalMsg = "The baseline is a " + base.tool + " log, not a " +
+                   curr.tool + " one";
+      return false;
+   }
+
+   // the log's errors: each new, changed or the same
+   m_entries = curr.entries;
+   QVector<bool> matched( base.entries.count(), false );
+   QHash<QByteArray, int>::const_iterator it;
+   for ( it = curr.entryIdxs.constBegin(); it != curr.entryIdxs.constEnd(); ++it ) {
+      VgLogDiffEntry& ent = m_entries[it.value()];
+      int b = base.entryIdxs.value( it.key(), -1 );
+      if ( b < 0 ) {
+         ent.status = VG_DIFF::NEW;
+         continue;
+      }
+      matched[b] = true;
+      const VgLogDiffEntry& old = base.entries.at( b );
+      ent.count[VG_DIFF::BASE]       = old.count[VG_DIFF::BASE];
+      ent.leakedBytes[VG_DIFF::BASE] = old.leakedBytes[VG_DIFF::BASE];
+      ent.status = ( ent.countDelta() != 0 || ent.leakedDelta() != 0 )
+                   ? VG_DIFF::CHANGED : VG_DIFF::SAME;
+   }
+
+   // then the baseline's that are gone
+   for ( int b = 0; b < base.entries.count(); ++b ) {
+      if ( !matched.at( b ) ) {
+         m_entries.append( base.entries.at( b ) );
+         m_entries.last().status = VG_DIFF::FIXED;
+      }
+   }
+
+   for ( int i = 0; i < m_entries.count(); ++i ) {
+      numStatus[ m_entries.at( i ).status ]++;
+   }
+   return true;
+}
+
+
+/*!
+  wait a little for numTasks to be done: returns true if they are.
+*/
+bool VgLogDiff::waitForTasks( int numTasks )
+{
+   QMutexLocker locker( &mutex );
+   if ( doneTasks < numTasks ) {
+      taskFinished.wait( &mutex, 50/*msecs*/ );
+   }
+   return doneTasks >= numTasks;
+}
+
+void VgLogDiff::taskDone()
+{
+   QMutexLocker locker( &mutex );
+   doneTasks++;
+   taskFinished.wakeAll();
+}
+
+/*!
+  tasks not yet started won't bother parsing.
+*/
+void VgLogDiff::cancel()
+{
+   QMutexLocker locker( &mutex );
+   cancelled = true;
+}
+
+bool VgLogDiff::isCancelled()
+{
+   QMutexLocker locker( &mutex );
+   return cancelled;
+}
@@ -0,0 +1,145 @@
+/****************************************************************************
+** VgLogDiff definition
+**  - the errors of a log, against those of a baseline log
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VGLOGDIFF_H
+#define __VGLOGDIFF_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QRunnable>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+#include <QWidget>
+
+
+class VgLogDiff;
+
+
+// ============================================================
+namespace VG_DIFF
+{
+enum Status { NEW, FIXED, CHANGED, SAME, NUM_STATUS };
+enum Side { BASE, LOG };
+}
+
+/*!
+  An error of either log, or both: with its counts in each.
+*/
+struct VgLogDiffEntry {
+   VG_DIFF::Status status;
+   QString kind;
+   QString what;              // the log's, else the baseline's
+   QString frames;            // top frames, innermost first
+   quint64 count[2];          // by VG_DIFF::Side: 0 if not in it
+   quint64 leakedBytes[2];
+
+   qint64 countDelta() const {
+      return ( qint64 )count[VG_DIFF::LOG] - ( qint64 )count[VG_DIFF::BASE];
+   }
+   qint64 leakedDelta() const {
+      return ( qint64 )leakedBytes[VG_DIFF::LOG] -
+             ( qint64 )leakedBytes[VG_DIFF::BASE];
+   }
+};
+
+
+// ============================================================
+/*!
+  VgLogDiffTask: one log's errors, by fingerprint, in a worker thread.
+   - errors with the same fingerprint are summed: e.g. a leak
+     found by more than one leak check.
+*/
+class VgLogDiffTask : public QRunnable
+{
+public:
+   VgLogDiffTask( VgLogDiff* dff, const QString& path, VG_DIFF::Side side );
+
+   void run();
+
+   QString path;
+   VG_DIFF::Side side;
+   bool ok;
+   QString fatalMsg;          // only set if !ok
+   QString tool;
+
+   QVector<VgLogDiffEntry> entries;        // in the log's order
+   QHash<QByteArray, int> entryIdxs;       // fingerprint -> entry
+
+private:
+   void parse();
+
+private:
+   VgLogDiff* differ;
+};
+
+
+// ============================================================
+/*!
+  VgLogDiff: what changed between two runs.
+   - the two logs are parsed in parallel, as records only, by
+     worker threads, while keeping the gui alive: progress is
+     shown, and the user may cancel.
+   - errors are matched by fingerprint (VgFingerprint::of()):
+     one hash lookup each, so two logs of 200k errors take no
+     longer to diff than to parse.
+   - counts come from each log's last <errorcounts>, by <unique>.
+*/
+class VgLogDiff
+{
+public:
+   VgLogDiff();
+
+   bool diff( const QString& baseline, const QString& log, QWidget* parent );
+
+   /* only set if fatal error */
+   QString fatalMsg() const {
+      return m_fatalMsg;
+   }
+
+   const QVector<VgLogDiffEntry>& entries() const {
+      return m_entries;
+   }
+   int numWith( VG_DIFF::Status status ) const {
+      return numStatus[status];
+   }
+   qint64 leakedDelta() const;
+
+   // called from worker threads
+   void taskDone();
+   bool isCancelled();
+
+private:
+   bool waitForTasks( int numTasks );
+   void cancel();
+
+private:
+   QVector<VgLogDiffEntry> m_entries;   // the log's, then those fixed
+   int numStatus[VG_DIFF::NUM_STATUS];
+   QString m_fatalMsg;
+
+   QMutex mutex;
+   QWaitCondition taskFinished;
+   int doneTasks;
+   bool cancelled;
+};
+
+#endif // #ifndef __VGLOGDIFF_H
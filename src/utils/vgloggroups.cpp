@@ -0,0 +1,115 @@
+/****************************************************************************
+** VgLogGroups implementation
+**  - buckets of errors with the same kind and innermost frames
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vgloggroups.h"
+#include "utils/vglogstore.h"
+#include "utils/vk_utils.h"
+
+
+// frames in a fingerprint, unless regroup()'d otherwise
+static const int DEFAULT_DEPTH = 4;
+
+
+/**********************************************************************/
+/*!
+  VgLogGroups
+*/
+VgLogGroups::VgLogGroups()
+   : m_depth( DEFAULT_DEPTH ), m_key( VG_FPRINT::FUNCTION )
+{ }
+
+/*!
+  Forget the groups, but not how to group.
+*/
+void VgLogGroups::clear()
+{
+   groups.clear();
+   errGroups.clear();
+   groupIds.clear();
+   stackGroups.clear();
+}
+
+
+/*!
+  Put a newly added error in its group, starting a new one if need be.
+*/
+void VgLogGroups::addError( int errIdx, const VgLogStore& store )
+{
+   vk_assert( errIdx == errGroups.count() );
+   const VgErrorRec& err = store.error( errIdx );
+
+   // equal (kind, stack) -> equal fingerprint
+   quint32 top = ( err.numStacks > 0 ) ? store.stack( err.firstStack ).top : 0;
+   quint64 stackKey = ( ( quint64 )err.kind << 32 ) | top;
+
+   int grp = stackGroups.value( stackKey, -1 );
+   if ( grp < 0 ) {
+      QByteArray fp = VgFingerprint::of( store, errIdx, m_depth, m_key );
+      grp = groupIds.value( fp, -1 );
+      if ( grp < 0 ) {
+         Group g;
+         g.firstError   = errIdx;
+         g.kind         = err.kind;
+         g.count        = 0;
+         g.leakedBytes  = 0;
+         g.leakedBlocks = 0;
+         grp = groups.count();
+         groups.append( g );
+         groupIds.insert( fp, grp );
+      }
+      stackGroups.insert( stackKey, grp );
+   }
+
+   Group& g = groups[grp];
+   g.errors.append( errIdx );
+   g.count        += err.count;
+   g.leakedBytes  += err.leakedBytes;
+   g.leakedBlocks += err.leakedBlocks;
+   errGroups.append( grp );
+}
+
+/*!
+  An error's count has been updated (by <errorcounts>).
+*/
+void VgLogGroups::setCount( int errIdx, quint32 oldCount, quint32 newCount )
+{
+   Group& g = groups[ errGroups.at( errIdx ) ];
+   g.count = g.count - oldCount + newCount;
+}
+
+
+/*!
+  Group all the store's errors again, by their top depth frames.
+*/
+void VgLogGroups::regroup( int depth, VG_FPRINT::Key key,
+                           const VgLogStore& store )
+{
+   vk_assert( depth >= 0 );
+   vk_assert( key >= 0 && key < VG_FPRINT::NUM_KEYS );
+
+   clear();
+   m_depth = depth;
+   m_key   = key;
+
+   errGroups.reserve( store.numErrors() );
+   for ( int i = 0; i < store.numErrors(); ++i ) {
+      addError( i, store );
+   }
+}
@@ -0,0 +1,91 @@
+/****************************************************************************
+** VgLogGroups definition
+**  - buckets of errors with the same kind and innermost frames
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VGLOGGROUPS_H
+#define __VGLOGGROUPS_H
+
+#include "utils/vgfingerprint.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+
+
+class VgLogStore;
+
+
+// ============================================================
+/*!
+  VgLogGroups: errors bucketed by fingerprint (VgFingerprint): their
+  kind, and the top depth() frames of their first stack, by key().  The same bug reached
+  through different callers is then just one bucket.
+
+   - kept up to date as errors are added to the store.
+   - fingerprints are worked out once per distinct (kind, stack):
+     equal stacks are the very same list of cells in the store, so
+     most errors only cost a hash lookup.
+   - regroup() at another depth or key starts again from the
+     store's records: no re-parsing.
+*/
+class VgLogGroups
+{
+public:
+   struct Group {
+      int firstError;             // the one shown for the group
+      quint32 kind;               // interned
+      quint64 count;              // sum of its errors' counts
+      quint64 leakedBytes, leakedBlocks;
+      QVector<int> errors;        // ascending error indices
+   };
+
+   VgLogGroups();
+
+   void addError( int errIdx, const VgLogStore& store );
+   void setCount( int errIdx, quint32 oldCount, quint32 newCount );
+   void regroup( int depth, VG_FPRINT::Key key, const VgLogStore& store );
+   void clear();
+
+   int depth() const {
+      return m_depth;
+   }
+   VG_FPRINT::Key key() const {
+      return m_key;
+   }
+   int count() const {
+      return groups.count();
+   }
+   const Group& group( int idx ) const {
+      return groups.at( idx );
+   }
+   int groupOf( int errIdx ) const {
+      return errGroups.at( errIdx );
+   }
+
+private:
+   int m_depth;
+   VG_FPRINT::Key m_key;
+
+   QVector<Group> groups;
+   QVector<int> errGroups;              // error index -> group
+   QHash<QByteArray, int> groupIds;     // fingerprint -> group
+   QHash<quint64, int> stackGroups;     // kind << 32 | top cell -> group
+};
+
+#endif // #ifndef __VGLOGGROUPS_H
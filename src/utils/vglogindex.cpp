@@ -0,0 +1,321 @@
+/****************************************************************************
+** VgLogIndex implementation
+**  - per-field inverted index over the errors of a VgLogStore
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vglogindex.h"
+#include "utils/vglogstore.h"
+#include "utils/vk_utils.h"
+
+
+/**********************************************************************/
+/*!
+  VgFieldMatch
+*/
+VgFieldMatch::VgFieldMatch( VG_FIELD::Field field, CmpFun cmp,
+                            const QString& value )
+   : m_field( field ), m_cmp( cmp ), m_str( value ), m_id( 0 ),
+     m_num( 0 ), m_valid( true )
+{
+   if ( VG_FIELD::isNumeric( field ) ) {
+      int base = ( field == VG_FIELD::LOCKADDR ) ? 0 : 10;
+      m_num = value.toLongLong( &m_valid, base );
+   }
+   else if ( cmp == REGEX || cmp == NREGEX ) {
+      m_rx = QRegExp( value );
+      m_valid = m_rx.isValid();
+   }
+}
+
+/*!
+  Ids are never reused: once the value's been interned, its id holds.
+  Until then, no interned string can equal it.
+*/
+quint32 VgFieldMatch::strId() const
+{
+   if ( m_id == 0 ) {
+      m_id = VgStrPool::global().find( m_str );
+   }
+   return m_id;
+}
+
+bool VgFieldMatch::matchStr( quint32 id, const QString& str ) const
+{
+   // id is interned (non-zero): equality is just id equality
+   if ( m_cmp == EQL ) {
+      return id == strId();
+   }
+   if ( m_cmp == NEQL ) {
+      return id != strId();
+   }
+
+   QHash<quint32, bool>::const_iterator it = strCache.constFind( id );
+   if ( it != strCache.constEnd() ) {
+      return it.value();
+   }
+
+   bool res = false;
+   switch ( m_cmp ) {
+   case CONT:  res = ( str.contains(   m_str )); break;
+   case NCONT: res = (!str.contains(   m_str )); break;
+   case STRT:  res = ( str.startsWith( m_str )); break;
+   case NSTRT: res = (!str.startsWith( m_str )); break;
+   case END:   res = ( str.endsWith(   m_str )); break;
+   case NEND:  res = (!str.endsWith(   m_str )); break;
+   case REGEX:  res = ( m_rx.indexIn( str ) != -1 ); break;
+   case NREGEX: res = ( m_rx.indexIn( str ) == -1 ); break;
+   default:
+      vk_assert_never_reached();
+   }
+
+   strCache.insert( id, res );
+   return res;
+}
+
+bool VgFieldMatch::matchNum( qint64 num ) const
+{
+   if ( !m_valid ) {
+      return false;
+   }
+
+   switch ( m_cmp ) {
+   case EQL:   return ( num == m_num );
+   case NEQL:  return ( num != m_num );
+   case LSTHN: return ( num  < m_num );
+   case GRTHN: return ( num  > m_num );
+   default:
+      vk_assert_never_reached();
+   }
+   return false;
+}
+
+
+
+/**********************************************************************/
+/*!
+  VgLogIndex
+*/
+VgLogIndex::VgLogIndex()
+   : nErrors( 0 )
+{ }
+
+void VgLogIndex::clear()
+{
+   for ( int f = 0; f < VG_FIELD::NUM_FIELDS; ++f ) {
+      strPosts[f].clear();
+      numPosts[f].clear();
+   }
+   leakErrors.clear();
+   nErrors = 0;
+}
+
+/*!
+  errors are added in order, so an error's index is only ever
+  the last one in a list: that's all there is to dedup.
+*/
+void VgLogIndex::post( Postings& list, int errIdx )
+{
+   if ( list.isEmpty() || list.last() != errIdx ) {
+      list.append( errIdx );
+   }
+}
+
+void VgLogIndex::setBits( QBitArray& bits, const Postings& list ) const
+{
+   for ( int i = 0; i < list.count(); ++i ) {
+      bits.setBit( list.at( i ) );
+   }
+}
+
+
+/*!
+  Index the error just added to store.
+   - leaked: whether it has leakedbytes/blocks (only leak errors do).
+*/
+void VgLogIndex::addError( int errIdx, const VgLogStore& store, bool leaked )
+{
+   vk_assert( errIdx == nErrors );
+   const VgErrorRec& err = store.error( errIdx );
+
+   nErrors++;
+   leakErrors.resize( nErrors );
+
+   post( strPosts[VG_FIELD::KIND][err.kind], errIdx );
+
+   if ( leaked ) {
+      leakErrors.setBit( errIdx );
+      post( numPosts[VG_FIELD::LEAKEDBYTES][( qint64 )err.leakedBytes], errIdx );
+      post( numPosts[VG_FIELD::LEAKEDBLOCKS][( qint64 )err.leakedBlocks], errIdx );
+   }
+
+   quint32 hg = err.firstHgVal;
+   for ( quint32 i = 0; i < err.numHThreads; ++i ) {
+      post( numPosts[VG_FIELD::HTHREADID][( qint64 )store.hgValue( hg++ )], errIdx );
+   }
+   for ( quint32 i = 0; i < err.numLockAddrs; ++i ) {
+      post( numPosts[VG_FIELD::LOCKADDR][( qint64 )store.hgValue( hg++ )], errIdx );
+   }
+
+   for ( quint32 s = 0; s < err.numStacks; ++s ) {
+      const VgStackRec& stk = store.stack( err.firstStack + s );
+      for ( quint32 c = stk.top; c != 0; c = store.cell( c ).next ) {
+         const VgFrameRec& frm = store.frame( store.cell( c ).frame );
+         // id 0 / line 0: frame doesn't have it
+         if ( frm.obj != 0 ) {
+            post( strPosts[VG_FIELD::OBJ][frm.obj], errIdx );
+         }
+         if ( frm.fn != 0 ) {
+            post( strPosts[VG_FIELD::FN][frm.fn], errIdx );
+         }
+         if ( frm.dir != 0 ) {
+            post( strPosts[VG_FIELD::SRCDIR][frm.dir], errIdx );
+         }
+         if ( frm.file != 0 ) {
+            post( strPosts[VG_FIELD::SRCFILE][frm.file], errIdx );
+         }
+         if ( frm.line != 0 ) {
+            post( numPosts[VG_FIELD::LINE][frm.line], errIdx );
+         }
+      }
+   }
+}
+
+
+/*!
+  All errors matching match, as a bitset over error indices.
+*/
+QBitArray VgLogIndex::select( const VgFieldMatch& match,
+                              const VgLogStore& store ) const
+{
+   QBitArray bits( nErrors );
+   VG_FIELD::Field f = match.field();
+
+   if ( !VG_FIELD::isNumeric( f ) ) {
+      const QHash<quint32, Postings>& posts = strPosts[f];
+      QHash<quint32, Postings>::const_iterator it;
+      if ( match.cmpFun() == VgFieldMatch::EQL ) {
+         // a single value: straight to its list
+         it = posts.constFind( match.strId() );
+         if ( it != posts.constEnd() && it.key() != 0 ) {
+            setBits( bits, it.value() );
+         }
+         return bits;
+      }
+      for ( it = posts.constBegin(); it != posts.constEnd(); ++it ) {
+         if ( it.key() != 0 && match.matchStr( it.key(), store.str( it.key() ) ) ) {
+            setBits( bits, it.value() );
+         }
+      }
+      return bits;
+   }
+
+   if ( !match.isValid() ) {
+      return bits;
+   }
+
+   // numbers are sorted: only visit the range that can match
+   const QMap<qint64, Postings>& posts = numPosts[f];
+   QMap<qint64, Postings>::const_iterator it  = posts.constBegin();
+   QMap<qint64, Postings>::const_iterator end = posts.constEnd();
+
+   switch ( match.cmpFun() ) {
+   case VgFieldMatch::EQL:
+      it = posts.constFind( match.num() );
+      if ( it != end ) {
+         setBits( bits, it.value() );
+      }
+      return bits;
+   case VgFieldMatch::LSTHN:
+      end = posts.lowerBound( match.num() );
+      break;
+   case VgFieldMatch::GRTHN:
+      it = posts.upperBound( match.num() );
+      break;
+   default:
+      break;
+   }
+
+   for ( ; it != end; ++it ) {
+      if ( match.matchNum( it.key() ) ) {
+         setBits( bits, it.value() );
+      }
+   }
+   return bits;
+}
+
+
+/*!
+  Does error errIdx match: for errors arriving after a select().
+*/
+bool VgLogIndex::matches( int errIdx, const VgFieldMatch& match,
+                          const VgLogStore& store ) const
+{
+   const VgErrorRec& err = store.error( errIdx );
+
+   switch ( match.field() ) {
+   case VG_FIELD::KIND:
+      return err.kind != 0 && match.matchStr( err.kind, store.str( err.kind ) );
+   case VG_FIELD::LEAKEDBYTES:
+      return leakErrors.testBit( errIdx ) && match.matchNum( err.leakedBytes );
+   case VG_FIELD::LEAKEDBLOCKS:
+      return leakErrors.testBit( errIdx ) && match.matchNum( err.leakedBlocks );
+   case VG_FIELD::HTHREADID:
+   case VG_FIELD::LOCKADDR: {
+      quint32 first = err.firstHgVal;
+      quint32 num   = err.numHThreads;
+      if ( match.field() == VG_FIELD::LOCKADDR ) {
+         first += err.numHThreads;
+         num    = err.numLockAddrs;
+      }
+      for ( quint32 i = 0; i < num; ++i ) {
+         if ( match.matchNum( ( qint64 )store.hgValue( first + i ) ) ) {
+            return true;
+         }
+      }
+      return false;
+   }
+   default:
+      break;
+   }
+
+   // frame fields
+   for ( quint32 s = 0; s < err.numStacks; ++s ) {
+      const VgStackRec& stk = store.stack( err.firstStack + s );
+      for ( quint32 c = stk.top; c != 0; c = store.cell( c ).next ) {
+         const VgFrameRec& frm = store.frame( store.cell( c ).frame );
+         quint32 id = 0;
+         switch ( match.field() ) {
+         case VG_FIELD::OBJ:     id = frm.obj;  break;
+         case VG_FIELD::FN:      id = frm.fn;   break;
+         case VG_FIELD::SRCDIR:  id = frm.dir;  break;
+         case VG_FIELD::SRCFILE: id = frm.file; break;
+         case VG_FIELD::LINE:
+            if ( frm.line != 0 && match.matchNum( frm.line ) ) {
+               return true;
+            }
+            continue;
+         default:
+            vk_assert_never_reached();
+         }
+         if ( id != 0 && match.matchStr( id, store.str( id ) ) ) {
+            return true;
+         }
+      }
+   }
+   return false;
+}
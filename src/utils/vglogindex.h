@@ -0,0 +1,142 @@
+/****************************************************************************
+** VgLogIndex definition
+**  - per-field inverted index over the errors of a VgLogStore
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VGLOGINDEX_H
+#define __VGLOGINDEX_H
+
+#include <QBitArray>
+#include <QHash>
+#include <QMap>
+#include <QRegExp>
+#include <QString>
+#include <QVector>
+
+
+class VgLogStore;
+
+
+// ============================================================
+namespace VG_FIELD {
+   // the error fields we can filter on
+   enum Field {
+      KIND, OBJ, FN, SRCDIR, SRCFILE,          // strings
+      LINE, LEAKEDBYTES, LEAKEDBLOCKS,         // numbers
+      HTHREADID, LOCKADDR,                     // helgrind numbers
+      NUM_FIELDS
+   };
+
+   inline bool isNumeric( Field f ) {
+      return f >= LINE;
+   }
+}
+
+
+
+// ============================================================
+/*!
+  VgFieldMatch: a test on the values of one error field.
+   - an error matches if _any_ of its values for the field does
+     (e.g. any frame's fn, over all its stacks).
+   - results for string values are cached by interned id, so each
+     distinct value is only ever tested once.
+   - EQL/NEQL on strings compare interned ids: the value's id is
+     looked up in the global pool, not the strings themselves.
+   - REGEX/NREGEX: value is a regular expression, compiled just once.
+   - LOCKADDR values may be given in hex (0x...).
+*/
+class VgFieldMatch
+{
+public:
+   enum CmpFun { EQL, NEQL, LSTHN, GRTHN, CONT, NCONT,
+                 STRT, NSTRT, END, NEND, REGEX, NREGEX };
+
+   VgFieldMatch( VG_FIELD::Field field, CmpFun cmp, const QString& value );
+
+   VG_FIELD::Field field() const {
+      return m_field;
+   }
+   CmpFun cmpFun() const {
+      return m_cmp;
+   }
+   qint64 num() const {
+      return m_num;
+   }
+   /* numeric fields need a numeric value, regexs a valid pattern */
+   bool isValid() const {
+      return m_valid;
+   }
+
+   quint32 strId() const;    // 0 while the value isn't interned
+   bool matchStr( quint32 id, const QString& str ) const;
+   bool matchNum( qint64 num ) const;
+
+private:
+   VG_FIELD::Field m_field;
+   CmpFun  m_cmp;
+   QString m_str;
+   mutable quint32 m_id;
+   QRegExp m_rx;
+   qint64  m_num;
+   bool    m_valid;
+   mutable QHash<quint32, bool> strCache;
+};
+
+
+
+// ============================================================
+/*!
+  VgLogIndex: for each field, which errors have which value.
+   - built as errors are added to the store: string values are
+     keyed by their interned id, numbers by value (sorted, for
+     range tests).
+   - selecting by a VgFieldMatch tests each distinct value once,
+     and or's the lists of the matching ones into a bitset:
+     filtering is then just bitset operations, not per-error work.
+*/
+class VgLogIndex
+{
+public:
+   VgLogIndex();
+
+   void addError( int errIdx, const VgLogStore& store, bool leaked );
+   void clear();
+
+   int numErrors() const {
+      return nErrors;
+   }
+
+   QBitArray select( const VgFieldMatch& match, const VgLogStore& store ) const;
+   bool matches( int errIdx, const VgFieldMatch& match,
+                 const VgLogStore& store ) const;
+
+private:
+   typedef QVector<int> Postings;   // ascending error indices
+
+   void post( Postings& list, int errIdx );
+   void setBits( QBitArray& bits, const Postings& list ) const;
+
+private:
+   QHash<quint32, Postings> strPosts[VG_FIELD::NUM_FIELDS];
+   QMap<qint64, Postings>   numPosts[VG_FIELD::NUM_FIELDS];
+   QBitArray leakErrors;            // errors with leakedbytes/blocks
+   int nErrors;
+};
+
+#endif // #ifndef __VGLOGINDEX_H
@@ -0,0 +1,286 @@
+/****************************************************************************
+** VgLogLeaks implementation
+**  - leaked bytes and blocks, totalled by allocation site
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vglogleaks.h"
+#include "utils/vglogstore.h"
+#include "utils/vk_utils.h"
+
+#include <algorithm>
+
+
+/*!
+  The loss record number in a leak error's what:
+  "... are definitely lost in loss record 3 of 10".  0 if none.
+*/
+static int lossRecord( const QString& what )
+{
+   static const int markerLen = 12;   // "loss record "
+   int start = what.lastIndexOf( QLatin1String( "loss record " ) );
+   if ( start < 0 ) {
+      return 0;
+   }
+   start += markerLen;
+   int end = start;
+   while ( end < what.length() && what.at( end ).isDigit() ) {
+      ++end;
+   }
+   return what.mid( start, end - start ).toInt();
+}
+
+
+/**********************************************************************/
+/*!
+  VgLeakChecks
+*/
+bool VgLeakChecks::add( const QString& what )
+{
+   // loss records are numbered from 1 in each leak check
+   int record = lossRecord( what );
+   bool restart = false;
+   if ( m_count == 0 ) {
+      m_count = 1;
+   }
+   else if ( !m_cumulative && record > 0 && record <= lastRecord ) {
+      m_count++;
+      restart = true;
+   }
+   lastRecord = record;
+   return restart;
+}
+
+
+
+/*!
+  Sites in order of one of their totals.
+   - ties go by site index: the ranking is always the same.
+*/
+struct SiteOrder {
+   SiteOrder( const VgLogLeaks& l, VG_LEAK::SortKey k, bool desc )
+      : leaks( l ), key( k ), descending( desc ) {}
+
+   bool operator()( int a, int b ) const {
+      quint64 va = leaks.sortValue( a, key );
+      quint64 vb = leaks.sortValue( b, key );
+      if ( va != vb ) {
+         return descending ? ( va > vb ) : ( va < vb );
+      }
+      return a < b;
+   }
+
+   const VgLogLeaks& leaks;
+   VG_LEAK::SortKey key;
+   bool descending;
+};
+
+
+
+/**********************************************************************/
+/*!
+  VgLogLeaks
+*/
+VgLogLeaks::VgLogLeaks()
+   : m_depth( 0 ), m_totalBytes( 0 ), m_totalBlocks( 0 )
+{
+   VgStrPool& pool = VgStrPool::global();
+   kinds[VG_LEAK::DEFINITE]  = pool.intern( "Leak_DefinitelyLost" );
+   kinds[VG_LEAK::INDIRECT]  = pool.intern( "Leak_IndirectlyLost" );
+   kinds[VG_LEAK::POSSIBLE]  = pool.intern( "Leak_PossiblyLost" );
+   kinds[VG_LEAK::REACHABLE] = pool.intern( "Leak_StillReachable" );
+}
+
+/*!
+  Forget the sites, and the leak checks seen: but not how to
+  tell sites apart.
+*/
+void VgLogLeaks::clear()
+{
+   reset();
+   checks.clear();
+}
+
+/*!
+  A new leak check: its totals start from nothing.
+*/
+void VgLogLeaks::reset()
+{
+   sites.clear();
+   siteIds.clear();
+   stackSites.clear();
+   m_totalBytes  = 0;
+   m_totalBlocks = 0;
+}
+
+/*!
+  The VG_LEAK::Loss of an error kind: -1 if not a leak.
+*/
+int VgLogLeaks::loss( quint32 kind ) const
+{
+   for ( int i = 0; i < VG_LEAK::NUM_LOSSES; ++i ) {
+      if ( kinds[i] == kind ) {
+         return i;
+      }
+   }
+   return -1;
+}
+
+
+/*!
+  The cell the allocation site starts at, in the error's first
+  stack: the first frame not in valgrind's preloaded malloc
+  replacements, else the top.  0 if no frames.
+*/
+quint32 VgLogLeaks::siteTop( int errIdx, const VgLogStore& store ) const
+{
+   const VgErrorRec& err = store.error( errIdx );
+   quint32 top = ( err.numStacks > 0 ) ? store.stack( err.firstStack ).top : 0;
+
+   for ( quint32 c = top; c != 0; c = store.cell( c ).next ) {
+      const VgFrameRec& frm = store.frame( store.cell( c ).frame );
+      if ( !store.str( frm.obj ).contains( "vgpreload_" ) ) {
+         return c;
+      }
+   }
+   return top;
+}
+
+/*!
+  The site's frames, as words to hash.
+   - depth 0: the rest of the stack is one shared list of cells,
+     so its first cell says it all.
+*/
+QByteArray VgLogLeaks::fingerprint( quint32 top, const VgLogStore& store ) const
+{
+   QVector<quint32> words;
+   if ( m_depth == 0 ) {
+      words.append( top );
+   }
+   else {
+      quint32 c = top;
+      for ( int n = 0; c != 0 && n < m_depth; ++n, c = store.cell( c ).next ) {
+         words.append( store.cell( c ).frame );
+      }
+   }
+   return QByteArray( ( const char* )words.constData(),
+                      words.count() * sizeof( quint32 ) );
+}
+
+
+/*!
+  Add a newly added error to its site's totals, if it's a leak.
+*/
+void VgLogLeaks::addError( int errIdx, const VgLogStore& store )
+{
+   const VgErrorRec& err = store.error( errIdx );
+   int lss = loss( err.kind );
+   if ( lss < 0 ) {
+      return;
+   }
+
+   if ( checks.add( store.text( err.what ) ) ) {
+      reset();
+   }
+
+   // equal first stacks -> equal site
+   quint32 top = ( err.numStacks > 0 ) ? store.stack( err.firstStack ).top : 0;
+   int idx = stackSites.value( top, -1 );
+   if ( idx < 0 ) {
+      QByteArray fp = fingerprint( siteTop( errIdx, store ), store );
+      idx = siteIds.value( fp, -1 );
+      if ( idx < 0 ) {
+         Site s;
+         s.firstError = errIdx;
+         s.records    = 0;
+         s.bytes      = 0;
+         s.blocks     = 0;
+         s.losses     = 0;
+         for ( int i = 0; i < VG_LEAK::NUM_LOSSES; ++i ) {
+            s.lostBytes[i] = 0;
+         }
+         idx = sites.count();
+         sites.append( s );
+         siteIds.insert( fp, idx );
+      }
+      stackSites.insert( top, idx );
+   }
+
+   Site& s = sites[idx];
+   s.lastError = errIdx;
+   s.records++;
+   s.bytes  += err.leakedBytes;
+   s.blocks += err.leakedBlocks;
+   s.lostBytes[lss] += err.leakedBytes;
+   s.losses |= 1 << lss;
+
+   m_totalBytes  += err.leakedBytes;
+   m_totalBlocks += err.leakedBlocks;
+}
+
+
+/*!
+  Total the store's leaks again, by their top depth frames.
+   - the leak checks are replayed too: only the last one counts.
+*/
+void VgLogLeaks::regroup( int depth, const VgLogStore& store )
+{
+   vk_assert( depth >= 0 );
+
+   clear();
+   m_depth = depth;
+   for ( int i = 0; i < store.numErrors(); ++i ) {
+      addError( i, store );
+   }
+}
+
+
+quint64 VgLogLeaks::sortValue( int site, VG_LEAK::SortKey key ) const
+{
+   const Site& s = sites.at( site );
+   switch ( key ) {
+   case VG_LEAK::BYTES:          return s.bytes;
+   case VG_LEAK::BLOCKS:         return s.blocks;
+   case VG_LEAK::RECORDS:        return s.records;
+   case VG_LEAK::DEFINITE_BYTES: return s.lostBytes[VG_LEAK::DEFINITE];
+   default:
+      vk_assert_never_reached();
+      return 0;
+   }
+}
+
+/*!
+  The top n sites by key: all of them if n <= 0.
+   - only the first n are put in order: the rest are left be.
+*/
+QVector<int> VgLogLeaks::top( int n, VG_LEAK::SortKey key, bool descending ) const
+{
+   QVector<int> order( sites.count() );
+   for ( int i = 0; i < order.count(); ++i ) {
+      order[i] = i;
+   }
+
+   SiteOrder less( *this, key, descending );
+   if ( n <= 0 || n >= order.count() ) {
+      std::sort( order.begin(), order.end(), less );
+   }
+   else {
+      std::partial_sort( order.begin(), order.begin() + n, order.end(), less );
+      order.resize( n );
+   }
+   return order;
+}
@@ -0,0 +1,176 @@
+/****************************************************************************
+** VgLogLeaks definition
+**  - leaked bytes and blocks, totalled by allocation site
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VGLOGLEAKS_H
+#define __VGLOGLEAKS_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+
+class VgLogStore;
+
+
+// ============================================================
+namespace VG_LEAK {
+   // memcheck's Leak_* kinds
+   enum Loss {
+      DEFINITE, INDIRECT, POSSIBLE, REACHABLE,
+      NUM_LOSSES
+   };
+
+   // what sites are ranked by
+   enum SortKey {
+      BYTES, BLOCKS, RECORDS, DEFINITE_BYTES,
+      NUM_SORTKEYS
+   };
+}
+
+
+
+// ============================================================
+/*!
+  VgLeakChecks: which leak check memcheck's loss records are from.
+  A loss record numbered no higher than the one before starts a new
+  one (e.g. from VALGRIND_DO_LEAK_CHECK): only the last one counts.
+  Unless cumulative: merged logs each have their own leak check,
+  and all of them count.
+*/
+class VgLeakChecks
+{
+public:
+   VgLeakChecks() : m_cumulative( false ), m_count( 0 ), lastRecord( 0 ) {}
+
+   // the next leak error: true if what's counted so far is to go
+   bool add( const QString& what );
+   void clear() {
+      m_count    = 0;
+      lastRecord = 0;
+   }
+   void setCumulative( bool cumulative ) {
+      checks.setCumulative( cumulative );
+   }
+   bool isCumulative() const {
+      return checks.isCumulative();
+   }
+   bool isCumulative() const {
+      return m_cumulative;
+   }
+   int count() const {                 // leak checks seen: 0 if none
+      return m_count;
+   }
+
+private:
+   bool m_cumulative;
+   int m_count;
+   int lastRecord;                     // loss record number: 0 if none
+};
+
+
+
+// ============================================================
+/*!
+  VgLogLeaks: memcheck's leak errors, totalled by allocation site:
+  the top depth() frames of their stack, once past valgrind's own
+  malloc replacements.  depth 0: the whole stack.
+
+   - kept up to date as errors are added to the store: each leak
+     error just adds to its site's totals.
+   - sites are worked out once per distinct stack, as for
+     VgLogGroups: most errors only cost a hash lookup.
+   - only the last leak check counts (VgLeakChecks): the totals
+     start again with each one.  Unless cumulative.
+   - top() ranks sites with a partial sort: the heaviest few of
+     many thousands, without sorting them all.
+*/
+class VgLogLeaks
+{
+public:
+   struct Site {
+      int firstError;             // the one shown for the site
+      int lastError;
+      quint64 records;            // loss records
+      quint64 bytes, blocks;
+      quint64 lostBytes[VG_LEAK::NUM_LOSSES];
+      quint32 losses;             // bit per VG_LEAK::Loss
+   };
+
+   VgLogLeaks();
+
+   void addError( int errIdx, const VgLogStore& store );
+   void regroup( int depth, const VgLogStore& store );
+   void setCumulative( bool cumulative ) {
+      checks.setCumulative( cumulative );
+   }
+   bool isCumulative() const {
+      return checks.isCumulative();
+   }
+   void clear();
+
+   QVector<int> top( int n, VG_LEAK::SortKey key, bool descending ) const;
+   quint64 sortValue( int site, VG_LEAK::SortKey key ) const;
+
+   // the allocation site's frames: past the allocator's
+   quint32 siteTop( int errIdx, const VgLogStore& store ) const;
+
+   int depth() const {
+      return m_depth;
+   }
+   int count() const {
+      return sites.count();
+   }
+   const Site& site( int idx ) const {
+      return sites.at( idx );
+   }
+   quint64 totalBytes() const {
+      return m_totalBytes;
+   }
+   quint64 totalBlocks() const {
+      return m_totalBlocks;
+   }
+   int leakCheck() const {             // leak checks seen: 0 if none
+      return checks.count();
+   }
+   quint32 kind( VG_LEAK::Loss lss ) const {
+      return kinds[lss];
+   }
+   bool isLeak( quint32 kind ) const {
+      return loss( kind ) >= 0;
+   }
+
+private:
+   void reset();
+   int  loss( quint32 kind ) const;
+   QByteArray fingerprint( quint32 top, const VgLogStore& store ) const;
+
+private:
+   int m_depth;
+   VgLeakChecks checks;
+   quint32 kinds[VG_LEAK::NUM_LOSSES];  // interned Leak_* kinds
+
+   QVector<Site> sites;
+   QHash<QByteArray, int> siteIds;      // fingerprint -> site
+   QHash<quint32, int> stackSites;      // first stack's top cell -> site
+   quint64 m_totalBytes, m_totalBlocks;
+};
+
+#endif // #ifndef __VGLOGLEAKS_H
@@ -0,0 +1,479 @@
+/****************************************************************************
+** VgLogLoader implementation
+**  - multi-threaded loading of large saved valgrind logs
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vglogloader.h"
+#include "utils/vglogsidecar.h"
+#include "utils/vk_config.h"
+#include "utils/vk_utils.h"
+
+#include <QApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QProgressDialog>
+#include <QThread>
+#include <QThreadPool>
+
+#include <string.h>
+
+
+// below this, chunks aren't worth a thread
+static const qint64 MIN_CHUNK_SIZE    = 1024 * 1024;
+// more chunks than threads, to even out the load
+static const int    CHUNKS_PER_THREAD = 4;
+// elements handed to the view between gui updates
+static const int    BATCH_SIZE        = 256;
+static const int    PROGRESS_STEPS    = 1000;
+// decoded elements waiting for the gui, before the decoding waits
+static const int    MAX_DECODED       = BATCH_SIZE * 16;
+
+
+
+// ============================================================
+/*!
+  VgLogChunkTask
+*/
+VgLogChunkTask::VgLogChunkTask( VgLogLoader* ldr, const VgXmlTokenizer* src,
+                                qint64 _from, qint64 _to )
+   : handler( 0 ), tokenizer( &handler ), ok( false ),
+     loader( ldr ), from( _from ), to( _to )
+{
+   // loader owns us
+   setAutoDelete( false );
+   tokenizer.setBuffer( src->data(), src->dataSize(), src->fileName() );
+}
+
+void VgLogChunkTask::run()
+{
+   if ( !loader->isCancelled() ) {
+      ok = tokenizer.parseFragment( from, to );
+   }
+   loader->chunkDone( this );
+}
+
+
+
+// ============================================================
+/*!
+  VgLogDecodeTask
+*/
+VgLogDecodeTask::VgLogDecodeTask( VgLogLoader* ldr, const QString& _path,
+                                  VkCompress::Format _fmt, VgErrorXml* xml )
+   : ok( false ), loader( ldr ), path( _path ), fmt( _fmt ), errorXml( xml )
+{
+   // loader owns us
+   setAutoDelete( false );
+}
+
+void VgLogDecodeTask::run()
+{
+   // no vglog: elements are handed to the loader as they're parsed.
+   // no offsets either: errors are spooled for the view.
+   VgLogReader reader( 0 );
+   reader.handler()->setErrorXml( errorXml );
+   ok = reader.parseCompressed( path, fmt, loader );
+   fatalMsg = reader.handler()->fatalMsg();
+   loader->decodeDone();
+}
+
+
+
+// ============================================================
+/*!
+  VgLogLoader
+*/
+VgLogLoader::VgLogLoader( VgLogHandler* hnd, VgXmlTokenizer* tok )
+   : handler( hnd ), tokenizer( tok ), cancelled( false ),
+     decodedFed( 0 ), decodedRoot( false ), decodeFinished( false )
+{ }
+
+VgLogLoader::~VgLogLoader()
+{ }
+
+
+/*!
+  Parse the whole (mapped) log.
+  Returns false on error, with the handler's fatalMsg() set,
+  or if cancelled by the user, with no fatalMsg().
+*/
+bool VgLogLoader::load( QWidget* parent )
+{
+   qint64 size  = tokenizer->dataSize();
+   qint64 first = tokenizer->find( 0, "<error>" );
+   qint64 last  = tokenizer->findLast( "</error>" );
+
+   // errors are only records: their elements are read back from the
+   // log as needed (VgLogView::errorElement()).  Small logs stay
+   // mapped for that, big ones are read from the file.
+   if ( isMappedSize( size ) ) {
+      handler->logView()->errorXml()->map( tokenizer->fileName() );
+   }
+
+   // no errors: nothing to index, just parse it.
+   if ( first < 0 || last < first ) {
+      return tokenizer->parse();
+   }
+   qint64 errsEnd = last + strlen( "</error>" );
+
+   // head: preamble, status etc. - sets up the view
+   if ( !tokenizer->begin() || !tokenizer->parseRange( 0, first ) ) {
+      return false;
+   }
+
+   QProgressDialog progress( "Loading log file...", "Cancel",
+                             0, PROGRESS_STEPS, parent );
+   progress.setWindowModality( Qt::WindowModal );
+   progress.setMinimumDuration( 500 );
+   progress.setValue( ( int )( first * PROGRESS_STEPS / size ) );
+
+   // the errors: from the log's index, if it has a good one.
+   VgLogSidecar sidecar( tokenizer->fileName(), tokenizer->data(), size );
+   bool indexed = sidecar.open();
+
+   bool ok = indexed ? loadIndexed( sidecar, progress )
+                     : loadChunks( first, errsEnd, sidecar, progress );
+   if ( !ok ) {
+      return false;
+   }
+   progress.setValue( PROGRESS_STEPS );
+
+   // tail: errorcounts, suppcounts, final status...
+   return tokenizer->parseRange( errsEnd, size ) && tokenizer->end();
+}
+
+
+/*!
+  Parse the errors [first, errsEnd) in parallel, writing an index
+  of them for next time as they're handed over.
+   - a small log is just the one chunk, in one thread: not worth
+     splitting, but the index is written all the same.
+*/
+bool VgLogLoader::loadChunks( qint64 first, qint64 errsEnd,
+                              VgLogSidecar& sidecar,
+                              QProgressDialog& progress )
+{
+   qint64 size  = tokenizer->dataSize();
+   int nThreads = QThread::idealThreadCount();
+
+   // split the errors at <error> boundaries
+   qint64 nChunks = qMin( ( errsEnd - first ) / MIN_CHUNK_SIZE,
+                          ( qint64 )nThreads * CHUNKS_PER_THREAD );
+   if ( nChunks < 2 || nThreads < 2 ) {
+      nChunks = 1;
+   }
+   qint64 target = ( errsEnd - first ) / nChunks;
+
+   QVector<VgLogChunkTask*> tasks;
+   for ( qint64 from = first; from < errsEnd; ) {
+      qint64 to = tokenizer->find( from + target, "<error>" );
+      if ( to < 0 || to > errsEnd ) {
+         to = errsEnd;
+      }
+      tasks.append( new VgLogChunkTask( this, tokenizer, from, to ) );
+      from = to;
+   }
+
+   // our own pool: don't tie up the global one
+   QThreadPool pool;
+   pool.setMaxThreadCount( qMax( nThreads, 1 ) );
+   for ( int i = 0; i < tasks.count(); ++i ) {
+      pool.start( tasks[i] );
+   }
+
+   // no index if we can't write one: not an error
+   bool indexing = sidecar.create();
+
+   // merge, in document order
+   bool ok = true;
+   for ( int i = 0; ok && i < tasks.count(); ++i ) {
+      VgLogChunkTask* task = tasks[i];
+
+      // wait for this chunk, keeping the gui alive
+      while ( !waitForChunk( task ) ) {
+         qApp->processEvents();
+         if ( progress.wasCanceled() ) {
+            ok = false;
+            break;
+         }
+      }
+      if ( !ok ) {
+         break;
+      }
+
+      if ( !task->ok ) {
+         handler->setFatalMsg( task->handler.fatalMsg() );
+         ok = false;
+         break;
+      }
+
+      // hand over to the view, in batches
+      QVector<VgLogRecord>& elems = task->handler.collectedElements();
+      for ( int e = 0; ok && e < elems.count(); ++e ) {
+         VgLogRecord& rec = elems[e];
+         indexing = indexing && rec.offset >= 0;
+         if ( indexing ) {
+            // before the view gets it: tool logviews may change rec
+            sidecar.append( rec.offset, rec.length, rec );
+         }
+         ok = handler->appendElement( rec );
+
+         if ( ok && ( e + 1 ) % BATCH_SIZE == 0 ) {
+            qApp->processEvents();
+            ok = !progress.wasCanceled();
+         }
+      }
+      progress.setValue( ( int )( task->rangeEnd() * PROGRESS_STEPS / size ) );
+
+      // done with this chunk's elements
+      delete task;
+      tasks[i] = 0;
+   }
+
+   if ( !ok ) {
+      cancel();
+      pool.waitForDone();
+      qDeleteAll( tasks );
+      sidecar.discard();
+      return false;
+   }
+
+   if ( indexing && !sidecar.commit() ) {
+      VK_DEBUG( "VgLogLoader::loadChunks(): failed to write log index" );
+   }
+   if ( !indexing ) {
+      sidecar.discard();
+   }
+   return true;
+}
+
+
+/*!
+  Hand the errors over straight from the log's index: no parsing.
+   - each error is just its record, as when parsed.
+   - the few other elements are parsed from their place in the log.
+*/
+bool VgLogLoader::loadIndexed( VgLogSidecar& sidecar,
+                               QProgressDialog& progress )
+{
+   qint64 size = tokenizer->dataSize();
+   VgLogSidecar::Entry entry;
+
+   for ( int i = 0; i < sidecar.count(); ++i ) {
+      if ( !sidecar.next( entry ) ) {
+         // too late to start over: have it rebuilt next time.
+         QFile::remove( VgLogSidecar::sidecarPath( tokenizer->fileName() ) );
+         handler->setFatalMsg( "Broken log index: please reload the log." );
+         return false;
+      }
+
+      bool ok;
+      if ( entry.rec.type == VG_ELEM::ERROR ) {
+         ok = handler->appendElement( entry.rec );
+      }
+      else {
+         ok = tokenizer->parseRange( entry.offset,
+                                     entry.offset + entry.length );
+      }
+      if ( !ok ) {
+         return false;
+      }
+
+      if ( ( i + 1 ) % ( BATCH_SIZE * 16 ) == 0 ) {
+         progress.setValue( ( int )( entry.offset * PROGRESS_STEPS / size ) );
+         qApp->processEvents();
+         if ( progress.wasCanceled() ) {
+            return false;
+         }
+      }
+   }
+
+   return true;
+}
+
+
+/*!
+  Parse a compressed log, as it's decompressed by a worker thread
+  (VgLogDecodeTask): its elements are handed to the view here, in
+  batches, while keeping the gui alive: progress is shown, and the
+  user may cancel.
+  Returns as load().
+*/
+bool VgLogLoader::loadCompressed( const QString& path, VkCompress::Format fmt,
+                                  QWidget* parent )
+{
+   vk_assert( handler->logView() != 0 );
+   qint64 size = QFileInfo( path ).size();
+
+   QProgressDialog progress( "Decompressing log file...", "Cancel",
+                             0, PROGRESS_STEPS, parent );
+   progress.setWindowModality( Qt::WindowModal );
+   progress.setMinimumDuration( 500 );
+
+   VgLogDecodeTask task( this, path, fmt, handler->logView()->errorXml() );
+   QThreadPool pool;
+   pool.start( &task );
+
+   bool ok = true;
+   bool done = false;
+   QVector<VgLogRecord> elems;
+   qint64 fed = 0;
+   while ( ok && !done ) {
+      done = waitForDecoded( elems, fed );
+
+      for ( int e = 0; ok && e < elems.count(); ++e ) {
+         if ( elems.at( e ).type == VG_ELEM::ROOT ) {
+            ok = handler->logView()->init( elems.at( e ) );
+            if ( !ok ) {
+               handler->setFatalMsg( "Failed log initialisation" );
+            }
+         }
+         else {
+            ok = handler->appendElement( elems[e] );
+         }
+
+         if ( ok && ( e + 1 ) % BATCH_SIZE == 0 ) {
+            qApp->processEvents();
+            ok = !progress.wasCanceled();
+         }
+      }
+      elems.clear();
+
+      if ( size > 0 ) {
+         progress.setValue( ( int )( fed * PROGRESS_STEPS / size ) );
+      }
+      qApp->processEvents();
+      if ( progress.wasCanceled() ) {
+         ok = false;
+      }
+   }
+
+   if ( !ok ) {
+      cancel();
+   }
+   pool.waitForDone();
+
+   if ( ok && !task.ok ) {
+      handler->setFatalMsg( task.fatalMsg );
+      ok = false;
+   }
+   if ( ok ) {
+      progress.setValue( PROGRESS_STEPS );
+   }
+   return ok;
+}
+
+
+/*!
+  Keep a log this big mapped while it's shown?  See load().
+*/
+bool VgLogLoader::isMappedSize( qint64 size )
+{
+   bool ok = false;
+   qint64 mb = vkCfgProj->value( "valkyrie/lazy-log-mb" ).toLongLong( &ok );
+   // 0: no limit
+   return !ok || mb <= 0 || size < mb * 1024 * 1024;
+}
+
+
+/*!
+  wait a little for task to finish: returns true if it has.
+*/
+bool VgLogLoader::waitForChunk( VgLogChunkTask* task )
+{
+   QMutexLocker locker( &mutex );
+   if ( !doneTasks.contains( task ) ) {
+      chunkFinished.wait( &mutex, 50/*msecs*/ );
+   }
+   return doneTasks.contains( task );
+}
+
+void VgLogLoader::chunkDone( VgLogChunkTask* task )
+{
+   QMutexLocker locker( &mutex );
+   doneTasks.append( task );
+   chunkFinished.wakeAll();
+}
+
+
+/*!
+  wait a little for more of a compressed log: taking what's been
+  parsed so far, and how much of the log it's from.
+  Returns true once the decoding is done, and all of it taken.
+*/
+bool VgLogLoader::waitForDecoded( QVector<VgLogRecord>& elems, qint64& fed )
+{
+   QMutexLocker locker( &mutex );
+   if ( decodedElems.isEmpty() && !decodeFinished ) {
+      chunkFinished.wait( &mutex, 50/*msecs*/ );
+   }
+   elems = decodedElems;
+   decodedElems.clear();
+   fed = decodedFed;
+   elemsTaken.wakeAll();
+   return decodeFinished;
+}
+
+/*!
+  The elements hnd has parsed, from fed bytes of the log, are ready
+  for the view: hnd no longer has them.  Waits while the view is
+  well behind.
+  Returns false if cancelled: no more are wanted.
+*/
+bool VgLogLoader::decoded( VgLogHandler* hnd, qint64 fed )
+{
+   QMutexLocker locker( &mutex );
+   if ( !decodedRoot && !hnd->rootTag().isEmpty() ) {
+      decodedElems.append( hnd->rootRecord() );
+      decodedRoot = true;
+   }
+   QVector<VgLogRecord>& elems = hnd->collectedElements();
+   decodedElems += elems;
+   elems.clear();
+   decodedFed = fed;
+   chunkFinished.wakeAll();
+
+   while ( decodedElems.count() > MAX_DECODED && !cancelled ) {
+      elemsTaken.wait( &mutex );
+   }
+   return !cancelled;
+}
+
+void VgLogLoader::decodeDone()
+{
+   QMutexLocker locker( &mutex );
+   decodeFinished = true;
+   chunkFinished.wakeAll();
+}
+
+/*!
+  tasks not yet started won't bother parsing.
+*/
+void VgLogLoader::cancel()
+{
+   QMutexLocker locker( &mutex );
+   cancelled = true;
+   elemsTaken.wakeAll();
+}
+
+bool VgLogLoader::isCancelled()
+{
+   QMutexLocker locker( &mutex );
+   return cancelled;
+}
@@ -0,0 +1,163 @@
+/****************************************************************************
+** VgLogLoader definition
+**  - multi-threaded loading of large saved valgrind logs
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VGLOGLOADER_H
+#define __VGLOGLOADER_H
+
+#include "utils/vglogreader.h"
+#include "utils/vgxmltokenizer.h"
+#include "utils/vk_compress.h"
+
+#include <QMutex>
+#include <QRunnable>
+#include <QVector>
+#include <QWaitCondition>
+#include <QWidget>
+
+
+class QProgressDialog;
+class VgLogLoader;
+class VgLogSidecar;
+
+
+// ============================================================
+/*!
+  VgLogChunkTask: parses one chunk of top-level elements,
+  in a worker thread, collecting them for VgLogLoader.
+*/
+class VgLogChunkTask : public QRunnable
+{
+public:
+   VgLogChunkTask( VgLogLoader* ldr, const VgXmlTokenizer* src,
+                   qint64 from, qint64 to );
+
+   void run();
+
+   qint64 rangeEnd() const {
+      return to;
+   }
+
+   // only valid once the loader has seen us finish:
+   VgLogHandler handler;
+   VgXmlTokenizer tokenizer;
+   bool ok;
+
+private:
+   VgLogLoader* loader;
+   qint64 from, to;
+};
+
+
+
+// ============================================================
+/*!
+  VgLogDecodeTask: parses a compressed log as it's decompressed,
+  in a worker thread, handing its elements to VgLogLoader as it goes.
+*/
+class VgLogDecodeTask : public QRunnable
+{
+public:
+   VgLogDecodeTask( VgLogLoader* ldr, const QString& path,
+                    VkCompress::Format fmt, VgErrorXml* xml );
+
+   void run();
+
+   // only valid once the loader has seen us finish:
+   bool ok;
+   QString fatalMsg;
+
+private:
+   VgLogLoader* loader;
+   QString path;
+   VkCompress::Format fmt;
+   VgErrorXml* errorXml;   // the view's: we don't own this
+};
+
+
+
+// ============================================================
+/*!
+  VgLogLoader: loads a mapped log file, in parallel if it's big enough.
+
+   - the head of the log (up to the first <error>) is parsed first,
+     to set up the view.
+   - the errors are split into chunks at <error> boundaries, and
+     parsed by a pool of worker threads.  A small log's errors are
+     just the one chunk.
+   - chunks are handed to VgLogView in document order, in batches,
+     while keeping the gui alive: progress is shown, and the user
+     may cancel.
+   - the tail of the log (errorcounts, suppcounts, status...)
+     is parsed last.
+   - the errors are indexed (VgLogSidecar) as they're handed over,
+     whatever the log's size: opening the same log again takes them
+     from the index instead, without parsing them at all.
+   - errors are kept just as records, their elements read back
+     from the log if ever wanted (VgErrorXml): memory doesn't grow
+     with the size of the log's xml.  Logs up to valkyrie/lazy-log-mb
+     are kept mapped for that, bigger ones read from the file.
+   - compressed logs can't be mapped: they're parsed as they're
+     decompressed, by a VgLogDecodeTask, and handed to VgLogView
+     as they come, just as the chunks are.  Their errors' elements
+     have no place in a file to be read back from: they're spooled.
+*/
+class VgLogLoader
+{
+public:
+   VgLogLoader( VgLogHandler* hnd, VgXmlTokenizer* tok );
+   ~VgLogLoader();
+
+   bool load( QWidget* parent );
+   bool loadCompressed( const QString& path, VkCompress::Format fmt,
+                        QWidget* parent );
+
+   // called from worker threads
+   void chunkDone( VgLogChunkTask* task );
+   bool decoded( VgLogHandler* hnd, qint64 fed );
+   void decodeDone();
+   bool isCancelled();
+
+private:
+   bool loadChunks( qint64 first, qint64 errsEnd,
+                    VgLogSidecar& sidecar, QProgressDialog& progress );
+   bool loadIndexed( VgLogSidecar& sidecar, QProgressDialog& progress );
+   bool waitForChunk( VgLogChunkTask* task );
+   bool waitForDecoded( QVector<VgLogRecord>& elems, qint64& fed );
+   static bool isMappedSize( qint64 size );
+   void cancel();
+
+private:
+   VgLogHandler* handler;       // we don't own these
+   VgXmlTokenizer* tokenizer;
+
+   QMutex mutex;
+   QWaitCondition chunkFinished;
+   QVector<VgLogChunkTask*> doneTasks;
+   bool cancelled;
+
+   // shared with a VgLogDecodeTask
+   QWaitCondition elemsTaken;
+   QVector<VgLogRecord> decodedElems;   // not yet handed to the view
+   qint64 decodedFed;                   // bytes of the log decoded
+   bool decodedRoot;                    // root element handed over
+   bool decodeFinished;
+};
+
+#endif // #ifndef __VGLOGLOADER_H
@@ -0,0 +1,422 @@
+/****************************************************************************
+** VgLogMerger implementation
+**  - many saved valgrind logs, merged into one view
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vglogmerger.h"
+#include "utils/vgfingerprint.h"
+#include "utils/vgxmltokenizer.h"
+#include "utils/vk_compress.h"
+#include "utils/vk_utils.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QProgressDialog>
+#include <QRegExp>
+#include <QThread>
+#include <QThreadPool>
+
+
+// elements handed to the view between gui updates
+static const int BATCH_SIZE = 256;
+
+// logs being parsed, or parsed and waiting to be handed over,
+// per worker thread
+static const int TASKS_PER_THREAD = 2;
+
+
+// ============================================================
+/*!
+  VgLogMergeTask
+*/
+VgLogMergeTask::VgLogMergeTask( VgLogMerger* mgr, const QString& _path )
+   : path( _path ), reader( 0 ), ok( false ), merger( mgr )
+{
+   // merger owns us
+   setAutoDelete( false );
+}
+
+void VgLogMergeTask::run()
+{
+   if ( !merger->isCancelled() ) {
+      parse();
+      if ( ok ) {
+         fingerprint();
+      }
+   }
+   merger->taskDone( this );
+}
+
+
+/*!
+  As VgLogReader::parseFile(), but all in this thread: mapped logs
+  are parsed whole, and compressed ones as they're decoded.
+   - errors the parse can't say where they are (compressed logs)
+     are spooled for the view, to read back.
+*/
+void VgLogMergeTask::parse()
+{
+   VgLogHandler* hnd = reader.handler();
+   hnd->setErrorXml( merger->errorXml() );
+
+   if ( VkCompress::fileFormat( path ) != VkCompress::NONE ) {
+      ok = reader.parseFile( path );
+      return;
+   }
+
+   // just for the parse: don't keep hundreds of logs open
+   VgXmlTokenizer tokenizer( hnd );
+   if ( !tokenizer.map( path ) ) {
+      ok = reader.parse( path );
+      return;
+   }
+
+   ok = tokenizer.parse();
+}
+
+
+/*!
+  Fingerprint the log's errors, and find their counts.
+*/
+void VgLogMergeTask::fingerprint()
+{
+   QVector<VgLogRecord>& elems = reader.handler()->collectedElements();
+   keys.resize( elems.count() );
+   counts = reader.handler()->errorCounts();
+   tool = reader.handler()->protocolTool();
+
+   for ( int e = 0; e < elems.count(); ++e ) {
+      const VgLogRecord& rec = elems.at( e );
+      if ( rec.type != VG_ELEM::ERROR ) {
+         continue;
+      }
+      keys[e] = VgFingerprint::of( rec );
+   }
+}
+
+
+
+// ============================================================
+/*!
+  VgLogMerger
+*/
+VgLogMerger::VgLogMerger( VgLogView* lv )
+   : handler( lv ), merged( 0 ), cancelled( false )
+{ }
+
+VgLogMerger::~VgLogMerger()
+{ }
+
+/*!
+  where the view's errors are read back from: safe to call from
+  the merge tasks.
+*/
+VgErrorXml* VgLogMerger::errorXml()
+{
+   return handler.logView()->errorXml();
+}
+
+
+/*!
+  A directory, or a path with wildcards in its file name.
+*/
+bool VgLogMerger::isLogSet( const QString& spec )
+{
+   return QFileInfo( spec ).isDir() || spec.contains( QRegExp( "[*?\\[]" ) );
+}
+
+/*!
+  The readable logs of a set, by name: for a directory, all its
+  (possibly compressed) xml files.
+*/
+QStringList VgLogMerger::logFiles( const QString& spec )
+{
+   QFileInfo fi( spec );
+   QDir dir;
+   QStringList patterns;
+   if ( fi.isDir() ) {
+      dir = QDir( spec );
+      patterns << "*.xml" << "*.xml.gz" << "*.xml.xz" << "*.xml.zst";
+   }
+   else {
+      dir = fi.absoluteDir();
+      patterns << fi.fileName();
+   }
+
+   QStringList logs;
+   QStringList names = dir.entryList( patterns, QDir::Files | QDir::Readable,
+                                      QDir::Name );
+   for ( int i = 0; i < names.count(); ++i ) {
+      logs << dir.absoluteFilePath( names.at( i ) );
+   }
+   return logs;
+}
+
+
+/*!
+  Merge logs into the view.
+  Returns false on error, with fatalMsg() set, or if cancelled by
+  the user, with no fatalMsg().  Logs left out aren't errors.
+*/
+bool VgLogMerger::merge( const QStringList& logs, QWidget* parent )
+{
+   QProgressDialog progress( "Merging log files...", "Cancel",
+                             0, logs.count(), parent );
+   progress.setWindowModality( Qt::WindowModal );
+   progress.setMinimumDuration( 500 );
+
+   // our own pool: don't tie up the global one
+   QThreadPool pool;
+   pool.setMaxThreadCount( QThread::idealThreadCount() );
+
+   // parsed logs wait for their turn whole: only so many ahead of
+   // the one being handed over are started
+   int inFlight = QThread::idealThreadCount() * TASKS_PER_THREAD;
+   QVector<VgLogMergeTask*> tasks( logs.count(), 0 );
+   int numStarted = 0;
+   for ( ; numStarted < logs.count() && numStarted < inFlight; ++numStarted ) {
+      tasks[numStarted] = new VgLogMergeTask( this, logs.at( numStarted ) );
+      pool.start( tasks[numStarted] );
+   }
+
+   // merge, in the order given
+   bool ok = true;
+   for ( int i = 0; ok && i < tasks.count(); ++i ) {
+      VgLogMergeTask* task = tasks[i];
+
+      // wait for this log, keeping the gui alive
+      while ( !waitForTask( task ) ) {
+         qApp->processEvents();
+         if ( progress.wasCanceled() ) {
+            ok = false;
+            break;
+         }
+      }
+      if ( !ok ) {
+         break;
+      }
+
+      ok = handOver( task, progress );
+      progress.setValue( i + 1 );
+
+      // done with this log's elements: on to another
+      delete task;
+      tasks[i] = 0;
+      if ( numStarted < logs.count() ) {
+         tasks[numStarted] = new VgLogMergeTask( this, logs.at( numStarted ) );
+         pool.start( tasks[numStarted] );
+         numStarted++;
+      }
+   }
+
+   if ( ok && merged == 0 ) {
+      handler.setFatalMsg( "None of the logs could be merged" );
+      ok = false;
+   }
+   if ( ok ) {
+      ok = appendCounts();
+   }
+
+   if ( !ok ) {
+      cancel();
+      pool.waitForDone();
+      qDeleteAll( tasks );
+   }
+   return ok;
+}
+
+
+/*!
+  Hand a parsed log over to the view: all of the first, and just
+  the errors of the rest.  Thread announcements (helgrind) are the
+  first log's only: thread ids are per process.
+*/
+bool VgLogMerger::handOver( VgLogMergeTask* task, QProgressDialog& progress )
+{
+   VgLogHandler* hnd = task->reader.handler();
+   if ( !task->ok ) {
+      skipped << task->path + ": " + hnd->fatalMsg();
+      return true;
+   }
+
+   bool first = ( merged == 0 );
+   VgLogView* logview = handler.logView();
+   if ( first ) {
+      if ( !logview->init( hnd->rootRecord() ) ) {
+         handler.setFatalMsg( "Failed log initialisation" );
+         return false;
+      }
+      // every log has its own leak check: they all count
+      logview->store()->setCumulativeLeaks( true );
+      tool = task->tool;
+   }
+   else if ( task->tool != tool ) {
+      skipped << task->path + ": not a " + tool + " log";
+      return true;
+   }
+
+   VgLogStore* store = logview->store();
+   quint32 logId = VgStrPool::global().intern( task->path );
+   QStringList logSuppNames;
+   QHash<QString, quint32> logSupps;
+
+   QVector<VgLogRecord>& elems = hnd->collectedElements();
+   for ( int e = 0; e < elems.count(); ++e ) {
+      VgLogRecord& rec = elems[e];
+
+      switch ( rec.type ) {
+      case VG_ELEM::ERROR: {
+         const QByteArray& key = task->keys.at( e );
+         int idx = errorIdxs.value( key, -1 );
+         if ( idx < 0 ) {
+            // each log numbers its own errors: number them afresh
+            idx = store->numErrors();
+            rec.unique = "0x" + QString::number( idx, 16 );
+            if ( !handler.appendElement( rec ) ) {
+               return false;
+            }
+            vk_assert( store->numErrors() == idx + 1 );
+            errorIdxs.insert( key, idx );
+            totals.append( 0 );
+         }
+         store->addOrigin( idx, logId, task->counts.at( e ) );
+         totals[idx] += task->counts.at( e );
+         break;
+      }
+
+      case VG_ELEM::ERRORCOUNTS:
+         // all logs' counts are given at the end: see appendCounts()
+         break;
+
+      case VG_ELEM::SUPPCOUNTS:
+         // the last suppcounts has them all
+         logSuppNames.clear();
+         logSupps.clear();
+         for ( int i = 0; i < rec.pairs.count(); ++i ) {
+            logSuppNames << rec.pairs.at( i ).name;
+            logSupps.insert( rec.pairs.at( i ).name, rec.pairs.at( i ).count );
+         }
+         break;
+
+      default:
+         if ( first && !handler.appendElement( rec ) ) {
+            return false;
+         }
+         break;
+      }
+
+      if ( ( e + 1 ) % BATCH_SIZE == 0 ) {
+         qApp->processEvents();
+         if ( progress.wasCanceled() ) {
+            return false;
+         }
+      }
+   }
+
+   for ( int i = 0; i < logSuppNames.count(); ++i ) {
+      const QString& name = logSuppNames.at( i );
+      if ( !suppTotals.contains( name ) ) {
+         suppNames << name;
+      }
+      suppTotals[name] += logSupps.value( name );
+   }
+
+   merged++;
+   return true;
+}
+
+
+/*!
+  The counts over all logs: as one errorcounts, and one suppcounts.
+*/
+bool VgLogMerger::appendCounts()
+{
+   VgLogStore* store = handler.logView()->store();
+
+   VgLogRecord counts;
+   counts.clear( VG_ELEM::ERRORCOUNTS );
+   for ( int i = 0; i < totals.count(); ++i ) {
+      VgLogPair pair;
+      pair.count  = ( quint32 )qMin( totals.at( i ), ( quint64 )0xffffffff );
+      pair.unique = store->error( i ).unique;
+      counts.pairs.append( pair );
+   }
+   if ( !handler.appendElement( counts ) ) {
+      return false;
+   }
+
+   if ( suppNames.isEmpty() ) {
+      return true;
+   }
+
+   // suppcounts come with their xml: make it look like valgrind's
+   VgLogRecord supps;
+   supps.clear( VG_ELEM::SUPPCOUNTS );
+   supps.xml = "<suppcounts>";
+   for ( int i = 0; i < suppNames.count(); ++i ) {
+      VgLogPair pair;
+      pair.count  = ( quint32 )qMin( suppTotals.value( suppNames.at( i ) ),
+                                     ( quint64 )0xffffffff );
+      pair.unique = 0;
+      pair.name   = suppNames.at( i );
+      supps.pairs.append( pair );
+
+      supps.xml += "<pair><count>" + QString::number( pair.count ) +
+                   "</count><name>" + VgLogHandler::xmlText( pair.name ) +
+                   "</name></pair>";
+   }
+   supps.xml += "</suppcounts>";
+   return handler.appendElement( supps );
+}
+
+
+/*!
+  wait a little for task to finish: returns true if it has.
+*/
+bool VgLogMerger::waitForTask( VgLogMergeTask* task )
+{
+   QMutexLocker locker( &mutex );
+   if ( !doneTasks.contains( task ) ) {
+      taskFinished.wait( &mutex, 50/*msecs*/ );
+   }
+   return doneTasks.contains( task );
+}
+
+void VgLogMerger::taskDone( VgLogMergeTask* task )
+{
+   QMutexLocker locker( &mutex );
+   doneTasks.append( task );
+   taskFinished.wakeAll();
+}
+
+/*!
+  tasks not yet started won't bother parsing.
+*/
+void VgLogMerger::cancel()
+{
+   QMutexLocker locker( &mutex );
+   cancelled = true;
+}
+
+bool VgLogMerger::isCancelled()
+{
+   QMutexLocker locker( &mutex );
+   return cancelled;
+}
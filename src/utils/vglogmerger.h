@@ -0,0 +1,144 @@
+/****************************************************************************
+** VgLogMerger definition
+**  - many saved valgrind logs, merged into one view
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VGLOGMERGER_H
+#define __VGLOGMERGER_H
+
+#include "utils/vglogreader.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QRunnable>
+#include <QStringList>
+#include <QVector>
+#include <QWaitCondition>
+#include <QWidget>
+
+
+class QProgressDialog;
+class VgLogMerger;
+
+
+// ============================================================
+/*!
+  VgLogMergeTask: parses one whole log, in a worker thread,
+  collecting its top-level elements for VgLogMerger.
+   - errors are fingerprinted here too: the merge itself is
+     then just hash lookups.
+*/
+class VgLogMergeTask : public QRunnable
+{
+public:
+   VgLogMergeTask( VgLogMerger* mgr, const QString& path );
+
+   void run();
+
+   // only valid once the merger has seen us finish:
+   QString path;
+   VgLogReader reader;            // its handler has the elements
+   QVector<QByteArray> keys;      // element -> fingerprint: errors only
+   QVector<quint32> counts;       // element -> count in this log: ditto
+   QString tool;                  // <protocoltool>
+   bool ok;
+
+private:
+   void parse();
+   void fingerprint();
+
+private:
+   VgLogMerger* merger;
+};
+
+
+
+// ============================================================
+/*!
+  VgLogMerger: merges a set of complete logs (e.g. one per test of
+  a test suite) into one VgLogView.
+
+   - logs are parsed in parallel, by a pool of worker threads, and
+     handed to the view in the order given, while keeping the gui
+     alive: progress is shown, and the user may cancel.  Just a few
+     logs per thread are parsed ahead: not the whole set at once.
+   - the first log sets up the view: its preamble, status etc.
+     Of the others, only the errors are wanted.
+   - errors are told apart by kind and first stack (VgFingerprint):
+     the same error found again, in the same log or another, isn't
+     a new row, but adds to the count of the first one.  Each error
+     keeps which logs it was found in, and its count in each
+     (VgLogStore::addOrigin()).
+   - errors are kept just as records (see VgLogLoader), and read
+     back from their log if wanted.
+   - logs that fail to parse, or are from another tool, are
+     left out: see skippedLogs().
+*/
+class VgLogMerger
+{
+public:
+   VgLogMerger( VgLogView* lv );
+   ~VgLogMerger();
+
+   // a directory or wildcard of logs, rather than just the one
+   static bool isLogSet( const QString& spec );
+   static QStringList logFiles( const QString& spec );
+
+   bool merge( const QStringList& logs, QWidget* parent );
+
+   /* only set if fatal error */
+   QString fatalMsg() {
+      return handler.fatalMsg();
+   }
+   QStringList skippedLogs() const {
+      return skipped;
+   }
+   int numMerged() const {
+      return merged;
+   }
+
+   // called from worker threads
+   void taskDone( VgLogMergeTask* task );
+   bool isCancelled();
+   VgErrorXml* errorXml();
+
+private:
+   bool handOver( VgLogMergeTask* task, QProgressDialog& progress );
+   bool appendCounts();
+   bool waitForTask( VgLogMergeTask* task );
+   void cancel();
+
+private:
+   VgLogHandler handler;                // hands elements to the view
+
+   QHash<QByteArray, int> errorIdxs;    // fingerprint -> error index
+   QVector<quint64> totals;             // error index -> count, over all logs
+   QStringList suppNames;               // suppcounts, over all logs
+   QHash<QString, quint64> suppTotals;
+   QString tool;                        // the first log's
+   QStringList skipped;
+   int merged;
+
+   QMutex mutex;
+   QWaitCondition taskFinished;
+   QVector<VgLogMergeTask*> doneTasks;
+   bool cancelled;
+};
+
+#endif // #ifndef __VGLOGMERGER_H
@@ -0,0 +1,350 @@
+/****************************************************************************
+** VgLogParser implementation
+**  - parses a live valgrind xml log in a separate thread
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vglogparser.h"
+#include "utils/vk_utils.h"
+
+#include <QMutexLocker>
+#include <QTime>
+
+
+// top-level elements in flight between the threads
+static const int QUEUE_SIZE     = 4096;
+// gui: how often to drain the queue, and for how long at most
+static const int DRAIN_INTERVAL = 10;  // msecs
+static const int DRAIN_SLICE    = 8;   // msecs
+// parser: back off when the gui can't keep up
+static const int QUEUE_FULL_SLEEP = 5; // msecs
+
+
+
+/**********************************************************************/
+/*!
+  VgLogParser
+*/
+VgLogParser::VgLogParser( VgLogView* lv, const QString& fname, QObject* parent )
+   : QThread( parent ), logview( lv ), logfile( fname ),
+     queue( QUEUE_SIZE ), pending( false ), stopRequested( false ),
+     m_ok( true ), m_failedStart( false ), drained( false )
+{
+   this->setObjectName( "vglogparser" );
+
+   // no vglog: records are handed to it by drain().
+   // errors come without xml: theirs is spooled for the view.
+   reader = new VgLogReader( 0 );
+   reader->handler()->setErrorXml( lv->errorXml() );
+
+   drainTimer = new QTimer( this );
+   connect( drainTimer, SIGNAL( timeout() ),
+            this,       SLOT( drain() ) );
+}
+
+VgLogParser::~VgLogParser()
+{
+   stopParsing();
+
+   delete reader;
+   reader = 0;
+}
+
+
+/*!
+  Start the parser thread, and draining its output into the view.
+   - without ownTimer, it's up to the caller to drainSlice().
+*/
+void VgLogParser::startParsing( bool ownTimer )
+{
+   start();
+   if ( ownTimer ) {
+      drainTimer->start( DRAIN_INTERVAL );
+   }
+}
+
+/*!
+  Stop parsing, waiting for the parser thread to exit.
+   - called from the gui thread only.
+*/
+void VgLogParser::stopParsing()
+{
+   drainTimer->stop();
+
+   mutex.lock();
+   stopRequested = true;
+   updated.wakeAll();
+   mutex.unlock();
+
+   wait();
+}
+
+
+/*!
+  The log has been written to: wake the parser.
+*/
+void VgLogParser::logUpdated()
+{
+   QMutexLocker locker( &mutex );
+   pending = true;
+   updated.wakeOne();
+}
+
+
+
+/**********************************************************************/
+/*
+  Parser thread
+*/
+
+/*!
+  Sleep until there's something more to parse.
+  Returns false if we've been asked to stop.
+*/
+bool VgLogParser::waitForUpdate()
+{
+   QMutexLocker locker( &mutex );
+   while ( !pending && !stopRequested ) {
+      updated.wait( &mutex );
+   }
+   pending = false;
+   return !stopRequested;
+}
+
+bool VgLogParser::stopping()
+{
+   QMutexLocker locker( &mutex );
+   return stopRequested;
+}
+
+/*!
+  Hand a complete top-level record over to the gui thread.
+   - blocks while the queue is full.
+  Returns false if we've been asked to stop.
+*/
+bool VgLogParser::push( VgLogRecord& rec )
+{
+   while ( !queue.push( rec ) ) {
+      if ( stopping() ) {
+         return false;
+      }
+      msleep( QUEUE_FULL_SLEEP );
+   }
+   return true;
+}
+
+
+/*!
+  Parse everything written so far, each time we're woken,
+  until the log is complete, broken, or we're stopped.
+*/
+void VgLogParser::run()
+{
+   VgLogHandler* hnd = reader->handler();
+   bool ok = true;
+   bool failedStart = false;
+   bool rootSent = false;
+   bool stopped = false;
+
+   while ( ok && !hnd->finished() && !stopped ) {
+      if ( !waitForUpdate() ) {
+         break;
+      }
+
+      // read all that's there: parse() & parseContinue() only
+      // fetch a block at a time.
+      do {
+         if ( !hnd->started() ) {
+            ok = reader->parse( logfile, true/*incremental*/ );
+            failedStart = !ok;
+         }
+         else {
+            ok = reader->parseContinue();
+         }
+
+         if ( !hnd->fatalMsg().isEmpty() ) {
+            ok = false;
+         }
+
+         if ( !rootSent && !hnd->rootTag().isEmpty() ) {
+            VgLogRecord root = hnd->rootRecord();
+            stopped   = !push( root );
+            rootSent  = true;
+         }
+
+         QVector<VgLogRecord>& elems = hnd->collectedElements();
+         for ( int i = 0; !stopped && i < elems.count(); ++i ) {
+            stopped = !push( elems[i] );
+         }
+         elems.clear();
+
+      } while ( ok && !stopped && !hnd->finished() && !reader->atEnd() );
+   }
+
+   QMutexLocker locker( &mutex );
+   m_ok          = ok;
+   m_fatalMsg    = hnd->fatalMsg();
+   m_failedStart = failedStart;
+}
+
+
+
+/**********************************************************************/
+/*
+  Gui thread
+*/
+
+void VgLogParser::drain()
+{
+   drainSlice( DRAIN_SLICE );
+}
+
+/*!
+  Hand queued records to the view, for msecs at most.
+  Once the parser thread is done, and the queue empty, we're done too.
+*/
+void VgLogParser::drainSlice( int msecs )
+{
+   if ( drained ) {
+      return;
+   }
+
+   // check first: anything pushed before it exited is then in the queue
+   bool parserDone = isFinished();
+
+   QTime slice;
+   slice.start();
+
+   VgLogRecord rec;
+   while ( slice.elapsed() < msecs && queue.pop( rec ) ) {
+      QString errMsg;
+      bool ok;
+
+      if ( rec.type == VG_ELEM::ROOT ) {
+         ok = logview->init( rec );
+         if ( !ok ) {
+            errMsg = "Failed log initialisation";
+         }
+      }
+      else {
+         ok = logview->appendNode( rec, errMsg );
+      }
+
+      if ( !ok ) {
+         stopParsing();
+         m_ok = false;
+         m_fatalMsg = errMsg;
+         finishDrain();
+         return;
+      }
+   }
+
+   if ( parserDone && queue.isEmpty() ) {
+      finishDrain();
+   }
+}
+
+void VgLogParser::finishDrain()
+{
+   drainTimer->stop();
+   drained = true;
+   emit logParsed();
+}
+
+
+
+/**********************************************************************/
+/*!
+  VgLogParserSet
+*/
+VgLogParserSet::VgLogParserSet( QObject* parent )
+   : QObject( parent ), next( 0 )
+{
+   this->setObjectName( "vglogparserset" );
+
+   drainTimer = new QTimer( this );
+   connect( drainTimer, SIGNAL( timeout() ),
+            this,       SLOT( drain() ) );
+}
+
+/*!
+  Parsers stop in their destructor: wait for them all.
+*/
+VgLogParserSet::~VgLogParserSet()
+{
+   drainTimer->stop();
+   qDeleteAll( parsers );
+}
+
+/*!
+  Start parsing logfile into lv: it should be woken by
+  logUpdated() from now on.
+*/
+void VgLogParserSet::addLog( const QString& logfile, VgLogView* lv )
+{
+   vk_assert( !parsers.contains( logfile ) );
+
+   VgLogParser* parser = new VgLogParser( lv, logfile, this );
+   connect( parser, SIGNAL( logParsed() ),
+            this,     SLOT( logParsed() ) );
+   parsers.insert( logfile, parser );
+   active.append( parser );
+
+   parser->startParsing( false/*ownTimer*/ );
+   if ( !drainTimer->isActive() ) {
+      drainTimer->start( DRAIN_INTERVAL );
+   }
+}
+
+void VgLogParserSet::logUpdated( const QString& logfile )
+{
+   VgLogParser* parser = parsers.value( logfile, 0 );
+   if ( parser != 0 ) {
+      parser->logUpdated();
+   }
+}
+
+/*!
+  One slice, split between the parsers: starting with a different
+  one each time, so none of them is kept waiting.
+*/
+void VgLogParserSet::drain()
+{
+   int n = active.count();
+   int msecs = qMax( 1, DRAIN_SLICE / qMax( n, 1 ) );
+
+   // as they finish, they drop out of active
+   QList<VgLogParser*> parsing = active;
+   for ( int i = 0; i < n; ++i ) {
+      parsing.at( ( next + i ) % n )->drainSlice( msecs );
+   }
+   next = ( n > 0 ) ? ( next + 1 ) % n : 0;
+}
+
+void VgLogParserSet::logParsed()
+{
+   VgLogParser* parser = qobject_cast<VgLogParser*>( sender() );
+   if ( !parser->ok() ) {
+      vkPrintErr( "VgLogParserSet: failed to parse a process' log: %s",
+                  qPrintable( parser->fatalMsg() ) );
+   }
+
+   active.removeAll( parser );
+   if ( active.isEmpty() ) {
+      drainTimer->stop();
+   }
+}
@@ -0,0 +1,154 @@
+/****************************************************************************
+** VgLogParser definition
+**  - parses a live valgrind xml log in a separate thread
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VGLOGPARSER_H
+#define __VGLOGPARSER_H
+
+#include "toolview/vglogview.h"
+#include "utils/vglogreader.h"
+#include "utils/vk_spscqueue.h"
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QTimer>
+#include <QWaitCondition>
+
+
+// ============================================================
+/*!
+  VgLogParser: incremental parsing of a log valgrind is still writing.
+
+   - run() (the parser thread) owns the VgLogReader: it parses
+     whatever has been written each time it's woken by logUpdated()
+     (see VkLogSource),
+     building the records of the top-level elements.
+   - complete top-level records are passed to the gui thread through
+     a lock-free queue: the parser only blocks if the gui falls far
+     behind.  No dom is built by either: the view builds a row's
+     element from its xml only once it's opened (QDom isn't
+     thread-safe, and most are never wanted).
+   - the gui thread drains the queue into VgLogView in short time
+     slices, so it never stalls on a burst of errors.  By our own
+     timer, or by whoever is draining many parsers (VgLogParserSet).
+
+  logParsed() is emitted once the log is complete (or broken), and
+  everything parsed has been handed to the view.
+*/
+class VgLogParser : public QThread
+{
+   Q_OBJECT
+public:
+   VgLogParser( VgLogView* lv, const QString& logfile, QObject* parent = 0 );
+   ~VgLogParser();
+
+   void startParsing( bool ownTimer = true );
+   void stopParsing();
+   void drainSlice( int msecs );
+
+   /* only valid after logParsed() */
+   bool ok() {
+      return m_ok;
+   }
+   QString fatalMsg() {
+      return m_fatalMsg;
+   }
+   /* did parsing fail before getting going */
+   bool failedStart() {
+      return m_failedStart;
+   }
+
+public slots:
+   void logUpdated();
+
+signals:
+   void logParsed();
+
+protected:
+   void run();
+
+private slots:
+   void drain();
+
+private:
+   bool waitForUpdate();
+   bool push( VgLogRecord& rec );
+   bool stopping();
+   void finishDrain();
+
+private:
+   typedef VkSpscQueue<VgLogRecord> ElemQueue;
+
+   VgLogView*   logview;      // we don't own this
+   QString      logfile;
+   VgLogReader* reader;       // only used by the parser thread
+   ElemQueue    queue;
+   QTimer*      drainTimer;
+
+   // shared with the parser thread
+   QMutex mutex;
+   QWaitCondition updated;
+   bool pending;              // log written since last parse
+   bool stopRequested;
+
+   // parser thread results: read once it has finished
+   bool    m_ok;
+   QString m_fatalMsg;
+   bool    m_failedStart;
+
+   bool    drained;           // all handed over: logParsed() emitted
+};
+
+
+
+// ============================================================
+/*!
+  VgLogParserSet: logs parsed all at once (--trace-children: one
+  per process), each by its own VgLogParser.
+   - one timer drains them all, sharing one time slice between
+     them: however many processes, the gui gets the same share.
+   - parsers are woken by path: see VkProcLogWatch.
+*/
+class VgLogParserSet : public QObject
+{
+   Q_OBJECT
+public:
+   VgLogParserSet( QObject* parent );
+   ~VgLogParserSet();
+
+   void addLog( const QString& logfile, VgLogView* lv );
+
+public slots:
+   void logUpdated( const QString& logfile );
+
+private slots:
+   void drain();
+   void logParsed();
+
+private:
+   QHash<QString, VgLogParser*> parsers;   // logfile -> its parser
+   QList<VgLogParser*> active;              // not yet all handed over
+   int next;                                // first to drain, next time
+   QTimer* drainTimer;
+};
+
+#endif // #ifndef __VGLOGPARSER_H
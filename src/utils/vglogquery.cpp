@@ -0,0 +1,370 @@
+/****************************************************************************
+** VgLogQuery implementation
+**  - compiled filter expressions over the errors of a VgLogStore
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vglogquery.h"
+#include "utils/vglogstore.h"
+#include "utils/vk_utils.h"
+
+
+// query field names
+static const struct {
+   const char* name;
+   VG_FIELD::Field field;
+} fieldNames[] = {
+   { "kind",         VG_FIELD::KIND         },
+   { "obj",          VG_FIELD::OBJ          },
+   { "fn",           VG_FIELD::FN           },
+   { "dir",          VG_FIELD::SRCDIR       },
+   { "file",         VG_FIELD::SRCFILE      },
+   { "line",         VG_FIELD::LINE         },
+   { "leakedbytes",  VG_FIELD::LEAKEDBYTES  },
+   { "leakedblocks", VG_FIELD::LEAKEDBLOCKS },
+   { "thread",       VG_FIELD::HTHREADID    },
+   { "lock",         VG_FIELD::LOCKADDR     },
+};
+static const int numFieldNames = sizeof( fieldNames ) / sizeof( fieldNames[0] );
+
+
+
+/**********************************************************************/
+/*!
+  VgLogQuery
+*/
+VgLogQuery::VgLogQuery()
+   : root( 0 ), pos( 0 )
+{ }
+
+VgLogQuery::~VgLogQuery()
+{
+   clear();
+}
+
+void VgLogQuery::clear()
+{
+   delete root;
+   root = 0;
+}
+
+/*!
+  A query of just the one clause.
+*/
+void VgLogQuery::setClause( VgFieldMatch* match )
+{
+   clear();
+   root = new Node( Node::CLAUSE );
+   root->match = match;
+}
+
+
+/*!
+  Compile text: on error, returns false with errMsg set, and the
+  query left as it was.  Empty text gives an empty query.
+*/
+bool VgLogQuery::compile( const QString& txt, QString& errMsg )
+{
+   text  = txt;
+   pos   = 0;
+   error = QString();
+
+   skipSpace();
+   Node* node = 0;
+   if ( pos < text.length() ) {
+      node = parseOr();
+      if ( node != 0 ) {
+         skipSpace();
+         if ( pos < text.length() ) {
+            delete node;
+            node = fail( "unexpected '" + text.mid( pos, 10 ) + "'" );
+         }
+      }
+      if ( node == 0 ) {
+         errMsg = error;
+         return false;
+      }
+   }
+
+   clear();
+   root = node;
+   return true;
+}
+
+
+/*!
+  All errors matching the query, as a bitset over error indices.
+  An empty query matches everything.
+*/
+QBitArray VgLogQuery::select( const VgLogStore& store ) const
+{
+   if ( root == 0 ) {
+      return QBitArray( store.index().numErrors(), true );
+   }
+   return select( root, store );
+}
+
+QBitArray VgLogQuery::select( const Node* node, const VgLogStore& store ) const
+{
+   switch ( node->op ) {
+   case Node::AND: {
+      QBitArray bits = select( node->left, store );
+      if ( bits.count( true ) != 0 ) {
+         bits &= select( node->right, store );
+      }
+      return bits;
+   }
+   case Node::OR:
+      return select( node->left, store ) | select( node->right, store );
+   case Node::NOT:
+      return ~select( node->left, store );
+   case Node::CLAUSE:
+      return store.index().select( *node->match, store );
+   }
+   vk_assert_never_reached();
+   return QBitArray();
+}
+
+
+/*!
+  Does error errIdx match: for errors arriving after a select().
+*/
+bool VgLogQuery::matches( int errIdx, const VgLogStore& store ) const
+{
+   if ( root == 0 ) {
+      return true;
+   }
+   return matches( root, errIdx, store );
+}
+
+bool VgLogQuery::matches( const Node* node, int errIdx,
+                          const VgLogStore& store ) const
+{
+   switch ( node->op ) {
+   case Node::AND:
+      return matches( node->left, errIdx, store ) &&
+             matches( node->right, errIdx, store );
+   case Node::OR:
+      return matches( node->left, errIdx, store ) ||
+             matches( node->right, errIdx, store );
+   case Node::NOT:
+      return !matches( node->left, errIdx, store );
+   case Node::CLAUSE:
+      return store.index().matches( errIdx, *node->match, store );
+   }
+   vk_assert_never_reached();
+   return false;
+}
+
+
+
+/**********************************************************************/
+/*
+  Parser: plain recursive descent.
+  Each parseX() returns 0 on error, having set error.
+*/
+
+VgLogQuery::Node* VgLogQuery::fail( const QString& msg )
+{
+   if ( error.isEmpty() ) {
+      error = msg + " (col " + QString::number( pos + 1 ) + ")";
+   }
+   return 0;
+}
+
+void VgLogQuery::skipSpace()
+{
+   while ( pos < text.length() && text.at( pos ).isSpace() ) {
+      pos++;
+   }
+}
+
+/*!
+  Consume token if it's next.
+*/
+bool VgLogQuery::accept( const char* token )
+{
+   skipSpace();
+   QString tok = QString::fromLatin1( token );
+   if ( text.mid( pos, tok.length() ) == tok ) {
+      pos += tok.length();
+      return true;
+   }
+   return false;
+}
+
+VgLogQuery::Node* VgLogQuery::parseOr()
+{
+   Node* node = parseAnd();
+   while ( node != 0 && accept( "||" ) ) {
+      Node* rhs = parseAnd();
+      if ( rhs == 0 ) {
+         delete node;
+         return 0;
+      }
+      node = new Node( Node::OR, node, rhs );
+   }
+   return node;
+}
+
+VgLogQuery::Node* VgLogQuery::parseAnd()
+{
+   Node* node = parseUnary();
+   while ( node != 0 && accept( "&&" ) ) {
+      Node* rhs = parseUnary();
+      if ( rhs == 0 ) {
+         delete node;
+         return 0;
+      }
+      node = new Node( Node::AND, node, rhs );
+   }
+   return node;
+}
+
+VgLogQuery::Node* VgLogQuery::parseUnary()
+{
+   if ( accept( "!" ) ) {
+      Node* node = parseUnary();
+      return ( node == 0 ) ? 0 : new Node( Node::NOT, node );
+   }
+
+   if ( accept( "(" ) ) {
+      Node* node = parseOr();
+      if ( node != 0 && !accept( ")" ) ) {
+         delete node;
+         return fail( "missing ')'" );
+      }
+      return node;
+   }
+
+   return parseClause();
+}
+
+VgLogQuery::Node* VgLogQuery::parseClause()
+{
+   // field
+   skipSpace();
+   int start = pos;
+   while ( pos < text.length() && text.at( pos ).isLetter() ) {
+      pos++;
+   }
+   QString name = text.mid( start, pos - start ).toLower();
+   if ( name.isEmpty() ) {
+      return fail( "expected a field name" );
+   }
+
+   int f = 0;
+   while ( f < numFieldNames && name != fieldNames[f].name ) {
+      f++;
+   }
+   if ( f == numFieldNames ) {
+      pos = start;
+      return fail( "unknown field '" + name + "'" );
+   }
+   VG_FIELD::Field field = fieldNames[f].field;
+   bool numeric = VG_FIELD::isNumeric( field );
+
+   // operator: longest first
+   VgFieldMatch::CmpFun cmp;
+   int opPos = pos;
+   if      ( accept( "==" ) ) cmp = VgFieldMatch::EQL;
+   else if ( accept( "!=" ) ) cmp = VgFieldMatch::NEQL;
+   else if ( accept( "!~" ) ) cmp = VgFieldMatch::NREGEX;
+   else if ( accept( "="  ) ) cmp = VgFieldMatch::EQL;
+   else if ( accept( "~"  ) ) cmp = VgFieldMatch::REGEX;
+   else if ( accept( "<"  ) ) cmp = VgFieldMatch::LSTHN;
+   else if ( accept( ">"  ) ) cmp = VgFieldMatch::GRTHN;
+   else {
+      return fail( "expected an operator after '" + name + "'" );
+   }
+
+   bool isRx = ( cmp == VgFieldMatch::REGEX || cmp == VgFieldMatch::NREGEX );
+   bool isOrd = ( cmp == VgFieldMatch::LSTHN || cmp == VgFieldMatch::GRTHN );
+   if ( ( numeric && isRx ) || ( !numeric && isOrd ) ) {
+      pos = opPos;
+      return fail( "operator not valid for '" + name + "'" );
+   }
+
+   // value
+   QString value;
+   bool regexValue = false;
+   if ( !parseValue( value, regexValue ) ) {
+      return 0;
+   }
+   if ( regexValue && !isRx ) {
+      return fail( "/regex/ needs ~ or !~" );
+   }
+
+   VgFieldMatch* match = new VgFieldMatch( field, cmp, value );
+   if ( !match->isValid() ) {
+      delete match;
+      return fail( ( numeric ? "not a number: '" : "bad regex: '" ) + value + "'" );
+   }
+
+   Node* node = new Node( Node::CLAUSE );
+   node->match = match;
+   return node;
+}
+
+/*!
+  word | "quoted string" | /regex/
+   - backslash escapes the closing quote/slash.
+*/
+bool VgLogQuery::parseValue( QString& value, bool& isRegex )
+{
+   skipSpace();
+   if ( pos >= text.length() ) {
+      fail( "expected a value" );
+      return false;
+   }
+
+   QChar quote = text.at( pos );
+   if ( quote == '"' || quote == '/' ) {
+      isRegex = ( quote == '/' );
+      int start = pos++;
+      while ( pos < text.length() && text.at( pos ) != quote ) {
+         if ( text.at( pos ) == '\\' && pos + 1 < text.length() &&
+              text.at( pos + 1 ) == quote ) {
+            pos++;
+         }
+         value += text.at( pos++ );
+      }
+      if ( pos >= text.length() ) {
+         pos = start;
+         fail( QString( "missing closing " ) + quote );
+         return false;
+      }
+      pos++;
+      return true;
+   }
+
+   // plain word: up to space, a paren, or an operator
+   int start = pos;
+   while ( pos < text.length() ) {
+      QChar c = text.at( pos );
+      if ( c.isSpace() || c == '(' || c == ')' || c == '&' || c == '|' ) {
+         break;
+      }
+      pos++;
+   }
+   value = text.mid( start, pos - start );
+   if ( value.isEmpty() ) {
+      fail( "expected a value" );
+      return false;
+   }
+   return true;
+}
@@ -0,0 +1,116 @@
+/****************************************************************************
+** VgLogQuery definition
+**  - compiled filter expressions over the errors of a VgLogStore
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VGLOGQUERY_H
+#define __VGLOGQUERY_H
+
+#include "utils/vglogindex.h"
+
+#include <QBitArray>
+#include <QString>
+
+
+class VgLogStore;
+
+
+// ============================================================
+/*!
+  VgLogQuery: a filter expression, compiled to a predicate tree.
+
+  Syntax:
+    query  := clause | query && query | query || query
+            | ! query | ( query )
+    clause := field op value
+    field  := kind | obj | fn | dir | file | line
+            | leakedbytes | leakedblocks
+            | thread | lock                  (helgrind)
+    op     := = (or ==) | != | < | >     (numeric fields)
+              = (or ==) | != | ~ | !~    (string fields)
+    value  := word | "quoted string" | /regex/   (regex: ~ and !~ only)
+
+  e.g.  kind=Leak_DefinitelyLost && fn~/^libfoo::/ && leakedbytes>4096
+        thread=1 && thread=2     (helgrind: errors between two threads)
+
+  && binds tighter than ||.  As with the single field filters, a
+  clause holds for an error if any of its values for the field does
+  (e.g. any frame's fn): use ! ( fn~/x/ ) for 'no frame'.
+
+  Clauses are evaluated against the store's VgLogIndex, giving
+  bitsets combined with and/or/not: regexes are compiled, and each
+  distinct value tested, just once.
+*/
+class VgLogQuery
+{
+public:
+   VgLogQuery();
+   ~VgLogQuery();
+
+   bool compile( const QString& text, QString& errMsg );
+   void setClause( VgFieldMatch* match );    // takes ownership
+   void clear();
+
+   bool isEmpty() const {
+      return root == 0;
+   }
+
+   QBitArray select( const VgLogStore& store ) const;
+   bool matches( int errIdx, const VgLogStore& store ) const;
+
+private:
+   Q_DISABLE_COPY( VgLogQuery )
+
+   struct Node {
+      enum Op { AND, OR, NOT, CLAUSE };
+      Node( Op o, Node* l = 0, Node* r = 0 )
+         : op( o ), left( l ), right( r ), match( 0 ) { }
+      ~Node() {
+         delete left;
+         delete right;
+         delete match;
+      }
+      Op op;
+      Node* left;
+      Node* right;
+      VgFieldMatch* match;    // CLAUSE only
+   };
+
+   QBitArray select( const Node* node, const VgLogStore& store ) const;
+   bool matches( const Node* node, int errIdx, const VgLogStore& store ) const;
+
+   // parser
+   Node* parseOr();
+   Node* parseAnd();
+   Node* parseUnary();
+   Node* parseClause();
+   bool parseValue( QString& value, bool& isRegex );
+   void skipSpace();
+   bool accept( const char* token );
+   Node* fail( const QString& msg );
+
+private:
+   Node* root;
+
+   // while compiling
+   QString text;
+   int pos;
+   QString error;
+};
+
+#endif // #ifndef __VGLOGQUERY_H
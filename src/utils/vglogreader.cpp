@@ -19,8 +19,21 @@
 ****************************************************************************/
 
 #include "utils/vglogreader.h"
+#include "utils/vglogloader.h"
+#include "utils/vgxmltokenizer.h"
+#include "utils/vk_compress.h"
 #include "utils/vk_utils.h"
 
+#include <QHash>
+#include <QProcess>
+
+
+// compressed logs: fed to the decoder this much at a time
+static const qint64 DECODE_BLOCK = 256 * 1024;
+// and how long to wait on it before checking if we're still wanted
+static const int    DECODE_WAIT  = 50;  // msecs
+
+
 
 /**********************************************************************/
 /*!
@@ -78,13 +91,178 @@ bool VgLogReader::parseContinue()
    return QXmlSimpleReader::parseContinue();
 }
 
+/*!
+  Parse a compressed log as it's decompressed, by a separate process:
+  no temporary file, and the decompression and parsing run in parallel.
+   - we feed the decoder the log, a block at a time: how much of it
+     has been fed is the progress.
+   - with a loader, the elements parsed are handed over to it as we
+     go, and we stop if it's cancelled (VgLogLoader::decoded()).
+     Without one, they're collected (VgLogHandler::collectedElements()).
+  Blocks till done: not for the gui thread (see parseFile()).
+*/
+bool VgLogReader::parseCompressed( QString filepath, VkCompress::Format fmt,
+                                   VgLogLoader* loader/*=0*/ )
+{
+   QFile log( filepath );
+   if ( !log.open( QIODevice::ReadOnly ) ) {
+      vghandler->setFatalMsg( "Failed to open the log: " + log.errorString() );
+      return false;
+   }
+
+   QProcess decoder;
+   if ( !VkCompress::startDecoder( decoder, fmt ) ) {
+      vghandler->setFatalMsg( "Failed to start a program to "
+                              "decompress the log" );
+      return false;
+   }
+
+   if ( source ) {
+      delete source;
+   }
+   source = new QXmlInputSource( &decoder );
+
+   // each parse step takes just one block: an empty one ends the
+   // document, so only step on once there's more, or there'll be
+   // no more.
+   bool ok = true;
+   bool started = false;
+   bool stopped = false;
+   qint64 fed = 0;
+   while ( ok && !stopped && !vghandler->finished() ) {
+      // keep it fed: but not with all of a huge log at once
+      if ( log.isOpen() && decoder.bytesToWrite() < DECODE_BLOCK ) {
+         QByteArray block = log.read( DECODE_BLOCK );
+         if ( block.isEmpty() ) {
+            log.close();
+            decoder.closeWriteChannel();
+         }
+         else {
+            decoder.write( block );
+            fed += block.size();
+         }
+      }
+
+      // writes the block, as it waits
+      bool more = decoder.bytesAvailable() > 0 ||
+                  decoder.waitForReadyRead( DECODE_WAIT );
+      if ( !more && decoder.state() != QProcess::NotRunning ) {
+         // nothing decoded yet: see if we're still wanted
+         stopped = ( loader != 0 && !loader->decoded( vghandler, fed ) );
+         continue;
+      }
+
+      if ( !started ) {
+         ok = QXmlSimpleReader::parse( source, true/*incremental*/ );
+         started = true;
+      }
+      else {
+         ok = parseContinue();
+      }
+
+      if ( !vghandler->fatalMsg().isEmpty() ) {
+         ok = false;
+      }
+      if ( loader != 0 && !loader->decoded( vghandler, fed ) ) {
+         stopped = true;
+      }
+      if ( !more ) {
+         break;
+      }
+   }
+
+   bool early = decoder.state() != QProcess::NotRunning;
+   if ( early ) {
+      // parsing ended early: no need for the rest
+      decoder.kill();
+   }
+   decoder.waitForFinished( -1 );
+
+   if ( ok && !stopped && !early &&
+        ( decoder.exitStatus() != QProcess::NormalExit ||
+          decoder.exitCode() != 0 ) ) {
+      vghandler->setFatalMsg(
+         "Failed to decompress the log: " +
+         QString::fromLocal8Bit( decoder.readAllStandardError() ).trimmed() );
+      ok = false;
+   }
+   return ok && !stopped;
+}
+
+/*!
+  Parse a complete log file in one go, all in this thread, without
+  a vglog: for summing up logs, rather than viewing them.  The errors
+  are just records, as always: nothing is spooled for them.
+*/
+bool VgLogReader::parseRecords( QString filepath )
+{
+   VkCompress::Format fmt = VkCompress::fileFormat( filepath );
+   if ( fmt != VkCompress::NONE ) {
+      return parseCompressed( filepath, fmt );
+   }
+
+   VgXmlTokenizer tokenizer( vghandler );
+   if ( !tokenizer.map( filepath ) ) {
+      return parse( filepath );
+   }
+   return tokenizer.parse();
+}
+
+/*!
+  Parse a complete log file in one go (i.e. not still being written).
+   - uses the memory-mapped VgXmlTokenizer, falling back to
+     QXmlSimpleReader if the file can't be mapped.
+   - big logs are parsed in parallel, with progress shown over parent.
+   - compressed logs are parsed as they're decompressed, by a worker
+     thread, with progress shown over parent (see VgLogLoader).
+     Without a vglog, we're a worker already: they're parsed here.
+  Returns false with an empty fatalMsg() if cancelled by the user.
+*/
+bool VgLogReader::parseFile( QString filepath, QWidget* parent )
+{
+   VkCompress::Format fmt = VkCompress::fileFormat( filepath );
+   if ( fmt != VkCompress::NONE ) {
+      if ( vghandler->logView() == 0 ) {
+         return parseCompressed( filepath, fmt );
+      }
+      VgLogLoader loader( vghandler, 0 );
+      return loader.loadCompressed( filepath, fmt, parent );
+   }
+
+   VgXmlTokenizer tokenizer( vghandler );
+   if ( !tokenizer.map( filepath ) ) {
+      return parse( filepath );
+   }
+
+   VgLogLoader loader( vghandler, &tokenizer );
+   return loader.load( parent );
+}
+
 
 /**********************************************************************/
 /* VgLogHandler */
+
+/*!
+  text, escaped for an element's content
+*/
+QString VgLogHandler::xmlText( const QString& str )
+{
+   QString txt = str;
+   txt.replace( '&', "&amp;" );
+   txt.replace( '<', "&lt;" );
+   txt.replace( '>', "&gt;" );
+   return txt;
+}
+
+
 VgLogHandler::VgLogHandler( VgLogView* lv )
 {
    logview = lv;
-   node = doc;
+   skipDepth = 0;
+   sourceId = 0;
+   elemStart = elemEnd = -1;
+   errorXml = ( lv != 0 ) ? lv->errorXml() : 0;
+   spooling = false;
    m_finished = false;
    m_started = false;
 }
@@ -92,12 +270,11 @@ VgLogHandler::VgLogHandler( VgLogView* lv )
 VgLogHandler::~VgLogHandler()
 { }
 
-/* gets <?xml...> element */
-bool VgLogHandler::processingInstruction( const QString& target, const QString& data )
+/* gets <?xml...> element: nothing we need from it */
+bool VgLogHandler::processingInstruction( const QString& /*target*/,
+                                          const QString& /*data*/ )
 {
    //  vkPrintErr("VgLogHandler::processingInstruction: %s, %s", target.latin1(), data.latin1());
-   doc.appendChild( doc.createProcessingInstruction( target, data ) );
-   node = doc;
    return true;
 }
 
@@ -106,47 +283,123 @@ bool VgLogHandler::startElement( const QString&, const QString&,
                                  const QXmlAttributes& )
 {
    //  vkPrintErr("VgLogHandler::startElement: '%s'", tag.latin1());
-   QDomNode n = doc.createElement( tag );
-   node.appendChild( n );
-   node = n;
-   
-   if ( node == doc.documentElement() ) {
-      QDomProcessingInstruction xml_insn =
-         doc.firstChild().toProcessingInstruction();
-      if ( ! logview->init( xml_insn, tag ) ) {
-         //VK_DEBUG("Error: Failed log initialisation");
-         return false;
-      }
-   }
-   
-   return true;
+   VG_ELEM::ElemType type =
+      VgLogView::elemtypeMap.value( tag, VG_ELEM::NUM_ELEMS );
+   return startTag( type, tag );
 }
 
 bool VgLogHandler::endElement( const QString&, const QString&,
                                const QString& /*tag*/ )
 {
    // vkPrintErr("VgLogHandler::endElement: %s", qPrintable( tag ));
-   // Should never have end element at doc level
-   if ( node == doc ) {
-      //VK_DEBUG("VgLogHandler::endElement(): Error: node == doc");
-      return false;
+   return endTag();
+}
+
+
+/*!
+  Where the top-level elements are: the tokenizer knows, the sax
+  reader doesn't.  offset is a byte offset into the file at path:
+  each top-level element's start, just before its startTag(), and
+  its end, just before its endTag().
+*/
+void VgLogHandler::setSource( const QString& path )
+{
+   sourceId = path.isEmpty() ? 0 : VgStrPool::global().intern( path );
+}
+
+void VgLogHandler::topLevelStart( qint64 offset )
+{
+   elemStart = offset;
+}
+
+void VgLogHandler::topLevelEnd( qint64 offset )
+{
+   elemEnd = offset;
+}
+
+
+/*!
+  Element-level interface: the tag has already been looked up.
+  Used both by the sax callbacks above and by VgXmlTokenizer.
+*/
+bool VgLogHandler::startTag( VG_ELEM::ElemType type, const QString& tag )
+{
+   elemPath.append( type );
+   recordStartElement( type );
+
+   if ( skipDepth > 0 ) {
+      skipDepth++;
+      return true;
    }
-   
-   QDomNode prnt = node.parentNode();
-   
-   /* if closing a top-level tag, append to vglog */
-   if ( prnt == doc.documentElement() ) {
-      QString errMsg;
-      if ( ! logview->appendNode( node, errMsg ) ) {
-         //VK_DEBUG("Failed to append node");
-         m_fatalMsg = errMsg;
+
+   // errors and errorcounts are consumed straight from the record:
+   // don't bother keeping their xml.  Unless
+   // it's an error with nowhere to read it back from: then spool it.
+   if ( elemPath.count() == 2 &&
+        ( type == VG_ELEM::ERROR || type == VG_ELEM::ERRORCOUNTS ) ) {
+      spooling = ( type == VG_ELEM::ERROR && rec.offset < 0 && errorXml != 0 );
+      if ( !spooling ) {
+         skipDepth = 1;
+         return true;
+      }
+   }
+
+   return collectStart( tag );
+}
+
+bool VgLogHandler::endTag()
+{
+   if ( elemPath.count() == 2 && rec.offset >= 0 && elemEnd > rec.offset ) {
+      rec.length = elemEnd - rec.offset;
+   }
+   elemEnd = -1;
+
+   if ( !elemPath.isEmpty() ) {
+      recordEndElement( elemPath.last() );
+      elemPath.removeLast();
+   }
+
+   if ( skipDepth > 0 ) {
+      skipDepth--;
+      // closing a top-level element: just its record
+      return ( skipDepth == 0 ) ? handOver() : true;
+   }
+
+   return collectEnd();
+}
+
+/*!
+  The element is kept as xml text, not built into a dom: that's
+  up to vglog, if it's ever wanted, in the gui thread.  Nor is the
+  document element: it's just its tag (see rootRecord()).
+*/
+bool VgLogHandler::collectStart( const QString& tag )
+{
+   if ( elemPath.count() == 1 ) {
+      // only the one document element
+      if ( !m_rootTag.isEmpty() ) {
+         return false;
+      }
+      m_rootTag = tag;
+      if ( logview != 0 && !logview->init( rootRecord() ) ) {
+         //VK_DEBUG("Error: Failed log initialisation");
          return false;
       }
+      return true;
    }
-   
-   node = prnt;
-   
-   if ( node == doc ) {
+   xml += '<' + tag + '>';
+   tagPath.append( tag );
+   return true;
+}
+
+bool VgLogHandler::collectEnd()
+{
+   /* closing the document element: see endTag() */
+   if ( tagPath.isEmpty() ) {
+      // Should never have end element at doc level
+      if ( m_rootTag.isEmpty() || m_finished ) {
+         return false;
+      }
       /* In case we get bad xml after the closing tag, mark as 'finished'
          This may happed, for example, as a result of doing fork() but
          not exec() under valgrind.  When the process forks, you wind up
@@ -154,8 +407,105 @@ bool VgLogHandler::endElement( const QString&, const QString&,
          sorted out until the child does exec().
       */
       m_finished = true;
+      return true;
+   }
+
+   xml += "</" + tagPath.takeLast() + '>';
+
+   /* if closing a top-level tag, hand it over */
+   if ( tagPath.isEmpty() ) {
+      return handOver();
+   }
+   return true;
+}
+
+
+/*!
+  A top-level element has been closed: hand its record over to
+  vglog, or keep it for a later appendElement().
+   - a spooled error goes on as just its record, as every other
+     error does: its xml is in the spool.
+   - anything else takes its xml along.
+*/
+bool VgLogHandler::handOver()
+{
+   if ( spooling ) {
+      errorXml->spool( xml, rec );
+      spooling = false;
+   }
+   else {
+      rec.xml = xml;
+   }
+   xml = QString();
+
+   bool ok = true;
+   if ( logview != 0 ) {
+      ok = appendElement( rec );
+   }
+   else {
+      collected.append( rec );
+   }
+   rec.clear();
+   return ok;
+}
+
+
+/*!
+  Without a vglog: the count of each collected error, by element
+  (0 for the rest).
+   - the last <errorcounts> has them all, by <unique>.
+   - leak errors aren't in errorcounts: found just the once.
+*/
+QVector<quint32> VgLogHandler::errorCounts() const
+{
+   QHash<quint64, quint32> logCounts;
+   for ( int e = collected.count() - 1; e >= 0; --e ) {
+      const VgLogRecord& rec = collected.at( e );
+      if ( rec.type == VG_ELEM::ERRORCOUNTS ) {
+         for ( int i = 0; i < rec.pairs.count(); ++i ) {
+            logCounts.insert( rec.pairs.at( i ).unique, rec.pairs.at( i ).count );
+         }
+         break;
+      }
+   }
+
+   QVector<quint32> counts( collected.count(), 0 );
+   for ( int e = 0; e < collected.count(); ++e ) {
+      const VgLogRecord& rec = collected.at( e );
+      if ( rec.type == VG_ELEM::ERROR ) {
+         counts[e] = logCounts.value( rec.unique.toULongLong( 0, 0 ), 1 );
+      }
+   }
+   return counts;
+}
+
+
+/*!
+  The ROOT record, to initialise a vglog with (VgLogView::init()):
+  once the document element's been seen.
+*/
+VgLogRecord VgLogHandler::rootRecord()
+{
+   VgLogRecord root;
+   root.clear( VG_ELEM::ROOT );
+   root.text = m_rootTag;
+   return root;
+}
+
+
+/*!
+  Hand a complete top-level record over to vglog: as parsed here,
+  or collected by another thread's handler.
+*/
+bool VgLogHandler::appendElement( VgLogRecord& record )
+{
+   vk_assert( logview != 0 );
+
+   QString errMsg;
+   if ( ! logview->appendNode( record, errMsg ) ) {
+      m_fatalMsg = errMsg;
+      return false;
    }
-   
    return true;
 }
 
@@ -163,34 +513,229 @@ bool VgLogHandler::characters( const QString&  ch )
 {
    //  vkPrintErr("characters: '%s'", ch.latin1());
    // No text as child of some document
-   if ( node == doc ) {
+   if ( elemPath.isEmpty() ) {
       return false;
    }
    
    /* ignore text as child of doc_elem
       => valgrind non-xml output (shouldn't happen), or client output */
-   if ( node == doc.documentElement() ) {
+   if ( elemPath.count() == 1 ) {
       return true;
    }
-   
-   QString chars = ch.simplified();
-   
-   if ( !chars.isEmpty() ) {
-      node.appendChild( doc.createTextNode( chars ) );
-      //    vkPrintErr("chars: '%s'", chars.latin1());
+
+   // may arrive in pieces (e.g. around entities): gather for the record
+   chars += ch;
+
+   if ( skipDepth > 0 ) {
+      return true;
    }
    
+   QString str = ch.simplified();
+   if ( !str.isEmpty() ) {
+      xml += xmlText( str );
+   }
    return true;
 }
 
+
+/*!
+  Intern the text of the element just closed: each distinct
+  fn/obj/dir/file is then held once, however many frames (of
+  however many logs) refer to it.
+*/
+quint32 VgLogHandler::internText( const QString& val )
+{
+   return VgStrPool::global().intern( val );
+}
+
+
+/*!
+  Record building: called for each element within the document.
+  elemPath includes the current element: [ROOT, top-level, ...]
+*/
+void VgLogHandler::recordStartElement( VG_ELEM::ElemType type )
+{
+   chars = QString();
+   int depth = elemPath.count();
+
+   if ( depth == 2 ) {
+      // new top-level element: where it is, if known
+      rec.clear( type );
+      if ( elemStart >= 0 ) {
+         rec.offset = elemStart;
+         rec.source = sourceId;
+      }
+      elemStart = -1;
+      return;
+   }
+
+   switch ( rec.type ) {
+   case VG_ELEM::ERROR:
+   case VG_ELEM::ANNOUNCETHREAD:
+      if ( depth == 3 && type == VG_ELEM::STACK ) {
+         rec.stacks.append( QVector<VgLogFrame>() );
+         VgLogDetail det = { type, QString() };
+         rec.details.append( det );
+      }
+      else if ( depth == 4 && type == VG_ELEM::FRAME &&
+                elemPath.at( 2 ) == VG_ELEM::STACK ) {
+         rec.stacks.last().append( VgLogFrame() );
+      }
+      break;
+
+   case VG_ELEM::ERRORCOUNTS:
+   case VG_ELEM::SUPPCOUNTS:
+      if ( depth == 3 && type == VG_ELEM::PAIR ) {
+         VgLogPair pr = { 0, 0, QString() };
+         rec.pairs.append( pr );
+      }
+      break;
+
+   default:
+      break;
+   }
+}
+
+void VgLogHandler::recordEndElement( VG_ELEM::ElemType type )
+{
+   int depth = elemPath.count();
+   if ( depth <= 2 ) {
+      if ( depth == 2 ) {
+         // only of use for leaf elements: e.g. <pid>
+         rec.text = chars.simplified();
+         if ( type == VG_ELEM::PROTOCOL_TOOL ) {
+            m_protocolTool = rec.text;
+         }
+      }
+      chars = QString();
+      return;
+   }
+
+   QString val = chars.simplified();
+   chars = QString();
+
+   switch ( rec.type ) {
+   case VG_ELEM::ERROR:
+   case VG_ELEM::ANNOUNCETHREAD:
+      if ( depth == 3 ) {
+         switch ( type ) {
+         case VG_ELEM::UNIQUE:    rec.unique    = val; break;
+         case VG_ELEM::KIND:      rec.kind      = val; break;
+         case VG_ELEM::HTHREADID: rec.hthreadid = val; break;
+
+         case VG_ELEM::TID: {
+            rec.tid = val;
+            VgLogDetail det = { type, val };
+            rec.details.append( det );
+            break;
+         }
+         case VG_ELEM::WHAT:
+         case VG_ELEM::AUXWHAT: {
+            if ( type == VG_ELEM::WHAT && rec.what.isEmpty() ) {
+               rec.what = val;
+            }
+            VgLogDetail det = { type, val };
+            rec.details.append( det );
+            break;
+         }
+         case VG_ELEM::XWHAT:
+         case VG_ELEM::XAUXWHAT: {
+            // All XWHAT/XAUXWHAT's have a text element
+            if ( type == VG_ELEM::XWHAT && rec.xwhat.isEmpty() ) {
+               rec.xwhat = rec.xtext;
+            }
+            VgLogDetail det = { type, rec.xtext };
+            rec.details.append( det );
+            rec.xtext = QString();
+            break;
+         }
+         default:
+            break;
+         }
+      }
+      else if ( depth == 4 ) {
+         VG_ELEM::ElemType prnt = elemPath.at( 2 );
+         if ( prnt == VG_ELEM::XWHAT || prnt == VG_ELEM::XAUXWHAT ) {
+            if ( type == VG_ELEM::TEXT ) {
+               rec.xtext = val;
+            }
+            else if ( type == VG_ELEM::HTHREADID ) {
+               rec.hthreadids.append( val.toInt() );
+            }
+            else if ( prnt == VG_ELEM::XWHAT && type == VG_ELEM::LEAKEDBYTES ) {
+               rec.leakedBytes = val;
+            }
+            else if ( prnt == VG_ELEM::XWHAT && type == VG_ELEM::LEAKEDBLOCKS ) {
+               rec.leakedBlocks = val;
+            }
+         }
+      }
+      else if ( depth == 5 && elemPath.at( 2 ) == VG_ELEM::STACK &&
+                elemPath.at( 3 ) == VG_ELEM::FRAME ) {
+         VgLogFrame& frm = rec.stacks.last().last();
+         switch ( type ) {
+         case VG_ELEM::IP:      frm.ip   = val; break;
+         case VG_ELEM::OBJ:     frm.obj  = internText( val ); break;
+         case VG_ELEM::FN:      frm.fn   = internText( val ); break;
+         case VG_ELEM::SRCDIR:  frm.dir  = internText( val ); break;
+         case VG_ELEM::SRCFILE: frm.file = internText( val ); break;
+         case VG_ELEM::LINE:    frm.line = val; break;
+         default: break;
+         }
+      }
+      break;
+
+   case VG_ELEM::ERRORCOUNTS:
+   case VG_ELEM::SUPPCOUNTS:
+      if ( depth == 4 && elemPath.at( 2 ) == VG_ELEM::PAIR ) {
+         VgLogPair& pr = rec.pairs.last();
+         switch ( type ) {
+         case VG_ELEM::COUNT:  pr.count  = val.toUInt(); break;
+         case VG_ELEM::UNIQUE: pr.unique = val.toULongLong( 0, 0 ); break;
+         case VG_ELEM::NAME:   pr.name   = val; break;
+         default: break;
+         }
+      }
+      break;
+
+   case VG_ELEM::ARGS:
+      if ( depth == 4 && type == VG_ELEM::EXE &&
+           elemPath.at( 2 ) == VG_ELEM::ARGV ) {
+         rec.exe = val;
+      }
+      break;
+
+   case VG_ELEM::STATUS:
+      if ( depth == 3 ) {
+         if ( type == VG_ELEM::STATE ) {
+            rec.state = val;
+         }
+         else if ( type == VG_ELEM::TIME ) {
+            rec.time = val;
+         }
+      }
+      break;
+
+   default:
+      break;
+   }
+}
+
 /* Called by xml reader at start of parsing */
 bool VgLogHandler::startDocument()
 {
    //   vkPrintErr("VgLogHandler::startDocument()\n");
-   vk_assert( logview != 0 );
-   
-   doc = QDomDocument();
-   node = doc;
+   rec.clear();
+   elemPath.clear();
+   chars = QString();
+   skipDepth = 0;
+   elemStart = elemEnd = -1;
+   spooling = false;
+   collected.clear();
+   xml = QString();
+   tagPath.clear();
+   m_rootTag = QString();
+   m_protocolTool = QString();
    m_fatalMsg = QString();
    m_finished = false;
    m_started = true;
@@ -199,14 +744,14 @@ bool VgLogHandler::startDocument()
 
 /* Called by xml reader after it has finished parsing
    Checks we have a complete document,
-   i.e. endElement() has returned node ptr to root
+   i.e. endElement() has closed the document element
 */
 bool VgLogHandler::endDocument()
 {
    //   vkPrintErr("VgLogHandler::endDocument()\n");
    m_finished = true;
    
-   if ( node != doc ) {
+   if ( !tagPath.isEmpty() || ( logview != 0 && !elemPath.isEmpty() ) ) {
       return false;
    }
    
@@ -22,10 +22,15 @@
 #define __VGLOGREADER_H
 
 #include "toolview/vglogview.h"
+#include "utils/vgerrorxml.h"
+#include "utils/vglogstore.h"
+#include "utils/vk_compress.h"
 
 #include <QFile>
 #include <QString>
-#include <QDomDocument>
+#include <QStringList>
+#include <QVector>
+#include <QWidget>
 
 #if 1
 #include <QXmlAttributes>
@@ -44,12 +49,25 @@
 #endif
 
 
+class VgLogLoader;
+
+
 // ============================================================
 /*
   Simple xml handler class for valgrind logs:
-  - creates node tree from input
-  - hands off complete top-level branches to VgLog
-  (e.g. preamble, error etc)
+  - fills a compact VgLogRecord for each top-level element
+    (e.g. preamble, error etc)
+  - hands off complete top-level records to VgLog
+  - no dom is built, here: QDom isn't thread-safe, and we may be
+    a worker thread's.  The elements VgLog may want a dom of come
+    with their xml (VgLogRecord::xml), for it to build one as needed.
+  - errors and errorcounts are just records: no xml.
+    Where an error is in the log is given by the tokenizer
+    (topLevelStart(), topLevelEnd()): without that (QXmlSimpleReader),
+    its xml is spooled instead, for VgLog to read back (VgErrorXml).
+  - without a VgLog (lv == 0), top-level records are collected
+    instead, for handing off later: used by worker threads.
+    The document element comes first, as a ROOT record (rootRecord()).
 */
 class VgLogHandler : public QXmlDefaultHandler
 {
@@ -70,6 +88,37 @@ public:
    bool characters( const QString& ch );
    bool startDocument();
    bool endDocument();
+
+   // element-level interface, for tokenizers doing their own tag lookup
+   bool startTag( VG_ELEM::ElemType type, const QString& tag );
+   bool endTag();
+   // ... and knowing where the top-level elements are, in source
+   void setSource( const QString& path );
+   void topLevelStart( qint64 offset );
+   void topLevelEnd( qint64 offset );
+
+   bool appendElement( VgLogRecord& record );
+   static QString xmlText( const QString& str );
+   VgLogView* logView() {
+      return logview;
+   }
+   /* where errors without offsets are spooled: 0 for none */
+   void setErrorXml( VgErrorXml* xml ) {
+      errorXml = xml;
+   }
+   QVector<VgLogRecord>& collectedElements() {
+      return collected;
+   }
+   QVector<quint32> errorCounts() const;
+   /* without a vglog: what it should be initialised with, once seen */
+   VgLogRecord rootRecord();
+   QString rootTag() {
+      return m_rootTag;
+   }
+   /* without a vglog: <protocoltool>, once seen */
+   QString protocolTool() {
+      return m_protocolTool;
+   }
    
    // reimplement error handlers
    bool error( const QXmlParseException& exception );
@@ -79,6 +128,9 @@ public:
    QString fatalMsg() {
       return m_fatalMsg;
    }
+   void setFatalMsg( const QString& msg ) {
+      m_fatalMsg = msg;
+   }
    /* may have reached end of log even with fatal error */
    bool finished() {
       return m_finished;
@@ -89,9 +141,33 @@ public:
    }
    
 private:
-   QDomDocument doc;
+   bool collectStart( const QString& tag );
+   bool collectEnd();
+   bool handOver();
+   void recordStartElement( VG_ELEM::ElemType type );
+   void recordEndElement( VG_ELEM::ElemType type );
+   quint32 internText( const QString& val );
+
+private:
    VgLogView* logview;
-   QDomNode node;
+
+   // record building
+   VgLogRecord rec;
+   QVector<VG_ELEM::ElemType> elemPath;   // root .. current element
+   QString chars;                         // text of current element
+   int skipDepth;                         // open elements without xml
+
+   // where the current top-level element is
+   quint32 sourceId;                      // interned path: 0 if unknown
+   qint64 elemStart, elemEnd;             // -1 if unknown
+   VgErrorXml* errorXml;                  // we don't own this
+   bool spooling;                         // error's xml: for errorXml
+
+   QVector<VgLogRecord> collected;        // only if no logview
+   QString xml;                           // top-level element so far
+   QStringList tagPath;                   // open tags of xml
+   QString m_rootTag;
+   QString m_protocolTool;
    
    QString m_fatalMsg;
    bool m_finished;
@@ -113,6 +189,13 @@ public:
    
    bool parse( QString filepath, bool incremental = false );
    bool parseContinue();
+   bool parseFile( QString filepath, QWidget* parent = 0 );
+   bool parseRecords( QString filepath );
+   bool parseCompressed( QString filepath, VkCompress::Format fmt,
+                         VgLogLoader* loader = 0 );
+   bool atEnd() {
+      return file.atEnd();
+   }
    
    VgLogHandler* handler() {
       return vghandler;
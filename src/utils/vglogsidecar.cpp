@@ -0,0 +1,401 @@
+/****************************************************************************
+** VgLogSidecar implementation
+**  - binary index of a saved valgrind log, for reopening it quickly
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vglogsidecar.h"
+#include "utils/vk_utils.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFileInfo>
+
+
+static const quint32 SIDECAR_MAGIC   = 0x564b4958;   // "VKIX"
+static const quint32 SIDECAR_VERSION = 1;
+// bytes hashed at each end of the log
+static const qint64  HASH_SPAN       = 64 * 1024;
+
+
+
+/**********************************************************************/
+/*!
+  VgLogSidecar
+   - data, size: the log, as mapped by the caller.
+*/
+VgLogSidecar::VgLogSidecar( const QString& path, const char* _data,
+                            qint64 _size )
+   : logPath( path ), data( _data ), size( _size ), numEntries( 0 )
+{
+   logId = VgStrPool::global().intern( logPath );
+   mtime = QFileInfo( logPath ).lastModified().toTime_t();
+}
+
+VgLogSidecar::~VgLogSidecar()
+{
+   if ( file.isOpen() && ( file.openMode() & QIODevice::WriteOnly ) ) {
+      discard();
+   }
+}
+
+QString VgLogSidecar::sidecarPath( const QString& logPath )
+{
+   return logPath + ".vkidx";
+}
+
+
+/*!
+  The ends of the log: where a rewritten log differs, in practice.
+*/
+QByteArray VgLogSidecar::logHash() const
+{
+   QCryptographicHash hash( QCryptographicHash::Md5 );
+   qint64 span = qMin( size, HASH_SPAN );
+   hash.addData( data, span );
+   hash.addData( data + size - span, span );
+   return hash.result();
+}
+
+/*!
+  Fixed size: commit() writes it again, over the first one.
+*/
+void VgLogSidecar::writeHeader( qint64 tableOffset )
+{
+   strm << SIDECAR_MAGIC << SIDECAR_VERSION
+        << size << mtime << logHash()
+        << ( quint32 )numEntries << tableOffset;
+}
+
+bool VgLogSidecar::readHeader( qint64& tableOffset )
+{
+   quint32 magic, version, num;
+   qint64 logSize, logMtime;
+   QByteArray hash;
+
+   strm >> magic >> version;
+   if ( strm.status() != QDataStream::Ok ||
+        magic != SIDECAR_MAGIC || version != SIDECAR_VERSION ) {
+      return false;
+   }
+
+   strm >> logSize >> logMtime >> hash >> num >> tableOffset;
+   if ( strm.status() != QDataStream::Ok ) {
+      return false;
+   }
+   numEntries = num;
+
+   return logSize == size && logMtime == mtime && hash == logHash();
+}
+
+
+
+/**********************************************************************/
+/*!
+  Open the index for reading, checking it's for the log as it is now.
+  It's mapped, and read from memory: if it can't be, from the file.
+  The string table is read in straight away: its frame names are
+  only interned (VgStrPool::global()) as frames use them, so the
+  rest of it (what, details) isn't kept for the life of the app.
+*/
+bool VgLogSidecar::open()
+{
+   file.setFileName( sidecarPath( logPath ) );
+   if ( !file.open( QIODevice::ReadOnly ) ) {
+      return false;
+   }
+   const char* mapped = ( file.size() > 0 )
+                      ? ( const char* )file.map( 0, file.size() ) : 0;
+   if ( mapped ) {
+      mapBytes = QByteArray::fromRawData( mapped, file.size() );
+      mapBuf.setBuffer( &mapBytes );
+      mapBuf.open( QIODevice::ReadOnly );
+      strm.setDevice( &mapBuf );
+   }
+   else {
+      strm.setDevice( &file );
+   }
+   strm.setVersion( QDataStream::Qt_4_6 );
+   QIODevice* dev = strm.device();
+
+   qint64 tableOffset;
+   quint32 num = 0;
+   if ( readHeader( tableOffset ) ) {
+      qint64 entriesOffset = dev->pos();
+      if ( dev->seek( tableOffset ) ) {
+         strm >> num;
+      }
+      // sanity: can't have more strings than bytes
+      if ( strm.status() == QDataStream::Ok && num > 0 &&
+           num <= file.size() ) {
+         strs.resize( num );
+         poolIds.fill( 0, num );   // 0: not interned yet
+         for ( quint32 i = 0; i < num; ++i ) {
+            strm >> strs[i];
+         }
+         if ( strm.status() == QDataStream::Ok && strs.at( 0 ).isEmpty() &&
+              dev->seek( entriesOffset ) ) {
+            return true;
+         }
+      }
+   }
+
+   VK_DEBUG( "VgLogSidecar::open(): ignoring stale or broken index '%s'",
+             qPrintable( file.fileName() ) );
+   strm.setDevice( 0 );
+   mapBuf.close();
+   mapBytes.clear();
+   file.close();   // unmaps too
+   strs.clear();
+   poolIds.clear();
+   return false;
+}
+
+/*!
+  Read the next entry: false if the index turns out to be broken.
+*/
+bool VgLogSidecar::next( Entry& entry )
+{
+   quint8 type = VG_ELEM::NUM_ELEMS;
+   strm >> type >> entry.offset >> entry.length;
+   if ( type >= VG_ELEM::NUM_ELEMS ) {
+      return false;
+   }
+
+   entry.rec.clear( ( VG_ELEM::ElemType )type );
+   if ( type == VG_ELEM::ERROR ) {
+      readRecord( entry.rec );
+   }
+   entry.rec.offset = entry.offset;
+   entry.rec.length = entry.length;
+   entry.rec.source = logId;
+
+   return strm.status() == QDataStream::Ok &&
+          entry.offset >= 0 && entry.length > 0 &&
+          entry.offset + entry.length <= size;
+}
+
+quint32 VgLogSidecar::readId()
+{
+   quint32 id = 0;
+   strm >> id;
+   if ( id >= ( quint32 )strs.count() ) {
+      strm.setStatus( QDataStream::ReadCorruptData );
+      id = 0;
+   }
+   return id;
+}
+
+/*!
+  A frame's name: interned, the first time it's wanted.
+*/
+quint32 VgLogSidecar::readPoolId()
+{
+   quint32 id = readId();
+   if ( poolIds.at( id ) == 0 ) {
+      poolIds[id] = VgStrPool::global().intern( strs.at( id ) );
+   }
+   return poolIds.at( id );
+}
+
+void VgLogSidecar::readRecord( VgLogRecord& rec )
+{
+   quint64 unique;
+   strm >> unique;
+   rec.unique       = "0x" + QString::number( unique, 16 );
+   rec.tid          = strs.at( readId() );
+   rec.kind         = strs.at( readId() );
+   rec.what         = strs.at( readId() );
+   rec.xwhat        = strs.at( readId() );
+   rec.hthreadid    = strs.at( readId() );
+   rec.leakedBytes  = strs.at( readId() );
+   rec.leakedBlocks = strs.at( readId() );
+
+   quint32 num = 0;
+   strm >> num;
+   for ( quint32 i = 0; i < num && strm.status() == QDataStream::Ok; ++i ) {
+      quint8 type;
+      strm >> type;
+      VgLogDetail det = { ( VG_ELEM::ElemType )type, strs.at( readId() ) };
+      rec.details.append( det );
+   }
+
+   num = 0;
+   strm >> num;
+   for ( quint32 s = 0; s < num && strm.status() == QDataStream::Ok; ++s ) {
+      rec.stacks.append( QVector<VgLogFrame>() );
+      QVector<VgLogFrame>& frms = rec.stacks.last();
+
+      quint32 numFrames = 0;
+      strm >> numFrames;
+      for ( quint32 f = 0; f < numFrames && strm.status() == QDataStream::Ok; ++f ) {
+         quint64 ip;
+         quint32 line;
+         VgLogFrame frm;
+         strm >> ip;
+         frm.ip   = "0x" + QString::number( ip, 16 );
+         frm.obj  = readPoolId();
+         frm.fn   = readPoolId();
+         frm.dir  = readPoolId();
+         frm.file = readPoolId();
+         strm >> line;
+         if ( line != 0 ) {
+            frm.line = QString::number( line );
+         }
+         frms.append( frm );
+      }
+   }
+
+   strm >> rec.hthreadids;
+}
+
+
+
+/**********************************************************************/
+/*!
+  Start writing a new index.  It's written to a temporary file,
+  and only replaces any old one on commit().
+*/
+bool VgLogSidecar::create()
+{
+   file.setFileName( sidecarPath( logPath ) + ".tmp" );
+   if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
+      return false;
+   }
+   strm.setDevice( &file );
+   strm.setVersion( QDataStream::Qt_4_6 );
+
+   numEntries = 0;
+   strIds.clear();
+   writeHeader( 0 );
+   return file.error() == QFile::NoError;
+}
+
+/*!
+  rec: as parsed, before any logview has had it.
+*/
+void VgLogSidecar::append( qint64 offset, qint64 length,
+                           const VgLogRecord& rec )
+{
+   strm << ( quint8 )rec.type << offset << length;
+   if ( rec.type == VG_ELEM::ERROR ) {
+      writeRecord( rec );
+   }
+   numEntries++;
+}
+
+bool VgLogSidecar::commit()
+{
+   vk_assert( file.isOpen() );
+
+   // string table, by id
+   qint64 tableOffset = file.pos();
+   QVector<QString> table( strIds.count() + 1 );
+   QHash<QString, quint32>::const_iterator it;
+   for ( it = strIds.constBegin(); it != strIds.constEnd(); ++it ) {
+      table[ it.value() ] = it.key();
+   }
+   strm << ( quint32 )table.count();
+   for ( int i = 0; i < table.count(); ++i ) {
+      strm << table.at( i );
+   }
+
+   bool ok = file.seek( 0 );
+   writeHeader( tableOffset );
+   ok = ok && file.error() == QFile::NoError;
+
+   QString tmpPath = file.fileName();
+   strm.setDevice( 0 );
+   file.close();
+   strIds.clear();
+
+   if ( ok ) {
+      QString path = sidecarPath( logPath );
+      QFile::remove( path );
+      ok = QFile::rename( tmpPath, path );
+   }
+   if ( !ok ) {
+      QFile::remove( tmpPath );
+   }
+   return ok;
+}
+
+/*!
+  Abandon the index being written.
+*/
+void VgLogSidecar::discard()
+{
+   strm.setDevice( 0 );
+   if ( file.isOpen() ) {
+      file.close();
+      QFile::remove( file.fileName() );
+   }
+   strIds.clear();
+}
+
+void VgLogSidecar::writeStr( const QString& str )
+{
+   quint32 id = 0;
+   if ( !str.isEmpty() ) {
+      QHash<QString, quint32>::const_iterator it = strIds.constFind( str );
+      if ( it != strIds.constEnd() ) {
+         id = it.value();
+      }
+      else {
+         id = strIds.count() + 1;
+         strIds.insert( str, id );
+      }
+   }
+   strm << id;
+}
+
+void VgLogSidecar::writeRecord( const VgLogRecord& rec )
+{
+   VgStrPool& pool = VgStrPool::global();
+
+   strm << ( quint64 )rec.unique.toULongLong( 0, 0 );
+   writeStr( rec.tid );
+   writeStr( rec.kind );
+   writeStr( rec.what );
+   writeStr( rec.xwhat );
+   writeStr( rec.hthreadid );
+   writeStr( rec.leakedBytes );
+   writeStr( rec.leakedBlocks );
+
+   strm << ( quint32 )rec.details.count();
+   for ( int i = 0; i < rec.details.count(); ++i ) {
+      strm << ( quint8 )rec.details.at( i ).type;
+      writeStr( rec.details.at( i ).text );
+   }
+
+   strm << ( quint32 )rec.stacks.count();
+   for ( int s = 0; s < rec.stacks.count(); ++s ) {
+      const QVector<VgLogFrame>& frms = rec.stacks.at( s );
+      strm << ( quint32 )frms.count();
+      for ( int f = 0; f < frms.count(); ++f ) {
+         const VgLogFrame& frm = frms.at( f );
+         strm << ( quint64 )frm.ip.toULongLong( 0, 0 );
+         writeStr( pool.str( frm.obj ) );
+         writeStr( pool.str( frm.fn ) );
+         writeStr( pool.str( frm.dir ) );
+         writeStr( pool.str( frm.file ) );
+         strm << ( quint32 )frm.line.toUInt();
+      }
+   }
+
+   strm << rec.hthreadids;
+}
@@ -0,0 +1,122 @@
+/****************************************************************************
+** VgLogSidecar definition
+**  - binary index of a saved valgrind log, for reopening it quickly
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VGLOGSIDECAR_H
+#define __VGLOGSIDECAR_H
+
+#include "utils/vglogstore.h"
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+
+// ============================================================
+/*!
+  VgLogSidecar: the index file (<log>.vkidx) kept next to a saved
+  log, so opening it again needn't parse its errors.
+
+   - written by VgLogLoader as it first loads the log: any log
+     with errors in it, not just big ones.
+   - read mapped (QDataStream over the mapped bytes): the index
+     is decoded in place, without reading it in first.
+   - only good for the log as it was: its size, mtime, and a hash
+     of its first and last 64k must all still match.  (Hashing
+     the whole of a multi-GB log would cost what we're saving.)
+   - holds each top-level element between the first <error> and
+     the last </error>, in log order: its byte range in the log,
+     and for errors, the record (VgLogRecord) as parsed.
+     The few other elements (e.g. helgrind's announcethread) are
+     just parsed again, from their range.
+   - strings are in a table of their own, written last: the
+     entries can be streamed out as they're parsed.
+
+  Format (QDataStream):
+    header: magic, version, log size, log mtime, log hash,
+            num entries, offset of string table
+    entries: type, offset, length [, record if an error]
+    string table: count, strings  (0 is the empty string)
+*/
+class VgLogSidecar
+{
+public:
+   struct Entry {
+      qint64 offset;
+      qint64 length;
+      VgLogRecord rec;     // rec.type: the element; the rest: errors only
+   };
+
+   VgLogSidecar( const QString& logPath, const char* data, qint64 size );
+   ~VgLogSidecar();
+
+   static QString sidecarPath( const QString& logPath );
+
+   // reading: false if there's no index, or it's stale or broken.
+   bool open();
+   int count() const {
+      return numEntries;
+   }
+   bool next( Entry& entry );
+
+   // writing: a new index is only put in place by commit().
+   bool create();
+   void append( qint64 offset, qint64 length, const VgLogRecord& rec );
+   bool commit();
+   void discard();
+
+private:
+   Q_DISABLE_COPY( VgLogSidecar )
+
+   QByteArray logHash() const;
+   bool readHeader( qint64& tableOffset );
+   void writeHeader( qint64 tableOffset );
+   quint32 readId();
+   quint32 readPoolId();
+   void writeStr( const QString& str );
+   void readRecord( VgLogRecord& rec );
+   void writeRecord( const VgLogRecord& rec );
+
+private:
+   QString logPath;
+   quint32 logId;           // interned logPath: the entries' source
+   const char* data;        // the mapped log: we don't own this
+   qint64 size;
+   qint64 mtime;
+
+   QFile file;
+   QByteArray mapBytes;     // reading: the mapped index, not copied
+   QBuffer mapBuf;
+   QDataStream strm;
+   int numEntries;
+
+   // reading: strings by table id, and the global pool ids of
+   // those interned so far (frame names)
+   QVector<QString> strs;
+   QVector<quint32> poolIds;
+
+   // writing
+   QHash<QString, quint32> strIds;
+};
+
+#endif // #ifndef __VGLOGSIDECAR_H
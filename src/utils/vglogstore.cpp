@@ -0,0 +1,366 @@
+/****************************************************************************
+** VgLogStore implementation
+**  - compact, arena-allocated records of a valgrind xml log
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vglogstore.h"
+#include "utils/vk_utils.h"
+
+
+/**********************************************************************/
+/*!
+  VgStrPool
+*/
+Q_GLOBAL_STATIC( VgStrPool, globalStrPool )
+
+VgStrPool::VgStrPool()
+{
+   clear();
+}
+
+VgStrPool& VgStrPool::global()
+{
+   return *globalStrPool();
+}
+
+quint32 VgStrPool::intern( const QString& str )
+{
+   if ( str.isEmpty() ) {
+      return 0;
+   }
+
+   {
+      QReadLocker locker( &lock );
+      QHash<QString, quint32>::const_iterator it = ids.constFind( str );
+      if ( it != ids.constEnd() ) {
+         return it.value();
+      }
+   }
+
+   QWriteLocker locker( &lock );
+   // another thread may have got there first
+   QHash<QString, quint32>::const_iterator it = ids.constFind( str );
+   if ( it != ids.constEnd() ) {
+      return it.value();
+   }
+
+   quint32 id = strs.append( str );
+   ids.insert( str, id );   // implicitly shared with strs: stored once.
+   return id;
+}
+
+quint32 VgStrPool::find( const QString& str ) const
+{
+   QReadLocker locker( &lock );
+   return ids.value( str, 0 );
+}
+
+const QString& VgStrPool::str( quint32 id ) const
+{
+   QReadLocker locker( &lock );
+   vk_assert( (int)id < strs.count() );
+   return strs.at( id );
+}
+
+int VgStrPool::count() const
+{
+   QReadLocker locker( &lock );
+   return strs.count();
+}
+
+void VgStrPool::clear()
+{
+   QWriteLocker locker( &lock );
+   strs.clear();
+   ids.clear();
+   strs.append( QString() );   // id 0
+}
+
+
+
+/**********************************************************************/
+/*!
+  VgLogRecord
+*/
+VgLogRecord::VgLogRecord()
+{
+   clear();
+}
+
+void VgLogRecord::clear( VG_ELEM::ElemType t )
+{
+   type = t;
+   unique = tid = kind = what = xwhat = hthreadid = QString();
+   leakedBytes = leakedBlocks = QString();
+   details.clear();
+   stacks.clear();
+   xtext = QString();
+   hthreadids.clear();
+   lockAddrs.clear();
+   pairs.clear();
+   state = time = QString();
+   xml = text = exe = QString();
+   offset = -1;
+   length = 0;
+   source = 0;
+}
+
+
+
+/**********************************************************************/
+/*!
+  VgLogStore
+*/
+VgLogStore::VgLogStore()
+{
+   clear();
+}
+
+VgLogStore::~VgLogStore()
+{ }
+
+void VgLogStore::clear()
+{
+   errors.clear();
+   details.clear();
+   stacks.clear();
+   frames.clear();
+   frameIds.clear();
+   cells.clear();
+   cellIds.clear();
+   hgvals.clear();
+   origins.clear();
+   suppcounts.clear();
+   texts.clear();
+   errindex.clear();
+   errgroups.clear();
+   errleaks.clear();
+
+   VgStackCell end = { 0, 0 };
+   cells.append( end );
+   VgOriginRec none = { 0, 0, 0 };
+   origins.append( none );
+}
+
+
+/*!
+  The id of frm in the frame table: added if not yet there.
+*/
+quint32 VgLogStore::internFrame( const VgFrameRec& frm )
+{
+   QHash<VgFrameRec, quint32>::const_iterator it = frameIds.constFind( frm );
+   if ( it != frameIds.constEnd() ) {
+      return it.value();
+   }
+   quint32 id = frames.append( frm );
+   frameIds.insert( frm, id );
+   return id;
+}
+
+/*!
+  The stack cell holding frame, in front of the list at next.
+*/
+quint32 VgLogStore::cons( quint32 frame, quint32 next )
+{
+   quint64 key = ( ( quint64 )frame << 32 ) | next;
+   QHash<quint64, quint32>::const_iterator it = cellIds.constFind( key );
+   if ( it != cellIds.constEnd() ) {
+      return it.value();
+   }
+   VgStackCell cell = { frame, next };
+   quint32 id = cells.append( cell );
+   cellIds.insert( key, id );
+   return id;
+}
+
+
+/*!
+  A parsed frame, as kept.
+*/
+VgFrameRec VgLogStore::frameRec( const VgLogFrame& lf )
+{
+   VgFrameRec frm;
+   frm.ip   = lf.ip.toULongLong( 0, 0 );   // "0x..."
+   frm.obj  = lf.obj;
+   frm.fn   = lf.fn;
+   frm.dir  = lf.dir;
+   frm.file = lf.file;
+   frm.line = lf.line.toUInt();
+   return frm;
+}
+
+/*!
+  Append all stacks of rec, adding their frames to the frame table.
+  Returns the index of the first stack.
+*/
+int VgLogStore::addStacks( const VgLogRecord& rec )
+{
+   int first = stacks.count();
+
+   for ( int s = 0; s < rec.stacks.count(); ++s ) {
+      const QVector<VgLogFrame>& frms = rec.stacks.at( s );
+
+      // built from the bottom up, so shared outer frames share cells
+      quint32 top = 0;
+      for ( int f = frms.count() - 1; f >= 0; --f ) {
+         top = cons( internFrame( frameRec( frms.at( f ) ) ), top );
+      }
+
+      VgStackRec stk;
+      stk.top       = top;
+      stk.numFrames = frms.count();
+      stacks.append( stk );
+   }
+
+   return first;
+}
+
+
+/*!
+  Append a closed <error>.
+  Returns the index of the new error record.
+*/
+int VgLogStore::addError( const VgLogRecord& rec )
+{
+   vk_assert( rec.type == VG_ELEM::ERROR );
+
+   VgStrPool& pool = VgStrPool::global();
+   bool ok;
+   VgErrorRec err;
+   err.unique       = rec.unique.toULongLong( 0, 0 );  // "0x..."
+   err.leakedBytes  = rec.leakedBytes.toULongLong();
+   err.leakedBlocks = rec.leakedBlocks.toULongLong();
+   err.kind         = pool.intern( rec.kind );
+   // unclear what we can expect re what/xwhat.
+   //  - give 'what' preference over 'xwhat'.
+   err.what         = texts.intern( rec.what.isEmpty() ? rec.xwhat : rec.what );
+   err.count        = 1;  // can't have less than 1 for a reported error
+   err.tid          = rec.tid.toInt( &ok );
+   if ( !ok ) {
+      err.tid = -1;
+   }
+   err.offset       = rec.offset;
+   err.length       = rec.length;
+   err.source       = rec.source;
+   err.firstOrigin  = 0;
+
+   err.numStacks  = rec.stacks.count();
+   err.firstStack = addStacks( rec );
+
+   err.firstDetail = details.count();
+   err.numDetails  = rec.details.count();
+   int stackNum = 0;
+   for ( int i = 0; i < rec.details.count(); ++i ) {
+      const VgLogDetail& ld = rec.details.at( i );
+      VgDetailRec det;
+      det.type  = ld.type;
+      det.value = ( ld.type == VG_ELEM::STACK ) ? stackNum++
+                                                : texts.intern( ld.text );
+      details.append( det );
+   }
+
+   err.firstHgVal   = hgvals.count();
+   err.numHThreads  = rec.hthreadids.count();
+   err.numLockAddrs = rec.lockAddrs.count();
+   for ( int i = 0; i < rec.hthreadids.count(); ++i ) {
+      hgvals.append( rec.hthreadids.at( i ) );
+   }
+   for ( int i = 0; i < rec.lockAddrs.count(); ++i ) {
+      hgvals.append( rec.lockAddrs.at( i ) );
+   }
+
+   int idx = errors.append( err );
+   bool leaked = !rec.leakedBytes.isEmpty() || !rec.leakedBlocks.isEmpty();
+   errindex.addError( idx, *this, leaked );
+   errgroups.addError( idx, *this );
+   errleaks.addError( idx, *this );
+   return idx;
+}
+
+
+/*!
+  From <errorcounts>: the error's groups keep count too.
+*/
+void VgLogStore::setErrorCount( int idx, quint32 count )
+{
+   VgErrorRec& err = errors[idx];
+   errgroups.setCount( idx, err.count, count );
+   err.count = count;
+}
+
+/*!
+  Merged logs: the error was (also) found in log, count times.
+   - the same log again just adds to its count: errors that only
+     differ in what the merge tells apart are one and the same.
+*/
+void VgLogStore::addOrigin( int idx, quint32 log, quint32 count )
+{
+   VgErrorRec& err = errors[idx];
+
+   quint32* link = &err.firstOrigin;
+   while ( *link != 0 ) {
+      VgOriginRec& org = origins[ *link ];
+      if ( org.log == log ) {
+         org.count += count;
+         return;
+      }
+      link = &org.next;
+   }
+
+   VgOriginRec org = { log, count, 0 };
+   *link = origins.append( org );
+}
+
+/*!
+  Group the errors again: see VgLogGroups.
+*/
+void VgLogStore::regroup( int depth, VG_FPRINT::Key key )
+{
+   errgroups.regroup( depth, key, *this );
+}
+
+/*!
+  Total the leaks again: see VgLogLeaks.
+*/
+void VgLogStore::regroupLeaks( int depth )
+{
+   errleaks.regroup( depth, *this );
+}
+
+/*!
+  Merged logs: each log's leak check adds to the totals, rather
+  than starting them again.
+*/
+void VgLogStore::setCumulativeLeaks( bool cumulative )
+{
+   errleaks.setCumulative( cumulative );
+}
+
+
+void VgLogStore::setSuppCounts( const VgLogRecord& rec )
+{
+   vk_assert( rec.type == VG_ELEM::SUPPCOUNTS );
+
+   suppcounts.clear();
+   for ( int i = 0; i < rec.pairs.count(); ++i ) {
+      VgPairRec pr;
+      pr.count = rec.pairs.at( i ).count;
+      pr.name  = texts.intern( rec.pairs.at( i ).name );
+      suppcounts.append( pr );
+   }
+}
@@ -0,0 +1,392 @@
+/****************************************************************************
+** VgLogStore definition
+**  - compact, arena-allocated records of a valgrind xml log
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VGLOGSTORE_H
+#define __VGLOGSTORE_H
+
+#include "utils/vgloggroups.h"
+#include "utils/vglogindex.h"
+#include "utils/vglogleaks.h"
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+
+
+// ============================================================
+namespace VG_ELEM {
+   // All valgrind tag types, for mapping of tags to enum values
+   enum ElemType {
+      ROOT, PROTOCOL_VERSION, PROTOCOL_TOOL, PREAMBLE, PID, PPID, TOOL,
+      LOGQUAL, VAR, VALUE, COMMENT,
+      ARGS, VARGV, ARGV, EXE, ARG,
+      STATUS, STATE, TIME,
+      ERROR, UNIQUE, TID, KIND, WHAT, XWHAT, TEXT, STACK,
+      FRAME, IP, OBJ, FN, SRCDIR, SRCFILE, LINE, AUXWHAT, XAUXWHAT,
+      ERRORCOUNTS, ANNOUNCETHREAD, HTHREADID, PAIR, COUNT,
+      SUPPCOUNTS, NAME, LEAKEDBYTES, LEAKEDBLOCKS,
+      SUPPRESSION, SNAME, SKIND, SKAUX, SFRAME, RAWTEXT,
+      NUM_ELEMS
+   };
+}
+
+
+
+// ============================================================
+/*!
+  VgArena: append-only storage for plain records.
+   - elements live in fixed-size chunks, so growing the arena
+     never copies (or moves) what's already been stored.
+*/
+template <typename T>
+class VgArena
+{
+public:
+   VgArena() : num( 0 ) {}
+   ~VgArena() {
+      clear();
+   }
+
+   int append( const T& t ) {
+      if ( ( num & CHUNK_MASK ) == 0 ) {
+         chunks.append( new T[ CHUNK_SIZE ] );
+      }
+      chunks.last()[ num & CHUNK_MASK ] = t;
+      return num++;
+   }
+
+   T& operator[]( int i ) {
+      return chunks[ i >> CHUNK_BITS ][ i & CHUNK_MASK ];
+   }
+   const T& at( int i ) const {
+      return chunks.at( i >> CHUNK_BITS )[ i & CHUNK_MASK ];
+   }
+
+   int count() const {
+      return num;
+   }
+
+   void clear() {
+      for ( int i = 0; i < chunks.count(); ++i ) {
+         delete [] chunks[i];
+      }
+      chunks.clear();
+      num = 0;
+   }
+
+private:
+   Q_DISABLE_COPY( VgArena )
+   enum { CHUNK_BITS = 12, CHUNK_SIZE = 1 << CHUNK_BITS, CHUNK_MASK = CHUNK_SIZE - 1 };
+
+   QVector<T*> chunks;
+   int num;
+};
+
+
+
+// ============================================================
+/*!
+  VgStrPool: string interning
+   - each distinct string is stored once, and referred to by id.
+   - id 0 is always the empty string.
+   - global(): the pool shared by all logs.  fn/obj/dir/file names
+     and error kinds recur across errors, runs and logs: intern them
+     once, for the life of the app, so ids compare equal between
+     logs too.  A log's own text (what, auxwhat, ...) goes in its
+     store's pool instead (VgLogStore::text()), freed with the log.
+   - safe to use from several threads (the loader's parse tasks):
+     strings live in an arena, so a reference from str() stays
+     valid as the pool grows.
+*/
+class VgStrPool
+{
+public:
+   VgStrPool();
+
+   static VgStrPool& global();
+
+   quint32 intern( const QString& str );
+   quint32 find( const QString& str ) const;   // 0 if unknown
+   const QString& str( quint32 id ) const;
+   int count() const;
+   void clear();
+
+private:
+   Q_DISABLE_COPY( VgStrPool )
+
+   mutable QReadWriteLock lock;
+   VgArena<QString> strs;
+   QHash<QString, quint32> ids;
+};
+
+
+
+// ============================================================
+/*
+  Compact records: all strings are interned ids: names and kinds in
+  VgStrPool::global(), free text in the store's own pool.
+   - frames are hash-consed: each distinct frame is stored once,
+     however many stacks it's in.
+   - a stack is a list of frame ids, top first, in cells that are
+     hash-consed too: stacks with the same outer frames (e.g. all
+     allocations through one factory) share those cells, and equal
+     stacks have the very same top cell.
+*/
+struct VgFrameRec {
+   quint64 ip;
+   quint32 obj, fn, dir, file;
+   quint32 line;
+};
+
+inline bool operator==( const VgFrameRec& a, const VgFrameRec& b )
+{
+   return a.ip == b.ip && a.fn == b.fn && a.obj == b.obj &&
+          a.file == b.file && a.line == b.line && a.dir == b.dir;
+}
+
+inline uint qHash( const VgFrameRec& frm )
+{
+   uint h = qHash( frm.ip );
+   h = h * 31 + frm.fn;
+   h = h * 31 + frm.obj;
+   h = h * 31 + frm.file;
+   h = h * 31 + frm.line;
+   return h;
+}
+
+struct VgStackCell {
+   quint32 frame;     // frame id
+   quint32 next;      // the caller's cell: 0 at the bottom
+};
+
+struct VgStackRec {
+   quint32 top;       // first cell: 0 if no frames
+   quint32 numFrames;
+};
+
+/* A displayable child of an error, in log order:
+   - STACK: value is the stack number within the error
+   - else:  value is the text (VgLogStore::text())      */
+struct VgDetailRec {
+   quint32 type;     // VG_ELEM::ElemType
+   quint32 value;
+};
+
+struct VgErrorRec {
+   quint64 unique;
+   quint64 leakedBytes, leakedBlocks;
+   quint32 kind;                      // interned
+   quint32 what;                      // VgLogStore::text()
+   quint32 firstDetail, numDetails;
+   quint32 firstStack, numStacks;
+   quint32 count;                     // updated by <errorcounts>
+   qint32  tid;                       // -1 if none
+   quint32 firstHgVal;                // helgrind: hthreadids, then lock addrs
+   quint16 numHThreads, numLockAddrs;
+   qint64  offset;                    // <error> in source: -1 if unknown
+   quint32 length;
+   quint32 source;                    // interned path: the log, or a spool
+   quint32 firstOrigin;               // merged logs: 0 if none (VgOriginRec)
+};
+
+/* Merged logs (VgLogMerger): a log an error was found in, and its
+   count there.  An error's origins are a list, in merge order.    */
+struct VgOriginRec {
+   quint32 log;       // interned path
+   quint32 count;
+   quint32 next;      // 0: the last
+};
+
+struct VgPairRec {
+   quint32 count;
+   quint32 name;                      // VgLogStore::text()
+};
+
+
+
+// ============================================================
+/*!
+  VgLogRecord: a closed top-level element, as handed over by the parser.
+   - transient: VgLogStore takes what it needs from it.
+   - only the top-level elements we need (error, errorcounts,
+     suppcounts, status, announcethread) are filled in.
+*/
+struct VgLogFrame {
+   VgLogFrame() : obj( 0 ), fn( 0 ), dir( 0 ), file( 0 ) {}
+   QString ip, line;
+   quint32 obj, fn, dir, file;   // interned by the parser
+};
+
+struct VgLogDetail {
+   VG_ELEM::ElemType type;
+   QString text;
+};
+
+struct VgLogPair {
+   quint32 count;
+   quint64 unique;   // errorcounts
+   QString name;     // suppcounts
+};
+
+class VgLogRecord
+{
+public:
+   VgLogRecord();
+   void clear( VG_ELEM::ElemType t = VG_ELEM::NUM_ELEMS );
+
+   VG_ELEM::ElemType type;
+
+   // error, announcethread
+   QString unique, tid, kind, what, xwhat, hthreadid;
+   QString leakedBytes, leakedBlocks;
+   QVector<VgLogDetail> details;
+   QVector< QVector<VgLogFrame> > stacks;
+   QString xtext;    // scratch: <text> of the current xwhat/xauxwhat
+   QVector<int> hthreadids;      // helgrind: all threads an error refers to
+   QVector<quint64> lockAddrs;   // helgrind: filled in by the tool's logview
+
+   // errorcounts, suppcounts
+   QVector<VgLogPair> pairs;
+
+   // status
+   QString state, time;
+
+   // the rest: the element as logged, for building its dom if it's
+   // ever wanted (errors: see offset), and the text of a leaf
+   // element (pid, tool, ...).  root: text is its tag.
+   QString xml, text;
+   QString exe;      // args: the client's
+
+   // where the element is, if known: in the file source (an interned
+   // path), from offset.  -1 if not known.
+   qint64 offset;
+   qint64 length;
+   quint32 source;
+};
+
+
+
+// ============================================================
+/*!
+  VgLogStore: the compact model of a valgrind log.
+   - errors, stacks, frames and details live in arenas,
+     referred to by index.
+   - frames and stack cells are shared (see VgFrameRec): walk a
+     stack's frames with cell( id ).next, from its top.
+   - names and kinds are ids into VgStrPool::global(): clear()
+     leaves that pool alone.  Free text (what, details, supp names)
+     differs from log to log: it's kept in the store's own pool,
+     and cleared with it.
+   - errors are indexed by field as they're added (VgLogIndex),
+     put in groups by fingerprint (VgLogGroups), and leaks totalled
+     by allocation site (VgLogLeaks).
+*/
+class VgLogStore
+{
+public:
+   VgLogStore();
+   ~VgLogStore();
+
+   int  addError( const VgLogRecord& rec );
+   int  addStacks( const VgLogRecord& rec );
+   void setSuppCounts( const VgLogRecord& rec );
+   void setErrorCount( int idx, quint32 count );
+   void addOrigin( int idx, quint32 log, quint32 count );
+   void regroup( int depth, VG_FPRINT::Key key );
+   void regroupLeaks( int depth );
+   void setCumulativeLeaks( bool cumulative );
+   void clear();
+
+   static VgFrameRec frameRec( const VgLogFrame& lf );
+
+   int numErrors() const {
+      return errors.count();
+   }
+   VgErrorRec& error( int idx ) {
+      return errors[idx];
+   }
+   const VgErrorRec& error( int idx ) const {
+      return errors.at( idx );
+   }
+   const VgStackRec& stack( int idx ) const {
+      return stacks.at( idx );
+   }
+   const VgStackCell& cell( quint32 id ) const {
+      return cells.at( id );
+   }
+   const VgFrameRec& frame( int idx ) const {
+      return frames.at( idx );
+   }
+   /* O(1): equal stacks are one and the same list */
+   bool sameStack( int idx1, int idx2 ) const {
+      return stacks.at( idx1 ).top == stacks.at( idx2 ).top;
+   }
+   const VgOriginRec& origin( quint32 id ) const {
+      return origins.at( id );
+   }
+   const VgDetailRec& detail( int idx ) const {
+      return details.at( idx );
+   }
+   quint64 hgValue( int idx ) const {
+      return hgvals.at( idx );
+   }
+   const QVector<VgPairRec>& suppCounts() const {
+      return suppcounts;
+   }
+
+   const QString& str( quint32 id ) const {
+      return VgStrPool::global().str( id );
+   }
+   const QString& text( quint32 id ) const {
+      return texts.str( id );
+   }
+   const VgLogIndex& index() const {
+      return errindex;
+   }
+   const VgLogGroups& groups() const {
+      return errgroups;
+   }
+   const VgLogLeaks& leaks() const {
+      return errleaks;
+   }
+
+private:
+   quint32 internFrame( const VgFrameRec& frm );
+   quint32 cons( quint32 frame, quint32 next );
+
+private:
+   VgArena<VgErrorRec>  errors;
+   VgArena<VgDetailRec> details;
+   VgArena<VgStackRec>  stacks;
+   VgArena<VgFrameRec>  frames;         // distinct frames
+   QHash<VgFrameRec, quint32> frameIds;
+   VgArena<VgStackCell> cells;          // cell 0: the end of every stack
+   QHash<quint64, quint32> cellIds;     // frame << 32 | next -> cell
+   VgArena<quint64>     hgvals;
+   VgArena<VgOriginRec> origins;        // origin 0: the end of every list
+   QVector<VgPairRec>   suppcounts;
+   VgStrPool texts;                     // what, details, supp names
+   VgLogIndex errindex;
+   VgLogGroups errgroups;
+   VgLogLeaks errleaks;
+};
+
+#endif // #ifndef __VGLOGSTORE_H
@@ -0,0 +1,199 @@
+/****************************************************************************
+** VgSrcInfo implementation
+**  - cached, asynchronous source-file metadata
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vgsrcinfo.h"
+#include "utils/vk_utils.h"
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+
+
+/**********************************************************************/
+/*!
+  VgSrcInfo
+*/
+VgSrcInfo* VgSrcInfo::instance()
+{
+   // deleted along with the application: stops the worker thread.
+   static VgSrcInfo* srcInfo = new VgSrcInfo( QCoreApplication::instance() );
+   return srcInfo;
+}
+
+VgSrcInfo::VgSrcInfo( QObject* parent )
+   : QThread( parent ), stopRequested( false )
+{
+   this->setObjectName( "vgsrcinfo" );
+
+   watcher = new QFileSystemWatcher( this );
+   connect( watcher, SIGNAL( directoryChanged( const QString& ) ),
+            this,      SLOT( dirChanged( const QString& ) ) );
+
+   // emitted by the worker thread: queued to us.
+   connect( this, SIGNAL( statted() ),
+            this,   SLOT( batchDone() ), Qt::QueuedConnection );
+
+   start( QThread::LowPriority );
+}
+
+VgSrcInfo::~VgSrcInfo()
+{
+   mutex.lock();
+   stopRequested = true;
+   queued.wakeAll();
+   mutex.unlock();
+
+   wait();
+}
+
+
+/*!
+  Ask for the metadata of path, if it's not already known or queued.
+*/
+quint32 VgSrcInfo::request( const QString& path )
+{
+   quint32 id = paths.intern( path );
+   if ( id >= ( quint32 )infos.size() ) {
+      infos.resize( id + 1 );
+   }
+
+   if ( infos.at( id ) == VG_SRC::UNKNOWN ) {
+      enqueue( id );
+   }
+   return id;
+}
+
+void VgSrcInfo::enqueue( quint32 id )
+{
+   infos[id] = VG_SRC::QUEUED;
+
+   Job job;
+   job.id    = id;
+   job.path  = paths.str( id );
+   job.flags = 0;
+
+   QMutexLocker locker( &mutex );
+   jobs.append( job );
+   queued.wakeOne();
+}
+
+
+/*!
+  Pick up the worker's results: flags, and directories to watch.
+*/
+void VgSrcInfo::batchDone()
+{
+   QVector<Job> done;
+   mutex.lock();
+   done.swap( results );
+   mutex.unlock();
+
+   if ( done.isEmpty() ) {
+      return;
+   }
+
+   for ( int i = 0; i < done.count(); ++i ) {
+      const Job& job = done.at( i );
+      infos[job.id] = job.flags;
+
+      if ( job.dir.isEmpty() ) {
+         continue;
+      }
+      QHash<QString, QVector<quint32> >::iterator it = dirIds.find( job.dir );
+      if ( it == dirIds.end() ) {
+         it = dirIds.insert( job.dir, QVector<quint32>() );
+         watcher->addPath( job.dir );
+      }
+      if ( !it.value().contains( job.id ) ) {
+         it.value().append( job.id );
+      }
+   }
+
+   emit updated();
+}
+
+
+/*!
+  A watched directory changed: files may have come, gone,
+  or changed permissions.  Re-stat all we know of in there.
+*/
+void VgSrcInfo::dirChanged( const QString& dir )
+{
+   QVector<quint32> ids = dirIds.take( dir );
+   watcher->removePath( dir );
+
+   for ( int i = 0; i < ids.count(); ++i ) {
+      enqueue( ids.at( i ) );
+   }
+
+   emit sourcesChanged( dir );
+}
+
+
+
+/**********************************************************************/
+/*
+  Worker thread
+*/
+void VgSrcInfo::run()
+{
+   for ( ;; ) {
+      QVector<Job> batch;
+
+      mutex.lock();
+      while ( jobs.isEmpty() && !stopRequested ) {
+         queued.wait( &mutex );
+      }
+      if ( stopRequested ) {
+         mutex.unlock();
+         return;
+      }
+      batch.swap( jobs );
+      mutex.unlock();
+
+      for ( int i = 0; i < batch.count(); ++i ) {
+         Job& job = batch[i];
+         QFileInfo fi( job.path );
+
+         job.flags = VG_SRC::KNOWN;
+         if ( fi.exists() && fi.isFile() /* && !fi.isSymLink() */) {
+            if ( fi.isReadable() ) {
+               job.flags |= VG_SRC::READABLE;
+            }
+            if ( fi.isWritable() ) {
+               job.flags |= VG_SRC::WRITEABLE;
+            }
+         }
+
+         // watch the directory, if there is one: the file may turn up.
+         QFileInfo di( fi.absolutePath() );
+         if ( di.isDir() ) {
+            job.dir = di.absoluteFilePath();
+         }
+      }
+
+      mutex.lock();
+      results += batch;
+      mutex.unlock();
+
+      emit statted();
+   }
+}
@@ -0,0 +1,112 @@
+/****************************************************************************
+** VgSrcInfo definition
+**  - cached, asynchronous source-file metadata
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VGSRCINFO_H
+#define __VGSRCINFO_H
+
+#include "utils/vglogstore.h"
+
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+
+namespace VG_SRC {
+   enum Flags {
+      UNKNOWN   = 0x0,     // never asked for
+      QUEUED    = 0x1,     // waiting to be stat'd
+      KNOWN     = 0x2,     // stat'd: the flags below are valid
+      READABLE  = 0x4,     // a readable regular file
+      WRITEABLE = 0x8      // ... and writeable too
+   };
+}
+
+
+// ============================================================
+/*!
+  VgSrcInfo: what we know about the source files frames refer to.
+
+   - one shared instance: paths are interned (VgStrPool), and
+     the flags looked up by path id.
+   - paths are stat'd in a worker thread, in batches, as they're
+     requested: the gui thread never touches the filesystem.
+     Lookups only ever see the flags as of the last batch done.
+   - the directories of stat'd files are watched: on a change,
+     all the files known in that directory are stat'd again.
+   - updated() is emitted (in the gui thread) after each batch,
+     and sourcesChanged() when a watched directory changes.
+
+  All public functions are for the gui thread only.
+*/
+class VgSrcInfo : public QThread
+{
+   Q_OBJECT
+public:
+   static VgSrcInfo* instance();
+   ~VgSrcInfo();
+
+   quint32 request( const QString& path );   // returns the path id
+   quint8 flags( quint32 pathId ) const {
+      return ( pathId < ( quint32 )infos.size() ) ? infos.at( pathId ) : 0;
+   }
+
+signals:
+   void updated();
+   void sourcesChanged( const QString& dir );   // a watched dir changed
+   void statted();     // from the worker thread: picked up by batchDone()
+
+protected:
+   void run();
+
+private slots:
+   void batchDone();
+   void dirChanged( const QString& dir );
+
+private:
+   VgSrcInfo( QObject* parent );
+   void enqueue( quint32 id );
+
+   struct Job {
+      quint32 id;
+      QString path;
+      QString dir;       // set by the worker
+      quint8  flags;     // set by the worker
+   };
+
+private:
+   // gui thread only
+   VgStrPool paths;
+   QVector<quint8> infos;                  // path id -> VG_SRC::Flags
+   QFileSystemWatcher* watcher;
+   QHash<QString, QVector<quint32> > dirIds;   // watched dir -> path ids
+
+   // shared with the worker thread
+   QMutex mutex;
+   QWaitCondition queued;
+   QVector<Job> jobs;        // to do
+   QVector<Job> results;     // done, not yet picked up by batchDone()
+   bool stopRequested;
+};
+
+#endif // #ifndef __VGSRCINFO_H
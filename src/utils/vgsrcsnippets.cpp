@@ -0,0 +1,218 @@
+/****************************************************************************
+** VgSrcSnippets implementation
+**  - line ranges of source files, for the frames of the log views
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vgsrcsnippets.h"
+#include "utils/vgsrcinfo.h"
+#include "utils/vk_utils.h"
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QVector>
+
+#include <string.h>
+
+
+// source files to keep around
+static const int SNIPPET_CACHE_KB = 64 * 1024;
+
+
+
+// ============================================================
+/*!
+  SrcFile: a source file read in, and its line index so far.
+   - read, not mapped: a mapping of a file truncated under us
+     (by an editor, a build) would SIGBUS on the next read.
+*/
+class VgSrcSnippets::SrcFile
+{
+public:
+   SrcFile() : buf( 0 ), size( 0 ), scanned( 0 ) { }
+
+   bool read( const QString& path );
+   bool isStale( const QString& path ) const;
+   bool line( int n, QString& str );
+   qint64 dataSize() const {
+      return size;
+   }
+
+   QString dir;                // absolute: for invalidation
+
+private:
+   void indexTo( int n );
+
+private:
+   QByteArray data;
+   const char* buf;            // data's
+   qint64 size;
+   QDateTime modified;         // when read
+   QVector<qint64> starts;     // starts[i]: offset of line i+1
+   qint64 scanned;             // all line starts before this are known
+};
+
+bool VgSrcSnippets::SrcFile::read( const QString& path )
+{
+   QFileInfo fi( path );
+   dir = fi.absolutePath();
+   modified = fi.lastModified();
+
+   QFile file( path );
+   if ( !file.open( QIODevice::ReadOnly ) ) {
+      return false;
+   }
+   data = file.readAll();
+   if ( file.error() != QFile::NoError ) {
+      return false;
+   }
+
+   buf  = data.constData();
+   size = data.size();
+   if ( size > 0 ) {
+      starts.append( 0 );
+   }
+   return true;
+}
+
+/*!
+  Changed since it was read: the directory watcher only tells us
+  later, if at all.
+*/
+bool VgSrcSnippets::SrcFile::isStale( const QString& path ) const
+{
+   QFileInfo fi( path );
+   return !fi.exists() || fi.size() != size || fi.lastModified() != modified;
+}
+
+/*!
+  Find line starts until we know where line n ends.
+*/
+void VgSrcSnippets::SrcFile::indexTo( int n )
+{
+   while ( starts.count() <= n && scanned < size ) {
+      const char* nl = ( const char* )memchr( buf + scanned, '\n',
+                                              size - scanned );
+      if ( nl == 0 ) {
+         scanned = size;
+         break;
+      }
+      scanned = nl - buf + 1;
+      if ( scanned < size ) {
+         starts.append( scanned );
+      }
+   }
+}
+
+/*!
+  Line n (from 1), without its line ending: false if past the end.
+*/
+bool VgSrcSnippets::SrcFile::line( int n, QString& str )
+{
+   indexTo( n );
+   if ( n < 1 || n > starts.count() ) {
+      return false;
+   }
+
+   qint64 from = starts.at( n - 1 );
+   qint64 to   = ( n < starts.count() ) ? starts.at( n ) : size;
+   if ( to > from && buf[to - 1] == '\n' ) {
+      to--;
+   }
+   if ( to > from && buf[to - 1] == '\r' ) {
+      to--;
+   }
+
+   // as QTextStream would have decoded it
+   str = QString::fromLocal8Bit( buf + from, ( int )( to - from ) );
+   return true;
+}
+
+
+
+// ============================================================
+/*!
+  VgSrcSnippets
+*/
+VgSrcSnippets* VgSrcSnippets::instance()
+{
+   static VgSrcSnippets* snippets =
+      new VgSrcSnippets( QCoreApplication::instance() );
+   return snippets;
+}
+
+VgSrcSnippets::VgSrcSnippets( QObject* parent )
+   : QObject( parent ), files( SNIPPET_CACHE_KB )
+{
+   connect( VgSrcInfo::instance(), SIGNAL( sourcesChanged( const QString& ) ),
+            this,                    SLOT( sourcesChanged( const QString& ) ) );
+}
+
+VgSrcSnippets::~VgSrcSnippets()
+{ }
+
+
+/*!
+  Lines first..last of the file at path.
+   - returns false if the file can't be read.
+*/
+bool VgSrcSnippets::lines( const QString& path, int first, int last,
+                           QStringList& lines )
+{
+   lines.clear();
+
+   SrcFile* src = files.object( path );
+   if ( src != 0 && src->isStale( path ) ) {
+      files.remove( path );
+      src = 0;
+   }
+   if ( src == 0 ) {
+      src = new SrcFile();
+      if ( !src->read( path ) ) {
+         delete src;
+         return false;
+      }
+      // a file bigger than the cache just pushes everything else out.
+      int cost = ( int )qMin( src->dataSize() / 1024 + 1,
+                              ( qint64 )files.maxCost() );
+      files.insert( path, src, cost );
+   }
+
+   QString str;
+   for ( int n = first; n <= last && src->line( n, str ); ++n ) {
+      lines.append( str );
+   }
+   return true;
+}
+
+
+/*!
+  The sources in dir may have changed: drop them.
+*/
+void VgSrcSnippets::sourcesChanged( const QString& dir )
+{
+   QList<QString> paths = files.keys();
+   for ( int i = 0; i < paths.count(); ++i ) {
+      SrcFile* src = files.object( paths.at( i ) );
+      if ( src != 0 && src->dir == dir ) {
+         files.remove( paths.at( i ) );
+      }
+   }
+}
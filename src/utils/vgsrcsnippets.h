@@ -0,0 +1,64 @@
+/****************************************************************************
+** VgSrcSnippets definition
+**  - line ranges of source files, for the frames of the log views
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VGSRCSNIPPETS_H
+#define __VGSRCSNIPPETS_H
+
+#include <QCache>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+
+// ============================================================
+/*!
+  VgSrcSnippets: serves line ranges of source files.
+
+   - each file is read once, and a line-offset index built
+     as far into the file as lines have been asked for: any line
+     range already indexed is then just a lookup.
+   - files read are kept in an LRU cache bounded by size, so
+     frames into the same (hot) headers cost nothing the next time.
+   - files are dropped from the cache when VgSrcInfo sees their
+     directory change, or when found changed on being asked for.
+
+  For the gui thread only.
+*/
+class VgSrcSnippets : public QObject
+{
+   Q_OBJECT
+public:
+   static VgSrcSnippets* instance();
+   ~VgSrcSnippets();
+
+   // lines first..last (from 1) of the file: fewer if it's shorter.
+   bool lines( const QString& path, int first, int last, QStringList& lines );
+
+private slots:
+   void sourcesChanged( const QString& dir );
+
+private:
+   VgSrcSnippets( QObject* parent );
+
+   class SrcFile;
+   QCache<QString, SrcFile> files;     // cost: KB read
+};
+
+#endif // #ifndef __VGSRCSNIPPETS_H
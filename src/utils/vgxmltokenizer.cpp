@@ -0,0 +1,619 @@
+/****************************************************************************
+** VgXmlTokenizer implementation
+**  - memory-mapped tokenizer for valgrind xml logs
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vgxmltokenizer.h"
+#include "utils/vglogreader.h"
+#include "utils/vk_utils.h"
+
+#include <QByteArray>
+#include <QPair>
+
+#include <string.h>
+
+
+// ============================================================
+/*!
+  tag names, indexed by VG_ELEM::ElemType: must follow the enum order.
+*/
+static const char* const tagStrs[VG_ELEM::NUM_ELEMS] = {
+   "valgrindoutput", "protocolversion", "protocoltool", "preamble",
+   "pid", "ppid", "tool",
+   "logfilequalifier", "var", "value", "usercomment",
+   "args", "vargv", "argv", "exe", "arg",
+   "status", "state", "time",
+   "error", "unique", "tid", "kind", "what", "xwhat", "text", "stack",
+   "frame", "ip", "obj", "fn", "dir", "file", "line", "auxwhat", "xauxwhat",
+   "errorcounts", "announcethread", "hthreadid", "pair", "count",
+   "suppcounts", "name", "leakedbytes", "leakedblocks",
+   "suppression", "sname", "skind", "skaux", "sframe", "rawtext"
+};
+
+static QVector<QString> setupTagNames()
+{
+   QVector<QString> names;
+   for ( int i = 0; i < VG_ELEM::NUM_ELEMS; ++i ) {
+      names.append( QString::fromLatin1( tagStrs[i] ) );
+   }
+   return names;
+}
+
+static inline bool isSpace( char c )
+{
+   return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+static inline bool isNameChar( char c )
+{
+   return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) ||
+          ( c >= '0' && c <= '9' ) || c == '_' || c == '-' ||
+          c == '.' || c == ':' || ( c & 0x80 );
+}
+
+static bool isBlank( const char* b, const char* e )
+{
+   for ( ; b < e; ++b ) {
+      if ( !isSpace( *b ) ) {
+         return false;
+      }
+   }
+   return true;
+}
+
+/* find str in [b,e): returns 0 if not found */
+static const char* findStr( const char* b, const char* e, const char* str )
+{
+   int len = strlen( str );
+   while ( e - b >= len ) {
+      b = ( const char* )memchr( b, str[0], e - b - len + 1 );
+      if ( !b ) {
+         return 0;
+      }
+      if ( memcmp( b, str, len ) == 0 ) {
+         return b;
+      }
+      ++b;
+   }
+   return 0;
+}
+
+
+
+// ============================================================
+/*!
+  VgXmlTokenizer
+*/
+VgXmlTokenizer::VgXmlTokenizer( VgLogHandler* hnd )
+   : handler( hnd ), buf( 0 ), size( 0 ), rootClosed( false )
+{ }
+
+VgXmlTokenizer::~VgXmlTokenizer()
+{
+   if ( buf && file.isOpen() ) {
+      file.unmap( ( uchar* )buf );
+   }
+   buf = 0;
+   if ( file.isOpen() ) {
+      file.close();
+   }
+}
+
+
+/*!
+  static: tag name -> enum, without going via QString.
+  Returns VG_ELEM::NUM_ELEMS for unknown tags.
+*/
+VG_ELEM::ElemType VgXmlTokenizer::tagType( const char* name, int len )
+{
+#define VG_TAG( t ) \
+   if ( memcmp( name, tagStrs[VG_ELEM::t], len ) == 0 ) return VG_ELEM::t
+
+   switch ( len ) {
+   case 2:
+      VG_TAG( IP ); VG_TAG( FN );
+      break;
+   case 3:
+      VG_TAG( OBJ ); VG_TAG( SRCDIR ); VG_TAG( TID );
+      VG_TAG( PID ); VG_TAG( VAR ); VG_TAG( EXE ); VG_TAG( ARG );
+      break;
+   case 4:
+      VG_TAG( SRCFILE ); VG_TAG( LINE ); VG_TAG( KIND ); VG_TAG( WHAT );
+      VG_TAG( TEXT ); VG_TAG( PAIR ); VG_TAG( NAME ); VG_TAG( TIME );
+      VG_TAG( PPID ); VG_TAG( TOOL ); VG_TAG( ARGV ); VG_TAG( ARGS );
+      break;
+   case 5:
+      VG_TAG( FRAME ); VG_TAG( STACK ); VG_TAG( ERROR ); VG_TAG( COUNT );
+      VG_TAG( XWHAT ); VG_TAG( STATE ); VG_TAG( VARGV ); VG_TAG( VALUE );
+      VG_TAG( SNAME ); VG_TAG( SKIND ); VG_TAG( SKAUX );
+      break;
+   case 6:
+      VG_TAG( UNIQUE ); VG_TAG( SFRAME ); VG_TAG( STATUS );
+      break;
+   case 7:
+      VG_TAG( AUXWHAT ); VG_TAG( RAWTEXT );
+      break;
+   case 8:
+      VG_TAG( XAUXWHAT ); VG_TAG( PREAMBLE );
+      break;
+   case 9:
+      VG_TAG( HTHREADID );
+      break;
+   case 10:
+      VG_TAG( SUPPCOUNTS );
+      break;
+   case 11:
+      VG_TAG( SUPPRESSION ); VG_TAG( LEAKEDBYTES );
+      VG_TAG( ERRORCOUNTS ); VG_TAG( COMMENT );
+      break;
+   case 12:
+      VG_TAG( LEAKEDBLOCKS ); VG_TAG( PROTOCOL_TOOL );
+      break;
+   case 14:
+      VG_TAG( ANNOUNCETHREAD ); VG_TAG( ROOT );
+      break;
+   case 15:
+      VG_TAG( PROTOCOL_VERSION );
+      break;
+   case 16:
+      VG_TAG( LOGQUAL );
+      break;
+   default:
+      break;
+   }
+#undef VG_TAG
+
+   return VG_ELEM::NUM_ELEMS;
+}
+
+
+/*!
+  static: shared tag name strings, so dom elements don't each
+  allocate their own.
+*/
+const QString& VgXmlTokenizer::tagName( VG_ELEM::ElemType type )
+{
+   static const QVector<QString> names = setupTagNames();
+   vk_assert( type < VG_ELEM::NUM_ELEMS );
+   return names.at( type );
+}
+
+
+/*!
+  Map the whole log file.
+  Returns false if the file can't be mapped (e.g. empty, or not
+  a regular file): the caller should fall back to QXmlSimpleReader.
+*/
+bool VgXmlTokenizer::map( const QString& filepath )
+{
+   file.setFileName( filepath );
+   if ( !file.open( QIODevice::ReadOnly ) ) {
+      return false;
+   }
+
+   size = file.size();
+   if ( size <= 0 ) {
+      file.close();
+      return false;
+   }
+
+   buf = ( const char* )file.map( 0, size );
+   if ( !buf ) {
+      file.close();
+      return false;
+   }
+
+   return true;
+}
+
+
+/*!
+  Use a buffer mapped elsewhere (e.g. by another tokenizer),
+  which must outlive us: filepath's.
+*/
+void VgXmlTokenizer::setBuffer( const char* data, qint64 len,
+                                const QString& filepath )
+{
+   vk_assert( buf == 0 );
+   buf  = data;
+   size = len;
+   file.setFileName( filepath );
+}
+
+
+/*!
+  Tokenize the whole mapped file, driving the handler.
+  On error, the handler's fatalError() is called, as with
+  QXmlSimpleReader, and false is returned.
+*/
+bool VgXmlTokenizer::parse()
+{
+   return begin() && parseRange( 0, size ) && end();
+}
+
+
+/*!
+  Piecewise parsing: begin(), parseRange()..., end()
+   - ranges must be consecutive, and split between markup.
+*/
+bool VgXmlTokenizer::begin()
+{
+   vk_assert( buf != 0 );
+
+   openTags.clear();
+   rootClosed = false;
+
+   handler->setSource( file.fileName() );
+   if ( !handler->startDocument() ) {
+      return fail( buf, handler->errorString() );
+   }
+   return true;
+}
+
+bool VgXmlTokenizer::end()
+{
+   if ( !rootClosed ) {
+      return fail( buf + size, "unexpected end of file" );
+   }
+
+   if ( !handler->endDocument() ) {
+      return fail( buf + size, handler->errorString() );
+   }
+
+   return true;
+}
+
+
+/*!
+  Parse a range holding only complete top-level elements
+  (no prolog, no document element), as if within the document element.
+  The handler gets a document of its own, with a dummy document element.
+*/
+bool VgXmlTokenizer::parseFragment( qint64 from, qint64 to )
+{
+   if ( !begin() ) {
+      return false;
+   }
+
+   const QString& root = tagName( VG_ELEM::ROOT );
+   if ( !handler->startTag( VG_ELEM::ROOT, root ) ) {
+      return fail( buf + from, handler->errorString() );
+   }
+   openTags.append( qMakePair( tagStrs[VG_ELEM::ROOT], root.length() ) );
+
+   if ( !parseRange( from, to ) ) {
+      return false;
+   }
+
+   if ( openTags.count() != 1 ) {
+      return fail( buf + to, "unexpected end of fragment" );
+   }
+   return true;
+}
+
+
+bool VgXmlTokenizer::parseRange( qint64 from, qint64 to )
+{
+   vk_assert( buf != 0 );
+   vk_assert( 0 <= from && from <= to && to <= size );
+
+   const char* p   = buf + from;
+   const char* end = buf + to;
+
+   // skip any UTF-8 BOM
+   if ( from == 0 && to >= 3 && memcmp( p, "\xEF\xBB\xBF", 3 ) == 0 ) {
+      p += 3;
+   }
+
+   while ( p < end ) {
+
+      // --- text ---
+      if ( *p != '<' ) {
+         const char* t = p;
+         p = ( const char* )memchr( p, '<', end - p );
+         if ( !p ) {
+            p = end;
+         }
+         if ( !isBlank( t, p ) ) {
+            QString str;
+            if ( !decodeText( t, p, str ) ) {
+               return fail( t, "error occurred while parsing reference" );
+            }
+            if ( !handler->characters( str ) ) {
+               return fail( t, handler->errorString() );
+            }
+         }
+         continue;
+      }
+
+      const char* m = p;
+      if ( end - p < 2 ) {
+         return fail( p, "unexpected end of file" );
+      }
+
+      // --- end tag ---
+      if ( p[1] == '/' ) {
+         const char* n  = p + 2;
+         const char* ne = n;
+         while ( ne < end && isNameChar( *ne ) ) {
+            ++ne;
+         }
+         const char* gt = ne;
+         while ( gt < end && isSpace( *gt ) ) {
+            ++gt;
+         }
+         if ( gt >= end ) {
+            return fail( m, "unexpected end of file" );
+         }
+         if ( *gt != '>' ) {
+            return fail( gt, "error while parsing end tag" );
+         }
+         if ( openTags.isEmpty() ) {
+            return fail( m, "unexpected end tag" );
+         }
+         const QPair<const char*, int>& open = openTags.last();
+         if ( open.second != ne - n || memcmp( open.first, n, ne - n ) != 0 ) {
+            return fail( m, "tag mismatch" );
+         }
+         openTags.removeLast();
+
+         if ( openTags.count() == 1 ) {
+            handler->topLevelEnd( gt + 1 - buf );
+         }
+         if ( !handler->endTag() ) {
+            return fail( m, handler->errorString() );
+         }
+         if ( openTags.isEmpty() ) {
+            rootClosed = true;
+         }
+         p = gt + 1;
+      }
+
+      // --- processing instruction ---
+      else if ( p[1] == '?' ) {
+         const char* close = findStr( p + 2, end, "?>" );
+         if ( !close ) {
+            return fail( m, "unexpected end of file" );
+         }
+         const char* t = p + 2;
+         const char* te = t;
+         while ( te < close && !isSpace( *te ) ) {
+            ++te;
+         }
+         const char* d = te;
+         while ( d < close && isSpace( *d ) ) {
+            ++d;
+         }
+         const char* de = close;
+         while ( de > d && isSpace( de[-1] ) ) {
+            --de;
+         }
+         QString target = QString::fromUtf8( t, te - t );
+         QString data   = QString::fromUtf8( d, de - d );
+         if ( !handler->processingInstruction( target, data ) ) {
+            return fail( m, handler->errorString() );
+         }
+         p = close + 2;
+      }
+
+      // --- comment, CDATA, doctype ---
+      else if ( p[1] == '!' ) {
+         if ( end - p >= 4 && memcmp( p, "<!--", 4 ) == 0 ) {
+            const char* close = findStr( p + 4, end, "-->" );
+            if ( !close ) {
+               return fail( m, "unexpected end of file" );
+            }
+            p = close + 3;
+         }
+         else if ( end - p >= 9 && memcmp( p, "<![CDATA[", 9 ) == 0 ) {
+            const char* t = p + 9;
+            const char* close = findStr( t, end, "]]>" );
+            if ( !close ) {
+               return fail( m, "unexpected end of file" );
+            }
+            if ( close > t &&
+                 !handler->characters( QString::fromUtf8( t, close - t ) ) ) {
+               return fail( m, handler->errorString() );
+            }
+            p = close + 3;
+         }
+         else {
+            const char* close = ( const char* )memchr( p, '>', end - p );
+            if ( !close ) {
+               return fail( m, "unexpected end of file" );
+            }
+            p = close + 1;
+         }
+      }
+
+      // --- start tag ---
+      else {
+         const char* n  = p + 1;
+         const char* ne = n;
+         while ( ne < end && isNameChar( *ne ) ) {
+            ++ne;
+         }
+         if ( ne == n ) {
+            return fail( m, "error while parsing tag name" );
+         }
+         if ( ne < end && *ne != '>' && *ne != '/' && !isSpace( *ne ) ) {
+            return fail( ne, "error while parsing tag name" );
+         }
+
+         // skip any attributes
+         const char* gt = ne;
+         while ( gt < end && *gt != '>' ) {
+            if ( *gt == '"' || *gt == '\'' ) {
+               const char* q = ( const char* )memchr( gt + 1, *gt, end - gt - 1 );
+               if ( !q ) {
+                  return fail( m, "unexpected end of file" );
+               }
+               gt = q;
+            }
+            ++gt;
+         }
+         if ( gt >= end ) {
+            return fail( m, "unexpected end of file" );
+         }
+         bool emptyElem = ( gt[-1] == '/' );
+
+         if ( rootClosed ) {
+            return fail( m, "extra content at end of document" );
+         }
+         if ( openTags.count() == 1 ) {
+            handler->topLevelStart( m - buf );
+         }
+
+         VG_ELEM::ElemType type = tagType( n, ne - n );
+         QString tag = ( type != VG_ELEM::NUM_ELEMS )
+                       ? tagName( type ) : QString::fromUtf8( n, ne - n );
+
+         if ( !handler->startTag( type, tag ) ) {
+            return fail( m, handler->errorString() );
+         }
+
+         if ( emptyElem ) {
+            if ( openTags.count() == 1 ) {
+               handler->topLevelEnd( gt + 1 - buf );
+            }
+            if ( !handler->endTag() ) {
+               return fail( m, handler->errorString() );
+            }
+            if ( openTags.isEmpty() ) {
+               rootClosed = true;
+            }
+         }
+         else {
+            openTags.append( qMakePair( n, ( int )( ne - n ) ) );
+         }
+         p = gt + 1;
+      }
+   }
+
+   return true;
+}
+
+
+qint64 VgXmlTokenizer::find( qint64 from, const char* str ) const
+{
+   if ( from < 0 || from >= size ) {
+      return -1;
+   }
+   const char* pos = findStr( buf + from, buf + size, str );
+   return pos ? pos - buf : -1;
+}
+
+qint64 VgXmlTokenizer::findLast( const char* str ) const
+{
+   qint64 len = strlen( str );
+   for ( qint64 i = size - len; i >= 0; --i ) {
+      if ( buf[i] == str[0] && memcmp( buf + i, str, len ) == 0 ) {
+         return i;
+      }
+   }
+   return -1;
+}
+
+
+/*!
+  report an error at pos via the handler, a-la QXmlSimpleReader
+*/
+bool VgXmlTokenizer::fail( const char* pos, const QString& msg )
+{
+   // only counted on error: no need to track lines while scanning
+   int line = 1;
+   const char* lineStart = buf;
+   for ( const char* c = buf; c < pos; ++c ) {
+      if ( *c == '\n' ) {
+         line++;
+         lineStart = c + 1;
+      }
+   }
+   int col = pos - lineStart + 1;
+
+   handler->fatalError( QXmlParseException( msg, col, line ) );
+   return false;
+}
+
+
+/*!
+  UTF-8 text [b,e) -> QString, resolving character references.
+  Returns false on a malformed / unknown reference.
+*/
+bool VgXmlTokenizer::decodeText( const char* b, const char* e, QString& out )
+{
+   const char* amp = ( const char* )memchr( b, '&', e - b );
+   if ( !amp ) {
+      out = QString::fromUtf8( b, e - b );
+      return true;
+   }
+
+   QByteArray text;
+   text.reserve( e - b );
+
+   while ( amp ) {
+      text.append( b, amp - b );
+
+      const char* semi = ( const char* )memchr( amp, ';', e - amp );
+      if ( !semi ) {
+         return false;
+      }
+      const char* ref = amp + 1;
+      int len = semi - ref;
+
+      if ( len == 2 && memcmp( ref, "lt", 2 ) == 0 ) {
+         text.append( '<' );
+      }
+      else if ( len == 2 && memcmp( ref, "gt", 2 ) == 0 ) {
+         text.append( '>' );
+      }
+      else if ( len == 3 && memcmp( ref, "amp", 3 ) == 0 ) {
+         text.append( '&' );
+      }
+      else if ( len == 4 && memcmp( ref, "quot", 4 ) == 0 ) {
+         text.append( '"' );
+      }
+      else if ( len == 4 && memcmp( ref, "apos", 4 ) == 0 ) {
+         text.append( '\'' );
+      }
+      else if ( len >= 2 && ref[0] == '#' ) {
+         bool ok;
+         uint ucs;
+         if ( ref[1] == 'x' || ref[1] == 'X' ) {
+            ucs = QByteArray( ref + 2, len - 2 ).toUInt( &ok, 16 );
+         }
+         else {
+            ucs = QByteArray( ref + 1, len - 1 ).toUInt( &ok, 10 );
+         }
+         if ( !ok ) {
+            return false;
+         }
+         text.append( QString::fromUcs4( &ucs, 1 ).toUtf8() );
+      }
+      else {
+         return false;
+      }
+
+      b = semi + 1;
+      amp = ( const char* )memchr( b, '&', e - b );
+   }
+   text.append( b, e - b );
+
+   out = QString::fromUtf8( text.constData(), text.size() );
+   return true;
+}
@@ -0,0 +1,106 @@
+/****************************************************************************
+** VgXmlTokenizer definition
+**  - memory-mapped tokenizer for valgrind xml logs
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VGXMLTOKENIZER_H
+#define __VGXMLTOKENIZER_H
+
+#include "utils/vglogstore.h"
+
+#include <QFile>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+
+class VgLogHandler;
+
+
+// ============================================================
+/*!
+  VgXmlTokenizer: parses a complete valgrind xml log file.
+
+   - The file is mapped, and scanned directly as UTF-8 bytes:
+     only text content is ever converted to QStrings.
+
+   - Tags are looked up by length + byte compare against the fixed
+     protocol vocabulary (VG_ELEM), and handed to VgLogHandler
+     as enum values: no per-tag hash lookups.
+
+   - Handles the xml subset valgrind writes: processing instructions,
+     comments, CDATA, the predefined + numeric character entities.
+     Attributes are skipped (valgrind doesn't write any).
+
+   - The handler is told where each top-level element is in the
+     log, for later random access into it (VgLogRecord::offset).
+
+   - Can parse piecewise, and parse fragments of top-level elements
+     on their own: see VgLogLoader.
+
+  Only for offline logs: a file still being written by valgrind
+  must go through the incremental QXmlSimpleReader path.
+*/
+class VgXmlTokenizer
+{
+public:
+   VgXmlTokenizer( VgLogHandler* hnd );
+   ~VgXmlTokenizer();
+
+   bool map( const QString& filepath );
+   QString fileName() const {
+      return file.fileName();
+   }
+   void setBuffer( const char* data, qint64 len, const QString& filepath );
+   const char* data() const {
+      return buf;
+   }
+   qint64 dataSize() const {
+      return size;
+   }
+
+   bool parse();
+
+   // piecewise / partial parsing
+   bool begin();
+   bool parseRange( qint64 from, qint64 to );
+   bool end();
+   bool parseFragment( qint64 from, qint64 to );
+
+   // raw byte search in the mapped buffer: -1 if not found
+   qint64 find( qint64 from, const char* str ) const;
+   qint64 findLast( const char* str ) const;
+
+   static VG_ELEM::ElemType tagType( const char* name, int len );
+   static const QString& tagName( VG_ELEM::ElemType type );
+
+private:
+   bool fail( const char* pos, const QString& msg );
+   bool decodeText( const char* b, const char* e, QString& out );
+
+private:
+   VgLogHandler* handler;    // we don't own this
+   QFile file;
+   const char* buf;
+   qint64 size;
+
+   QVector< QPair<const char*, int> > openTags;
+   bool rootClosed;
+};
+
+#endif // #ifndef __VGXMLTOKENIZER_H
@@ -0,0 +1,329 @@
+/****************************************************************************
+** VkCompress implementation
+**  - reading and writing compressed (gzip/xz/zstd) logs
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vk_compress.h"
+#include "utils/vk_utils.h"
+
+#include <QApplication>
+#include <QByteArray>
+#include <QFile>
+#include <QProgressDialog>
+
+
+// copies are fed through this much at a time
+static const qint64 COPY_BLOCK     = 256 * 1024;
+// how long to wait on a process, before seeing to the gui
+static const int    COPY_WAIT      = 50;   // msecs
+static const int    PROGRESS_STEPS = 1000;
+
+
+/**********************************************************************/
+/*!
+  By magic bytes: a compressed log may well be called foo.xml.
+*/
+VkCompress::Format VkCompress::fileFormat( const QString& path )
+{
+   QFile file( path );
+   if ( !file.open( QIODevice::ReadOnly ) ) {
+      return NONE;
+   }
+   QByteArray magic = file.read( 6 );
+
+   if ( magic.startsWith( "\x1f\x8b" ) ) {
+      return GZIP;
+   }
+   if ( magic == QByteArray( "\xfd" "7zXZ\0", 6 ) ) {
+      return XZ;
+   }
+   if ( magic.startsWith( "\x28\xb5\x2f\xfd" ) ) {
+      return ZSTD;
+   }
+   return NONE;
+}
+
+VkCompress::Format VkCompress::nameFormat( const QString& path )
+{
+   if ( path.endsWith( ".gz" ) ) {
+      return GZIP;
+   }
+   if ( path.endsWith( ".xz" ) ) {
+      return XZ;
+   }
+   if ( path.endsWith( ".zst" ) ) {
+      return ZSTD;
+   }
+   return NONE;
+}
+
+
+bool VkCompress::findTool( const QString& name, QString& path )
+{
+   int errval = PARSED_OK;
+   path = fileCheck( &errval, name, false, false, true );
+   return errval == PARSED_OK;
+}
+
+bool VkCompress::decoder( Format fmt, QString& prog, QStringList& args )
+{
+   switch ( fmt ) {
+   case GZIP:
+      args << "-dc";
+      return findTool( "gzip", prog );
+   case XZ:
+      args << "-dc";
+      return findTool( "xz", prog );
+   case ZSTD:
+      args << "-dcq";
+      return findTool( "zstd", prog );
+   default:
+      break;
+   }
+   return false;
+}
+
+/*!
+  Multi-threaded where we can: a big log compresses many times
+  faster over all the cores.
+*/
+bool VkCompress::encoder( Format fmt, QString& prog, QStringList& args )
+{
+   switch ( fmt ) {
+   case GZIP:
+      args << "-c";
+      return findTool( "pigz", prog ) || findTool( "gzip", prog );
+   case XZ:
+      args << "-T0" << "-c";
+      return findTool( "xz", prog );
+   case ZSTD:
+      args << "-T0" << "-q" << "-c";
+      return findTool( "zstd", prog );
+   default:
+      break;
+   }
+   return false;
+}
+
+
+/*!
+  Write the log to proc's stdin, and read it from proc's stdout:
+  the caller owns proc, and should check its exit code once all
+  the output has been read.
+*/
+bool VkCompress::startDecoder( QProcess& proc, Format fmt )
+{
+   QString prog;
+   QStringList args;
+   if ( !decoder( fmt, prog, args ) ) {
+      VK_DEBUG( "VkCompress::startDecoder(): no decoder for format %d",
+                ( int )fmt );
+      return false;
+   }
+
+   proc.start( prog, args );
+   return proc.waitForStarted();
+}
+
+
+/*!
+  Decoder and encoder are piped one to the other, as needed, and we
+  feed src to the first of them (or straight to dst, if neither's
+  needed) a block at a time, keeping the gui alive meanwhile:
+  progress is shown over parent, and the user may cancel.
+  A partly written dst is removed if anything goes wrong, or the
+  user cancels: then returns false with an empty errMsg.
+*/
+bool VkCompress::copy( const QString& src, const QString& dst,
+                       QString& errMsg, QWidget* parent/*=0*/ )
+{
+   Format srcFmt = fileFormat( src );
+   Format dstFmt = nameFormat( dst );
+
+   QString decProg, encProg;
+   QStringList decArgs, encArgs;
+   if ( srcFmt != dstFmt && srcFmt != NONE &&
+        !decoder( srcFmt, decProg, decArgs ) ) {
+      errMsg = "Failed to find a program to decompress '" + src + "'";
+      return false;
+   }
+   if ( srcFmt != dstFmt && dstFmt != NONE &&
+        !encoder( dstFmt, encProg, encArgs ) ) {
+      errMsg = "Failed to find a program to compress '" + dst + "'";
+      return false;
+   }
+
+   QFile in( src );
+   if ( !in.open( QIODevice::ReadOnly ) ) {
+      errMsg = "Failed to open '" + src + "'";
+      return false;
+   }
+
+   // what we write to: the first process, else dst itself
+   QProcess dec, enc;
+   QProcess* first = 0;
+   QProcess* last  = 0;
+   QFile out( dst );
+   if ( srcFmt == dstFmt ) {
+      if ( !out.open( QIODevice::WriteOnly ) ) {
+         errMsg = "Failed to open '" + dst + "'";
+         return false;
+      }
+   }
+   else {
+      if ( srcFmt != NONE ) {
+         if ( dstFmt != NONE ) {
+            dec.setStandardOutputProcess( &enc );
+         }
+         else {
+            dec.setStandardOutputFile( dst );
+         }
+         first = last = &dec;
+      }
+      if ( dstFmt != NONE ) {
+         enc.setStandardOutputFile( dst );
+         if ( first == 0 ) {
+            first = &enc;
+         }
+         last = &enc;
+      }
+
+      if ( srcFmt != NONE ) {
+         dec.start( decProg, decArgs );
+      }
+      if ( dstFmt != NONE ) {
+         enc.start( encProg, encArgs );
+      }
+      if ( srcFmt != NONE && !dec.waitForStarted() ) {
+         errMsg = "Failed to start '" + decProg + "'";
+      }
+      else if ( dstFmt != NONE && !enc.waitForStarted() ) {
+         errMsg = "Failed to start '" + encProg + "'";
+      }
+   }
+
+   QProgressDialog progress( "Saving log file...", "Cancel",
+                             0, PROGRESS_STEPS, parent );
+   progress.setWindowModality( Qt::WindowModal );
+   progress.setMinimumDuration( 500 );
+
+   qint64 size = in.size();
+   qint64 fed  = 0;
+   bool ok = errMsg.isEmpty();
+   while ( ok ) {
+      QByteArray block = in.read( COPY_BLOCK );
+      if ( block.isEmpty() ) {
+         break;
+      }
+
+      QIODevice* dev = ( first != 0 ) ? ( QIODevice* )first : &out;
+      if ( dev->write( block ) != block.size() ) {
+         errMsg = "Failed to write '" + dst + "'";
+         ok = false;
+         break;
+      }
+
+      // wait for the pipe to take it, keeping the gui alive
+      while ( ok && first != 0 && first->bytesToWrite() > 0 ) {
+         if ( !first->waitForBytesWritten( COPY_WAIT ) &&
+              first->state() == QProcess::NotRunning ) {
+            // it's given up: exitedOk() says why
+            ok = false;
+         }
+         qApp->processEvents();
+         if ( progress.wasCanceled() ) {
+            ok = false;
+         }
+      }
+
+      fed += block.size();
+      if ( size > 0 ) {
+         progress.setValue( ( int )( fed * PROGRESS_STEPS / size ) );
+      }
+      qApp->processEvents();
+      if ( progress.wasCanceled() ) {
+         ok = false;
+      }
+   }
+
+   if ( first == 0 ) {
+      out.close();
+      if ( ok && out.error() != QFile::NoError ) {
+         errMsg = "Failed to write '" + dst + "'";
+         ok = false;
+      }
+   }
+   else {
+      first->closeWriteChannel();
+
+      // the last of them finishes once it has all been written
+      while ( ok && last->state() != QProcess::NotRunning ) {
+         last->waitForFinished( COPY_WAIT );
+         qApp->processEvents();
+         if ( progress.wasCanceled() ) {
+            ok = false;
+         }
+      }
+
+      // not cancelled: find out why
+      if ( !ok && !progress.wasCanceled() && errMsg.isEmpty() ) {
+         if ( srcFmt != NONE && dec.state() == QProcess::NotRunning ) {
+            exitedOk( dec, decProg, errMsg );
+         }
+         if ( errMsg.isEmpty() && dstFmt != NONE &&
+              enc.state() == QProcess::NotRunning ) {
+            exitedOk( enc, encProg, errMsg );
+         }
+         if ( errMsg.isEmpty() ) {
+            errMsg = "Failed to write '" + dst + "'";
+         }
+      }
+      if ( !ok ) {
+         dec.kill();
+         enc.kill();
+      }
+      dec.waitForFinished();
+      enc.waitForFinished();
+
+      if ( ok && srcFmt != NONE ) {
+         ok = exitedOk( dec, decProg, errMsg );
+      }
+      if ( ok && dstFmt != NONE ) {
+         ok = exitedOk( enc, encProg, errMsg );
+      }
+   }
+
+   if ( !ok ) {
+      QFile::remove( dst );
+   }
+   else {
+      progress.setValue( PROGRESS_STEPS );
+   }
+   return ok;
+}
+
+bool VkCompress::exitedOk( QProcess& proc, const QString& what,
+                           QString& errMsg )
+{
+   if ( proc.exitStatus() != QProcess::NormalExit || proc.exitCode() != 0 ) {
+      errMsg = "'" + what + "' failed: " +
+               QString::fromLocal8Bit( proc.readAllStandardError() ).trimmed();
+      return false;
+   }
+   return true;
+}
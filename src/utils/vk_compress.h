@@ -0,0 +1,66 @@
+/****************************************************************************
+** VkCompress definition
+**  - reading and writing compressed (gzip/xz/zstd) logs
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VK_COMPRESS_H
+#define __VK_COMPRESS_H
+
+#include <QProcess>
+#include <QString>
+#include <QStringList>
+#include <QWidget>
+
+
+// ============================================================
+/*!
+  VkCompress: compressed logs, via the usual command-line tools.
+
+   - reading: the decoder is fed the log through its stdin, and
+     its stdout is streamed straight into the parser
+     (see VgLogReader::parseCompressed()): no temporary file.
+   - writing: multi-threaded encoders where there are any
+     (pigz, xz -T0, zstd -T0), falling back to plain gzip.
+     Fed by us, keeping the gui alive, with progress shown.
+   - a file's format is known by its magic bytes; the format to
+     write is known by the name's extension.
+*/
+class VkCompress
+{
+public:
+   enum Format { NONE = 0, GZIP, XZ, ZSTD };
+
+   static Format fileFormat( const QString& path );
+   static Format nameFormat( const QString& path );
+
+   // starts proc decompressing its stdin (of format fmt) to its stdout
+   static bool startDecoder( QProcess& proc, Format fmt );
+
+   // copy src to dst, (de|re)compressing to dst's extension
+   static bool copy( const QString& src, const QString& dst,
+                     QString& errMsg, QWidget* parent = 0 );
+
+private:
+   static bool findTool( const QString& name, QString& path );
+   static bool decoder( Format fmt, QString& prog, QStringList& args );
+   static bool encoder( Format fmt, QString& prog, QStringList& args );
+   static bool exitedOk( QProcess& proc, const QString& what,
+                         QString& errMsg );
+};
+
+#endif // #ifndef __VK_COMPRESS_H
@@ -43,7 +43,7 @@
 /*!
   Initialise static data: Basic configuration setup
 */
-const unsigned int VkCfg::_projCfgVersion = 1;   // @@@ increment if project config keys change @@@
+const unsigned int VkCfg::_projCfgVersion = 2;   // @@@ increment if project config keys change @@@
 const unsigned int VkCfg::_glblCfgVersion = 2;   // @@@ increment if  global config keys change @@@
 
 const QString VkCfg::_email       = "info@open-works.net"; // bug-reports
@@ -419,7 +419,7 @@ void VkCfgGlbl::writeConfigDefaults()
    // These are settings/caches for file/dir-dialogs: filterlist + default filter to use
    // - list key = filefilters/<proj or glbl key, with all '/' replaced by '_'>
    // - dflt key = <list key>-default
-   setValue( "filefilters/valkyrie_view-log", "XML Files (*.xml);;Log Files (*.log.*);;All Files (*)" );
+   setValue( "filefilters/valkyrie_view-log", "XML Files (*.xml);;Compressed XML Files (*.xml.gz *.xml.xz *.xml.zst);;Log Files (*.log.*);;All Files (*)" );
    setValue( "filefilters/valkyrie_view-log-default", "" );
    setValue( "filefilters/handbook_docdir", "Html Files (*.html *.htm);;All Files (*)" );
    setValue( "filefilters/handbook_docdir-default", "" );
@@ -731,6 +731,7 @@ void VkCfgProj::openProject( const QString& proj_filename )
 
    // open new config
    QSettings* new_cfg = new QSettings( proj_filename, QSettings::IniFormat );
+   upgradeConfig( new_cfg );
 
    if ( ! checkValidConfig( new_cfg ) ) {
       vkPrintErr( "New project file bad/incomplete. Keeping existing config." );
@@ -829,6 +830,7 @@ bool VkCfgProj::loadDefaultConfig()
 
    // open default config
    QSettings* defaultCfg = new QSettings( VkCfg::projDfltPath(), QSettings::IniFormat );
+   upgradeConfig( defaultCfg );
 
    // test default project config is ok.
    if ( ! checkValidConfig( defaultCfg ) ) {
@@ -867,6 +869,47 @@ bool VkCfgProj::loadDefaultConfig()
 }
 
 
+/*!
+  Bring a config from an older valkyrie up to date:
+   - options added since get their compiled defaults,
+   - keys no longer used are kept: it's the user's file, and an
+     older valkyrie sharing it may still want them.
+  A config from a newer valkyrie is left alone: checkValidConfig()
+  turns it down.
+*/
+void VkCfgProj::upgradeConfig( QSettings* cfg )
+{
+   unsigned int version = cfg->value( "config_proj_version" ).toUInt();
+   if ( version > VkCfg::projCfgVersion() ) {
+      return;
+   }
+
+   bool changed = false;
+
+   foreach( VkObject* obj, vk->vkObjList() ) {
+      foreach( VkOption* opt, obj->getOptions() ) {
+         if ( !opt->isaConfigOpt() ) {
+            continue;
+         }
+         QString key = opt->configKey();
+         if ( !cfg->contains( key ) ) {
+            VK_DEBUG( "Upgrading config: adding key '%s'", qPrintable( key ) );
+            cfg->setValue( key, opt->dfltValue );
+            changed = true;
+         }
+      }
+   }
+
+   if ( version != VkCfg::projCfgVersion() ) {
+      cfg->setValue( "config_proj_version", VkCfg::projCfgVersion() );
+      changed = true;
+   }
+   if ( changed ) {
+      cfg->sync();
+   }
+}
+
+
 /*!
   Sanity check:
   Iterate over all options and make sure there is a config entry for it in the defaultCfg
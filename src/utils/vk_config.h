@@ -150,6 +150,7 @@ public:
 
 private:
    bool checkValidConfig( QSettings* cfg );
+   void upgradeConfig( QSettings* cfg );
    static bool checkVersionOk( unsigned int new_version );
    static void cleanTempDir();
    void writeConfigDefaults();
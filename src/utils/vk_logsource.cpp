@@ -0,0 +1,334 @@
+/****************************************************************************
+** VkLogSource implementation
+**  - tells the log parser when valgrind has written more output
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "utils/vk_logsource.h"
+#include "utils/vk_config.h"
+#include "utils/vk_utils.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+
+/***************************************************************************/
+/*!
+  VkLogSource
+*/
+VkLogSource::VkLogSource( const QString& fname, QObject* parent )
+   : QObject( parent ), logfile( fname )
+{
+   this->setObjectName( "logsource" );
+}
+
+VkLogSource::~VkLogSource()
+{ }
+
+/*!
+  The source the user asked for: a pipe, or the file.
+*/
+VkLogSource* VkLogSource::create( const QString& logfile, QObject* parent )
+{
+   if ( vkCfgProj->value( "valkyrie/xml-pipe" ).toBool() ) {
+      return new VkLogPipe( logfile, parent );
+   }
+   return new VkLogFileTail( logfile, parent );
+}
+
+
+
+/***************************************************************************/
+/*!
+  VkLogFileTail
+*/
+VkLogFileTail::VkLogFileTail( const QString& fname, QObject* parent )
+   : VkLogSource( fname, parent ), created( false )
+{
+   watcher = new QFileSystemWatcher( this );
+   connect( watcher, SIGNAL( directoryChanged( const QString& ) ),
+            this,      SLOT( dirChanged() ) );
+   connect( watcher, SIGNAL( fileChanged( const QString& ) ),
+            this,      SLOT( fileChanged() ) );
+}
+
+VkLogFileTail::~VkLogFileTail()
+{
+   close();
+}
+
+bool VkLogFileTail::open( QStringList& )
+{
+   QString dir = QFileInfo( logfile ).absolutePath();
+   if ( !QFileInfo( dir ).isDir() ) {
+      VK_DEBUG( "Error: no log directory '%s'", qPrintable( dir ) );
+      return false;
+   }
+
+   created = false;
+   watcher->addPath( dir );
+   dirChanged();   // just in case it's there already
+   return true;
+}
+
+void VkLogFileTail::close()
+{
+   QStringList paths = watcher->directories() + watcher->files();
+   if ( !paths.isEmpty() ) {
+      watcher->removePaths( paths );
+   }
+}
+
+/*!
+  Waiting for valgrind to create the log.
+*/
+void VkLogFileTail::dirChanged()
+{
+   if ( created || !QFile::exists( logfile ) ) {
+      return;
+   }
+
+   // got it: only interested in the log from now on.
+   created = true;
+   watcher->removePath( QFileInfo( logfile ).absolutePath() );
+   watcher->addPath( logfile );
+   emit logUpdated();
+}
+
+void VkLogFileTail::fileChanged()
+{
+   emit logUpdated();
+}
+
+
+
+/***************************************************************************/
+/*!
+  VkLogPipe
+*/
+VkLogPipe::VkLogPipe( const QString& fname, QObject* parent )
+   : VkLogSource( fname, parent ), readFd( -1 ), writeFd( -1 ), notifier( 0 )
+{ }
+
+VkLogPipe::~VkLogPipe()
+{
+   close();
+}
+
+/*!
+  Create the pipe, and tell valgrind to write to it instead of logfile.
+   - only the write end is to be inherited by valgrind.
+*/
+bool VkLogPipe::open( QStringList& vgflags )
+{
+   int fds[2];
+   if ( ::pipe( fds ) != 0 ) {
+      VK_DEBUG( "Error: failed to create pipe: %s", strerror( errno ) );
+      return false;
+   }
+   readFd  = fds[0];
+   writeFd = fds[1];
+   ::fcntl( readFd, F_SETFD, FD_CLOEXEC );
+   ::fcntl( readFd, F_SETFL, ::fcntl( readFd, F_GETFL ) | O_NONBLOCK );
+
+   file.setFileName( logfile );
+   if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
+      VK_DEBUG( "Error: failed to open '%s'", qPrintable( logfile ) );
+      close();
+      return false;
+   }
+
+   QString xmlFileFlag = "--xml-file=" + logfile;
+   QString xmlFdFlag   = "--xml-fd=" + QString::number( writeFd );
+   int idx = vgflags.indexOf( xmlFileFlag );
+   if ( idx >= 0 ) {
+      vgflags[idx] = xmlFdFlag;
+   }
+   else {
+      vgflags.insert( 1, xmlFdFlag );
+   }
+
+   notifier = new QSocketNotifier( readFd, QSocketNotifier::Read, this );
+   connect( notifier, SIGNAL( activated( int ) ),
+            this,       SLOT( readPipe() ) );
+   return true;
+}
+
+/*!
+  Valgrind has its copy of the write end: drop ours,
+  so we see end-of-file when it's done.
+*/
+void VkLogPipe::processStarted()
+{
+   closeWriteEnd();
+}
+
+void VkLogPipe::closeWriteEnd()
+{
+   if ( writeFd != -1 ) {
+      ::close( writeFd );
+      writeFd = -1;
+   }
+}
+
+void VkLogPipe::close()
+{
+   if ( notifier != 0 ) {
+      delete notifier;
+      notifier = 0;
+   }
+   if ( readFd != -1 ) {
+      ::close( readFd );
+      readFd = -1;
+   }
+   closeWriteEnd();
+
+   if ( file.isOpen() ) {
+      file.close();
+   }
+}
+
+/*!
+  Copy all that's waiting into logfile, then wake the parser.
+*/
+void VkLogPipe::readPipe()
+{
+   char buf[64 * 1024];
+   bool eof = false;
+   bool got = false;
+
+   for ( ;; ) {
+      ssize_t n = ::read( readFd, buf, sizeof( buf ) );
+      if ( n > 0 ) {
+         file.write( buf, n );
+         got = true;
+      }
+      else if ( n < 0 && errno == EINTR ) {
+         continue;
+      }
+      else {
+         // 0: valgrind's done; EAGAIN: nothing more for now
+         eof = ( n == 0 || errno != EAGAIN );
+         break;
+      }
+   }
+
+   if ( got ) {
+      file.flush();
+      emit logUpdated();
+   }
+
+   if ( eof ) {
+      notifier->setEnabled( false );
+   }
+}
+
+
+
+/***************************************************************************/
+/*!
+  VkProcLogWatch
+*/
+VkProcLogWatch::VkProcLogWatch( const QString& pattern, QObject* parent )
+   : QObject( parent )
+{
+   this->setObjectName( "proclogwatch" );
+
+   QFileInfo fi( pattern );
+   dir = fi.absolutePath();
+
+   QString name = fi.fileName();
+   int p = name.indexOf( "%p" );
+   vk_assert( p >= 0 );
+   nameFilter = name.left( p ) + "*" + name.mid( p + 2 );
+   nameRx = QRegExp( QRegExp::escape( name.left( p ) ) + "(\\d+)" +
+                     QRegExp::escape( name.mid( p + 2 ) ) );
+
+   watcher = new QFileSystemWatcher( this );
+   connect( watcher, SIGNAL( directoryChanged( const QString& ) ),
+            this,      SLOT( dirChanged() ) );
+   connect( watcher, SIGNAL( fileChanged( const QString& ) ),
+            this,    SIGNAL( logUpdated( const QString& ) ) );
+}
+
+VkProcLogWatch::~VkProcLogWatch()
+{
+   close();
+}
+
+/*!
+  The log of process pid: as valgrind expands %p.
+*/
+QString VkProcLogWatch::logFile( const QString& pattern, qint64 pid )
+{
+   QString path = pattern;
+   return path.replace( "%p", QString::number( pid ) );
+}
+
+bool VkProcLogWatch::open()
+{
+   if ( !QFileInfo( dir ).isDir() ) {
+      VK_DEBUG( "Error: no log directory '%s'", qPrintable( dir ) );
+      return false;
+   }
+
+   // watched all along: processes may start at any time
+   watcher->addPath( dir );
+   dirChanged();   // just in case some are there already
+   return true;
+}
+
+void VkProcLogWatch::close()
+{
+   QStringList paths = watcher->directories() + watcher->files();
+   if ( !paths.isEmpty() ) {
+      watcher->removePaths( paths );
+   }
+}
+
+/*!
+  All the logs seen so far.
+*/
+QStringList VkProcLogWatch::logFiles() const
+{
+   return logs.toList();
+}
+
+/*!
+  Something in the directory changed: any new logs?
+*/
+void VkProcLogWatch::dirChanged()
+{
+   QStringList names = QDir( dir ).entryList( QStringList( nameFilter ),
+                                              QDir::Files );
+   for ( int i = 0; i < names.count(); ++i ) {
+      QString path = dir + "/" + names.at( i );
+      if ( logs.contains( path ) || !nameRx.exactMatch( names.at( i ) ) ) {
+         continue;
+      }
+
+      logs.insert( path );
+      watcher->addPath( path );
+      emit logCreated( path, nameRx.cap( 1 ).toLongLong() );
+      emit logUpdated( path );
+   }
+}
@@ -0,0 +1,162 @@
+/****************************************************************************
+** VkLogSource definition
+**  - tells the log parser when valgrind has written more output
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VK_LOGSOURCE_H
+#define __VK_LOGSOURCE_H
+
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QRegExp>
+#include <QSet>
+#include <QSocketNotifier>
+#include <QString>
+#include <QStringList>
+
+
+// ============================================================
+/*!
+  VkLogSource: where valgrind's xml output comes from.
+
+  Whatever the source, the output ends up in logfile, and
+  logUpdated() is emitted as soon as more of it is there:
+  no polling, so no idle wakeups and no latency.
+
+  Use create() to get the source configured by the user.
+*/
+class VkLogSource : public QObject
+{
+   Q_OBJECT
+public:
+   VkLogSource( const QString& logfile, QObject* parent );
+   virtual ~VkLogSource();
+
+   static VkLogSource* create( const QString& logfile, QObject* parent );
+
+   // before starting valgrind: may change how it's told where to log
+   virtual bool open( QStringList& vgflags ) = 0;
+   // valgrind is up and running
+   virtual void processStarted() { }
+   virtual void close() = 0;
+
+signals:
+   void logUpdated();
+
+protected:
+   QString logfile;
+};
+
+
+// ============================================================
+/*!
+  VkLogFileTail: valgrind writes to logfile (--xml-file);
+  we're woken by the filesystem when it does.
+   - until valgrind creates the file, we watch its directory.
+*/
+class VkLogFileTail : public VkLogSource
+{
+   Q_OBJECT
+public:
+   VkLogFileTail( const QString& logfile, QObject* parent );
+   ~VkLogFileTail();
+
+   bool open( QStringList& vgflags );
+   void close();
+
+private slots:
+   void dirChanged();
+   void fileChanged();
+
+private:
+   QFileSystemWatcher* watcher;
+   bool created;
+};
+
+
+// ============================================================
+/*!
+  VkLogPipe: valgrind writes to a pipe (--xml-fd); we're woken
+  as soon as anything arrives, and copy it into logfile.
+   - the copy is what gets parsed, and saved.
+*/
+class VkLogPipe : public VkLogSource
+{
+   Q_OBJECT
+public:
+   VkLogPipe( const QString& logfile, QObject* parent );
+   ~VkLogPipe();
+
+   bool open( QStringList& vgflags );
+   void processStarted();
+   void close();
+
+private slots:
+   void readPipe();
+
+private:
+   void closeWriteEnd();
+
+private:
+   int readFd;
+   int writeFd;
+   QSocketNotifier* notifier;
+   QFile file;
+};
+
+
+// ============================================================
+/*!
+  VkProcLogWatch: --trace-children: valgrind writes a log per
+  process, to pattern with its pid for %p (--xml-file=pattern).
+   - one watcher for the lot: the directory, for new logs, and
+     each log once it's there.  No polling, however many.
+   - logCreated() for each new log, then logUpdated() as it's
+     written to: the root process' log too.
+   - a pipe won't do here: all processes would write to it.
+*/
+class VkProcLogWatch : public QObject
+{
+   Q_OBJECT
+public:
+   VkProcLogWatch( const QString& pattern, QObject* parent );
+   ~VkProcLogWatch();
+
+   static QString logFile( const QString& pattern, qint64 pid );
+
+   bool open();
+   void close();
+   QStringList logFiles() const;
+
+signals:
+   void logCreated( const QString& logfile, qint64 pid );
+   void logUpdated( const QString& logfile );
+
+private slots:
+   void dirChanged();
+
+private:
+   QFileSystemWatcher* watcher;
+   QString dir;
+   QString nameFilter;      // the log names, as a wildcard
+   QRegExp nameRx;          // ditto, with the pid captured
+   QSet<QString> logs;
+};
+
+#endif // #ifndef __VK_LOGSOURCE_H
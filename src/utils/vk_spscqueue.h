@@ -0,0 +1,119 @@
+/****************************************************************************
+** VkSpscQueue definition
+**  - lock-free single-producer/single-consumer ring buffer
+** --------------------------------------------------------------------------
+**
+** Copyright (C) 2000-2011, OpenWorks LLP. All rights reserved.
+** <info@open-works.co.uk>
+**
+** This file is part of Valkyrie, a front-end for Valgrind.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file COPYING included in the packaging of
+** this file.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef __VK_SPSCQUEUE_H
+#define __VK_SPSCQUEUE_H
+
+#include <QAtomicInt>
+
+
+// ============================================================
+/*!
+  VkSpscQueue: fixed-size ring buffer, safe for exactly one thread
+  pushing and one (other) thread popping, without locks.
+
+   - tail is only written by the producer, head only by the consumer:
+     each publishes its index with release semantics, and reads the
+     other's with acquire semantics.
+   - one slot is always left free, to tell 'full' from 'empty'.
+   - popped slots are reset, so items don't hang on to shared data.
+*/
+template <typename T>
+class VkSpscQueue
+{
+public:
+   VkSpscQueue( int capacity );
+   ~VkSpscQueue();
+
+   // producer only: false if full
+   bool push( const T& item );
+   // consumer only: false if empty
+   bool pop( T& item );
+
+   bool isEmpty() const;
+
+private:
+   VkSpscQueue( const VkSpscQueue& );
+   VkSpscQueue& operator=( const VkSpscQueue& );
+
+   static int load( const QAtomicInt& idx ) {
+      return const_cast<QAtomicInt&>( idx ).fetchAndAddAcquire( 0 );
+   }
+
+private:
+   T*  ring;
+   int mask;
+   QAtomicInt head;     // next slot to pop
+   QAtomicInt tail;     // next slot to push
+};
+
+
+template <typename T>
+VkSpscQueue<T>::VkSpscQueue( int capacity )
+   : head( 0 ), tail( 0 )
+{
+   // round up to a power of 2
+   int size = 2;
+   while ( size < capacity + 1 ) {
+      size <<= 1;
+   }
+   ring = new T[size];
+   mask = size - 1;
+}
+
+template <typename T>
+VkSpscQueue<T>::~VkSpscQueue()
+{
+   delete[] ring;
+}
+
+template <typename T>
+bool VkSpscQueue<T>::push( const T& item )
+{
+   int t = load( tail );
+   int next = ( t + 1 ) & mask;
+   if ( next == load( head ) ) {
+      return false;
+   }
+   ring[t] = item;
+   tail.fetchAndStoreRelease( next );
+   return true;
+}
+
+template <typename T>
+bool VkSpscQueue<T>::pop( T& item )
+{
+   int h = load( head );
+   if ( h == load( tail ) ) {
+      return false;
+   }
+   item = ring[h];
+   ring[h] = T();
+   head.fetchAndStoreRelease( ( h + 1 ) & mask );
+   return true;
+}
+
+template <typename T>
+bool VkSpscQueue<T>::isEmpty() const
+{
+   return load( head ) == load( tail );
+}
+
+#endif // #ifndef __VK_SPSCQUEUE_H